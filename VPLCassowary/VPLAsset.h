@@ -7,6 +7,13 @@
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
+/**
+ * `representationFactory` creates the asset's representations the first time they're needed. It's passed the asset,
+ * so the representations can refer back to it.
+ */
+- (instancetype)initWithTitle:(NSString *)title
+        representationFactory:(NSArray * (^)(VPLAsset * asset))representationFactory;
+
 + (instancetype)assetWithDictionary:(NSDictionary *)assetDictionary
                               error:(NSError * __autoreleasing *)error;
 
@@ -11,7 +11,7 @@ NSString * const VPLAssetTitleKey = @"title";
 
 @interface VPLAsset ()
 
-@property (nonatomic, strong, readonly) NSArray * representationData;
+@property (nonatomic, copy, readonly) NSArray * (^representationFactory)(VPLAsset * asset);
 
 @end
 
@@ -20,14 +20,14 @@ NSString * const VPLAssetTitleKey = @"title";
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
-- (id)initWithTitle:(NSString *)title
- representationData:(NSArray *)representationData
+- (instancetype)initWithTitle:(NSString *)title
+        representationFactory:(NSArray * (^)(VPLAsset * asset))representationFactory
 {
   self = [super init];
   if (self != nil)
   {
     _title = title;
-    _representationData = representationData;
+    _representationFactory = [representationFactory copy];
   }
   return self;
 }
@@ -47,7 +47,35 @@ NSString * const VPLAssetTitleKey = @"title";
   NSArray * representationDictionaries = [assetDictionary objectForKey:@"representations"];
   
   return [[self alloc] initWithTitle:assetTitle
-                  representationData:representationDictionaries];
+               representationFactory:^NSArray *(VPLAsset * asset) {
+                 
+                 return [self representationsWithDictionaries:representationDictionaries
+                                                        asset:asset];
+                 
+               }];
+}
+
++ (NSArray *)representationsWithDictionaries:(NSArray *)representationDictionaries
+                                       asset:(VPLAsset *)asset
+{
+  NSMutableArray * representations = [[NSMutableArray alloc] initWithCapacity:[representationDictionaries count]];
+  for (NSDictionary * representationDictionary in representationDictionaries)
+  {
+    NSError * error = nil;
+    VPLAssetRepresentation * representation = [VPLAssetRepresentation assetRepresentationWithDictionary:representationDictionary
+                                                                                                asset:asset
+                                                                                                error:&error];
+    if (representation != nil)
+    {
+      [representations addObject:representation];
+    }
+    else
+    {
+      NSLog(@"Error constructing representation: %@", [error localizedDescription]);
+    }
+  }
+  
+  return representations;
 }
 
 // ===== REPRESENTATIONS ===============================================================================================
@@ -59,24 +87,10 @@ NSString * const VPLAssetTitleKey = @"title";
 {
   if (_representations == nil)
   {
-    NSMutableArray * representations = [[NSMutableArray alloc] initWithCapacity:[self.representationData count]];
-    for (NSDictionary * representationDictionary in self.representationData)
-    {
-      NSError * error = nil;
-      VPLAssetRepresentation * representation = [VPLAssetRepresentation assetRepresentationWithDictionary:representationDictionary
-                                                                                                  asset:self
-                                                                                                  error:&error];
-      if (representation != nil)
-      {
-        [representations addObject:representation];
-      }
-      else
-      {
-        NSLog(@"Error constructing representation: %@", [error localizedDescription]);
-      }
-    }
+    _representations = self.representationFactory(self);
     
-    _representations = representations;
+    // the factory may hold on to the library's data, which isn't needed once the representations exist
+    _representationFactory = nil;
   }
   return _representations;
 }
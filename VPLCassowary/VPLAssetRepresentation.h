@@ -17,6 +17,11 @@ typedef enum _VPLAssetRepresentationError {
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
+- (instancetype)initWithAsset:(VPLAsset *)asset
+                     filename:(NSString *)filename
+                         size:(CGSize)size
+                    rootLayer:(VPLLayer *)rootLayer;
+
 + (instancetype)assetRepresentationWithDictionary:(NSDictionary *)assetRepresentationDictionary
                                             asset:(VPLAsset *)asset
                                             error:(NSError * __autoreleasing *)error;
@@ -41,6 +46,37 @@ typedef enum _VPLAssetRepresentationError {
 
 @property (nonatomic, strong, readonly) VPLLayer * rootLayer;
 
+// ===== LAYOUT ========================================================================================================
+#pragma mark - Layout
+
+/**
+ * Lays out the layer tree at the representation's size.
+ */
+- (void)performLayout;
+
+/**
+ * Lays out the layer tree at `size`. The constraints are built once, with the root layer's width and height as edit
+ * variables, so laying out again at another size only re-solves the existing constraint set.
+ *
+ * The layer tree stays attached to the constraint set between layouts, so changes to the tree or to layers' text are
+ * applied to it as they're made. Only the layers whose variables have changed since the last layout get new frames.
+ *
+ * If there's a shared `VPLLayoutCache`, the first layout looks for the same constraints, intrinsic sizes and size in
+ * it, and on a hit takes the layers' frames from the cache without building the constraint set at all.
+ */
+- (void)performLayoutWithSize:(CGSize)size;
+
+/**
+ * Detaches the layer tree and discards the constraint set, so that the next layout builds it again from the layer tree.
+ */
+- (void)invalidateLayout;
+
+/**
+ * The layers whose frames come from the solution, which are those with identifiers, in the order of the root layer's
+ * `subtreeLayers`.
+ */
+- (NSArray *)layersWithFrameVariables;
+
 // ===== DRAWING =======================================================================================================
 #pragma mark - Drawing
 
@@ -10,9 +10,48 @@
 #import "VPLConstraint.h"
 #import "VPLTableau.h"
 #import "VPLLinearExpression.h"
+#import "VPLInstrumentation.h"
+#import "VPLLayoutCache.h"
 
 NSString * const VPLAssetRepresentationErrorDomain = @"VPLAssetRepresentation";
 
+/**
+ * The root layer's width and height are edit variables, so that the same constraints can be re-solved at any size, but
+ * the size is what the representation is drawn at, so it should hold like a required constraint. It's weighted well
+ * above layers' intrinsic sizes, which are in turn weighted above every strength of preference:
+ *
+ *     required constraints > root size > intrinsic sizes > strong > medium > weak
+ *
+ * so only the required constraints can move it.
+ */
+static const CGFloat VPLAssetRepresentationSizeWeight = 100000.0;
+
+// cached layouts come from a different solve, possibly in another process, so they can differ by rounding
+static const CGFloat VPLAssetRepresentationCachedLayoutTolerance = 1.0e-3;
+
+static BOOL
+VPLAssetRepresentationValuesAreEqual(NSData * values, NSData * otherValues)
+{
+  if ([values length] != [otherValues length]) return NO;
+  
+  const double * doubles = [values bytes];
+  const double * otherDoubles = [otherValues bytes];
+  for (NSUInteger valueIndex = 0; valueIndex < [values length] / sizeof(double); valueIndex++)
+  {
+    if (fabs(doubles[valueIndex] - otherDoubles[valueIndex]) > VPLAssetRepresentationCachedLayoutTolerance)
+    {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+@interface VPLAssetRepresentation ()
+
+@property (nonatomic, strong) VPLConstraintSet * constraintSet;
+
+@end
+
 @implementation VPLAssetRepresentation
 
 // ===== INITIALIZATION ================================================================================================
@@ -77,113 +116,288 @@ NSString * const VPLAssetRepresentationErrorDomain = @"VPLAssetRepresentation";
 // ===== LAYOUT ========================================================================================================
 #pragma mark - Layout
 
+- (NSString *)rootLayerVariableNameForAttribute:(NSString *)attribute
+{
+  return [NSString stringWithFormat:@"%@.%@", self.rootLayer.identifier, attribute];
+}
+
+- (NSArray *)rootLayerOriginConstraints
+{
+  return @[
+    [VPLConstraint constraintWithVariable:[self rootLayerVariableNameForAttribute:@"x"]
+                                relatedBy:VPLConstraintRelationEqual
+                               toVariable:nil
+                               multiplier:0
+                                 constant:0],
+    [VPLConstraint constraintWithVariable:[self rootLayerVariableNameForAttribute:@"y"]
+                                relatedBy:VPLConstraintRelationEqual
+                               toVariable:nil
+                               multiplier:0
+                                 constant:0],
+  ];
+}
+
 - (VPLConstraintSet *)buildConstraints
 {
   VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
   
+  // add constraints for the root layer's origin
+  for (VPLConstraint * constraint in [self rootLayerOriginConstraints])
+  {
+    [constraintSet addConstraint:constraint];
+  }
   
+  // ...then the layer tree's, which stay up to date as the tree changes
+  NSArray * unsatisfiableConstraints = [self.rootLayer attachToConstraintSet:constraintSet];
+  if ([unsatisfiableConstraints count] > 0)
+  {
+    NSLog(@"%@: ignoring unsatisfiable constraints: %@", self.filename, unsatisfiableConstraints);
+  }
   
-  // add constraints for the root layer's dimensions
-  [constraintSet addConstraint:[VPLConstraint constraintWithVariable:[NSString stringWithFormat:@"%@.x", self.rootLayer.identifier]
-                                                          relatedBy:VPLConstraintRelationEqual
-                                                         toVariable:nil
-                                                         multiplier:0
-                                                           constant:0]];
+  // The root layer's dimensions are edit variables, so the same constraints can be re-solved at any size. They're
+  // added last so that they start out at the values the layer constraints give them. The root layer never has an
+  // intrinsic size of its own, so nothing else edits them.
+  for (NSString * attribute in @[ @"width", @"height" ])
+  {
+    [constraintSet addEditVariable:[self rootLayerVariableNameForAttribute:attribute]
+                            weight:VPLAssetRepresentationSizeWeight];
+  }
+  
+  return constraintSet;
+}
+
+- (void)performLayout
+{
+  [self performLayoutWithSize:self.size];
+}
+
+- (void)performLayoutWithSize:(CGSize)size
+{
+  // A cached layout can only stand in for building the constraint set from scratch. Once the constraint set exists,
+  // layers only get new frames when their variables change, so every layout after that has to go through it.
+  VPLLayoutCache * layoutCache = [VPLLayoutCache sharedLayoutCache];
+  NSArray * layers = nil;
+  NSString * fingerprint = nil;
+  NSData * cachedValues = nil;
+  if (layoutCache != nil && self.constraintSet == nil && self.rootLayer != nil)
+  {
+    layers = [self layersWithFrameVariables];
+    fingerprint = [self layoutFingerprintWithSize:size
+                                           layers:layers];
+    cachedValues = [layoutCache valuesForFingerprint:fingerprint];
+    if (cachedValues != nil && !layoutCache.verifiesCachedLayouts)
+    {
+      [self applyValues:cachedValues
+               toLayers:layers];
+      return;
+    }
+  }
+  
+  if (self.constraintSet == nil)
+  {
+    uint64_t buildStartTime = VPLInstrumentationPhaseStart();
+    self.constraintSet = [self buildConstraints];
+    VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseBuildConstraints, buildStartTime);
+  }
+  
+  VPLConstraintSet * constraintSet = self.constraintSet;
   
-  [constraintSet addConstraint:[VPLConstraint constraintWithVariable:[NSString stringWithFormat:@"%@.y", self.rootLayer.identifier]
-                                                          relatedBy:VPLConstraintRelationEqual
-                                                         toVariable:nil
-                                                         multiplier:0
-                                                           constant:0]];
+  // a dimension that isn't positive is left to the layer constraints
+  uint64_t solveStartTime = VPLInstrumentationPhaseStart();
+  if (size.width > 0)
+  {
+    [constraintSet suggestValue:size.width
+                    forVariable:[self rootLayerVariableNameForAttribute:@"width"]];
+  }
   
-  if (self.size.width > 0)
+  if (size.height > 0)
   {
-    [constraintSet addConstraint:[VPLConstraint constraintWithVariable:[NSString stringWithFormat:@"%@.width", self.rootLayer.identifier]
-                                                            relatedBy:VPLConstraintRelationEqual
-                                                           toVariable:nil
-                                                           multiplier:0
-                                                             constant:self.size.width]];
+    [constraintSet suggestValue:size.height
+                    forVariable:[self rootLayerVariableNameForAttribute:@"height"]];
   }
   
-  if (self.size.height > 0)
+  [constraintSet resolve];
+  VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseSolve, solveStartTime);
+  
+  uint64_t extractStartTime = VPLInstrumentationPhaseStart();
+  [self updateChangedLayerFrames];
+  VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseExtractFrames, extractStartTime);
+  
+  if (fingerprint == nil)
   {
-    [constraintSet addConstraint:[VPLConstraint constraintWithVariable:[NSString stringWithFormat:@"%@.height", self.rootLayer.identifier]
-                                                            relatedBy:VPLConstraintRelationEqual
-                                                           toVariable:nil
-                                                           multiplier:0
-                                                             constant:self.size.height]];
+    return;
   }
   
-  // construct the constraint set...
-  NSMutableArray * stack = [[NSMutableArray alloc] initWithObjects:self.rootLayer, nil];
-  while ([stack count] > 0)
+  // the layers' frames now hold the whole solution, since they were all reset when the tree was attached
+  NSData * values = [self valuesOfLayers:layers];
+  if (cachedValues != nil)
   {
-    VPLLayer * topLayer = [stack lastObject];
-    [stack removeLastObject];
-    
-    [topLayer updateConstraints];
-    
-    // process constraints
-    for (VPLLayoutConstraint * layoutConstraint in topLayer.layoutConstraints)
+    if (!VPLAssetRepresentationValuesAreEqual(values, cachedValues))
     {
-      [constraintSet addConstraint:layoutConstraint.constraint];
+      NSLog(@"%@: cached layout doesn't match a fresh solve", self.filename);
+      NSAssert(NO,
+               @"-[%@ %@] %@: cached layout doesn't match a fresh solve",
+               NSStringFromClass([self class]),
+               NSStringFromSelector(_cmd),
+               self.filename);
     }
-    
-    [stack addObjectsFromArray:topLayer.sublayers];
   }
-  
-  return constraintSet;
+  else
+  {
+    [layoutCache setValues:values
+            forFingerprint:fingerprint];
+  }
 }
 
-- (void)performLayout
+/**
+ * Applies the solution to only those layers whose variables may have changed since the last layout.
+ */
+- (void)updateChangedLayerFrames
 {
-  VPLConstraintSet * constraintSet = [self buildConstraints];
+  VPLConstraintSet * constraintSet = self.constraintSet;
   
-  // ...and then apply
-  NSMutableArray * stack = [[NSMutableArray alloc] initWithObjects:self.rootLayer, nil];
-  while ([stack count] > 0)
+  NSMutableSet * changedLayerSet = [[NSMutableSet alloc] init];
+  [[constraintSet changedVariableIDs] enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    
+    VPLLayer * layer = [self.rootLayer attachedLayerForVariableID:(VPLVariableID)idx];
+    if (layer != nil)
+    {
+      [changedLayerSet addObject:layer];
+    }
+    
+  }];
+  [constraintSet resetChangedVariableIDs];
+  
+  NSArray * changedLayers = [changedLayerSet allObjects];
+  NSUInteger variableCount = [changedLayers count] * 4;
+  if (variableCount == 0)
   {
-    VPLLayer * topLayer = [stack lastObject];
-    [stack removeLastObject];
+    return;
+  }
+  
+  VPLVariableID * variableIDs = malloc(variableCount * sizeof(VPLVariableID));
+  CGFloat * values = malloc(variableCount * sizeof(CGFloat));
+  
+  [changedLayers enumerateObjectsUsingBlock:^(VPLLayer * layer, NSUInteger idx, BOOL *stop) {
     
-    CGRect frame = CGRectZero;
+    variableIDs[idx * 4 + 0] = layer.xVariableID;
+    variableIDs[idx * 4 + 1] = layer.yVariableID;
+    variableIDs[idx * 4 + 2] = layer.widthVariableID;
+    variableIDs[idx * 4 + 3] = layer.heightVariableID;
     
-    // apply all variables for this layer
-    NSString * prefix = [topLayer.identifier stringByAppendingString:@"."];
+  }];
+  
+  [constraintSet getValues:values
+            forVariableIDs:variableIDs
+                     count:variableCount];
+  
+  [changedLayers enumerateObjectsUsingBlock:^(VPLLayer * layer, NSUInteger idx, BOOL *stop) {
     
-    for (NSString * variableName in constraintSet.tableau.rowVariableNames)
-    {
-      
-      if ([variableName hasPrefix:prefix])
-      {
-        NSString * attributeName = [variableName substringFromIndex:prefix.length];
-        CGFloat value = [[constraintSet.tableau expressionForRow:variableName] constantValue];
-        NSLog(@"%@ = %f", variableName, value);
-        if ([attributeName isEqualToString:@"x"])
-        {
-          frame.origin.x = value;
-        }
-        else if ([attributeName isEqualToString:@"y"])
-        {
-          frame.origin.y = value;
-        }
-        else if ([attributeName isEqualToString:@"width"])
-        {
-          frame.size.width = value;
-        }
-        else if ([attributeName isEqualToString:@"height"])
-        {
-          frame.size.height = value;
-        }
-      }
-    }
+    layer.frame = CGRectMake(values[idx * 4 + 0],
+                             values[idx * 4 + 1],
+                             values[idx * 4 + 2],
+                             values[idx * 4 + 3]);
+    
+  }];
+  
+  free(variableIDs);
+  free(values);
+}
+
+// ----- LAYOUT CACHE --------------------------------------------------------------------------------------------------
+#pragma mark Layout Cache
+
+/**
+ * Layouts are cached as the values of these layers' frames, in this order.
+ */
+- (NSArray *)layersWithFrameVariables
+{
+  NSArray * layers = [self.rootLayer subtreeLayers];
+  NSIndexSet * indexes = [layers indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
     
-    topLayer.frame = frame;
+    return ((VPLLayer *)obj).identifier != nil;
     
-    [stack addObjectsFromArray:topLayer.sublayers];
+  }];
+  return [layers objectsAtIndexes:indexes];
+}
+
+/**
+ * Fingerprints everything `-buildConstraints` and the size suggestions would give the solver.
+ */
+- (NSString *)layoutFingerprintWithSize:(CGSize)size
+                                 layers:(NSArray *)layers
+{
+  VPLLayoutFingerprint * fingerprint = [[VPLLayoutFingerprint alloc] init];
+  
+  // the root layer's origin constraints, in the form `-rootLayerOriginConstraints` gives them, 0 = -x
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  for (NSString * attribute in @[ @"x", @"y" ])
+  {
+    VPLTerm term = { [symbolTable variableIDForName:[self rootLayerVariableNameForAttribute:attribute]], -1.0 };
+    [fingerprint addConstraintWithExpression:[VPLLinearExpression expressionWithConstantValue:0.0
+                                                                                        terms:&term
+                                                                                        count:1]
+                                    relation:VPLConstraintRelationEqual
+                                    strength:VPLConstraintStrengthRequired];
+  }
+  
+  [self.rootLayer addSubtreeToLayoutFingerprint:fingerprint];
+  
+  [fingerprint addEditVariable:[self rootLayerVariableNameForAttribute:@"width"]
+                        weight:VPLAssetRepresentationSizeWeight
+                         value:size.width];
+  [fingerprint addEditVariable:[self rootLayerVariableNameForAttribute:@"height"]
+                        weight:VPLAssetRepresentationSizeWeight
+                         value:size.height];
+  
+  for (VPLLayer * layer in layers)
+  {
+    [fingerprint addResultVariable:[symbolTable nameForVariableID:layer.xVariableID]];
+    [fingerprint addResultVariable:[symbolTable nameForVariableID:layer.yVariableID]];
+    [fingerprint addResultVariable:[symbolTable nameForVariableID:layer.widthVariableID]];
+    [fingerprint addResultVariable:[symbolTable nameForVariableID:layer.heightVariableID]];
+  }
+  
+  return [fingerprint stringValue];
+}
+
+- (NSData *)valuesOfLayers:(NSArray *)layers
+{
+  NSMutableData * values = [[NSMutableData alloc] initWithLength:[layers count] * 4 * sizeof(double)];
+  double * layerValues = [values mutableBytes];
+  [layers enumerateObjectsUsingBlock:^(VPLLayer * layer, NSUInteger idx, BOOL *stop) {
+    
+    CGRect frame = layer.frame;
+    layerValues[idx * 4 + 0] = frame.origin.x;
+    layerValues[idx * 4 + 1] = frame.origin.y;
+    layerValues[idx * 4 + 2] = frame.size.width;
+    layerValues[idx * 4 + 3] = frame.size.height;
+    
+  }];
+  return values;
+}
+
+- (void)applyValues:(NSData *)values
+           toLayers:(NSArray *)layers
+{
+  const double * layerValues = [values bytes];
+  NSUInteger layerCount = MIN([layers count], [values length] / (4 * sizeof(double)));
+  for (NSUInteger layerIndex = 0; layerIndex < layerCount; layerIndex++)
+  {
+    VPLLayer * layer = [layers objectAtIndex:layerIndex];
+    layer.frame = CGRectMake(layerValues[layerIndex * 4 + 0],
+                             layerValues[layerIndex * 4 + 1],
+                             layerValues[layerIndex * 4 + 2],
+                             layerValues[layerIndex * 4 + 3]);
   }
 }
 
+- (void)invalidateLayout
+{
+  [self.rootLayer detachFromConstraintSet];
+  self.constraintSet = nil;
+}
+
 // ===== DRAWING =======================================================================================================
 #pragma mark - Drawing
 
@@ -260,7 +474,9 @@ CGImageWriteToFile(CGImageRef image, NSString * filename)
                                             self.rootLayer.frame.size.height);
   
   // draw in the context
+  uint64_t drawStartTime = VPLInstrumentationPhaseStart();
   [self.rootLayer drawInContext:ctx];
+  VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseDraw, drawStartTime);
   
   // create an image from the context
   CGImageRef imageRef = CGBitmapContextCreateImage(ctx);
@@ -275,7 +491,9 @@ CGImageWriteToFile(CGImageRef image, NSString * filename)
 {
   CGImageRef image = [self drawCGImage];
   
+  uint64_t encodeStartTime = VPLInstrumentationPhaseStart();
   NSError * writeError = CGImageWriteToFile(image, filename);
+  VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseEncodePNG, encodeStartTime);
   if (writeError != nil && error != NULL)
   {
     *error = writeError;
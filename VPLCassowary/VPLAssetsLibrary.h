@@ -1,5 +1,8 @@
 #import <Foundation/Foundation.h>
 
+@class VPLAsset;
+@class VPLAssetRepresentation;
+
 extern NSString * const VPLAssetsLibraryErrorDomain;
 
 typedef
@@ -15,15 +18,65 @@ VPLAssetsLibaryError;
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
+/**
+ * Loads a library from either its JSON form, or the binary form written by `VPLCompiledLibrary`. The file is memory
+ * mapped rather than read. A JSON library is only scanned for its assets and their representations' filenames, and
+ * each representation is parsed when it's first looked up.
+ */
 + (instancetype)assetsLibraryWithPath:(NSString *)libraryPath
                                 error:(NSError * __autoreleasing *)error;
 
++ (instancetype)assetsLibraryWithAssets:(NSArray *)assets;
+
 + (instancetype)assetsLibraryWithDictionary:(NSDictionary *)libraryDictionary
                                       error:(NSError * __autoreleasing *)error;
 
+/**
+ * Makes a library whose representations are loaded on demand, the way a library loaded from a file is. `titles` holds
+ * each asset's title, and `representationFilenames` an array of each asset's representations' filenames, in the same
+ * order, with `NSNull` standing in for a missing title or filename. `loader` creates a representation when it's looked
+ * up, given its asset and its position in both arrays; it may be called from several threads at once, and again for a
+ * representation that has been freed.
+ */
++ (instancetype)assetsLibraryWithAssetTitles:(NSArray *)titles
+                     representationFilenames:(NSArray *)representationFilenames
+                                      loader:(VPLAssetRepresentation * (^)(VPLAsset * asset,
+                                                                           NSUInteger assetIndex,
+                                                                           NSUInteger representationIndex))loader;
+
 // ===== ASSETS ========================================================================================================
 #pragma mark - Assets
 
 @property (nonatomic, strong, readonly) NSArray * assets;
 
+// ===== REPRESENTATIONS ===============================================================================================
+#pragma mark - Representations
+
+/**
+ * Returns the representation with the given filename, or nil. If several representations share a filename, the first
+ * one in the library is returned.
+ *
+ * The lookup goes through an index of every representation's filename. A library loaded from a file has its index
+ * from the start, and creates a representation when it's looked up; the library doesn't keep the representation, so
+ * it's freed once nothing else is using it, and created again by the next lookup. Looking up representations is safe
+ * from several threads at once.
+ *
+ * A library made from assets builds its index on first use, which creates every representation, so it should be done
+ * on one thread before representations are looked up from others.
+ */
+- (VPLAssetRepresentation *)representationWithFilename:(NSString *)filename;
+
+/**
+ * Returns the representations whose filenames match a shell-style `pattern` such as `@"*@2x.png"`, in library order.
+ * A nil pattern matches every representation. Every matching representation is created at once, so to go through a
+ * large library a representation at a time, use `-representationFilenamesMatchingPattern:` instead.
+ */
+- (NSArray *)representationsMatchingPattern:(NSString *)pattern;
+
+/**
+ * Returns the distinct filenames of the representations matching `pattern`, in library order, without creating any
+ * representations.
+ */
+- (NSArray *)representationFilenamesMatchingPattern:(NSString *)pattern;
+
 @end
@@ -5,23 +5,124 @@
 #import "VPLAssetsLibrary.h"
 #import "VPLCassowaryTypes.h"
 #import "VPLAsset.h"
+#import "VPLAssetRepresentation.h"
+#import "VPLCompiledLibrary.h"
+#import "VPLJSONScanner.h"
+#import <fnmatch.h>
 
 NSString * const VPLAssetsLibraryErrorDomain = @"com.vulpinelabs.VPLAssetLibrary";
 
 NSString * const VPLAssetsLibraryTypeKey = @"assets_library";
 NSString * const VPLAssetsLibraryAssetsKey = @"assets";
 
+static NSString * const VPLAssetsLibraryAssetTitleKey = @"title";
+static NSString * const VPLAssetsLibraryAssetRepresentationsKey = @"representations";
+static NSString * const VPLAssetsLibraryRepresentationFilenameKey = @"filename";
+
+// ===== ENTRIES =======================================================================================================
+#pragma mark - Entries
+
+/**
+ * A representation in the library's index. An entry either holds on to a representation that already exists, or
+ * knows how to load one, in which case it only keeps the representation for as long as something else does.
+ */
+@interface VPLAssetsLibraryEntry : NSObject
+
+@property (nonatomic, strong, readonly) NSString * filename;
+@property (nonatomic, weak, readwrite) VPLAsset * asset;
+
+@property (nonatomic, copy, readonly) VPLAssetRepresentation * (^loader)(VPLAsset * asset);
+@property (nonatomic, strong, readonly) VPLAssetRepresentation * retainedRepresentation;
+@property (nonatomic, weak, readwrite) VPLAssetRepresentation * loadedRepresentation;
+
+- (VPLAssetRepresentation *)representation;
+
+@end
+
+@implementation VPLAssetsLibraryEntry
+
+- (instancetype)initWithRepresentation:(VPLAssetRepresentation *)representation
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _filename = representation.filename;
+    _asset = representation.asset;
+    _retainedRepresentation = representation;
+  }
+  return self;
+}
+
+- (instancetype)initWithFilename:(NSString *)filename
+                          loader:(VPLAssetRepresentation * (^)(VPLAsset * asset))loader
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _filename = filename;
+    _loader = [loader copy];
+  }
+  return self;
+}
+
+- (VPLAssetRepresentation *)representation
+{
+  if (self.retainedRepresentation != nil)
+  {
+    return self.retainedRepresentation;
+  }
+  
+  // representations can be looked up from several threads, but each one should only be loaded once at a time
+  @synchronized (self)
+  {
+    VPLAssetRepresentation * representation = self.loadedRepresentation;
+    if (representation == nil)
+    {
+      representation = self.loader(self.asset);
+      self.loadedRepresentation = representation;
+    }
+    return representation;
+  }
+}
+
+@end
+
+// ===== ASSETS LIBRARY ================================================================================================
+#pragma mark - Assets Library
+
+@interface VPLAssetsLibrary ()
+
+@property (nonatomic, strong, readonly) NSArray * entries;
+@property (nonatomic, strong, readonly) NSDictionary * entriesByFilename;
+
+@end
+
 @implementation VPLAssetsLibrary
 
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
 - (instancetype)initWithAssets:(NSArray *)assets
+{
+  return [self initWithAssets:assets
+                      entries:nil];
+}
+
+/**
+ * `entries` is the library's index, if it's already known; otherwise it's built from the assets' representations when
+ * it's first needed.
+ */
+- (instancetype)initWithAssets:(NSArray *)assets
+                       entries:(NSArray *)entries
 {
   self = [super init];
   if (self != nil)
   {
     _assets = assets;
+    if (entries != nil)
+    {
+      [self setEntries:entries];
+    }
   }
   return self;
 }
@@ -29,37 +130,62 @@ NSString * const VPLAssetsLibraryAssetsKey = @"assets";
 + (instancetype)assetsLibraryWithPath:(NSString *)libraryPath
                                 error:(NSError * __autoreleasing *)error
 {
-  // load the library file
+  // Load the library file. Neither form is read all at once: a compiled library is read straight from the mapping, and
+  // a JSON library is scanned for its index, so only the pages that are needed are ever read in.
   NSData * libraryData = [NSData dataWithContentsOfFile:libraryPath
-                                                options:0
+                                                options:NSDataReadingMappedIfSafe
                                                   error:error];
   if (libraryData == nil)
   {
     return nil;
   }
   
-  id jsonObj = [NSJSONSerialization JSONObjectWithData:libraryData
-                                               options:0
-                                                 error:error];
-  if (jsonObj != nil)
+  if ([VPLCompiledLibrary isCompiledLibraryData:libraryData])
   {
-    if ([jsonObj isKindOfClass:[NSDictionary class]])
-    {
-      return [self assetsLibraryWithDictionary:jsonObj
-                                         error:error];
-    }
-    else
-    {
-      if (error != NULL)
-      {
-        NSString * localizedString = NSLocalizedString(@"Invalid asset library data", nil);
-        *error = [NSError errorWithDomain:VPLAssetsLibraryErrorDomain
-                                     code:VPLAssetsLibraryErrorInvalidContents
-                                 userInfo:@{ NSLocalizedDescriptionKey : localizedString }];
-      }
-    }
+    return [VPLCompiledLibrary assetsLibraryWithData:libraryData
+                                               error:error];
   }
-  return nil;
+  
+  return [self assetsLibraryWithJSONData:libraryData
+                                   error:error];
+}
+
++ (instancetype)assetsLibraryWithAssets:(NSArray *)assets
+{
+  return [[self alloc] initWithAssets:assets];
+}
+
++ (instancetype)assetsLibraryWithAssetTitles:(NSArray *)titles
+                     representationFilenames:(NSArray *)representationFilenames
+                                      loader:(VPLAssetRepresentation * (^)(VPLAsset * asset,
+                                                                           NSUInteger assetIndex,
+                                                                           NSUInteger representationIndex))loader
+{
+  NSMutableArray * assets = [[NSMutableArray alloc] initWithCapacity:[titles count]];
+  NSMutableArray * entries = [[NSMutableArray alloc] init];
+  [titles enumerateObjectsUsingBlock:^(id title, NSUInteger assetIndex, BOOL *stop) {
+    
+    NSArray * filenames = [representationFilenames objectAtIndex:assetIndex];
+    NSMutableArray * assetEntries = [[NSMutableArray alloc] initWithCapacity:[filenames count]];
+    [filenames enumerateObjectsUsingBlock:^(id filename, NSUInteger representationIndex, BOOL *stopFilenames) {
+      
+      filename = (filename != [NSNull null] ? filename : nil);
+      VPLAssetRepresentation * (^entryLoader)(VPLAsset *) = ^VPLAssetRepresentation *(VPLAsset * asset) {
+        return loader(asset, assetIndex, representationIndex);
+      };
+      [assetEntries addObject:[[VPLAssetsLibraryEntry alloc] initWithFilename:filename
+                                                                       loader:entryLoader]];
+      
+    }];
+    
+    [assets addObject:[self assetWithTitle:(title != [NSNull null] ? title : nil)
+                                   entries:assetEntries]];
+    [entries addObjectsFromArray:assetEntries];
+    
+  }];
+  
+  return [[self alloc] initWithAssets:assets
+                              entries:entries];
 }
 
 + (instancetype)assetsLibraryWithDictionary:(NSDictionary *)libraryDictionary
@@ -85,9 +211,309 @@ NSString * const VPLAssetsLibraryAssetsKey = @"assets";
   return [[self alloc] initWithAssets:assets];
 }
 
+// ----- STREAMING -----------------------------------------------------------------------------------------------------
+#pragma mark Streaming
+
+/**
+ * Scans a JSON library for its assets and the filename of each representation, skipping over everything else. Each
+ * representation's bytes are only parsed when the representation is loaded, so memory use depends on the largest
+ * representation rather than on the whole library.
+ */
++ (instancetype)assetsLibraryWithJSONData:(NSData *)libraryData
+                                    error:(NSError * __autoreleasing *)error
+{
+  VPLJSONScanner * scanner = [[VPLJSONScanner alloc] initWithData:libraryData];
+  
+  NSMutableArray * assets = [[NSMutableArray alloc] init];
+  NSMutableArray * entries = [[NSMutableArray alloc] init];
+  BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+    
+    if (![key isEqualToString:VPLAssetsLibraryAssetsKey])
+    {
+      return [scanner skipValue];
+    }
+    
+    return [scanner scanArrayUsingBlock:^BOOL(NSUInteger index) {
+      
+      VPLAsset * asset = [self scanAssetWithScanner:scanner
+                                            entries:entries];
+      if (asset != nil)
+      {
+        [assets addObject:asset];
+      }
+      return asset != nil;
+      
+    }];
+    
+  }];
+  
+  if (!didScan || ![scanner scanEnd])
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLAssetsLibraryErrorDomain
+                                   code:VPLAssetsLibraryErrorInvalidContents
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Invalid asset library data", nil),
+                  NSUnderlyingErrorKey : scanner.error
+                
+                }];
+    }
+    return nil;
+  }
+  
+  return [[self alloc] initWithAssets:assets
+                              entries:entries];
+}
+
++ (VPLAsset *)scanAssetWithScanner:(VPLJSONScanner *)scanner
+                           entries:(NSMutableArray *)entries
+{
+  __block NSString * title = nil;
+  NSMutableArray * assetEntries = [[NSMutableArray alloc] init];
+  BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+    
+    if ([key isEqualToString:VPLAssetsLibraryAssetTitleKey])
+    {
+      NSString * scannedTitle = nil;
+      BOOL didScanTitle = [scanner scanString:&scannedTitle];
+      title = scannedTitle;
+      return didScanTitle;
+    }
+    
+    if ([key isEqualToString:VPLAssetsLibraryAssetRepresentationsKey])
+    {
+      return [scanner scanArrayUsingBlock:^BOOL(NSUInteger index) {
+        
+        VPLAssetsLibraryEntry * entry = [self scanRepresentationEntryWithScanner:scanner];
+        if (entry != nil)
+        {
+          [assetEntries addObject:entry];
+        }
+        return entry != nil;
+        
+      }];
+    }
+    
+    return [scanner skipValue];
+    
+  }];
+  
+  if (!didScan)
+  {
+    return nil;
+  }
+  
+  VPLAsset * asset = [self assetWithTitle:title
+                                  entries:assetEntries];
+  [entries addObjectsFromArray:assetEntries];
+  
+  return asset;
+}
+
+/**
+ * Makes an asset for a library entry's representations. The asset's own representations come from the same entries as
+ * the library's lookups, so they're the same objects. The asset holds on to them once they've been asked for, though.
+ */
++ (VPLAsset *)assetWithTitle:(NSString *)title
+                     entries:(NSArray *)assetEntries
+{
+  VPLAsset * asset = [[VPLAsset alloc] initWithTitle:title
+                               representationFactory:^NSArray *(VPLAsset * representedAsset) {
+                                 
+                                 NSMutableArray * representations = [[NSMutableArray alloc] init];
+                                 for (VPLAssetsLibraryEntry * entry in assetEntries)
+                                 {
+                                   VPLAssetRepresentation * representation = [entry representation];
+                                   if (representation != nil)
+                                   {
+                                     [representations addObject:representation];
+                                   }
+                                 }
+                                 return representations;
+                                 
+                               }];
+  
+  for (VPLAssetsLibraryEntry * entry in assetEntries)
+  {
+    entry.asset = asset;
+  }
+  
+  return asset;
+}
+
++ (VPLAssetsLibraryEntry *)scanRepresentationEntryWithScanner:(VPLJSONScanner *)scanner
+{
+  NSUInteger start = [scanner locationOfNextValue];
+  
+  __block NSString * filename = nil;
+  BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+    
+    if ([key isEqualToString:VPLAssetsLibraryRepresentationFilenameKey])
+    {
+      NSString * scannedFilename = nil;
+      BOOL didScanFilename = [scanner scanString:&scannedFilename];
+      filename = scannedFilename;
+      return didScanFilename;
+    }
+    
+    return [scanner skipValue];
+    
+  }];
+  
+  if (!didScan)
+  {
+    return nil;
+  }
+  
+  // the loader keeps the library's data, which is usually mapped, and parses just this representation's bytes in place
+  NSData * libraryData = scanner.data;
+  NSRange representationRange = NSMakeRange(start, scanner.location - start);
+  VPLAssetRepresentation * (^loader)(VPLAsset *) = ^VPLAssetRepresentation *(VPLAsset * asset) {
+    
+    const uint8_t * representationBytes = (const uint8_t *)[libraryData bytes] + representationRange.location;
+    NSData * representationData = [NSData dataWithBytesNoCopy:(void *)representationBytes
+                                                        length:representationRange.length
+                                                  freeWhenDone:NO];
+    
+    NSError * error = nil;
+    NSDictionary * representationDictionary = [NSJSONSerialization JSONObjectWithData:representationData
+                                                                              options:0
+                                                                                error:&error];
+    VPLAssetRepresentation * representation = nil;
+    if (representationDictionary != nil)
+    {
+      representation = [VPLAssetRepresentation assetRepresentationWithDictionary:representationDictionary
+                                                                           asset:asset
+                                                                           error:&error];
+    }
+    
+    if (representation == nil)
+    {
+      NSLog(@"Error constructing representation: %@", [error localizedDescription]);
+    }
+    return representation;
+    
+  };
+  
+  return [[VPLAssetsLibraryEntry alloc] initWithFilename:filename
+                                                  loader:loader];
+}
+
 // ===== ASSETS ========================================================================================================
 #pragma mark - Assets
 
 @synthesize assets = _assets;
 
+// ===== REPRESENTATIONS ===============================================================================================
+#pragma mark - Representations
+
+@synthesize entries = _entries;
+@synthesize entriesByFilename = _entriesByFilename;
+
+- (void)setEntries:(NSArray *)entries
+{
+  NSMutableDictionary * entriesByFilename = [[NSMutableDictionary alloc] init];
+  for (VPLAssetsLibraryEntry * entry in entries)
+  {
+    // the first representation with a filename wins, as it would in a search through the assets
+    if (entry.filename != nil && [entriesByFilename objectForKey:entry.filename] == nil)
+    {
+      [entriesByFilename setObject:entry
+                            forKey:entry.filename];
+    }
+  }
+  
+  _entries = entries;
+  _entriesByFilename = entriesByFilename;
+}
+
+- (void)buildRepresentationIndex
+{
+  NSMutableArray * entries = [[NSMutableArray alloc] init];
+  for (VPLAsset * asset in self.assets)
+  {
+    for (VPLAssetRepresentation * representation in asset.representations)
+    {
+      [entries addObject:[[VPLAssetsLibraryEntry alloc] initWithRepresentation:representation]];
+    }
+  }
+  
+  [self setEntries:entries];
+}
+
+- (NSArray *)entries
+{
+  if (_entries == nil)
+  {
+    [self buildRepresentationIndex];
+  }
+  return _entries;
+}
+
+- (NSDictionary *)entriesByFilename
+{
+  if (_entriesByFilename == nil)
+  {
+    [self buildRepresentationIndex];
+  }
+  return _entriesByFilename;
+}
+
+- (VPLAssetRepresentation *)representationWithFilename:(NSString *)filename
+{
+  return [[self.entriesByFilename objectForKey:filename] representation];
+}
+
+- (NSArray *)entriesMatchingPattern:(NSString *)pattern
+{
+  NSArray * entries = self.entries;
+  if (pattern == nil)
+  {
+    return entries;
+  }
+  
+  const char * patternString = [pattern fileSystemRepresentation];
+  NSIndexSet * matchingIndexes = [entries indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+    
+    NSString * filename = ((VPLAssetsLibraryEntry *)obj).filename;
+    return filename != nil && fnmatch(patternString, [filename fileSystemRepresentation], 0) == 0;
+    
+  }];
+  
+  return [entries objectsAtIndexes:matchingIndexes];
+}
+
+- (NSArray *)representationsMatchingPattern:(NSString *)pattern
+{
+  NSArray * entries = [self entriesMatchingPattern:pattern];
+  
+  NSMutableArray * representations = [[NSMutableArray alloc] initWithCapacity:[entries count]];
+  for (VPLAssetsLibraryEntry * entry in entries)
+  {
+    VPLAssetRepresentation * representation = [entry representation];
+    if (representation != nil)
+    {
+      [representations addObject:representation];
+    }
+  }
+  
+  return representations;
+}
+
+- (NSArray *)representationFilenamesMatchingPattern:(NSString *)pattern
+{
+  NSMutableOrderedSet * filenames = [[NSMutableOrderedSet alloc] init];
+  for (VPLAssetsLibraryEntry * entry in [self entriesMatchingPattern:pattern])
+  {
+    if (entry.filename != nil)
+    {
+      [filenames addObject:entry.filename];
+    }
+  }
+  
+  return [filenames array];
+}
+
 @end
@@ -0,0 +1,59 @@
+#import <Foundation/Foundation.h>
+
+@class VPLAssetsLibrary;
+
+extern NSString * const VPLCompiledLibraryErrorDomain;
+
+typedef enum _VPLCompiledLibraryError {
+
+  VPLCompiledLibraryErrorNone = 0,
+  VPLCompiledLibraryErrorInvalidContents,
+  VPLCompiledLibraryErrorUnsupportedVersion,
+  VPLCompiledLibraryErrorWriteFailed
+
+} VPLCompiledLibraryError;
+
+/**
+ * Reads and writes the compiled form of an assets library: a flat binary file that can be memory mapped and used in
+ * place, instead of being parsed and built into objects up front.
+ *
+ * A compiled library holds a string table, a table of the variables used by its constraints, and flat tables of
+ * assets, representations, layers, layout constraints and terms that refer to each other by index. Each constraint is
+ * stored already normalized, as the terms of its expression without its marker variable, so loading it doesn't have to
+ * go through `VPLLinearExpression` arithmetic again. Variable names are interned into the shared symbol table once per
+ * library, not once per constraint.
+ *
+ * Loading checks the header and the bounds of each table, and reads the assets' titles and representations' filenames
+ * for the library's index. Each representation is built from the mapping when it's looked up, and isn't kept by the
+ * library, so only the representations that are actually used are ever paged in, and only while they're in use.
+ *
+ * Compiled libraries are written in the byte order of the machine that wrote them, and are rejected on a machine with
+ * a different one; they're a cache, and the JSON library they came from is the source of truth.
+ */
+@interface VPLCompiledLibrary : NSObject
+
+// ===== READING =======================================================================================================
+#pragma mark - Reading
+
+/**
+ * Returns YES if `data` starts with a compiled library's header. It doesn't check that the rest of the data is valid.
+ */
++ (BOOL)isCompiledLibraryData:(NSData *)data;
+
+/**
+ * Returns a library that reads its assets from `data` as they're needed. `data` is retained, so it can be a mapped
+ * file.
+ */
++ (VPLAssetsLibrary *)assetsLibraryWithData:(NSData *)data
+                                      error:(NSError * __autoreleasing *)error;
+
+// ===== WRITING =======================================================================================================
+#pragma mark - Writing
+
++ (NSData *)dataWithAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary;
+
++ (BOOL)writeAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+                    toFile:(NSString *)path
+                     error:(NSError * __autoreleasing *)error;
+
+@end
@@ -0,0 +1,1011 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLCompiledLibrary.h"
+#import "VPLAssetsLibrary.h"
+#import "VPLAsset.h"
+#import "VPLAssetRepresentation.h"
+#import "VPLLayer.h"
+#import "VPLLayoutConstraint.h"
+#import "VPLConstraint.h"
+#import "VPLLinearExpression.h"
+#import "VPLSymbolTable.h"
+
+NSString * const VPLCompiledLibraryErrorDomain = @"com.vulpinelabs.VPLCompiledLibrary";
+
+// ===== FORMAT ========================================================================================================
+#pragma mark - Format
+
+/**
+ * A compiled library is a header followed by its tables. Every table starts on an 8 byte boundary, and records refer
+ * to each other by their index in a table, with `VPLCompiledIndexNone` for "none". All values are in the byte order of
+ * the machine that wrote the file.
+ *
+ * A layer's sublayers, constraints and a constraint's terms are each contiguous runs of their tables, and the layers
+ * of a tree are written breadth first, so each layer's sublayers start right after the layers queued before them, and
+ * a tree is read back in the same single pass.
+ */
+static const char VPLCompiledLibraryMagic[4] = { 'V', 'P', 'L', 'C' };
+static const uint16_t VPLCompiledLibraryVersion = 2;
+static const uint16_t VPLCompiledLibraryByteOrderMark = 0xFEFF;
+
+#define VPLCompiledIndexNone UINT32_MAX
+#define VPLCompiledAlignment 8
+
+typedef enum _VPLCompiledSection {
+
+  VPLCompiledSectionStringOffsets = 0,    // one more offset than there are strings, so every string has an end
+  VPLCompiledSectionStringBytes,          // UTF-8, not terminated
+  VPLCompiledSectionVariables,            // the string index of each variable's name
+  VPLCompiledSectionAssets,
+  VPLCompiledSectionRepresentations,
+  VPLCompiledSectionLayers,
+  VPLCompiledSectionConstraints,
+  VPLCompiledSectionTerms,
+
+  VPLCompiledSectionCount
+
+} VPLCompiledSection;
+
+typedef struct _VPLCompiledSectionRange {
+
+  uint32_t offset;
+  uint32_t count;
+
+} VPLCompiledSectionRange;
+
+typedef struct _VPLCompiledLibraryHeader {
+
+  char magic[4];
+  uint16_t version;
+  uint16_t byteOrderMark;
+  VPLCompiledSectionRange sections[VPLCompiledSectionCount];
+
+} VPLCompiledLibraryHeader;
+
+typedef struct _VPLCompiledAsset {
+
+  uint32_t title;
+  uint32_t firstRepresentation;
+  uint32_t representationCount;
+  uint32_t reserved;
+
+} VPLCompiledAsset;
+
+typedef struct _VPLCompiledRepresentation {
+
+  uint32_t filename;
+  uint32_t rootLayer;
+  double width;
+  double height;
+
+} VPLCompiledRepresentation;
+
+typedef struct _VPLCompiledLayer {
+
+  uint32_t identifier;
+  uint32_t text;
+  uint32_t firstSublayer;
+  uint32_t sublayerCount;
+  uint32_t firstConstraint;
+  uint32_t constraintCount;
+  uint32_t hasBackgroundColor;
+  uint32_t reserved;
+  double backgroundColor[4];
+
+} VPLCompiledLayer;
+
+/**
+ * A layout constraint, and the constraint it builds. The constraint's expression is stored without its marker term,
+ * as `VPLConstraint` keeps it, since markers are handed out by the constraint set it's added to.
+ */
+typedef struct _VPLCompiledConstraint {
+
+  uint32_t subject;
+  uint32_t attribute;
+  uint32_t relationship;
+  uint32_t relatedObject;
+  uint32_t relatedAttribute;
+  uint32_t variableName;
+  uint32_t relatedVariableName;
+  int32_t relation;
+  double multiplier;
+  double constant;
+  uint32_t firstTerm;
+  uint32_t termCount;
+  int32_t strength;
+  uint32_t reserved;
+  double expressionConstant;
+  double markerCoefficient;
+
+} VPLCompiledConstraint;
+
+typedef struct _VPLCompiledTerm {
+
+  uint32_t variable;
+  uint32_t reserved;
+  double coefficient;
+
+} VPLCompiledTerm;
+
+_Static_assert(sizeof(VPLCompiledLibraryHeader) == 72, "compiled library header layout changed");
+_Static_assert(sizeof(VPLCompiledAsset) == 16, "compiled asset layout changed");
+_Static_assert(sizeof(VPLCompiledRepresentation) == 24, "compiled representation layout changed");
+_Static_assert(sizeof(VPLCompiledLayer) == 64, "compiled layer layout changed");
+_Static_assert(sizeof(VPLCompiledConstraint) == 80, "compiled constraint layout changed");
+_Static_assert(sizeof(VPLCompiledTerm) == 16, "compiled term layout changed");
+
+static const size_t VPLCompiledSectionElementSizes[VPLCompiledSectionCount] = {
+  sizeof(uint32_t),
+  sizeof(uint8_t),
+  sizeof(uint32_t),
+  sizeof(VPLCompiledAsset),
+  sizeof(VPLCompiledRepresentation),
+  sizeof(VPLCompiledLayer),
+  sizeof(VPLCompiledConstraint),
+  sizeof(VPLCompiledTerm),
+};
+
+static BOOL
+VPLCompiledRangeIsValid(uint32_t first, uint32_t count, uint32_t tableCount)
+{
+  return count == 0 || (first < tableCount && count <= tableCount - first);
+}
+
+static NSError *
+VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryError code, NSString * localizedDescription)
+{
+  return [NSError errorWithDomain:VPLCompiledLibraryErrorDomain
+                             code:code
+                         userInfo:@{ NSLocalizedDescriptionKey : localizedDescription }];
+}
+
+static int
+VPLTermCompare(const void * a, const void * b)
+{
+  VPLVariableID aVariableID = ((const VPLTerm *)a)->variableID;
+  VPLVariableID bVariableID = ((const VPLTerm *)b)->variableID;
+  return (aVariableID > bVariableID) - (aVariableID < bVariableID);
+}
+
+// ===== WRITER ========================================================================================================
+#pragma mark - Writer
+
+@interface VPLCompiledLibraryWriter : NSObject
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * stringIndexes;
+@property (nonatomic, strong, readonly) NSMutableDictionary * variableIndexes;
+@property (nonatomic, strong, readonly) NSArray * sections;
+
+- (void)addAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary;
+
+- (NSData *)data;
+
+@end
+
+@implementation VPLCompiledLibraryWriter
+
+- (instancetype)init
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _stringIndexes = [[NSMutableDictionary alloc] init];
+    _variableIndexes = [[NSMutableDictionary alloc] init];
+
+    NSMutableArray * sections = [[NSMutableArray alloc] initWithCapacity:VPLCompiledSectionCount];
+    for (NSUInteger section = 0; section < VPLCompiledSectionCount; section++)
+    {
+      [sections addObject:[[NSMutableData alloc] init]];
+    }
+    _sections = sections;
+  }
+  return self;
+}
+
+- (NSMutableData *)dataForSection:(VPLCompiledSection)section
+{
+  return [self.sections objectAtIndex:section];
+}
+
+- (uint32_t)countForSection:(VPLCompiledSection)section
+{
+  return (uint32_t)([[self dataForSection:section] length] / VPLCompiledSectionElementSizes[section]);
+}
+
+- (void)appendRecord:(const void *)record
+           toSection:(VPLCompiledSection)section
+{
+  [[self dataForSection:section] appendBytes:record
+                                      length:VPLCompiledSectionElementSizes[section]];
+}
+
+// ----- STRINGS -------------------------------------------------------------------------------------------------------
+#pragma mark Strings
+
+- (uint32_t)indexForString:(NSString *)string
+{
+  if (string == nil)
+  {
+    return VPLCompiledIndexNone;
+  }
+
+  NSNumber * stringIndex = [self.stringIndexes objectForKey:string];
+  if (stringIndex == nil)
+  {
+    stringIndex = @([self.stringIndexes count]);
+    [self.stringIndexes setObject:stringIndex
+                           forKey:string];
+
+    NSMutableData * stringBytes = [self dataForSection:VPLCompiledSectionStringBytes];
+    uint32_t offset = (uint32_t)[stringBytes length];
+    [self appendRecord:&offset
+             toSection:VPLCompiledSectionStringOffsets];
+    [stringBytes appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+  }
+
+  return [stringIndex unsignedIntValue];
+}
+
+- (uint32_t)indexForVariableID:(VPLVariableID)variableID
+{
+  NSNumber * variableKey = @(variableID);
+  NSNumber * variableIndex = [self.variableIndexes objectForKey:variableKey];
+  if (variableIndex == nil)
+  {
+    variableIndex = @([self countForSection:VPLCompiledSectionVariables]);
+    [self.variableIndexes setObject:variableIndex
+                             forKey:variableKey];
+
+    uint32_t nameIndex = [self indexForString:[[VPLSymbolTable sharedSymbolTable] nameForVariableID:variableID]];
+    [self appendRecord:&nameIndex
+             toSection:VPLCompiledSectionVariables];
+  }
+
+  return [variableIndex unsignedIntValue];
+}
+
+// ----- RECORDS -------------------------------------------------------------------------------------------------------
+#pragma mark Records
+
+- (void)addAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+{
+  for (VPLAsset * asset in assetsLibrary.assets)
+  {
+    [self addAsset:asset];
+  }
+}
+
+- (void)addAsset:(VPLAsset *)asset
+{
+  NSArray * representations = asset.representations;
+
+  VPLCompiledAsset record = {
+    .title = [self indexForString:asset.title],
+    .firstRepresentation = [self countForSection:VPLCompiledSectionRepresentations],
+    .representationCount = (uint32_t)[representations count],
+  };
+  [self appendRecord:&record
+           toSection:VPLCompiledSectionAssets];
+
+  for (VPLAssetRepresentation * representation in representations)
+  {
+    // the root layer's tree goes first, so the representation can refer to it
+    uint32_t rootLayerIndex = VPLCompiledIndexNone;
+    if (representation.rootLayer != nil)
+    {
+      rootLayerIndex = [self addLayerTree:representation.rootLayer];
+    }
+
+    VPLCompiledRepresentation representationRecord = {
+      .filename = [self indexForString:representation.filename],
+      .rootLayer = rootLayerIndex,
+      .width = representation.size.width,
+      .height = representation.size.height,
+    };
+    [self appendRecord:&representationRecord
+             toSection:VPLCompiledSectionRepresentations];
+  }
+}
+
+/**
+ * Writes a layer tree breadth first. Layers are written in the order they're queued, so each layer's sublayers are
+ * the next ones to be queued after it's written.
+ */
+- (uint32_t)addLayerTree:(VPLLayer *)rootLayer
+{
+  uint32_t rootLayerIndex = [self countForSection:VPLCompiledSectionLayers];
+
+  NSMutableArray * queue = [[NSMutableArray alloc] initWithObjects:rootLayer, nil];
+  for (NSUInteger queueIndex = 0; queueIndex < [queue count]; queueIndex++)
+  {
+    VPLLayer * layer = [queue objectAtIndex:queueIndex];
+
+    VPLCompiledLayer record = {
+      .identifier = [self indexForString:layer.identifier],
+      .text = [self indexForString:layer.text],
+      .firstSublayer = rootLayerIndex + (uint32_t)[queue count],
+      .sublayerCount = (uint32_t)[layer.sublayers count],
+      .firstConstraint = [self countForSection:VPLCompiledSectionConstraints],
+      .constraintCount = (uint32_t)[layer.layoutConstraints count],
+    };
+
+    CGColorRef backgroundColorRef = layer.backgroundColorRef;
+    if (backgroundColorRef != NULL)
+    {
+      const CGFloat * components = CGColorGetComponents(backgroundColorRef);
+      size_t componentCount = CGColorGetNumberOfComponents(backgroundColorRef);
+      if (componentCount == 4)
+      {
+        record.hasBackgroundColor = 1;
+        for (size_t component = 0; component < 4; component++)
+        {
+          record.backgroundColor[component] = components[component];
+        }
+      }
+      else if (componentCount == 2)
+      {
+        // gray and alpha
+        record.hasBackgroundColor = 1;
+        record.backgroundColor[0] = record.backgroundColor[1] = record.backgroundColor[2] = components[0];
+        record.backgroundColor[3] = components[1];
+      }
+      else
+      {
+        NSLog(@"%@: not compiling background color with %zu components", layer.identifier, componentCount);
+      }
+    }
+
+    [self appendRecord:&record
+             toSection:VPLCompiledSectionLayers];
+
+    for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+    {
+      [self addLayoutConstraint:layoutConstraint];
+    }
+
+    [queue addObjectsFromArray:layer.sublayers];
+  }
+
+  return rootLayerIndex;
+}
+
+- (void)addLayoutConstraint:(VPLLayoutConstraint *)layoutConstraint
+{
+  VPLConstraint * constraint = layoutConstraint.constraint;
+  VPLLinearExpression * normalizedExpression = constraint.expression;
+
+  VPLCompiledConstraint record = {
+    .subject = [self indexForString:layoutConstraint.subject],
+    .attribute = [self indexForString:layoutConstraint.attribute],
+    .relationship = [self indexForString:layoutConstraint.relationship],
+    .relatedObject = [self indexForString:layoutConstraint.relatedObject],
+    .relatedAttribute = [self indexForString:layoutConstraint.relatedObjectAttribute],
+    .variableName = [self indexForString:constraint.variableName],
+    .relatedVariableName = [self indexForString:constraint.relatedVariableName],
+    .relation = constraint.relation,
+    .multiplier = constraint.multiplier,
+    .constant = constraint.constant,
+    .firstTerm = [self countForSection:VPLCompiledSectionTerms],
+    .termCount = (uint32_t)normalizedExpression.termCount,
+    .strength = constraint.strength,
+    .expressionConstant = normalizedExpression.constantValue,
+    .markerCoefficient = constraint.markerCoefficient,
+  };
+  [self appendRecord:&record
+           toSection:VPLCompiledSectionConstraints];
+
+  const VPLTerm * terms = normalizedExpression.terms;
+  for (NSUInteger termIndex = 0; termIndex < normalizedExpression.termCount; termIndex++)
+  {
+    VPLCompiledTerm termRecord = {
+      .variable = [self indexForVariableID:terms[termIndex].variableID],
+      .coefficient = terms[termIndex].coefficient,
+    };
+    [self appendRecord:&termRecord
+             toSection:VPLCompiledSectionTerms];
+  }
+}
+
+// ----- DATA ----------------------------------------------------------------------------------------------------------
+#pragma mark Data
+
+- (NSData *)data
+{
+  // close off the last string
+  uint32_t stringCount = [self countForSection:VPLCompiledSectionStringOffsets];
+  uint32_t stringBytesEnd = (uint32_t)[[self dataForSection:VPLCompiledSectionStringBytes] length];
+  [self appendRecord:&stringBytesEnd
+           toSection:VPLCompiledSectionStringOffsets];
+
+  VPLCompiledLibraryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, VPLCompiledLibraryMagic, sizeof(header.magic));
+  header.version = VPLCompiledLibraryVersion;
+  header.byteOrderMark = VPLCompiledLibraryByteOrderMark;
+
+  NSMutableData * data = [[NSMutableData alloc] initWithLength:sizeof(header)];
+  for (NSUInteger section = 0; section < VPLCompiledSectionCount; section++)
+  {
+    [data increaseLengthBy:(VPLCompiledAlignment - [data length] % VPLCompiledAlignment) % VPLCompiledAlignment];
+
+    NSData * sectionData = [self dataForSection:(VPLCompiledSection)section];
+    header.sections[section].offset = (uint32_t)[data length];
+    header.sections[section].count = (section == VPLCompiledSectionStringOffsets
+                                      ? stringCount
+                                      : [self countForSection:(VPLCompiledSection)section]);
+    [data appendData:sectionData];
+  }
+
+  // offsets are 32 bits
+  if ([data length] > UINT32_MAX)
+  {
+    return nil;
+  }
+
+  [data replaceBytesInRange:NSMakeRange(0, sizeof(header))
+                  withBytes:&header];
+  return data;
+}
+
+@end
+
+// ===== READER ========================================================================================================
+#pragma mark - Reader
+
+/**
+ * Builds objects from a compiled library's data. An asset's representations can be asked for from any thread, so
+ * materializing them, and the string and variable caches they use, are synchronized on the reader.
+ */
+@interface VPLCompiledLibraryReader : NSObject
+{
+  const uint32_t * _stringOffsets;
+  const uint8_t * _stringBytes;
+  const uint32_t * _variables;
+  const VPLCompiledAsset * _assets;
+  const VPLCompiledRepresentation * _representations;
+  const VPLCompiledLayer * _layers;
+  const VPLCompiledConstraint * _constraints;
+  const VPLCompiledTerm * _terms;
+
+  uint32_t _counts[VPLCompiledSectionCount];
+
+  // interned on first use, VPLVariableIDNone until then
+  VPLVariableID * _variableIDs;
+}
+
+- (instancetype)initWithData:(NSData *)data
+                       error:(NSError * __autoreleasing *)error;
+
+@property (nonatomic, strong, readonly) NSData * data;
+@property (nonatomic, strong, readonly) NSMutableDictionary * strings;
+
+- (VPLAssetsLibrary *)assetsLibrary:(NSError * __autoreleasing *)error;
+
+@end
+
+@implementation VPLCompiledLibraryReader
+
+- (instancetype)initWithData:(NSData *)data
+                       error:(NSError * __autoreleasing *)error
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _data = data;
+    _strings = [[NSMutableDictionary alloc] init];
+
+    const uint8_t * bytes = [data bytes];
+    NSUInteger length = [data length];
+
+    VPLCompiledLibraryHeader header;
+    if (length < sizeof(header))
+    {
+      if (error != NULL)
+      {
+        *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorInvalidContents,
+                                                 NSLocalizedString(@"Compiled library is truncated", nil));
+      }
+      return nil;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    if (memcmp(header.magic, VPLCompiledLibraryMagic, sizeof(header.magic)) != 0)
+    {
+      if (error != NULL)
+      {
+        *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorInvalidContents,
+                                                 NSLocalizedString(@"Not a compiled library", nil));
+      }
+      return nil;
+    }
+
+    if (header.byteOrderMark != VPLCompiledLibraryByteOrderMark)
+    {
+      if (error != NULL)
+      {
+        NSString * description = NSLocalizedString(@"Compiled library was written with a different byte order", nil);
+        *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorUnsupportedVersion, description);
+      }
+      return nil;
+    }
+
+    if (header.version != VPLCompiledLibraryVersion)
+    {
+      if (error != NULL)
+      {
+        NSString * localizedErrorFormat = NSLocalizedString(@"Unsupported compiled library version (%u)", nil);
+        NSString * description = [NSString stringWithFormat:localizedErrorFormat, (unsigned int)header.version];
+        *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorUnsupportedVersion, description);
+      }
+      return nil;
+    }
+
+    // Only the tables' bounds are checked here, so that loading doesn't touch every page. Indexes within records are
+    // checked as the records are read.
+    const void * sectionBytes[VPLCompiledSectionCount];
+    for (NSUInteger section = 0; section < VPLCompiledSectionCount; section++)
+    {
+      VPLCompiledSectionRange range = header.sections[section];
+      uint64_t elementCount = (uint64_t)range.count + (section == VPLCompiledSectionStringOffsets ? 1 : 0);
+      uint64_t sectionLength = elementCount * VPLCompiledSectionElementSizes[section];
+      if (range.offset % VPLCompiledAlignment != 0 || range.offset > length || sectionLength > length - range.offset)
+      {
+        if (error != NULL)
+        {
+          *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorInvalidContents,
+                                                   NSLocalizedString(@"Compiled library has an invalid table", nil));
+        }
+        return nil;
+      }
+
+      sectionBytes[section] = bytes + range.offset;
+      _counts[section] = range.count;
+    }
+
+    _stringOffsets = sectionBytes[VPLCompiledSectionStringOffsets];
+    _stringBytes = sectionBytes[VPLCompiledSectionStringBytes];
+    _variables = sectionBytes[VPLCompiledSectionVariables];
+    _assets = sectionBytes[VPLCompiledSectionAssets];
+    _representations = sectionBytes[VPLCompiledSectionRepresentations];
+    _layers = sectionBytes[VPLCompiledSectionLayers];
+    _constraints = sectionBytes[VPLCompiledSectionConstraints];
+    _terms = sectionBytes[VPLCompiledSectionTerms];
+
+    _variableIDs = calloc(MAX(_counts[VPLCompiledSectionVariables], 1), sizeof(VPLVariableID));
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  free(_variableIDs);
+}
+
+// ----- STRINGS -------------------------------------------------------------------------------------------------------
+#pragma mark Strings
+
+/**
+ * Strings are copied out of the data, since `NSString`s can't refer to bytes they don't own. Each one is only copied
+ * once.
+ */
+- (BOOL)getString:(NSString * __autoreleasing *)string
+          atIndex:(uint32_t)stringIndex
+{
+  if (stringIndex == VPLCompiledIndexNone)
+  {
+    *string = nil;
+    return YES;
+  }
+
+  if (stringIndex >= _counts[VPLCompiledSectionStringOffsets])
+  {
+    return NO;
+  }
+
+  NSNumber * stringKey = @(stringIndex);
+  NSString * cachedString = [self.strings objectForKey:stringKey];
+  if (cachedString == nil)
+  {
+    uint32_t start = _stringOffsets[stringIndex];
+    uint32_t end = _stringOffsets[stringIndex + 1];
+    if (start > end || end > _counts[VPLCompiledSectionStringBytes])
+    {
+      return NO;
+    }
+
+    cachedString = [[NSString alloc] initWithBytes:_stringBytes + start
+                                            length:end - start
+                                          encoding:NSUTF8StringEncoding];
+    if (cachedString == nil)
+    {
+      return NO;
+    }
+
+    [self.strings setObject:cachedString
+                     forKey:stringKey];
+  }
+
+  *string = cachedString;
+  return YES;
+}
+
+- (VPLVariableID)variableIDAtIndex:(uint32_t)variableIndex
+{
+  if (variableIndex >= _counts[VPLCompiledSectionVariables])
+  {
+    return VPLVariableIDNone;
+  }
+
+  if (_variableIDs[variableIndex] == VPLVariableIDNone)
+  {
+    NSString * variableName = nil;
+    if (![self getString:&variableName atIndex:_variables[variableIndex]] || variableName == nil)
+    {
+      return VPLVariableIDNone;
+    }
+
+    _variableIDs[variableIndex] = [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName];
+  }
+
+  return _variableIDs[variableIndex];
+}
+
+// ----- ASSETS --------------------------------------------------------------------------------------------------------
+#pragma mark Assets
+
+/**
+ * Reads the assets' titles and their representations' filenames, which is all the library's index needs. Each
+ * representation is built from its record when the library looks it up.
+ */
+- (VPLAssetsLibrary *)assetsLibrary:(NSError * __autoreleasing *)error
+{
+  uint32_t assetCount = _counts[VPLCompiledSectionAssets];
+  NSMutableArray * titles = [[NSMutableArray alloc] initWithCapacity:assetCount];
+  NSMutableArray * representationFilenames = [[NSMutableArray alloc] initWithCapacity:assetCount];
+
+  @synchronized(self)
+  {
+    for (uint32_t assetIndex = 0; assetIndex < assetCount; assetIndex++)
+    {
+      const VPLCompiledAsset * record = &_assets[assetIndex];
+
+      NSString * title = nil;
+      NSMutableArray * filenames = [[NSMutableArray alloc] initWithCapacity:record->representationCount];
+      BOOL assetIsValid = ([self getString:&title atIndex:record->title]
+                           && VPLCompiledRangeIsValid(record->firstRepresentation,
+                                                      record->representationCount,
+                                                      _counts[VPLCompiledSectionRepresentations]));
+      for (uint32_t offset = 0; assetIsValid && offset < record->representationCount; offset++)
+      {
+        uint32_t representationIndex = record->firstRepresentation + offset;
+        NSString * filename = nil;
+        assetIsValid = [self getString:&filename atIndex:_representations[representationIndex].filename];
+        [filenames addObject:(filename != nil ? filename : [NSNull null])];
+      }
+
+      if (!assetIsValid)
+      {
+        if (error != NULL)
+        {
+          NSString * localizedErrorFormat = NSLocalizedString(@"Compiled library has an invalid asset (%u)", nil);
+          NSString * description = [NSString stringWithFormat:localizedErrorFormat, assetIndex];
+          *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorInvalidContents, description);
+        }
+        return nil;
+      }
+
+      [titles addObject:(title != nil ? title : [NSNull null])];
+      [representationFilenames addObject:filenames];
+    }
+  }
+
+  // the library keeps the reader, and so the data, alive for as long as it may load representations
+  return [VPLAssetsLibrary assetsLibraryWithAssetTitles:titles
+                                representationFilenames:representationFilenames
+                                                 loader:^VPLAssetRepresentation *(VPLAsset * asset,
+                                                                                  NSUInteger assetIndex,
+                                                                                  NSUInteger representationIndex) {
+
+                                                   return [self representationForAsset:asset
+                                                                               atIndex:(uint32_t)assetIndex
+                                                                                offset:(uint32_t)representationIndex];
+
+                                                 }];
+}
+
+- (VPLAssetRepresentation *)representationForAsset:(VPLAsset *)asset
+                                           atIndex:(uint32_t)assetIndex
+                                            offset:(uint32_t)offset
+{
+  @synchronized(self)
+  {
+    uint32_t representationIndex = _assets[assetIndex].firstRepresentation + offset;
+    VPLAssetRepresentation * representation = [self representationAtIndex:representationIndex
+                                                                     asset:asset];
+    if (representation == nil)
+    {
+      NSLog(@"Error constructing representation: invalid compiled representation (%u)", representationIndex);
+    }
+
+    return representation;
+  }
+}
+
+- (VPLAssetRepresentation *)representationAtIndex:(uint32_t)representationIndex
+                                            asset:(VPLAsset *)asset
+{
+  const VPLCompiledRepresentation * record = &_representations[representationIndex];
+
+  NSString * filename = nil;
+  if (![self getString:&filename atIndex:record->filename])
+  {
+    return nil;
+  }
+
+  VPLLayer * rootLayer = nil;
+  if (record->rootLayer != VPLCompiledIndexNone)
+  {
+    rootLayer = [self layerTreeAtIndex:record->rootLayer];
+    if (rootLayer == nil)
+    {
+      return nil;
+    }
+  }
+
+  return [[VPLAssetRepresentation alloc] initWithAsset:asset
+                                              filename:filename
+                                                  size:CGSizeMake(record->width, record->height)
+                                             rootLayer:rootLayer];
+}
+
+// ----- LAYERS --------------------------------------------------------------------------------------------------------
+#pragma mark Layers
+
+/**
+ * Reads a layer tree the way `addLayerTree:` wrote it, breadth first. Each layer's sublayers must be the next run of
+ * layers after those already queued, so every layer is read once and only once, without recursing, however the file
+ * was put together.
+ */
+- (VPLLayer *)layerTreeAtIndex:(uint32_t)rootLayerIndex
+{
+  if (rootLayerIndex >= _counts[VPLCompiledSectionLayers])
+  {
+    return nil;
+  }
+
+  NSMutableArray * layers = [[NSMutableArray alloc] init];
+  uint32_t queueEnd = rootLayerIndex + 1;
+  for (uint32_t layerIndex = rootLayerIndex; layerIndex < queueEnd; layerIndex++)
+  {
+    const VPLCompiledLayer * record = &_layers[layerIndex];
+    if (record->firstSublayer != queueEnd
+        || !VPLCompiledRangeIsValid(record->firstSublayer, record->sublayerCount, _counts[VPLCompiledSectionLayers]))
+    {
+      return nil;
+    }
+    queueEnd += record->sublayerCount;
+
+    VPLLayer * layer = [self layerAtIndex:layerIndex];
+    if (layer == nil)
+    {
+      return nil;
+    }
+    [layers addObject:layer];
+  }
+
+  for (uint32_t queueIndex = 0; queueIndex < [layers count]; queueIndex++)
+  {
+    const VPLCompiledLayer * record = &_layers[rootLayerIndex + queueIndex];
+    VPLLayer * layer = [layers objectAtIndex:queueIndex];
+    for (uint32_t offset = 0; offset < record->sublayerCount; offset++)
+    {
+      [layer addSublayer:[layers objectAtIndex:record->firstSublayer - rootLayerIndex + offset]];
+    }
+  }
+
+  return [layers objectAtIndex:0];
+}
+
+/**
+ * Reads a single layer, without its sublayers.
+ */
+- (VPLLayer *)layerAtIndex:(uint32_t)layerIndex
+{
+  const VPLCompiledLayer * record = &_layers[layerIndex];
+
+  if (!VPLCompiledRangeIsValid(record->firstConstraint,
+                               record->constraintCount,
+                               _counts[VPLCompiledSectionConstraints]))
+  {
+    return nil;
+  }
+
+  NSString * identifier = nil;
+  NSString * text = nil;
+  if (![self getString:&identifier atIndex:record->identifier] || ![self getString:&text atIndex:record->text])
+  {
+    return nil;
+  }
+
+  NSMutableArray * layoutConstraints = [[NSMutableArray alloc] initWithCapacity:record->constraintCount];
+  for (uint32_t offset = 0; offset < record->constraintCount; offset++)
+  {
+    VPLLayoutConstraint * layoutConstraint = [self layoutConstraintAtIndex:record->firstConstraint + offset];
+    if (layoutConstraint == nil)
+    {
+      return nil;
+    }
+    [layoutConstraints addObject:layoutConstraint];
+  }
+
+  VPLLayer * layer = [[VPLLayer alloc] initWithIdentifier:identifier
+                                        layoutConstraints:layoutConstraints];
+  layer.text = text;
+
+  if (record->hasBackgroundColor)
+  {
+    CGColorRef backgroundColorRef = CGColorCreateGenericRGB(record->backgroundColor[0],
+                                                            record->backgroundColor[1],
+                                                            record->backgroundColor[2],
+                                                            record->backgroundColor[3]);
+    layer.backgroundColorRef = backgroundColorRef;
+    CGColorRelease(backgroundColorRef);
+  }
+
+  return layer;
+}
+
+// ----- CONSTRAINTS ---------------------------------------------------------------------------------------------------
+#pragma mark Constraints
+
+- (VPLLayoutConstraint *)layoutConstraintAtIndex:(uint32_t)constraintIndex
+{
+  const VPLCompiledConstraint * record = &_constraints[constraintIndex];
+
+  if (record->relation != VPLConstraintRelationLessThanOrEqual
+      && record->relation != VPLConstraintRelationEqual
+      && record->relation != VPLConstraintRelationGreaterThanOrEqual)
+  {
+    return nil;
+  }
+
+  if (VPLConstraintStrengthName((VPLConstraintStrength)record->strength) == nil)
+  {
+    return nil;
+  }
+
+  if (!VPLCompiledRangeIsValid(record->firstTerm, record->termCount, _counts[VPLCompiledSectionTerms]))
+  {
+    return nil;
+  }
+
+  NSString * subject = nil;
+  NSString * attribute = nil;
+  NSString * relationship = nil;
+  NSString * relatedObject = nil;
+  NSString * relatedAttribute = nil;
+  NSString * variableName = nil;
+  NSString * relatedVariableName = nil;
+  if (![self getString:&subject atIndex:record->subject]
+      || ![self getString:&attribute atIndex:record->attribute]
+      || ![self getString:&relationship atIndex:record->relationship]
+      || ![self getString:&relatedObject atIndex:record->relatedObject]
+      || ![self getString:&relatedAttribute atIndex:record->relatedAttribute]
+      || ![self getString:&variableName atIndex:record->variableName]
+      || ![self getString:&relatedVariableName atIndex:record->relatedVariableName]
+      || variableName == nil)
+  {
+    return nil;
+  }
+
+  // Variable ids depend on the order names were interned in this process, so the terms have to be sorted again. A
+  // repeated variable means the terms weren't written by a compiler.
+  VPLTerm * terms = malloc(MAX(record->termCount, 1) * sizeof(VPLTerm));
+  BOOL termsAreValid = YES;
+  for (uint32_t offset = 0; offset < record->termCount && termsAreValid; offset++)
+  {
+    const VPLCompiledTerm * termRecord = &_terms[record->firstTerm + offset];
+    terms[offset].variableID = [self variableIDAtIndex:termRecord->variable];
+    terms[offset].coefficient = termRecord->coefficient;
+    termsAreValid = (terms[offset].variableID != VPLVariableIDNone);
+  }
+
+  if (termsAreValid)
+  {
+    qsort(terms, record->termCount, sizeof(VPLTerm), VPLTermCompare);
+    for (uint32_t termIndex = 1; termIndex < record->termCount && termsAreValid; termIndex++)
+    {
+      termsAreValid = (terms[termIndex - 1].variableID != terms[termIndex].variableID);
+    }
+  }
+
+  VPLLinearExpression * normalizedExpression = nil;
+  if (termsAreValid)
+  {
+    normalizedExpression = [VPLLinearExpression expressionWithConstantValue:record->expressionConstant
+                                                                      terms:terms
+                                                                      count:record->termCount];
+  }
+  free(terms);
+
+  if (normalizedExpression == nil)
+  {
+    return nil;
+  }
+
+  VPLConstraint * constraint = [[VPLConstraint alloc] initWithVariable:variableName
+                                                             relatedBy:(VPLConstraintRelation)record->relation
+                                                            toVariable:relatedVariableName
+                                                            multiplier:record->multiplier
+                                                              constant:record->constant
+                                                  normalizedExpression:normalizedExpression
+                                                     markerCoefficient:record->markerCoefficient];
+  constraint.strength = (VPLConstraintStrength)record->strength;
+
+  return [[VPLLayoutConstraint alloc] initWithSubject:subject
+                                            attribute:attribute
+                                         relationship:relationship
+                                        relatedObject:relatedObject
+                                     relatedAttribute:relatedAttribute
+                                           multiplier:record->multiplier
+                                             constant:record->constant
+                                           constraint:constraint];
+}
+
+@end
+
+// ===== COMPILED LIBRARY ==============================================================================================
+#pragma mark - Compiled Library
+
+@implementation VPLCompiledLibrary
+
+// ===== READING =======================================================================================================
+#pragma mark - Reading
+
++ (BOOL)isCompiledLibraryData:(NSData *)data
+{
+  return ([data length] >= sizeof(VPLCompiledLibraryHeader)
+          && memcmp([data bytes], VPLCompiledLibraryMagic, sizeof(VPLCompiledLibraryMagic)) == 0);
+}
+
++ (VPLAssetsLibrary *)assetsLibraryWithData:(NSData *)data
+                                      error:(NSError * __autoreleasing *)error
+{
+  VPLCompiledLibraryReader * reader = [[VPLCompiledLibraryReader alloc] initWithData:data
+                                                                               error:error];
+  return [reader assetsLibrary:error];
+}
+
+// ===== WRITING =======================================================================================================
+#pragma mark - Writing
+
++ (NSData *)dataWithAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+{
+  VPLCompiledLibraryWriter * writer = [[VPLCompiledLibraryWriter alloc] init];
+  [writer addAssetsLibrary:assetsLibrary];
+  return [writer data];
+}
+
++ (BOOL)writeAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+                    toFile:(NSString *)path
+                     error:(NSError * __autoreleasing *)error
+{
+  NSData * data = [self dataWithAssetsLibrary:assetsLibrary];
+  if (data == nil)
+  {
+    if (error != NULL)
+    {
+      *error = VPLCompiledLibraryErrorWithCode(VPLCompiledLibraryErrorWriteFailed,
+                                               NSLocalizedString(@"Library is too large to compile", nil));
+    }
+    return NO;
+  }
+
+  return [data writeToFile:[path stringByExpandingTildeInPath]
+                   options:NSDataWritingAtomic
+                     error:error];
+}
+
+@end
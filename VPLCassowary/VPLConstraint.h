@@ -1,4 +1,5 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLSymbolTable.h"
 @class VPLLinearExpression;
 
 typedef enum _VPLConstraintRelation {
@@ -9,6 +10,36 @@ typedef enum _VPLConstraintRelation {
   
 } VPLConstraintRelation;
 
+/**
+ * How strongly a constraint holds. Required constraints must be satisfied, and adding one that can't be is an error.
+ * Any other constraint is a preference: it's satisfied as nearly as the required constraints allow, and its error is
+ * minimized along with those of the edit variables, multiplied by `VPLConstraintStrengthWeight()`.
+ */
+typedef enum _VPLConstraintStrength {
+  
+  VPLConstraintStrengthRequired = 0,
+  VPLConstraintStrengthStrong = 1,
+  VPLConstraintStrengthMedium = 2,
+  VPLConstraintStrengthWeak = 3
+  
+} VPLConstraintStrength;
+
+/**
+ * The weight of a preference's error in the objective, on the same scale as edit variable weights. Weak and medium
+ * constraints give way to edit variables of the default weight of 1, and strong ones don't; every strength gives way to
+ * layers' intrinsic sizes and to the size an asset is drawn at, which are weighted far higher. Each strength is weighted
+ * 100 times the next weaker one. Required constraints aren't weighted, and return 0.
+ */
+CGFloat VPLConstraintStrengthWeight(VPLConstraintStrength strength);
+
+/**
+ * Returns the strength named `required`, `strong`, `medium` or `weak`, or `VPLConstraintStrengthRequired` for nil.
+ * Returns NO for any other name.
+ */
+BOOL VPLConstraintStrengthFromName(NSString * name, VPLConstraintStrength * strength);
+
+NSString * VPLConstraintStrengthName(VPLConstraintStrength strength);
+
 /**
  * Expresses a constraint relating two variables with each other in the form of:
  *
@@ -19,6 +50,7 @@ typedef enum _VPLConstraintRelation {
  *    v <= m*x + b
  *    v >= m*x + b
  *
+ * Constraints are required unless they're given another `strength`.
  */
 @interface VPLConstraint : NSObject
 
@@ -30,6 +62,30 @@ typedef enum _VPLConstraintRelation {
                             multiplier:(CGFloat)multiplier
                               constant:(CGFloat)constant;
 
+/**
+ * Creates a constraint whose expression has already been built, such as one read from a compiled library.
+ * `normalizedExpression` is the constraint's expression without its marker variable, and `markerCoefficient` is the
+ * marker's coefficient in it.
+ */
+- (id)initWithVariable:(NSString *)variableName
+             relatedBy:(VPLConstraintRelation)relation
+            toVariable:(NSString *)relatedVariableName
+            multiplier:(CGFloat)multiplier
+              constant:(CGFloat)constant
+  normalizedExpression:(VPLLinearExpression *)normalizedExpression
+     markerCoefficient:(CGFloat)markerCoefficient;
+
+/**
+ * Creates the constraint `leftExpression relation rightExpression` between two linear expressions, such as one parsed
+ * from constraint text. The constraint is named after `variableName`, which should appear in one of them. A constraint
+ * of the form `v = m*x + b` gets its related variable, multiplier and constant as usual; any other only has its
+ * expression, and its constant is the difference of the two sides' constants.
+ */
+- (id)initWithVariable:(NSString *)variableName
+        leftExpression:(VPLLinearExpression *)leftExpression
+             relatedBy:(VPLConstraintRelation)relation
+       rightExpression:(VPLLinearExpression *)rightExpression;
+
 // ===== VARIABLE ======================================================================================================
 
 @property (nonatomic, strong, readonly) NSString * variableName;
@@ -38,6 +94,16 @@ typedef enum _VPLConstraintRelation {
 
 @property (nonatomic, assign, readonly) VPLConstraintRelation relation;
 
+// ===== STRENGTH ======================================================================================================
+
+/**
+ * Defaults to `VPLConstraintStrengthRequired`. It can only be changed before the constraint is added to a constraint
+ * set, since the solver gives a preference error variables of its own when it's added.
+ */
+@property (nonatomic, assign) VPLConstraintStrength strength;
+
+- (BOOL)isRequired;
+
 // ===== RELATED VARIABLE ==============================================================================================
 
 @property (nonatomic, strong, readonly) NSString * relatedVariableName;
@@ -46,7 +112,24 @@ typedef enum _VPLConstraintRelation {
 
 // ===== EXPRESSION ====================================================================================================
 
+/**
+ * The constraint as `0 = expression + markerCoefficient * marker`, without its marker term. A constraint doesn't own a
+ * marker: the constraint set it's added to hands it an anonymous one of `markerVariableKind`, and takes it back when
+ * the constraint is removed, so constraints that come and go don't leave markers behind in the symbol table.
+ */
 @property (nonatomic, strong, readonly) VPLLinearExpression * expression;
-@property (nonatomic, strong, readonly) NSString * markerVariableName;
+@property (nonatomic, assign, readonly) CGFloat markerCoefficient;
+@property (nonatomic, assign, readonly) VPLVariableKind markerVariableKind;
+
+/**
+ * The interned id of `variableName`, so the solver can find the constraint in the tableau without going through the
+ * symbol table.
+ */
+@property (nonatomic, assign, readonly) VPLVariableID variableID;
+
+/**
+ * Returns `expression` with the marker's term added, which is what the solver adds to its tableau.
+ */
+- (VPLLinearExpression *)expressionWithMarkerVariableID:(VPLVariableID)markerVariableID;
 
 @end
@@ -5,11 +5,97 @@
 #import "VPLConstraint.h"
 #import "VPLLinearExpression.h"
 
-static int64_t
-VPLConstraintGenerateMarkerNumber()
+/**
+ * Convert inequalities to an equality, with a 'marker' variable to help identify the constraint's effect in the
+ * tableau. Inequalities need a slack variable, which can act as a marker as well. But equalities will have a 'dummy'
+ * marker that has no effect except to track the constraint when removing a constraint.
+ *
+ * Returns NO for an invalid relation, and otherwise the marker's kind and its coefficient on the left hand side of the
+ * equality.
+ */
+static BOOL
+VPLConstraintMarkerKind(VPLConstraintRelation relation, VPLVariableKind * markerKind, CGFloat * markerCoefficient)
 {
-  static int64_t markerCount = 0;
-  return OSAtomicIncrement64Barrier(&markerCount);
+  *markerCoefficient = 1.0;
+  
+  if (relation == VPLConstraintRelationEqual)
+  {
+    // x = 50
+    // x + d1 = 50
+    *markerKind = VPLVariableKindDummy;
+  }
+  else if (relation == VPLConstraintRelationGreaterThanOrEqual)
+  {
+    // x >= 50
+    // x - s1 = 50
+    *markerKind = VPLVariableKindSlack;
+    *markerCoefficient = -1.0;
+  }
+  else if (relation == VPLConstraintRelationLessThanOrEqual)
+  {
+    // x <= 50
+    // x + s1 = 50
+    *markerKind = VPLVariableKindSlack;
+  }
+  else
+  {
+    return NO;
+  }
+  
+  return YES;
+}
+
+static const CGFloat VPLConstraintStrengthWeights[] = {
+  
+  [VPLConstraintStrengthRequired] = 0.0,
+  [VPLConstraintStrengthStrong] = 10.0,
+  [VPLConstraintStrengthMedium] = 0.1,
+  [VPLConstraintStrengthWeak] = 0.001
+  
+};
+
+static NSString * const VPLConstraintStrengthNames[] = {
+  
+  [VPLConstraintStrengthRequired] = @"required",
+  [VPLConstraintStrengthStrong] = @"strong",
+  [VPLConstraintStrengthMedium] = @"medium",
+  [VPLConstraintStrengthWeak] = @"weak"
+  
+};
+
+static const NSUInteger VPLConstraintStrengthCount = sizeof(VPLConstraintStrengthNames) / sizeof(NSString *);
+
+CGFloat
+VPLConstraintStrengthWeight(VPLConstraintStrength strength)
+{
+  return ((NSUInteger)strength < VPLConstraintStrengthCount ? VPLConstraintStrengthWeights[strength] : 0.0);
+}
+
+BOOL
+VPLConstraintStrengthFromName(NSString * name, VPLConstraintStrength * strength)
+{
+  if (name == nil)
+  {
+    *strength = VPLConstraintStrengthRequired;
+    return YES;
+  }
+  
+  for (NSUInteger strengthIndex = 0; strengthIndex < VPLConstraintStrengthCount; strengthIndex++)
+  {
+    if ([name isEqualToString:VPLConstraintStrengthNames[strengthIndex]])
+    {
+      *strength = (VPLConstraintStrength)strengthIndex;
+      return YES;
+    }
+  }
+  
+  return NO;
+}
+
+NSString *
+VPLConstraintStrengthName(VPLConstraintStrength strength)
+{
+  return ((NSUInteger)strength < VPLConstraintStrengthCount ? VPLConstraintStrengthNames[strength] : nil);
 }
 
 @implementation VPLConstraint
@@ -32,82 +118,141 @@ VPLConstraintGenerateMarkerNumber()
     _multiplier = multiplier;
     _constant = constant;
     
-    // Convert inequalities to an equality, and produce a 'marker' variable to help identify the constraint's effect in
-    // the tableau. Inequalities need a slack variable, which can act as a marker as well. But equalities will have a
-    // 'dummy' marker that has no effect except to track the constraint when removing a constraint.
-    
-    NSUInteger markerId = VPLConstraintGenerateMarkerNumber();
-    NSString * markerVariablePrefix = nil;
     CGFloat markerVariableCoefficient = 1.0;
-    
-    if (relation == VPLConstraintRelationEqual)
-    {
-      // x = 50
-      // x + d1 = 50
-      markerVariablePrefix = VPLLinearExpressionDummyVariablePrefix;
-    }
-    else if (relation == VPLConstraintRelationGreaterThanOrEqual)
-    {
-      // x >= 50
-      // x - s1 = 50
-      markerVariablePrefix = VPLLinearExpressionSlackVariablePrefix;
-      markerVariableCoefficient = -1.0;
-    }
-    else if (relation == VPLConstraintRelationLessThanOrEqual)
+    if (![self validateMarkerVariableWithCoefficient:&markerVariableCoefficient])
     {
-      // x <= 50
-      // x + s1 = 50
-      markerVariablePrefix = VPLLinearExpressionSlackVariablePrefix;
+      return nil;
     }
-    else
-    {
-      NSString * className = NSStringFromClass([self class]);
-      
-      self = nil;
-      [NSException raise:NSInternalInconsistencyException
-                  format:@"Attempt to initialize %@ with invalid relation (%li)",
-                         className,
-                         (long)relation];
-    }
-    
-    _markerVariableName = [NSString stringWithFormat:@"%@%@%lu",
-                                                     markerVariablePrefix,
-                                                     variableName,
-                                                     (unsigned long)markerId];
     
     // construct an expression:
     //
     // variableName + (markerVariableCoeff * markerVariable) = constant + (multiplier * relatedVariableName)
     // 0 =  constant + (multiplier * relatedVariableName) - variableName - (markerVariableCoeff * markerVariable)
     //
-    // if constant is negative, negate it
+    // if constant is negative, negate it. The marker term is left out until a constraint set gives it a marker.
     
     NSArray * variableNames;
     NSArray * variableCoefficients;
     if (relatedVariableName != nil && multiplier != 0.0)
     {
-      variableNames = @[ relatedVariableName, _markerVariableName, variableName ];
-      variableCoefficients = @[ @(multiplier), @(-markerVariableCoefficient), @(-1) ];
+      variableNames = @[ relatedVariableName, variableName ];
+      variableCoefficients = @[ @(multiplier), @(-1) ];
     }
     else
     {
-      variableNames = @[ _markerVariableName, variableName ];
-      variableCoefficients = @[ @(-markerVariableCoefficient), @(-1) ];
+      variableNames = @[ variableName ];
+      variableCoefficients = @[ @(-1) ];
     }
     
     VPLLinearExpression * expr = [VPLLinearExpression expressionWithConstantValue:constant
                                                                   variableNames:variableNames
                                                            variableCoefficients:variableCoefficients];
+    _markerCoefficient = -markerVariableCoefficient;
     if (expr.constantValue < 0.0)
     {
       expr = [expr expressionByNegatingExpression];
+      _markerCoefficient = -_markerCoefficient;
     }
     
     _expression = expr;
+    _variableID = [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName];
   }
   return self;
 }
 
+- (id)initWithVariable:(NSString *)variableName
+             relatedBy:(VPLConstraintRelation)relation
+            toVariable:(NSString *)relatedVariableName
+            multiplier:(CGFloat)multiplier
+              constant:(CGFloat)constant
+  normalizedExpression:(VPLLinearExpression *)normalizedExpression
+     markerCoefficient:(CGFloat)markerCoefficient
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _variableName = variableName;
+    _relation = relation;
+    _relatedVariableName = relatedVariableName;
+    _multiplier = multiplier;
+    _constant = constant;
+    
+    CGFloat markerVariableCoefficient = 1.0;
+    if (![self validateMarkerVariableWithCoefficient:&markerVariableCoefficient])
+    {
+      return nil;
+    }
+    
+    // the expression is already in its final form
+    _expression = normalizedExpression;
+    _markerCoefficient = markerCoefficient;
+    _variableID = [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName];
+  }
+  return self;
+}
+
+- (id)initWithVariable:(NSString *)variableName
+        leftExpression:(VPLLinearExpression *)leftExpression
+             relatedBy:(VPLConstraintRelation)relation
+       rightExpression:(VPLLinearExpression *)rightExpression
+{
+  // describe it as v = m*x + b if it has that form
+  NSString * relatedVariableName = nil;
+  CGFloat multiplier = 0.0;
+  CGFloat constant = rightExpression.constantValue - leftExpression.constantValue;
+  
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  if (leftExpression.termCount == 1
+      && leftExpression.constantValue == 0.0
+      && leftExpression.terms[0].coefficient == 1.0
+      && [[symbolTable nameForVariableID:leftExpression.terms[0].variableID] isEqualToString:variableName]
+      && rightExpression.termCount == 1)
+  {
+    relatedVariableName = [symbolTable nameForVariableID:rightExpression.terms[0].variableID];
+    multiplier = rightExpression.terms[0].coefficient;
+  }
+  
+  // 0 = right - left + (markerCoeff * marker), with the constant kept positive just as above
+  VPLVariableKind markerKind = VPLVariableKindDummy;
+  CGFloat markerVariableCoefficient = 1.0;
+  VPLConstraintMarkerKind(relation, &markerKind, &markerVariableCoefficient);
+  CGFloat markerCoefficient = -markerVariableCoefficient;
+  
+  VPLLinearExpression * expr = [rightExpression expressionByAddingExpression:leftExpression
+                                                                  multiplier:-1.0];
+  if (expr.constantValue < 0.0)
+  {
+    expr = [expr expressionByNegatingExpression];
+    markerCoefficient = -markerCoefficient;
+  }
+  
+  return [self initWithVariable:variableName
+                      relatedBy:relation
+                     toVariable:relatedVariableName
+                     multiplier:multiplier
+                       constant:constant
+           normalizedExpression:expr
+              markerCoefficient:markerCoefficient];
+}
+
+/**
+ * Every constraint needs a marker of its own, even if it's identical to another constraint. The constraint set it's
+ * added to hands one out, so only the marker's kind is decided here.
+ */
+- (BOOL)validateMarkerVariableWithCoefficient:(CGFloat *)markerVariableCoefficient
+{
+  if (!VPLConstraintMarkerKind(_relation, &_markerVariableKind, markerVariableCoefficient))
+  {
+    [NSException raise:NSInternalInconsistencyException
+                format:@"Attempt to initialize %@ with invalid relation (%li)",
+                       NSStringFromClass([self class]),
+                       (long)_relation];
+    return NO;
+  }
+  
+  return YES;
+}
+
 + (instancetype)constraintWithVariable:(NSString *)variableName
                              relatedBy:(VPLConstraintRelation)relation
                             toVariable:(NSString *)relatedVariableName
@@ -121,4 +266,31 @@ VPLConstraintGenerateMarkerNumber()
                                constant:constant];
 }
 
+// ===== EXPRESSION ====================================================================================================
+#pragma mark - Expression
+
+- (VPLLinearExpression *)expressionWithMarkerVariableID:(VPLVariableID)markerVariableID
+{
+  NSAssert(VPLVariableIDGetKind(markerVariableID) == _markerVariableKind,
+           @"[%@ %@] marker has the wrong kind for this constraint",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+  
+  VPLTerm markerTerm = { markerVariableID, _markerCoefficient };
+  VPLLinearExpression * markerExpr = [VPLLinearExpression expressionWithConstantValue:0.0
+                                                                                terms:&markerTerm
+                                                                                count:1];
+  
+  return [_expression expressionByAddingExpression:markerExpr
+                                        multiplier:1.0];
+}
+
+// ===== STRENGTH ======================================================================================================
+#pragma mark - Strength
+
+- (BOOL)isRequired
+{
+  return self.strength == VPLConstraintStrengthRequired;
+}
+
 @end
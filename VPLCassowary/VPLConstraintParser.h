@@ -0,0 +1,80 @@
+#import "VPLCassowaryTypes.h"
+
+@class VPLConstraint;
+@class VPLLinearExpression;
+
+extern NSString * const VPLConstraintParserErrorDomain;
+
+typedef enum _VPLConstraintParserError {
+
+  VPLConstraintParserErrorNone = 0,
+  VPLConstraintParserErrorInvalidSyntax
+
+} VPLConstraintParserError;
+
+/**
+ * Parses constraint statements straight from their UTF-8 bytes, such as:
+ *
+ *     second.x >= first.x + 10
+ *     label.width == 0.5 * container.width - 2 * margin
+ *
+ * Each side is a linear expression of numbers and variables. Variable names start with a letter or underscore, and may
+ * contain digits, underscores and dots. A coefficient may come before its variable, with or without a `*`, or after it
+ * with one. The relation is one of `=`, `==`, `>=` and `<=`.
+ *
+ * Statements are separated by newlines or semicolons, and `#` starts a comment that runs to the end of the line. A
+ * constraint is named after the first variable in its statement.
+ *
+ * Tokens are scanned in place without allocating anything; each distinct variable name is only turned into a string
+ * and interned the first time the parser meets it. On a syntax error, `error` describes where the error is.
+ */
+@interface VPLConstraintParser : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+/**
+ * `data` must be UTF-8. It isn't copied, so it can be a mapped file.
+ */
+- (instancetype)initWithData:(NSData *)data;
+
+- (instancetype)initWithString:(NSString *)string;
+
+@property (nonatomic, strong, readonly) NSData * data;
+
+// ===== PARSING =======================================================================================================
+#pragma mark - Parsing
+
+/**
+ * Parses the next statement. Returns nil once there are none left, or on a syntax error.
+ */
+- (VPLConstraint *)parseConstraint;
+
+/**
+ * Parses every remaining statement. Returns nil on a syntax error.
+ */
+- (NSArray *)parseConstraints;
+
+/**
+ * Parses the rest of the data as a single linear expression. Returns nil on a syntax error.
+ */
+- (VPLLinearExpression *)parseExpression;
+
+// ----- CONVENIENCE ---------------------------------------------------------------------------------------------------
+#pragma mark Convenience
+
++ (VPLConstraint *)constraintFromString:(NSString *)string
+                                 error:(NSError * __autoreleasing *)error;
+
+/**
+ * Parses a whole file of constraint statements in one pass. The file is mapped rather than read.
+ */
++ (NSArray *)constraintsWithContentsOfFile:(NSString *)path
+                                     error:(NSError * __autoreleasing *)error;
+
+// ===== ERRORS ========================================================================================================
+#pragma mark - Errors
+
+@property (nonatomic, strong, readonly) NSError * error;
+
+@end
@@ -0,0 +1,621 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLConstraintParser.h"
+#import "VPLConstraint.h"
+#import "VPLLinearExpression.h"
+#import "VPLSymbolTable.h"
+
+NSString * const VPLConstraintParserErrorDomain = @"com.vulpinelabs.VPLConstraintParser";
+
+// numbers are copied to the stack to be converted, so they can't be longer than this
+static const NSUInteger VPLConstraintParserMaximumNumberLength = 63;
+
+static const NSUInteger VPLConstraintParserInitialNameCapacity = 64;
+
+static inline BOOL
+VPLConstraintParserIsSpace(uint8_t character)
+{
+  return character == ' ' || character == '\t' || character == '\r';
+}
+
+static inline BOOL
+VPLConstraintParserIsDigit(uint8_t character)
+{
+  return character >= '0' && character <= '9';
+}
+
+static inline BOOL
+VPLConstraintParserIsNameStart(uint8_t character)
+{
+  return ((character >= 'a' && character <= 'z')
+          || (character >= 'A' && character <= 'Z')
+          || character == '_');
+}
+
+static inline BOOL
+VPLConstraintParserIsName(uint8_t character)
+{
+  return VPLConstraintParserIsNameStart(character) || VPLConstraintParserIsDigit(character) || character == '.';
+}
+
+static int
+VPLConstraintParserTermCompare(const void * term, const void * otherTerm)
+{
+  VPLVariableID variableID = ((const VPLTerm *)term)->variableID;
+  VPLVariableID otherVariableID = ((const VPLTerm *)otherTerm)->variableID;
+
+  return (variableID < otherVariableID ? -1 : (variableID > otherVariableID ? 1 : 0));
+}
+
+/**
+ * A variable name the parser has already interned, found by the bytes of its first occurrence.
+ */
+typedef struct _VPLConstraintParserName {
+
+  NSUInteger hash;
+  NSUInteger location;
+  NSUInteger length;
+  VPLVariableID variableID;
+
+} VPLConstraintParserName;
+
+@interface VPLConstraintParser ()
+{
+  const uint8_t * _bytes;
+  NSUInteger _length;
+  NSUInteger _location;
+
+  NSUInteger _line;
+  NSUInteger _lineStart;
+
+  // the terms of the expression being scanned, reused from one expression to the next
+  VPLTerm * _terms;
+  NSUInteger _termCount;
+  NSUInteger _termCapacity;
+
+  // an open addressed hash table of the names interned so far, whose capacity is a power of two
+  VPLConstraintParserName * _names;
+  NSUInteger _nameCount;
+  NSUInteger _nameCapacity;
+
+  VPLVariableID _subjectVariableID;
+}
+
+@property (nonatomic, strong, readwrite) NSError * error;
+
+@end
+
+@implementation VPLConstraintParser
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithData:(NSData *)data
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _data = data;
+    _bytes = [data bytes];
+    _length = [data length];
+    _location = 0;
+    _line = 1;
+    _lineStart = 0;
+    _subjectVariableID = VPLVariableIDNone;
+  }
+  return self;
+}
+
+- (instancetype)initWithString:(NSString *)string
+{
+  return [self initWithData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)dealloc
+{
+  free(_terms);
+  free(_names);
+}
+
+// ===== PARSING =======================================================================================================
+#pragma mark - Parsing
+
+- (VPLConstraint *)parseConstraint
+{
+  if (self.error != nil) return nil;
+
+  // blank lines, comments and empty statements are skipped
+  while ([self scanEndOfStatement])
+  {
+    if (_location >= _length) return nil;
+  }
+
+  _subjectVariableID = VPLVariableIDNone;
+
+  VPLLinearExpression * leftExpression = [self scanExpression];
+  if (leftExpression == nil) return nil;
+
+  VPLConstraintRelation relation;
+  if (![self scanRelation:&relation])
+  {
+    [self failWithReason:@"expected '=', '>=' or '<='"];
+    return nil;
+  }
+
+  VPLLinearExpression * rightExpression = [self scanExpression];
+  if (rightExpression == nil) return nil;
+
+  if (_subjectVariableID == VPLVariableIDNone)
+  {
+    [self failWithReason:@"a constraint needs at least one variable"];
+    return nil;
+  }
+
+  if (![self scanEndOfStatement])
+  {
+    [self failWithReason:@"expected the end of the constraint"];
+    return nil;
+  }
+
+  NSString * variableName = [[VPLSymbolTable sharedSymbolTable] nameForVariableID:_subjectVariableID];
+  return [[VPLConstraint alloc] initWithVariable:variableName
+                                  leftExpression:leftExpression
+                                       relatedBy:relation
+                                 rightExpression:rightExpression];
+}
+
+- (NSArray *)parseConstraints
+{
+  NSMutableArray * constraints = [[NSMutableArray alloc] init];
+  for (VPLConstraint * constraint = [self parseConstraint]; constraint != nil; constraint = [self parseConstraint])
+  {
+    [constraints addObject:constraint];
+  }
+
+  return (self.error == nil ? constraints : nil);
+}
+
+- (VPLLinearExpression *)parseExpression
+{
+  if (self.error != nil) return nil;
+
+  VPLLinearExpression * expression = [self scanExpression];
+  if (expression == nil) return nil;
+
+  // trailing blank lines and comments are fine
+  [self skipSpaces];
+  while (_location < _length && _bytes[_location] == '\n')
+  {
+    [self scanEndOfStatement];
+    [self skipSpaces];
+  }
+
+  if (_location < _length)
+  {
+    [self failWithReason:@"unexpected text after the expression"];
+    return nil;
+  }
+  return expression;
+}
+
+// ----- CONVENIENCE ---------------------------------------------------------------------------------------------------
+#pragma mark Convenience
+
++ (VPLConstraint *)constraintFromString:(NSString *)string
+                                 error:(NSError * __autoreleasing *)error
+{
+  VPLConstraintParser * parser = [[VPLConstraintParser alloc] initWithString:string];
+  VPLConstraint * constraint = [parser parseConstraint];
+  if (constraint != nil && parser.error == nil && [parser parseConstraint] != nil)
+  {
+    [parser failWithReason:@"expected a single constraint"];
+  }
+
+  if (parser.error != nil || constraint == nil)
+  {
+    if (error != NULL)
+    {
+      *error = (parser.error != nil ? parser.error : [parser errorWithReason:@"expected a constraint"]);
+    }
+    return nil;
+  }
+  return constraint;
+}
+
++ (NSArray *)constraintsWithContentsOfFile:(NSString *)path
+                                     error:(NSError * __autoreleasing *)error
+{
+  NSData * data = [NSData dataWithContentsOfFile:[path stringByExpandingTildeInPath]
+                                         options:NSDataReadingMappedIfSafe
+                                           error:error];
+  if (data == nil)
+  {
+    return nil;
+  }
+
+  VPLConstraintParser * parser = [[VPLConstraintParser alloc] initWithData:data];
+  NSArray * constraints = [parser parseConstraints];
+  if (constraints == nil && error != NULL)
+  {
+    *error = parser.error;
+  }
+  return constraints;
+}
+
+// ===== SCANNING ======================================================================================================
+#pragma mark - Scanning
+
+- (void)skipSpaces
+{
+  while (_location < _length && VPLConstraintParserIsSpace(_bytes[_location]))
+  {
+    _location++;
+  }
+
+  if (_location < _length && _bytes[_location] == '#')
+  {
+    while (_location < _length && _bytes[_location] != '\n')
+    {
+      _location++;
+    }
+  }
+}
+
+/**
+ * Scans a newline or a semicolon, or the end of the data.
+ */
+- (BOOL)scanEndOfStatement
+{
+  [self skipSpaces];
+  if (_location >= _length)
+  {
+    return YES;
+  }
+
+  if (_bytes[_location] == '\n')
+  {
+    _location++;
+    _line++;
+    _lineStart = _location;
+    return YES;
+  }
+
+  if (_bytes[_location] == ';')
+  {
+    _location++;
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)scanRelation:(VPLConstraintRelation *)relation
+{
+  [self skipSpaces];
+  if (_location >= _length) return NO;
+
+  uint8_t character = _bytes[_location];
+  BOOL isFollowedByEquals = (_location + 1 < _length && _bytes[_location + 1] == '=');
+  if (character == '=')
+  {
+    *relation = VPLConstraintRelationEqual;
+    _location += (isFollowedByEquals ? 2 : 1);
+    return YES;
+  }
+  else if ((character == '>' || character == '<') && isFollowedByEquals)
+  {
+    *relation = (character == '>' ? VPLConstraintRelationGreaterThanOrEqual : VPLConstraintRelationLessThanOrEqual);
+    _location += 2;
+    return YES;
+  }
+
+  return NO;
+}
+
+- (BOOL)scanNumber:(CGFloat *)number
+{
+  NSUInteger start = _location;
+  while (_location < _length && VPLConstraintParserIsDigit(_bytes[_location]))
+  {
+    _location++;
+  }
+
+  if (_location < _length && _bytes[_location] == '.')
+  {
+    _location++;
+    while (_location < _length && VPLConstraintParserIsDigit(_bytes[_location]))
+    {
+      _location++;
+    }
+  }
+
+  // an exponent has to have digits, or the 'e' is the start of a variable name, as in `2em`
+  if (_location < _length && (_bytes[_location] == 'e' || _bytes[_location] == 'E'))
+  {
+    NSUInteger exponentLocation = _location + 1;
+    if (exponentLocation < _length && (_bytes[exponentLocation] == '+' || _bytes[exponentLocation] == '-'))
+    {
+      exponentLocation++;
+    }
+
+    if (exponentLocation < _length && VPLConstraintParserIsDigit(_bytes[exponentLocation]))
+    {
+      _location = exponentLocation;
+      while (_location < _length && VPLConstraintParserIsDigit(_bytes[_location]))
+      {
+        _location++;
+      }
+    }
+  }
+
+  NSUInteger numberLength = _location - start;
+  if (numberLength == 0 || (numberLength == 1 && _bytes[start] == '.'))
+  {
+    _location = start;
+    return [self failWithReason:@"expected a number"];
+  }
+
+  if (numberLength > VPLConstraintParserMaximumNumberLength)
+  {
+    _location = start;
+    return [self failWithReason:@"number is too long"];
+  }
+
+  char numberString[VPLConstraintParserMaximumNumberLength + 1];
+  memcpy(numberString, _bytes + start, numberLength);
+  numberString[numberLength] = '\0';
+
+  *number = strtod(numberString, NULL);
+  return YES;
+}
+
+- (VPLVariableID)scanVariable
+{
+  NSUInteger start = _location;
+  NSUInteger hash = 2166136261u;    // FNV-1a
+  while (_location < _length && VPLConstraintParserIsName(_bytes[_location]))
+  {
+    hash = (hash ^ _bytes[_location]) * 16777619u;
+    _location++;
+  }
+
+  VPLVariableID variableID = [self variableIDForNameAtLocation:start
+                                                         length:_location - start
+                                                           hash:hash];
+  if (_subjectVariableID == VPLVariableIDNone)
+  {
+    _subjectVariableID = variableID;
+  }
+  return variableID;
+}
+
+/**
+ * Scans a signed term, adding it to the terms being collected or to `constantValue`.
+ */
+- (BOOL)scanTermWithSign:(CGFloat)sign
+           constantValue:(CGFloat *)constantValue
+{
+  CGFloat coefficient = sign;
+  BOOL hasNumber = NO;
+
+  uint8_t character = (_location < _length ? _bytes[_location] : 0);
+  if (VPLConstraintParserIsDigit(character) || character == '.')
+  {
+    CGFloat number = 0.0;
+    if (![self scanNumber:&number]) return NO;
+
+    coefficient *= number;
+    hasNumber = YES;
+
+    [self skipSpaces];
+    if (_location < _length && _bytes[_location] == '*')
+    {
+      _location++;
+      [self skipSpaces];
+      if (_location >= _length || !VPLConstraintParserIsNameStart(_bytes[_location]))
+      {
+        return [self failWithReason:@"expected a variable after '*'"];
+      }
+    }
+  }
+
+  if (_location < _length && VPLConstraintParserIsNameStart(_bytes[_location]))
+  {
+    VPLVariableID variableID = [self scanVariable];
+
+    // a coefficient can follow its variable instead, as in `x * 2`
+    [self skipSpaces];
+    if (!hasNumber && _location < _length && _bytes[_location] == '*')
+    {
+      _location++;
+      [self skipSpaces];
+
+      CGFloat number = 0.0;
+      if (![self scanNumber:&number]) return NO;
+      coefficient *= number;
+    }
+
+    [self addTermWithVariableID:variableID
+                    coefficient:coefficient];
+    return YES;
+  }
+
+  if (hasNumber)
+  {
+    *constantValue += coefficient;
+    return YES;
+  }
+
+  return [self failWithReason:@"expected a number or a variable"];
+}
+
+- (VPLLinearExpression *)scanExpression
+{
+  _termCount = 0;
+  CGFloat constantValue = 0.0;
+
+  BOOL isFirstTerm = YES;
+  while (YES)
+  {
+    [self skipSpaces];
+
+    CGFloat sign = 1.0;
+    if (_location < _length && (_bytes[_location] == '+' || _bytes[_location] == '-'))
+    {
+      sign = (_bytes[_location] == '-' ? -1.0 : 1.0);
+      _location++;
+      [self skipSpaces];
+    }
+    else if (!isFirstTerm)
+    {
+      // anything but another term ends the expression
+      break;
+    }
+
+    if (![self scanTermWithSign:sign constantValue:&constantValue])
+    {
+      return nil;
+    }
+    isFirstTerm = NO;
+  }
+
+  // the terms are in the order they were written, so they're sorted and any repeated variables are combined
+  if (_termCount > 1)
+  {
+    qsort(_terms, _termCount, sizeof(VPLTerm), VPLConstraintParserTermCompare);
+  }
+
+  NSUInteger combinedTermCount = 0;
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    if (combinedTermCount > 0 && _terms[combinedTermCount - 1].variableID == _terms[termIndex].variableID)
+    {
+      _terms[combinedTermCount - 1].coefficient += _terms[termIndex].coefficient;
+    }
+    else
+    {
+      _terms[combinedTermCount++] = _terms[termIndex];
+    }
+  }
+
+  return [VPLLinearExpression expressionWithConstantValue:constantValue
+                                                    terms:_terms
+                                                    count:combinedTermCount];
+}
+
+// ===== TERMS =========================================================================================================
+#pragma mark - Terms
+
+- (void)addTermWithVariableID:(VPLVariableID)variableID
+                  coefficient:(CGFloat)coefficient
+{
+  if (_termCount == _termCapacity)
+  {
+    _termCapacity = MAX(_termCapacity * 2, 8);
+    _terms = realloc(_terms, sizeof(VPLTerm) * _termCapacity);
+  }
+
+  _terms[_termCount].variableID = variableID;
+  _terms[_termCount].coefficient = coefficient;
+  _termCount++;
+}
+
+// ===== NAMES =========================================================================================================
+#pragma mark - Names
+
+- (VPLVariableID)variableIDForNameAtLocation:(NSUInteger)location
+                                      length:(NSUInteger)length
+                                        hash:(NSUInteger)hash
+{
+  if (_nameCapacity == 0)
+  {
+    _nameCapacity = VPLConstraintParserInitialNameCapacity;
+    _names = calloc(_nameCapacity, sizeof(VPLConstraintParserName));
+  }
+
+  NSUInteger mask = _nameCapacity - 1;
+  for (NSUInteger slot = hash & mask; ; slot = (slot + 1) & mask)
+  {
+    VPLConstraintParserName * name = &_names[slot];
+    if (name->length == 0)
+    {
+      // first time this name has come up, so it's interned
+      NSString * variableName = [[NSString alloc] initWithBytes:_bytes + location
+                                                         length:length
+                                                       encoding:NSUTF8StringEncoding];
+      VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName];
+
+      *name = (VPLConstraintParserName){ hash, location, length, variableID };
+      _nameCount++;
+
+      if (_nameCount * 2 > _nameCapacity)
+      {
+        [self growNames];
+      }
+      return variableID;
+    }
+
+    if (name->hash == hash
+        && name->length == length
+        && memcmp(_bytes + name->location, _bytes + location, length) == 0)
+    {
+      return name->variableID;
+    }
+  }
+}
+
+- (void)growNames
+{
+  VPLConstraintParserName * names = _names;
+  NSUInteger nameCapacity = _nameCapacity;
+
+  _nameCapacity = nameCapacity * 2;
+  _names = calloc(_nameCapacity, sizeof(VPLConstraintParserName));
+
+  NSUInteger mask = _nameCapacity - 1;
+  for (NSUInteger nameIndex = 0; nameIndex < nameCapacity; nameIndex++)
+  {
+    if (names[nameIndex].length == 0) continue;
+
+    NSUInteger slot = names[nameIndex].hash & mask;
+    while (_names[slot].length != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+    _names[slot] = names[nameIndex];
+  }
+
+  free(names);
+}
+
+// ===== ERRORS ========================================================================================================
+#pragma mark - Errors
+
+- (NSError *)errorWithReason:(NSString *)reason
+{
+  NSString * localizedErrorFormat = NSLocalizedString(@"Invalid constraint at line %lu, column %lu: %@", nil);
+  NSString * localizedErrorMsg = [NSString stringWithFormat:localizedErrorFormat,
+                                                            (unsigned long)_line,
+                                                            (unsigned long)(_location - _lineStart + 1),
+                                                            reason];
+
+  return [NSError errorWithDomain:VPLConstraintParserErrorDomain
+                             code:VPLConstraintParserErrorInvalidSyntax
+                         userInfo:@{ NSLocalizedDescriptionKey : localizedErrorMsg }];
+}
+
+/**
+ * Records the first error, which is the one that's reported.
+ */
+- (BOOL)failWithReason:(NSString *)reason
+{
+  if (self.error == nil)
+  {
+    self.error = [self errorWithReason:reason];
+  }
+  return NO;
+}
+
+@end
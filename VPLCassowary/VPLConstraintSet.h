@@ -1,28 +1,173 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLTableau.h"
 
 @class VPLConstraint;
-@class VPLTableau;
+@class VPLConstraintSet;
 
+/**
+ * Changes a forked constraint set into one variant of the constraint set it was forked from. See
+ * `-constraintSetsByApplyingVariants:`.
+ */
+typedef void (^VPLConstraintSetVariant)(VPLConstraintSet * constraintSet);
+
+/**
+ * Maintains a tableau that satisfies a set of required constraints, and that can be re-solved incrementally.
+ * Constraints with a weaker `strength` are preferences: they're satisfied as nearly as the required constraints allow,
+ * with stronger preferences winning when they conflict. Conflicts between preferences are settled by the same
+ * optimization that holds edit variables at their suggested values, so they never raise and never need the constraint
+ * set to be built again without them.
+ *
+ * Besides constraints, a constraint set may have _edit variables_. An edit variable is held at a suggested value as
+ * closely as the required constraints allow. Changing a suggestion only adjusts row constants; calling `-resolve`
+ * then restores feasibility with a dual simplex pass over the rows that were affected, which is much cheaper than
+ * building the constraint set again.
+ *
+ *     [constraintSet addEditVariable:@"root.width"];
+ *     [constraintSet suggestValue:320 forVariable:@"root.width"];
+ *     [constraintSet resolve];
+ *
+ *     CGFloat width = [constraintSet valueForVariable:@"content.width"];
+ *
+ * Constraints that share no variables, directly or through other constraints, can't affect each other's solutions. A
+ * constraint set tracks these independent components as constraints are added, and gives each one a
+ * `VPLSimplexSolver` of its own. Batches of constraints, removals and `-resolve` run the affected components'
+ * solvers concurrently. Components are merged when a constraint joins them, but aren't split again on removal.
+ */
 @interface VPLConstraintSet : NSObject
 
 // ===== TABLEAU =======================================================================================================
 #pragma mark - Tableau
 
+/**
+ * A snapshot of every component's rows. With more than one component, the variables their solvers made for themselves
+ * are renumbered so they don't clash, and there's a single objective that sums theirs.
+ */
 @property (nonatomic, strong, readonly) VPLTableau * tableau;
 
+// ===== PIVOT RULE ====================================================================================================
+#pragma mark - Pivot Rule
+
+/**
+ * The pivot rule used by every component's solver. Defaults to `VPLPivotRuleDantzig`.
+ */
+@property (nonatomic, assign) VPLPivotRule pivotRule;
+
+/**
+ * The total number of pivots performed so far. Comparing it before and after a call gives the pivots that call needed,
+ * which is how pivot rules can be compared on a particular layout.
+ */
+@property (nonatomic, assign, readonly) NSUInteger pivotCount;
+
 // ===== CONSTRAINTS ===================================================================================================
 #pragma mark - Constraints
 
 - (BOOL)containsConstraint:(VPLConstraint *)constraint;
 
+/**
+ * The marker the constraint set gave the constraint when it was added, or `VPLVariableIDNone` if it isn't in the
+ * constraint set. Markers are anonymous, and are handed to other constraints once theirs are removed, so they only
+ * identify a constraint for as long as it stays in the constraint set.
+ */
+- (VPLVariableID)markerVariableIDForConstraint:(VPLConstraint *)constraint;
+
 // ===== ADD CONSTRAINTS ===============================================================================================
 #pragma mark - Add Constraints
 
+/**
+ * Adds a single constraint. Raises `VPLConstraintSetUnsatisfiableConstraint` if it's required and can't be satisfied
+ * along with the existing required constraints. Preferences can always be added.
+ */
 - (void)addConstraint:(VPLConstraint *)constraint;
 
+/**
+ * Adds a batch of constraints. All of their rows are added first, and any that need artificial variables share a
+ * single phase one optimization, instead of running one per constraint.
+ *
+ * Required constraints that can't be satisfied are left out of the constraint set and returned, rather than raising.
+ */
+- (NSArray *)addConstraints:(NSArray *)constraints;
+
 // ===== REMOVE CONSTRAINTS ============================================================================================
 #pragma mark - Remove Constraints
 
 - (void)removeConstraint:(VPLConstraint *)constraint;
 
+- (void)removeConstraints:(NSArray *)constraints;
+
+// ===== EDIT VARIABLES ================================================================================================
+#pragma mark - Edit Variables
+
+- (BOOL)containsEditVariable:(NSString *)variableName;
+
+/**
+ * Adds an edit variable, initially held at the variable's current value.
+ */
+- (void)addEditVariable:(NSString *)variableName;
+
+/**
+ * Adds an edit variable whose error is multiplied by `weight`. When suggestions conflict, edit variables with higher
+ * weights are held closer to their suggested values. `-addEditVariable:` uses a weight of 1.
+ */
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight;
+
+- (void)removeEditVariable:(NSString *)variableName;
+
+/**
+ * Suggests a new value for an edit variable. The tableau isn't guaranteed to be feasible again until `-resolve` is
+ * called, so several suggestions can be made before re-solving once.
+ */
+- (void)suggestValue:(CGFloat)value
+         forVariable:(NSString *)variableName;
+
+- (void)resolve;
+
+// ===== VALUES ========================================================================================================
+#pragma mark - Values
+
+/**
+ * Returns the variable's value in the current solution. Parametric and unknown variables have a value of 0.
+ */
+- (CGFloat)valueForVariable:(NSString *)variableName;
+
+/**
+ * Reads the values of `count` variables into `values`, in one pass and without going through the symbol table.
+ * Parametric and unknown variables, and `VPLVariableIDNone`, read as 0.
+ */
+- (void)getValues:(CGFloat *)values
+   forVariableIDs:(const VPLVariableID *)variableIDs
+            count:(NSUInteger)count;
+
+// ===== CHANGED VARIABLES =============================================================================================
+#pragma mark - Changed Variables
+
+/**
+ * The ids of the external variables whose values may have changed since the last `-resetChangedVariableIDs`. Any
+ * variable not included still has the value it had then, so a solution can be applied incrementally.
+ */
+- (NSIndexSet *)changedVariableIDs;
+
+- (void)resetChangedVariableIDs;
+
+// ===== FORKING =======================================================================================================
+#pragma mark - Forking
+
+/**
+ * Returns a constraint set with the same constraints, edit variables and solution, which can be changed without
+ * affecting this one. The fork's tableaux share their rows with this constraint set's until either side changes them,
+ * so no rows are copied; only the bookkeeping of which constraints and variables belong to which component is.
+ *
+ * The fork reports no changed variables until it's changed itself.
+ */
+- (VPLConstraintSet *)constraintSetByForking;
+
+/**
+ * Tries several variants of this constraint set at once, such as adding candidate constraints or suggesting different
+ * sizes. Each variant is applied to a fork of its own on a worker thread, and the fork is resolved afterwards. Returns
+ * the forks, in the same order as `variants`, for their values to be read.
+ *
+ * This constraint set itself isn't changed, but it mustn't be used by any other thread while this runs.
+ */
+- (NSArray *)constraintSetsByApplyingVariants:(NSArray *)variants;
+
 @end
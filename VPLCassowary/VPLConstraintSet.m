@@ -6,17 +6,49 @@
 #import "VPLConstraint.h"
 #import "VPLLinearExpression.h"
 #import "VPLTableau.h"
+#import "VPLSimplexSolver.h"
 
-static int64_t
-VPLConstraintSetGenerateVariableNumber()
-{
-  static int64_t variableCount = 0;
-  return OSAtomicIncrement64Barrier(&variableCount);
-}
+/**
+ * A node in the union-find structure over the constraint set's variables. Each variable maps to the component it was
+ * first seen in. A merged component points at the component that absorbed it, and only root components (those without
+ * a parent) have a solver.
+ */
+@interface VPLConstraintComponent : NSObject
+
+@property (nonatomic, strong) VPLConstraintComponent * parent;
+@property (nonatomic, assign) NSUInteger variableCount;
+@property (nonatomic, strong) VPLSimplexSolver * solver;
+
+@end
+
+@implementation VPLConstraintComponent
+
+@end
+
+/**
+ * The constraints of a batch that belong to a single component.
+ */
+@interface VPLConstraintBatch : NSObject
+
+@property (nonatomic, strong) VPLConstraintComponent * component;
+@property (nonatomic, strong) NSMutableArray * constraints;
+@property (nonatomic, strong) NSMutableArray * markerVariableIDs;
+@property (nonatomic, strong) NSArray * unsatisfiableConstraints;
+
+@end
+
+@implementation VPLConstraintBatch
+
+@end
 
 @interface VPLConstraintSet ()
 
-@property (nonatomic, strong, readonly) NSMutableArray * constraints;
+@property (nonatomic, strong, readonly) NSMapTable * markerVariableIDsByConstraint;
+@property (nonatomic, strong, readonly) NSMutableIndexSet * freeMarkerIndexes;
+@property (nonatomic, assign) NSUInteger markerCount;
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * componentsByVariableID;
+@property (nonatomic, strong, readonly) NSMutableArray * rootComponents;
 
 @end
 
@@ -30,324 +62,589 @@ VPLConstraintSetGenerateVariableNumber()
   self = [super init];
   if (self != nil)
   {
-    _tableau = [[VPLTableau alloc] init];
-    _constraints = [[NSMutableArray alloc] init];
+    _markerVariableIDsByConstraint = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                                           valueOptions:NSPointerFunctionsStrongMemory];
+    _freeMarkerIndexes = [[NSMutableIndexSet alloc] init];
+    _componentsByVariableID = [[NSMutableDictionary alloc] init];
+    _rootComponents = [[NSMutableArray alloc] init];
+    _pivotRule = VPLPivotRuleDantzig;
   }
   return self;
 }
 
-// ===== CONSTRAINTS ===================================================================================================
-#pragma mark - Constraints
+// ===== TABLEAU =======================================================================================================
+#pragma mark - Tableau
 
-- (BOOL)containsConstraint:(VPLConstraint *)constraint
+- (VPLTableau *)tableau
 {
-  return [self.constraints containsObject:constraint];
+  if ([self.rootComponents count] == 1)
+  {
+    VPLConstraintComponent * component = [self.rootComponents lastObject];
+    return [component.solver.tableau copy];
+  }
+  
+  // Each solver's own variables may have the same ids as another's, so the rows are collected by merging forks of the
+  // solvers, which gives those variables ids of their own.
+  VPLSimplexSolver * solver = [[VPLSimplexSolver alloc] init];
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    [solver mergeSolver:[component.solver copy]];
+  }
+  
+  return [solver.tableau copy];
 }
 
-// ===== ADD CONSTRAINTS ===============================================================================================
-#pragma mark - Add Constraints
+// ===== PIVOT RULE ====================================================================================================
+#pragma mark - Pivot Rule
+
+- (void)setPivotRule:(VPLPivotRule)pivotRule
+{
+  _pivotRule = pivotRule;
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    component.solver.pivotRule = pivotRule;
+  }
+}
+
+- (NSUInteger)pivotCount
+{
+  NSUInteger pivotCount = 0;
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    pivotCount += component.solver.pivotCount;
+  }
+  return pivotCount;
+}
+
+// ===== MARKERS =======================================================================================================
+#pragma mark - Markers
 
 /**
- * When adding a constraint, we first search the expression for a basic variable that can be added to the tableau
- * directly. This method returns the name of the variable that should be used to add the expression.
- *
- * If no variable can be found, then nil is returned, and the expression must be added using an artificial variable.
+ * Hands out an anonymous marker of the constraint's kind. The lowest index that's free is reused first, so the markers
+ * a constraint set holds stay as dense as the constraints it holds, however many have come and gone. Markers are only
+ * handed out on the calling thread, before any batches run, so a constraint set built the same way always gives its
+ * constraints the same markers.
  */
-- (NSString *)selectBasicVariableFromBasicExpression:(VPLLinearExpression *)expression
+- (VPLVariableID)createMarkerVariableIDForConstraint:(VPLConstraint *)constraint
 {
-  // If there is an unrestricted variable in the equation, make that the basic variable. However, a new unrestricted
-  // variable can be inserted into the tableau directly, so we prefer unknown variables first.
-  NSArray * expressionVariableNames = expression.variableTerms.allKeys;
-  NSArray * columnVariableNames = self.tableau.columnVariableNames;
-  
-  NSString * unrestrictedVariableName = nil;
-  for (NSString * variableName in expressionVariableNames)
+  NSUInteger markerIndex = [self.freeMarkerIndexes firstIndex];
+  if (markerIndex != NSNotFound)
+  {
+    [self.freeMarkerIndexes removeIndex:markerIndex];
+  }
+  else
   {
-    if (VPLLinearExpressionVariableIsUnrestricted(variableName))
+    if (self.markerCount >= VPLVariableSolverIndexBase)
     {
-      if (![columnVariableNames containsObject:variableName])
-      {
-        // unrestricted, unknown variable
-        return variableName;
-      }
-      else if (unrestrictedVariableName == nil)
-      {
-        // unrestricted, but known. Keep searching for a better match.
-        unrestrictedVariableName = variableName;
-      }
+      [NSException raise:NSInternalInconsistencyException
+                  format:@"Unable to add %@, since the constraint set already holds %lu constraints",
+                         constraint,
+                         (unsigned long)VPLVariableSolverIndexBase];
     }
+    
+    markerIndex = self.markerCount++;
+  }
+  
+  VPLVariableID markerVariableID = VPLVariableIDMakeAnonymous(markerIndex, constraint.markerVariableKind);
+  [self.markerVariableIDsByConstraint setObject:@(markerVariableID)
+                                         forKey:constraint];
+  return markerVariableID;
+}
+
+/**
+ * Takes a constraint's marker back once it has left the tableau, so it can be handed to another constraint. The
+ * marker's component no longer needs it either, or a constraint that's given it next would be merged into that
+ * component for no reason.
+ */
+- (void)releaseMarkerVariableIDForConstraint:(VPLConstraint *)constraint
+{
+  VPLVariableID markerVariableID = [self markerVariableIDForConstraint:constraint];
+  
+  NSNumber * markerKey = @(markerVariableID);
+  VPLConstraintComponent * component = [self componentForVariableID:markerVariableID];
+  if (component != nil)
+  {
+    component.variableCount--;
+    [self.componentsByVariableID removeObjectForKey:markerKey];
+  }
+  
+  [self.markerVariableIDsByConstraint removeObjectForKey:constraint];
+  [self.freeMarkerIndexes addIndex:VPLVariableIDGetAnonymousIndex(markerVariableID)];
+}
+
+- (VPLVariableID)markerVariableIDForConstraint:(VPLConstraint *)constraint
+{
+  NSNumber * markerVariableID = [self.markerVariableIDsByConstraint objectForKey:constraint];
+  return (markerVariableID != nil ? [markerVariableID unsignedIntValue] : VPLVariableIDNone);
+}
+
+// ===== COMPONENTS ====================================================================================================
+#pragma mark - Components
+
+- (VPLConstraintComponent *)rootComponent:(VPLConstraintComponent *)component
+{
+  VPLConstraintComponent * root = component;
+  while (root.parent != nil)
+  {
+    root = root.parent;
   }
   
-  if (unrestrictedVariableName != nil)
+  // compress the path, so the next lookup goes straight to the root
+  while (component.parent != nil && component.parent != root)
   {
-    // there was an unrestricted variable, but we'll have to perform a substitution
-    return unrestrictedVariableName;
+    VPLConstraintComponent * parent = component.parent;
+    component.parent = root;
+    component = parent;
   }
   
-  // No unrestricted variables, but if there is an unknown restricted variable with a negative coefficient we can use
-  // that.
-  for (NSString * variableName in expressionVariableNames)
+  return root;
+}
+
+- (VPLConstraintComponent *)componentForVariableID:(VPLVariableID)variableID
+{
+  VPLConstraintComponent * component = [self.componentsByVariableID objectForKey:@(variableID)];
+  return (component != nil ? [self rootComponent:component] : nil);
+}
+
+/**
+ * Merges two root components, moving the smaller component's solver into the larger one's. Returns the root of the
+ * merged component.
+ */
+- (VPLConstraintComponent *)unionComponent:(VPLConstraintComponent *)component
+                             withComponent:(VPLConstraintComponent *)otherComponent
+{
+  if (component == otherComponent) return component;
+  
+  if (component.variableCount < otherComponent.variableCount)
   {
-    CGFloat coeff = [expression coefficientForVariable:variableName];
-    if (coeff < 0.0
-        && !VPLLinearExpressionVariableIsDummy(variableName)
-        && ![columnVariableNames containsObject:variableName])
-    {
-      return variableName;
-    }
+    VPLConstraintComponent * swap = component;
+    component = otherComponent;
+    otherComponent = swap;
   }
   
-  // all restricted variables have positive coefficients, or are dummy variables. In the special case where the
-  // expression contains only dummy variables, then pick the one that is not in the tableau to enter the basis.
-  NSString * newDummyVariable = nil;
-  for (NSString * variableName in expressionVariableNames)
+  [component.solver mergeSolver:otherComponent.solver];
+  component.variableCount += otherComponent.variableCount;
+  
+  otherComponent.parent = component;
+  otherComponent.solver = nil;
+  [self.rootComponents removeObjectIdenticalTo:otherComponent];
+  
+  return component;
+}
+
+/**
+ * Returns the root component that all of an expression's variables belong to. Components that the expression joins are
+ * merged, and variables that haven't been seen before are added to the result. A new component is created if none of
+ * the variables have been seen before.
+ */
+- (VPLConstraintComponent *)componentForExpression:(VPLLinearExpression *)expression
+{
+  NSMutableDictionary * componentsByVariableID = self.componentsByVariableID;
+  
+  VPLConstraintComponent * component = nil;
+  NSMutableArray * newVariableIDs = [[NSMutableArray alloc] init];
+  
+  const VPLTerm * terms = expression.terms;
+  for (NSUInteger termIndex = 0; termIndex < expression.termCount; termIndex++)
   {
-    if (VPLLinearExpressionVariableIsDummy(variableName))
+    NSNumber * variableID = @(terms[termIndex].variableID);
+    VPLConstraintComponent * variableComponent = [componentsByVariableID objectForKey:variableID];
+    if (variableComponent == nil)
     {
-      if (![columnVariableNames containsObject:variableName])
-      {
-        newDummyVariable = variableName;
-      }
+      [newVariableIDs addObject:variableID];
     }
     else
     {
-      // the expression contained non-dummy variables
-      return nil;
+      variableComponent = [self rootComponent:variableComponent];
+      component = (component != nil
+                   ? [self unionComponent:component withComponent:variableComponent]
+                   : variableComponent);
     }
   }
   
-  return newDummyVariable;
+  if (component == nil)
+  {
+    component = [[VPLConstraintComponent alloc] init];
+    component.solver = [[VPLSimplexSolver alloc] init];
+    component.solver.pivotRule = self.pivotRule;
+    [self.rootComponents addObject:component];
+  }
+  
+  for (NSNumber * variableID in newVariableIDs)
+  {
+    [componentsByVariableID setObject:component
+                               forKey:variableID];
+  }
+  component.variableCount += [newVariableIDs count];
+  
+  return component;
 }
 
-- (void)addConstraint:(VPLConstraint *)constraint
+/**
+ * Splits constraints into one batch per component, in the order the components are first seen, along with their
+ * markers. Every constraint must already belong to a component.
+ */
+- (NSArray *)batchesForConstraints:(NSArray *)constraints
 {
-  NSAssert(![self containsConstraint:constraint],
-           @"Attempt to add constraint that already exists: %@",
-           constraint);
-  
-  // The constraint's expression is in the form 0 = c - e, with c gauranteed to be positive as required by the cassowary
-  // algorithm
-  VPLLinearExpression * constraintExpr = constraint.expression;
-  NSAssert(constraintExpr.constantValue >= 0.0,
-           @"[%@ %@] constraint expressions are expected to have positive constants!",
-           NSStringFromClass([self class]),
-           NSStringFromSelector(_cmd));
-  
-  // replace all basic variables in the expression with their expressions in the tableau
-  VPLLinearExpression * basicExpression =
-    [self.tableau expressionByReplacingRowVariablesInExpression:constraintExpr];
+  NSMutableArray * batches = [[NSMutableArray alloc] init];
+  NSMapTable * batchesByComponent = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                                          valueOptions:NSPointerFunctionsStrongMemory];
   
-  // all basic variables have been removed from the expression, so the only variables left are parametric, or new
-  // variables.
-  
-  // If we find a basic variable in the expression, we can add it directly to the tableau
-  NSString * basicVariable = [self selectBasicVariableFromBasicExpression:basicExpression];
-  if (basicVariable != nil)
+  for (VPLConstraint * constraint in constraints)
   {
-    VPLLinearExpression * rowExpression = [basicExpression expressionBySolvingForVariable:basicVariable];
+    // all of a constraint's variables are in the same component, so its marker will do
+    VPLVariableID markerVariableID = [self markerVariableIDForConstraint:constraint];
+    VPLConstraintComponent * component = [self componentForVariableID:markerVariableID];
     
-    VPLTableau * tableau = self.tableau;
-    if ([tableau.columnVariableNames containsObject:basicVariable])
+    VPLConstraintBatch * batch = [batchesByComponent objectForKey:component];
+    if (batch == nil)
     {
-      // substitute for the basic variable
-      tableau = [tableau tableauBySubstitutingExpression:rowExpression
-                                       forColumnVariable:basicVariable];
+      batch = [[VPLConstraintBatch alloc] init];
+      batch.component = component;
+      batch.constraints = [[NSMutableArray alloc] init];
+      batch.markerVariableIDs = [[NSMutableArray alloc] init];
+      
+      [batchesByComponent setObject:batch
+                             forKey:component];
+      [batches addObject:batch];
     }
     
-    _tableau = [tableau tableauBySettingExpression:rowExpression
-                                    forRowVariable:basicVariable];
+    [batch.constraints addObject:constraint];
+    [batch.markerVariableIDs addObject:@(markerVariableID)];
   }
-  else
+  
+  return batches;
+}
+
+/**
+ * Runs the block once for each batch. Each batch belongs to a different component, and components' solvers share
+ * nothing, so the batches are run concurrently.
+ */
+- (void)performBatches:(NSArray *)batches
+            usingBlock:(void(^)(VPLConstraintBatch * batch))block
+{
+  if ([batches count] == 1)
   {
-    // create an artifical variable @az, and add a row @az = expr
+    block([batches lastObject]);
+    return;
+  }
+  
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply([batches count], queue, ^(size_t batchIndex) {
+    
+    block([batches objectAtIndex:batchIndex]);
     
-    int64_t artificialVariableNumber = VPLConstraintSetGenerateVariableNumber();
-    NSString * slackVariableName = [NSString stringWithFormat:@"%@AZ%lli",
-                                                              VPLLinearExpressionSlackVariablePrefix,
-                                                              artificialVariableNumber];
+  });
+}
 
-    NSString * objectiveVariableName = [NSString stringWithFormat:@"%@AZ%lli",
-                                                                  VPLLinearExpressionObjectiveVariablePrefix,
-                                                                  artificialVariableNumber];
+// ===== CONSTRAINTS ===================================================================================================
+#pragma mark - Constraints
 
-    VPLTableau * artificialTableau = [self.tableau tableauBySettingExpression:basicExpression
-                                                              forRowVariable:slackVariableName];
-    
-    // Minimize expr.
-    VPLTableau * minimizedTableau = [artificialTableau tableauByMinimizingExpression:basicExpression
-                                                              objectiveVariableName:objectiveVariableName];
-    
-    VPLLinearExpression * objExpr = [minimizedTableau expressionForRow:objectiveVariableName];
-    CGFloat minimum = objExpr.constantValue;
-    
-    if (minimum != 0.0)
-    {
-      // if the minimum is not 0, the constraints are unsatisfiable
-      [NSException raise:@"VPLConstraintSetUnsatisfiableConstraint"
-                  format:@"Unable to satisy constraint %@",
-                         constraint];
-    }
+- (BOOL)containsConstraint:(VPLConstraint *)constraint
+{
+  // only constraints in the constraint set hold one of its markers
+  return [self.markerVariableIDsByConstraint objectForKey:constraint] != nil;
+}
+
+// ===== ADD CONSTRAINTS ===============================================================================================
+#pragma mark - Add Constraints
+
+- (void)addConstraint:(VPLConstraint *)constraint
+{
+  NSArray * unsatisfiableConstraints = [self addConstraints:@[ constraint ]];
+  if ([unsatisfiableConstraints count] > 0)
+  {
+    [NSException raise:@"VPLConstraintSetUnsatisfiableConstraint"
+                format:@"Unable to satisy constraint %@",
+                       constraint];
+  }
+}
+
+- (NSArray *)addConstraints:(NSArray *)constraints
+{
+  if ([constraints count] == 0) return @[];
+  
+  // hand out markers and merge every component the batch joins up front, so the solvers can then be run independently
+  for (VPLConstraint * constraint in constraints)
+  {
+    NSAssert(![self containsConstraint:constraint],
+             @"[%@ %@] Attempt to add constraint that already exists: %@",
+             NSStringFromClass([self class]),
+             NSStringFromSelector(_cmd),
+             constraint);
     
-    VPLLinearExpression * absRow = [minimizedTableau expressionForRow:slackVariableName];
-    if (absRow == nil)
-    {
-      // Artificial parameter is parametric. Simply remove the column for it
-      minimizedTableau = [minimizedTableau tableauByRemovingColumnVariable:slackVariableName];
-      minimizedTableau = [minimizedTableau tableauByRemovingExpressionForRow:objectiveVariableName];
-      
-      _tableau = minimizedTableau;
-    }
-    else
+    VPLVariableID markerVariableID = [self createMarkerVariableIDForConstraint:constraint];
+    [self componentForExpression:[constraint expressionWithMarkerVariableID:markerVariableID]];
+  }
+  
+  NSArray * batches = [self batchesForConstraints:constraints];
+  [self performBatches:batches
+            usingBlock:^(VPLConstraintBatch * batch) {
+              
+              batch.unsatisfiableConstraints = [batch.component.solver addConstraints:batch.constraints
+                                                                    markerVariableIDs:batch.markerVariableIDs];
+              
+            }];
+  
+  NSMutableSet * unsatisfiableConstraintSet = [[NSMutableSet alloc] init];
+  for (VPLConstraintBatch * batch in batches)
+  {
+    [unsatisfiableConstraintSet addObjectsFromArray:batch.unsatisfiableConstraints];
+  }
+  
+  // report unsatisfiable constraints in the order they were given
+  NSMutableArray * unsatisfiableConstraints = [[NSMutableArray alloc] init];
+  for (VPLConstraint * constraint in constraints)
+  {
+    if ([unsatisfiableConstraintSet containsObject:constraint])
     {
-      // Artificial variable is basic (@az = 0 + ...). It must have a 0 constant, otherwise we wouldn't have been
-      // able to get a minimum of 0.
-      //
-      // If it is 
-      if ([absRow isConstant])
-      {
-        // it's constant (@az = 0), so we can simply remove the row
-        minimizedTableau = [minimizedTableau tableauByRemovingExpressionForRow:slackVariableName];
-        minimizedTableau = [minimizedTableau tableauByRemovingExpressionForRow:objectiveVariableName];
-        _tableau = minimizedTableau;
-      }
-      else
-      {
-        // Artificial variable is non-constant (@az = 0 + bx + ...). We can pivot and turn @az into a column, which
-        // can then be removed.
-        NSString * entryVar = nil;
-        for (NSString * variableName in absRow.variableTerms.allKeys)
-        {
-          if (VPLLinearExpressionVariableIsSlack(variableName))
-          {
-            entryVar = variableName;
-            break;
-          }
-            
-        }
-        
-        NSAssert(entryVar != nil,
-                 @"Expected to be able to find one slack variable in expression: %@",
-                 absRow);
-        
-        
-        minimizedTableau = [minimizedTableau tableauByPivotingRowVariable:slackVariableName
-                                                           columnVariable:entryVar];
-        
-        // remove column
-        NSAssert([minimizedTableau expressionForRow:slackVariableName] == nil,
-                 @"Expected artificial variable %@ to be parametric",
-                 slackVariableName);
-        
-        minimizedTableau = [minimizedTableau tableauByRemovingColumnVariable:slackVariableName];
-        minimizedTableau = [minimizedTableau tableauByRemovingExpressionForRow:objectiveVariableName];
-        
-        _tableau = minimizedTableau;
-
-      }
+      [self releaseMarkerVariableIDForConstraint:constraint];
+      [unsatisfiableConstraints addObject:constraint];
     }
   }
   
-  [self.constraints addObject:constraint];
+  return unsatisfiableConstraints;
 }
 
-// ===== REMOVE CONSTRAINT =============================================================================================
-#pragma mark - Remove Constraint
+// ===== REMOVE CONSTRAINTS ============================================================================================
+#pragma mark - Remove Constraints
 
 - (void)removeConstraint:(VPLConstraint *)constraint
 {
-  NSAssert([self containsConstraint:constraint],
-           @"Attempt to remove constraint that doesn't exist: %@",
-           constraint);
+  [self removeConstraints:@[ constraint ]];
+}
+
+- (void)removeConstraints:(NSArray *)constraints
+{
+  if ([constraints count] == 0) return;
   
-  NSString * markerVariableName = constraint.markerVariableName;
-  if ([self.tableau.rowVariableNames containsObject:markerVariableName])
+  for (VPLConstraint * constraint in constraints)
   {
-    _tableau = [self.tableau tableauByRemovingExpressionForRow:markerVariableName];
+    NSAssert([self containsConstraint:constraint],
+             @"[%@ %@] Attempt to remove constraint that doesn't exist: %@",
+             NSStringFromClass([self class]),
+             NSStringFromSelector(_cmd),
+             constraint);
   }
-  else
+  
+  // Components aren't split when a removal disconnects them, since finding out would mean walking the whole component.
+  // A component that's larger than it needs to be is still solved correctly.
+  [self performBatches:[self batchesForConstraints:constraints]
+            usingBlock:^(VPLConstraintBatch * batch) {
+              
+              [batch.component.solver removeConstraints:batch.constraints
+                                      markerVariableIDs:batch.markerVariableIDs];
+              
+            }];
+  
+  for (VPLConstraint * constraint in constraints)
   {
-    // The marker variable is parametric, so we need to find a way to pivot it into the basis before we can remove it
-    
-    // First look for a restricted row that contains the marker variable with a negative coefficient. Then we can do a
-    // simple pivot.
-    NSString * exitVariableName = nil;
-    CGFloat minRatio = CGFLOAT_MAX;
-    for (NSString * rowVariableName in self.tableau.rowVariableNames)
+    [self releaseMarkerVariableIDForConstraint:constraint];
+  }
+}
+
+// ===== EDIT VARIABLES ================================================================================================
+#pragma mark - Edit Variables
+
+- (VPLSimplexSolver *)solverForVariable:(NSString *)variableName
+{
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  if (variableID == VPLVariableIDNone) return nil;
+  
+  return [self componentForVariableID:variableID].solver;
+}
+
+- (BOOL)containsEditVariable:(NSString *)variableName
+{
+  return [[self solverForVariable:variableName] containsEditVariable:variableName];
+}
+
+- (void)addEditVariable:(NSString *)variableName
+{
+  [self addEditVariable:variableName
+                 weight:1.0];
+}
+
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight
+{
+  // an edit variable that isn't in any constraint yet gets a component of its own
+  VPLTerm term = { [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName], 1.0 };
+  VPLLinearExpression * variableExpr = [VPLLinearExpression expressionWithConstantValue:0.0
+                                                                                  terms:&term
+                                                                                  count:1];
+  
+  [[self componentForExpression:variableExpr].solver addEditVariable:variableName
+                                                               weight:weight];
+}
+
+- (void)removeEditVariable:(NSString *)variableName
+{
+  VPLSimplexSolver * solver = [self solverForVariable:variableName];
+  NSAssert(solver != nil,
+           @"[%@ %@] Attempt to remove edit variable that doesn't exist: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           variableName);
+  
+  [solver removeEditVariable:variableName];
+}
+
+- (void)suggestValue:(CGFloat)value
+         forVariable:(NSString *)variableName
+{
+  VPLSimplexSolver * solver = [self solverForVariable:variableName];
+  NSAssert(solver != nil,
+           @"[%@ %@] Attempt to suggest a value for %@, which is not an edit variable",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           variableName);
+  
+  [solver suggestValue:value
+           forVariable:variableName];
+}
+
+- (void)resolve
+{
+  // only components that had suggestions need re-solving
+  NSMutableArray * batches = [[NSMutableArray alloc] init];
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    if ([component.solver needsResolve])
     {
-      if (VPLLinearExpressionVariableIsRestricted(rowVariableName))
-      {
-        VPLLinearExpression * rowExpr = [self.tableau expressionForRow:rowVariableName];
-        if ([rowExpr containsVariable:markerVariableName])
-        {
-          CGFloat coeff = [rowExpr coefficientForVariable:markerVariableName];
-          if (coeff < 0.0)
-          {
-            CGFloat ratio = -rowExpr.constantValue / coeff;
-            if (exitVariableName == nil || ratio < minRatio)
-            {
-              minRatio = ratio;
-              exitVariableName = rowVariableName;
-            }
-          }
-        }
-      }
+      VPLConstraintBatch * batch = [[VPLConstraintBatch alloc] init];
+      batch.component = component;
+      [batches addObject:batch];
     }
+  }
+  
+  if ([batches count] == 0) return;
+  
+  [self performBatches:batches
+            usingBlock:^(VPLConstraintBatch * batch) {
+              
+              [batch.component.solver resolve];
+              
+            }];
+}
+
+// ===== VALUES ========================================================================================================
+#pragma mark - Values
+
+- (CGFloat)valueForVariable:(NSString *)variableName
+{
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  if (variableID == VPLVariableIDNone) return 0.0;
+  
+  return [[self componentForVariableID:variableID].solver valueForVariableID:variableID];
+}
+
+- (void)getValues:(CGFloat *)values
+   forVariableIDs:(const VPLVariableID *)variableIDs
+            count:(NSUInteger)count
+{
+  for (NSUInteger variableIndex = 0; variableIndex < count; variableIndex++)
+  {
+    VPLVariableID variableID = variableIDs[variableIndex];
+    VPLConstraintComponent * component = (variableID != VPLVariableIDNone ? [self componentForVariableID:variableID] : nil);
     
-    if (exitVariableName == nil)
-    {
-      // the marker variable is either positive in all restricted row expressions, or only appears in unrestricted rows.
-      //
-      // Let's look again at restricted rows, and pick the one with the smallest ratio
-      for (NSString * rowVariableName in self.tableau.rowVariableNames)
+    // a variable without a component isn't in any constraint, and a parametric one has no row, so both read as 0
+    values[variableIndex] = (component != nil ? [component.solver valueForVariableID:variableID] : 0.0);
+  }
+}
+
+// ===== CHANGED VARIABLES =============================================================================================
+#pragma mark - Changed Variables
+
+- (NSIndexSet *)changedVariableIDs
+{
+  NSMutableIndexSet * changedVariableIDs = [[NSMutableIndexSet alloc] init];
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    [component.solver.tableau.changedRowVariableIDs enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      
+      if (VPLVariableIDIsExternal((VPLVariableID)idx))
       {
-        if (VPLLinearExpressionVariableIsRestricted(rowVariableName))
-        {
-          VPLLinearExpression * rowExpr = [self.tableau expressionForRow:rowVariableName];
-          if ([rowExpr containsVariable:markerVariableName])
-          {
-            CGFloat coeff = [rowExpr coefficientForVariable:markerVariableName];
-            CGFloat ratio = rowExpr.constantValue / coeff;
-            if (exitVariableName == nil || ratio < minRatio)
-            {
-              minRatio = ratio;
-              exitVariableName = rowVariableName;
-            }
-          }
-        }
+        [changedVariableIDs addIndex:idx];
       }
-    }
+      
+    }];
+  }
+  return changedVariableIDs;
+}
+
+- (void)resetChangedVariableIDs
+{
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    [component.solver.tableau resetChangedRowVariableIDs];
+  }
+}
+
+// ===== FORKING =======================================================================================================
+#pragma mark - Forking
+
+- (VPLConstraintSet *)constraintSetByForking
+{
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  constraintSet->_pivotRule = self.pivotRule;
+  constraintSet.markerCount = self.markerCount;
+  [constraintSet.freeMarkerIndexes addIndexes:self.freeMarkerIndexes];
+  for (VPLConstraint * constraint in self.markerVariableIDsByConstraint)
+  {
+    [constraintSet.markerVariableIDsByConstraint setObject:[self.markerVariableIDsByConstraint objectForKey:constraint]
+                                                    forKey:constraint];
+  }
+  
+  // Each root component gets a fork of its solver. Merged components aren't needed by the fork, so every variable maps
+  // straight to the fork of its root component.
+  NSMapTable * forkedComponents = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                                        valueOptions:NSPointerFunctionsStrongMemory];
+  for (VPLConstraintComponent * component in self.rootComponents)
+  {
+    VPLConstraintComponent * forkedComponent = [[VPLConstraintComponent alloc] init];
+    forkedComponent.variableCount = component.variableCount;
+    forkedComponent.solver = [component.solver copy];
     
-    if (exitVariableName == nil)
-    {
-      // the marker variable only appears in unrestricted row expressions. Pick any, but prefer the original equation
-      VPLLinearExpression * originalExpr = [self.tableau expressionForRow:constraint.variableName];
-      if (originalExpr != nil
-          && [originalExpr containsVariable:markerVariableName])
-      {
-        exitVariableName = constraint.variableName;
-      }
-      else
-      {
-        for (NSString * rowVariableName in self.tableau.rowVariableNames)
-        {
-          VPLLinearExpression * rowExpr = [self.tableau expressionForRow:rowVariableName];
-          if ([rowExpr containsVariable:markerVariableName])
-          {
-            exitVariableName = rowVariableName;
-            break;
-          }
-        }
-      }
-    }
+    [forkedComponents setObject:forkedComponent
+                         forKey:component];
+    [constraintSet.rootComponents addObject:forkedComponent];
+  }
+  
+  NSMutableDictionary * componentsByVariableID = constraintSet.componentsByVariableID;
+  [self.componentsByVariableID enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
     
-    if (exitVariableName != nil)
-    {
-      VPLTableau * tableau = [self.tableau tableauByPivotingRowVariable:exitVariableName
-                                                        columnVariable:markerVariableName];
-      _tableau = [tableau tableauByRemovingExpressionForRow:markerVariableName];
-    }
-    // else the marker variable doesn't appear in any equations
+    [componentsByVariableID setObject:[forkedComponents objectForKey:[self rootComponent:obj]]
+                               forKey:key];
+    
+  }];
+  
+  return constraintSet;
+}
+
+- (NSArray *)constraintSetsByApplyingVariants:(NSArray *)variants
+{
+  // forking changes which tableau nodes this constraint set may change in place, so every fork is taken here, before
+  // any of the variants start
+  NSMutableArray * constraintSets = [[NSMutableArray alloc] initWithCapacity:[variants count]];
+  for (NSUInteger variantIndex = 0; variantIndex < [variants count]; variantIndex++)
+  {
+    [constraintSets addObject:[self constraintSetByForking]];
   }
+  
+  // the forks share nothing that either of them changes, so each one can be run on a thread of its own
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply([variants count], queue, ^(size_t variantIndex) {
+    
+    VPLConstraintSetVariant variant = [variants objectAtIndex:variantIndex];
+    VPLConstraintSet * constraintSet = [constraintSets objectAtIndex:variantIndex];
+    
+    variant(constraintSet);
+    [constraintSet resolve];
+    
+  });
+  
+  return constraintSets;
 }
 
 @end
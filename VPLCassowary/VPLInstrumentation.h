@@ -0,0 +1,134 @@
+#import "VPLCassowaryTypes.h"
+
+/**
+ * Instrumentation is compiled in unless `VPL_INSTRUMENTATION` is defined as 0, and even then only collects anything
+ * after `+[VPLInstrumentation setEnabled:YES]`. While disabled, each instrumentation point costs a single branch.
+ */
+#ifndef VPL_INSTRUMENTATION
+#define VPL_INSTRUMENTATION 1
+#endif
+
+// ===== MEASUREMENTS ==================================================================================================
+#pragma mark - Measurements
+
+typedef enum _VPLInstrumentationCounter {
+
+  VPLInstrumentationCounterConstraintsAdded = 0,
+  VPLInstrumentationCounterConstraintsRemoved,
+  VPLInstrumentationCounterArtificialPhases,
+  VPLInstrumentationCounterPivots,
+  VPLInstrumentationCounterSubstitutions,
+  VPLInstrumentationCounterRowsTouched,
+  VPLInstrumentationCounterTermsPruned,
+  VPLInstrumentationCounterFillInTerms,
+  VPLInstrumentationCounterLayoutCacheHits,
+  VPLInstrumentationCounterLayoutCacheMisses,
+  VPLInstrumentationCounterTextMeasurementHits,
+  VPLInstrumentationCounterTextMeasurementMisses,
+
+  VPLInstrumentationCounterCount
+
+} VPLInstrumentationCounter;
+
+/**
+ * Gauges keep the largest value recorded, such as the largest tableau seen over a whole run.
+ */
+typedef enum _VPLInstrumentationGauge {
+
+  VPLInstrumentationGaugeTableauRows = 0,
+  VPLInstrumentationGaugeTableauTerms,
+  VPLInstrumentationGaugeTableauMaximumRowLength,
+
+  VPLInstrumentationGaugeCount
+
+} VPLInstrumentationGauge;
+
+typedef enum _VPLInstrumentationPhase {
+
+  VPLInstrumentationPhaseBuildConstraints = 0,
+  VPLInstrumentationPhaseSolve,
+  VPLInstrumentationPhaseExtractFrames,
+  VPLInstrumentationPhaseDraw,
+  VPLInstrumentationPhaseEncodePNG,
+  VPLInstrumentationPhaseWriteLayout,
+
+  VPLInstrumentationPhaseCount
+
+} VPLInstrumentationPhase;
+
+// ===== RECORDING =====================================================================================================
+#pragma mark - Recording
+
+extern BOOL VPLInstrumentationEnabled;
+
+void VPLInstrumentationAddToCounter(VPLInstrumentationCounter counter, int64_t amount);
+
+void VPLInstrumentationRecordGauge(VPLInstrumentationGauge gauge, int64_t value);
+
+uint64_t VPLInstrumentationCurrentTime(void);
+
+void VPLInstrumentationAddPhaseTime(VPLInstrumentationPhase phase, uint64_t startTime);
+
+/**
+ * Instrumentation points should use these macros rather than the functions above, so they compile out entirely:
+ *
+ *     uint64_t startTime = VPLInstrumentationPhaseStart();
+ *     ...
+ *     VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseSolve, startTime);
+ */
+#if VPL_INSTRUMENTATION
+
+#define VPLInstrumentationCount(counter, amount) \
+  do { if (VPLInstrumentationEnabled) VPLInstrumentationAddToCounter((counter), (amount)); } while (0)
+
+#define VPLInstrumentationRecordMaximum(gauge, value) \
+  do { if (VPLInstrumentationEnabled) VPLInstrumentationRecordGauge((gauge), (value)); } while (0)
+
+#define VPLInstrumentationPhaseStart() \
+  (VPLInstrumentationEnabled ? VPLInstrumentationCurrentTime() : (uint64_t)0)
+
+#define VPLInstrumentationPhaseEnd(phase, startTime) \
+  do { if ((startTime) != 0) VPLInstrumentationAddPhaseTime((phase), (startTime)); } while (0)
+
+#else
+
+#define VPLInstrumentationCount(counter, amount) do { } while (0)
+#define VPLInstrumentationRecordMaximum(gauge, value) do { } while (0)
+#define VPLInstrumentationPhaseStart() ((uint64_t)0)
+#define VPLInstrumentationPhaseEnd(phase, startTime) do { (void)(startTime); } while (0)
+
+#endif
+
+/**
+ * Collects counters and timings from the solver and the layout pipeline, for the whole process. Recording is thread
+ * safe, so components solved concurrently all add to the same totals.
+ */
+@interface VPLInstrumentation : NSObject
+
+// ===== ENABLING ======================================================================================================
+#pragma mark - Enabling
+
+/**
+ * Whether measurements are being recorded. Always NO when compiled without `VPL_INSTRUMENTATION`.
+ */
++ (BOOL)isEnabled;
+
++ (void)setEnabled:(BOOL)enabled;
+
+// ===== STATISTICS ====================================================================================================
+#pragma mark - Statistics
+
+/**
+ * A property list of everything recorded since the last `+reset`, suitable for `NSJSONSerialization`:
+ *
+ *     {
+ *       "counters" : { "pivots" : 120, ... },
+ *       "gauges" : { "tableauRows" : 48, ... },
+ *       "phases" : { "solve" : { "count" : 3, "seconds" : 0.0021 }, ... }
+ *     }
+ */
++ (NSDictionary *)statistics;
+
++ (void)reset;
+
+@end
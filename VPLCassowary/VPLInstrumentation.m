@@ -0,0 +1,157 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLInstrumentation.h"
+#import <mach/mach_time.h>
+#import <stdatomic.h>
+
+BOOL VPLInstrumentationEnabled = NO;
+
+static _Atomic int64_t VPLInstrumentationCounters[VPLInstrumentationCounterCount];
+static _Atomic int64_t VPLInstrumentationGauges[VPLInstrumentationGaugeCount];
+static _Atomic uint64_t VPLInstrumentationPhaseTimes[VPLInstrumentationPhaseCount];    // in mach absolute time units
+static _Atomic int64_t VPLInstrumentationPhaseCounts[VPLInstrumentationPhaseCount];
+
+static NSString * const VPLInstrumentationCounterNames[VPLInstrumentationCounterCount] = {
+  @"constraintsAdded",
+  @"constraintsRemoved",
+  @"artificialPhases",
+  @"pivots",
+  @"substitutions",
+  @"rowsTouched",
+  @"termsPruned",
+  @"fillInTerms",
+  @"layoutCacheHits",
+  @"layoutCacheMisses",
+  @"textMeasurementHits",
+  @"textMeasurementMisses",
+};
+
+static NSString * const VPLInstrumentationGaugeNames[VPLInstrumentationGaugeCount] = {
+  @"tableauRows",
+  @"tableauTerms",
+  @"tableauMaximumRowLength",
+};
+
+static NSString * const VPLInstrumentationPhaseNames[VPLInstrumentationPhaseCount] = {
+  @"buildConstraints",
+  @"solve",
+  @"extractFrames",
+  @"draw",
+  @"encodePNG",
+  @"writeLayout",
+};
+
+// ===== RECORDING =====================================================================================================
+#pragma mark - Recording
+
+void
+VPLInstrumentationAddToCounter(VPLInstrumentationCounter counter, int64_t amount)
+{
+  atomic_fetch_add_explicit(&VPLInstrumentationCounters[counter], amount, memory_order_relaxed);
+}
+
+void
+VPLInstrumentationRecordGauge(VPLInstrumentationGauge gauge, int64_t value)
+{
+  int64_t maximum = atomic_load_explicit(&VPLInstrumentationGauges[gauge], memory_order_relaxed);
+  while (value > maximum
+         && !atomic_compare_exchange_weak_explicit(&VPLInstrumentationGauges[gauge],
+                                                   &maximum,
+                                                   value,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed))
+  {
+    // maximum was reloaded by the failed exchange
+  }
+}
+
+uint64_t
+VPLInstrumentationCurrentTime(void)
+{
+  return mach_absolute_time();
+}
+
+void
+VPLInstrumentationAddPhaseTime(VPLInstrumentationPhase phase, uint64_t startTime)
+{
+  uint64_t elapsedTime = mach_absolute_time() - startTime;
+  atomic_fetch_add_explicit(&VPLInstrumentationPhaseTimes[phase], elapsedTime, memory_order_relaxed);
+  atomic_fetch_add_explicit(&VPLInstrumentationPhaseCounts[phase], 1, memory_order_relaxed);
+}
+
+@implementation VPLInstrumentation
+
+// ===== ENABLING ======================================================================================================
+#pragma mark - Enabling
+
++ (BOOL)isEnabled
+{
+  return VPLInstrumentationEnabled;
+}
+
++ (void)setEnabled:(BOOL)enabled
+{
+#if VPL_INSTRUMENTATION
+  VPLInstrumentationEnabled = enabled;
+#endif
+}
+
+// ===== STATISTICS ====================================================================================================
+#pragma mark - Statistics
+
++ (NSDictionary *)statistics
+{
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+
+  NSMutableDictionary * counters = [[NSMutableDictionary alloc] init];
+  for (NSUInteger counter = 0; counter < VPLInstrumentationCounterCount; counter++)
+  {
+    counters[VPLInstrumentationCounterNames[counter]] = @(atomic_load(&VPLInstrumentationCounters[counter]));
+  }
+
+  NSMutableDictionary * gauges = [[NSMutableDictionary alloc] init];
+  for (NSUInteger gauge = 0; gauge < VPLInstrumentationGaugeCount; gauge++)
+  {
+    gauges[VPLInstrumentationGaugeNames[gauge]] = @(atomic_load(&VPLInstrumentationGauges[gauge]));
+  }
+
+  NSMutableDictionary * phases = [[NSMutableDictionary alloc] init];
+  for (NSUInteger phase = 0; phase < VPLInstrumentationPhaseCount; phase++)
+  {
+    double nanoseconds = (double)atomic_load(&VPLInstrumentationPhaseTimes[phase]) * timebase.numer / timebase.denom;
+    phases[VPLInstrumentationPhaseNames[phase]] = @{
+      @"count" : @(atomic_load(&VPLInstrumentationPhaseCounts[phase])),
+      @"seconds" : @(nanoseconds / 1.0e9),
+    };
+  }
+
+  return @{
+    @"counters" : counters,
+    @"gauges" : gauges,
+    @"phases" : phases,
+  };
+}
+
++ (void)reset
+{
+  for (NSUInteger counter = 0; counter < VPLInstrumentationCounterCount; counter++)
+  {
+    atomic_store(&VPLInstrumentationCounters[counter], 0);
+  }
+
+  for (NSUInteger gauge = 0; gauge < VPLInstrumentationGaugeCount; gauge++)
+  {
+    atomic_store(&VPLInstrumentationGauges[gauge], 0);
+  }
+
+  for (NSUInteger phase = 0; phase < VPLInstrumentationPhaseCount; phase++)
+  {
+    atomic_store(&VPLInstrumentationPhaseTimes[phase], 0);
+    atomic_store(&VPLInstrumentationPhaseCounts[phase], 0);
+  }
+}
+
+@end
@@ -0,0 +1,74 @@
+#import <Foundation/Foundation.h>
+
+extern NSString * const VPLJSONScannerErrorDomain;
+
+typedef enum _VPLJSONScannerError {
+
+  VPLJSONScannerErrorNone = 0,
+  VPLJSONScannerErrorInvalidSyntax
+
+} VPLJSONScannerError;
+
+/**
+ * Reads a JSON document a piece at a time, straight from its bytes, without building Foundation objects for the parts
+ * that aren't needed. The caller walks the document with the `scan...` methods, and passes over values it isn't
+ * interested in with `-skipValue`; a skipped value's bytes can be handed to `NSJSONSerialization` later.
+ *
+ * As with `NSJSONSerialization`, a trailing comma at the end of a scanned object or array is a syntax error. Skipped
+ * values are only checked for balanced brackets and terminated strings, so it's left to `NSJSONSerialization` to reject
+ * one inside them.
+ *
+ * Every method returns NO on a syntax error, after which `error` describes where the error is.
+ */
+@interface VPLJSONScanner : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+/**
+ * `data` must be UTF-8. It isn't copied, so it can be a mapped file.
+ */
+- (instancetype)initWithData:(NSData *)data;
+
+@property (nonatomic, strong, readonly) NSData * data;
+
+// ===== LOCATION ======================================================================================================
+#pragma mark - Location
+
+@property (nonatomic, assign, readonly) NSUInteger location;
+
+/**
+ * Skips whitespace, and returns the location of the next value.
+ */
+- (NSUInteger)locationOfNextValue;
+
+// ===== SCANNING ======================================================================================================
+#pragma mark - Scanning
+
+/**
+ * Scans an object, calling `block` with each key. The scanner is left at the key's value, which the block must scan or
+ * skip. The block returns NO to stop scanning; unless it has caused a syntax error, the scan is then treated as having
+ * failed on the value.
+ */
+- (BOOL)scanObjectUsingBlock:(BOOL (^)(NSString * key))block;
+
+/**
+ * Scans an array, calling `block` at each element, which the block must scan or skip.
+ */
+- (BOOL)scanArrayUsingBlock:(BOOL (^)(NSUInteger index))block;
+
+- (BOOL)scanString:(NSString * __autoreleasing *)string;
+
+- (BOOL)skipValue;
+
+/**
+ * Checks that nothing but whitespace follows the scanner's location.
+ */
+- (BOOL)scanEnd;
+
+// ===== ERRORS ========================================================================================================
+#pragma mark - Errors
+
+@property (nonatomic, strong, readonly) NSError * error;
+
+@end
@@ -0,0 +1,323 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLJSONScanner.h"
+
+NSString * const VPLJSONScannerErrorDomain = @"com.vulpinelabs.VPLJSONScanner";
+
+static inline BOOL
+VPLJSONIsWhitespace(uint8_t character)
+{
+  return character == ' ' || character == '\t' || character == '\n' || character == '\r';
+}
+
+static inline BOOL
+VPLJSONIsDelimiter(uint8_t character)
+{
+  return (VPLJSONIsWhitespace(character)
+          || character == ',' || character == ':' || character == '}' || character == ']');
+}
+
+@interface VPLJSONScanner ()
+{
+  const uint8_t * _bytes;
+  NSUInteger _length;
+}
+
+@property (nonatomic, assign, readwrite) NSUInteger location;
+@property (nonatomic, strong, readwrite) NSError * error;
+
+@end
+
+@implementation VPLJSONScanner
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithData:(NSData *)data
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _data = data;
+    _bytes = [data bytes];
+    _length = [data length];
+    _location = 0;
+  }
+  return self;
+}
+
+// ===== LOCATION ======================================================================================================
+#pragma mark - Location
+
+- (void)skipWhitespace
+{
+  while (_location < _length && VPLJSONIsWhitespace(_bytes[_location]))
+  {
+    _location++;
+  }
+}
+
+- (NSUInteger)locationOfNextValue
+{
+  [self skipWhitespace];
+  return _location;
+}
+
+- (BOOL)scanCharacter:(uint8_t)character
+{
+  [self skipWhitespace];
+  if (_location < _length && _bytes[_location] == character)
+  {
+    _location++;
+    return YES;
+  }
+  return NO;
+}
+
+// ===== SCANNING ======================================================================================================
+#pragma mark - Scanning
+
+- (BOOL)scanObjectUsingBlock:(BOOL (^)(NSString * key))block
+{
+  if (![self scanCharacter:'{'])
+  {
+    return [self failWithReason:@"expected an object"];
+  }
+
+  if ([self scanCharacter:'}'])
+  {
+    return YES;
+  }
+
+  // a comma is always followed by another key, so a trailing comma fails on the closing brace
+  do
+  {
+    NSString * key = nil;
+    if (![self scanString:&key])
+    {
+      return NO;
+    }
+
+    if (![self scanCharacter:':'])
+    {
+      return [self failWithReason:@"expected ':'"];
+    }
+
+    if (!block(key))
+    {
+      NSString * reason = [NSString stringWithFormat:@"invalid value for '%@'", key];
+      return (self.error != nil ? NO : [self failWithReason:reason]);
+    }
+  }
+  while ([self scanCharacter:',']);
+
+  return ([self scanCharacter:'}'] ? YES : [self failWithReason:@"expected ',' or '}'"]);
+}
+
+- (BOOL)scanArrayUsingBlock:(BOOL (^)(NSUInteger index))block
+{
+  if (![self scanCharacter:'['])
+  {
+    return [self failWithReason:@"expected an array"];
+  }
+
+  if ([self scanCharacter:']'])
+  {
+    return YES;
+  }
+
+  NSUInteger index = 0;
+  do
+  {
+    if (!block(index))
+    {
+      return (self.error != nil ? NO : [self failWithReason:@"invalid array element"]);
+    }
+    index++;
+  }
+  while ([self scanCharacter:',']);
+
+  return ([self scanCharacter:']'] ? YES : [self failWithReason:@"expected ',' or ']'"]);
+}
+
+/**
+ * Moves past a string that starts at the scanner's location, and returns the range of its contents.
+ */
+- (BOOL)skipStringWithContentsRange:(NSRange *)contentsRange
+                         hasEscapes:(BOOL *)hasEscapes
+{
+  if (_location >= _length || _bytes[_location] != '"')
+  {
+    return [self failWithReason:@"expected a string"];
+  }
+  _location++;
+
+  NSUInteger start = _location;
+  *hasEscapes = NO;
+  while (_location < _length && _bytes[_location] != '"')
+  {
+    if (_bytes[_location] == '\\')
+    {
+      *hasEscapes = YES;
+      _location++;
+    }
+    _location++;
+  }
+
+  if (_location >= _length)
+  {
+    return [self failWithReason:@"unterminated string"];
+  }
+
+  *contentsRange = NSMakeRange(start, _location - start);
+  _location++;
+  return YES;
+}
+
+- (BOOL)scanString:(NSString * __autoreleasing *)string
+{
+  [self skipWhitespace];
+
+  NSRange contentsRange;
+  BOOL hasEscapes = NO;
+  if (![self skipStringWithContentsRange:&contentsRange hasEscapes:&hasEscapes])
+  {
+    return NO;
+  }
+
+  NSString * value = nil;
+  if (!hasEscapes)
+  {
+    value = [[NSString alloc] initWithBytes:_bytes + contentsRange.location
+                                     length:contentsRange.length
+                                   encoding:NSUTF8StringEncoding];
+  }
+  else
+  {
+    // escapes are rare enough in keys and filenames to leave to NSJSONSerialization, quotes and all
+    NSData * quotedString = [NSData dataWithBytes:_bytes + contentsRange.location - 1
+                                           length:contentsRange.length + 2];
+    value = [NSJSONSerialization JSONObjectWithData:quotedString
+                                            options:NSJSONReadingAllowFragments
+                                              error:NULL];
+  }
+
+  if (![value isKindOfClass:[NSString class]])
+  {
+    return [self failWithReason:@"invalid string"];
+  }
+
+  *string = value;
+  return YES;
+}
+
+- (BOOL)skipValue
+{
+  [self skipWhitespace];
+  if (_location >= _length)
+  {
+    return [self failWithReason:@"unexpected end of data"];
+  }
+
+  NSRange contentsRange;
+  BOOL hasEscapes = NO;
+  uint8_t character = _bytes[_location];
+  if (character == '"')
+  {
+    return [self skipStringWithContentsRange:&contentsRange hasEscapes:&hasEscapes];
+  }
+
+  // numbers, true, false and null run up to the next delimiter
+  if (character != '{' && character != '[')
+  {
+    NSUInteger start = _location;
+    while (_location < _length && !VPLJSONIsDelimiter(_bytes[_location]))
+    {
+      _location++;
+    }
+    return (_location > start ? YES : [self failWithReason:@"expected a value"]);
+  }
+
+  // containers only have to be balanced, so they're skipped a character at a time with a stack of closing brackets
+  NSMutableData * closingBrackets = [[NSMutableData alloc] init];
+  do
+  {
+    if (_location >= _length)
+    {
+      return [self failWithReason:@"unexpected end of data"];
+    }
+
+    character = _bytes[_location];
+    if (character == '"')
+    {
+      if (![self skipStringWithContentsRange:&contentsRange hasEscapes:&hasEscapes])
+      {
+        return NO;
+      }
+      continue;
+    }
+
+    if (character == '{' || character == '[')
+    {
+      uint8_t closingBracket = (character == '{' ? '}' : ']');
+      [closingBrackets appendBytes:&closingBracket length:1];
+    }
+    else if (character == '}' || character == ']')
+    {
+      const uint8_t * brackets = [closingBrackets bytes];
+      if (brackets[[closingBrackets length] - 1] != character)
+      {
+        return [self failWithReason:[NSString stringWithFormat:@"unexpected '%c'", character]];
+      }
+      [closingBrackets setLength:[closingBrackets length] - 1];
+    }
+    _location++;
+  }
+  while ([closingBrackets length] > 0);
+
+  return YES;
+}
+
+- (BOOL)scanEnd
+{
+  [self skipWhitespace];
+  return (_location == _length ? YES : [self failWithReason:@"unexpected data after the end of the document"]);
+}
+
+// ===== ERRORS ========================================================================================================
+#pragma mark - Errors
+
+- (BOOL)failWithReason:(NSString *)reason
+{
+  if (self.error != nil)
+  {
+    return NO;
+  }
+
+  // lines and columns are only worked out for the error, since it means going back over the data
+  NSUInteger line = 1;
+  NSUInteger lineStart = 0;
+  for (NSUInteger location = 0; location < MIN(_location, _length); location++)
+  {
+    if (_bytes[location] == '\n')
+    {
+      line++;
+      lineStart = location + 1;
+    }
+  }
+
+  NSString * localizedErrorFormat = NSLocalizedString(@"Invalid JSON at line %lu, column %lu: %@", nil);
+  NSString * localizedErrorMsg = [NSString stringWithFormat:localizedErrorFormat,
+                                                            (unsigned long)line,
+                                                            (unsigned long)(_location - lineStart + 1),
+                                                            reason];
+
+  self.error = [NSError errorWithDomain:VPLJSONScannerErrorDomain
+                                   code:VPLJSONScannerErrorInvalidSyntax
+                               userInfo:@{ NSLocalizedDescriptionKey : localizedErrorMsg }];
+  return NO;
+}
+
+@end
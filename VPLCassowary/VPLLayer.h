@@ -1,10 +1,19 @@
 #import <Foundation/Foundation.h>
+#import "VPLSymbolTable.h"
+
+@class VPLConstraintSet;
+@class VPLLayoutFingerprint;
 
 @interface VPLLayer : NSObject
 
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
 
+- (instancetype)initWithIdentifier:(NSString *)identifier;
+
+- (instancetype)initWithIdentifier:(NSString *)identifier
+                 layoutConstraints:(NSArray *)layoutConstraints;
+
 + (instancetype)layerWithDictionary:(NSDictionary *)layerDictionary
                               error:(NSError * __autoreleasing *)error;
 
@@ -20,13 +29,66 @@
 
 @property (nonatomic, assign, readonly) CGSize intrinsicContentSize;
 
+// ===== VARIABLES =====================================================================================================
+#pragma mark - Variables
+
+/**
+ * The ids of the variables that hold the layer's frame in a constraint set, named `identifier.x` and so on. They're
+ * interned once, when the layer is created, so a solution can be read back without building or looking up names. A
+ * layer without an identifier has no variables, and its ids are `VPLVariableIDNone`.
+ */
+@property (nonatomic, assign, readonly) VPLVariableID xVariableID;
+@property (nonatomic, assign, readonly) VPLVariableID yVariableID;
+@property (nonatomic, assign, readonly) VPLVariableID widthVariableID;
+@property (nonatomic, assign, readonly) VPLVariableID heightVariableID;
+
 // ===== CONSTRAINTS ===================================================================================================
 #pragma mark - Constraints
 
 @property (nonatomic, strong, readonly) NSArray * layoutConstraints;
 
+/**
+ * Brings the layer's intrinsic content size up to date in its constraint set. The intrinsic width and height are edit
+ * variables, so a change only suggests new values; it's called automatically when the layer's text changes.
+ */
 - (void)updateConstraints;
 
+// ===== CONSTRAINT SET ================================================================================================
+#pragma mark - Constraint Set
+
+/**
+ * The constraint set that the layer's constraints are kept in. Only the root of a layer tree is attached to a
+ * constraint set; its sublayers return their superlayer's. Nil if the layer tree isn't attached.
+ */
+@property (nonatomic, strong, readonly) VPLConstraintSet * constraintSet;
+
+/**
+ * Adds the constraints and intrinsic sizes of this layer and all of its sublayers to `constraintSet`, and keeps them up
+ * to date from then on: inserting a sublayer adds just that subtree's constraints, removing one removes just its
+ * constraints, and changing a layer's text suggests its new intrinsic size. Returns the constraints that couldn't be
+ * satisfied.
+ *
+ * The layer must be the root of its layer tree.
+ */
+- (NSArray *)attachToConstraintSet:(VPLConstraintSet *)constraintSet;
+
+/**
+ * Removes the layer tree's constraints from its constraint set, and stops keeping them up to date.
+ */
+- (void)detachFromConstraintSet;
+
+/**
+ * Returns the layer in this layer's tree that one of the frame variables belongs to. Only the layers of an attached
+ * tree are indexed, so returns nil if the tree isn't attached.
+ */
+- (VPLLayer *)attachedLayerForVariableID:(VPLVariableID)variableID;
+
+/**
+ * Adds the constraints and intrinsic sizes of this layer and all of its sublayers to `fingerprint`, just as
+ * `-attachToConstraintSet:` would add them to a constraint set.
+ */
+- (void)addSubtreeToLayoutFingerprint:(VPLLayoutFingerprint *)fingerprint;
+
 // ===== LAYER HIERARCHY ===============================================================================================
 #pragma mark - Layer Hierarchy
 
@@ -40,6 +102,11 @@
 
 - (void)removeFromSuperlayer;
 
+/**
+ * This layer and all of its descendents, in the order they're added to a constraint set.
+ */
+- (NSArray *)subtreeLayers;
+
 // ===== TEXT ==========================================================================================================
 #pragma mark - Text
 
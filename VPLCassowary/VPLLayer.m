@@ -1,5 +1,18 @@
 #import "VPLLayer.h"
 #import "VPLLayoutConstraint.h"
+#import "VPLConstraintSet.h"
+#import "VPLLayoutCache.h"
+#import "VPLTextMeasurementCache.h"
+
+/**
+ * Intrinsic sizes are edit variables rather than required constraints, so that changing a layer's text only suggests
+ * new values. They're weighted above strong constraints, so that they still win when they conflict, but below the size
+ * the asset is drawn at (see `VPLAssetRepresentationSizeWeight`), which must hold for the drawing to match the layout.
+ */
+static const CGFloat VPLLayerIntrinsicContentSizeWeight = 1000.0;
+
+static NSString * const VPLLayerFontName = @"Helvetica Neue";
+static const CGFloat VPLLayerFontSize = 17.0;
 
 @interface VPLLayer ()
 
@@ -11,8 +24,15 @@
 
 @property (nonatomic, strong, readwrite) NSArray * layoutConstraints;
 
-@property (nonatomic, strong, readwrite) VPLLayoutConstraint * intrinsicWidthConstraint;
-@property (nonatomic, strong, readwrite) VPLLayoutConstraint * intrinsicHeightConstraint;
+@property (nonatomic, assign, readwrite) BOOL editsIntrinsicWidth;
+@property (nonatomic, assign, readwrite) BOOL editsIntrinsicHeight;
+
+// ===== CONSTRAINT SET ================================================================================================
+#pragma mark - Constraint Set
+
+// only set on the root layer of an attached tree
+@property (nonatomic, strong, readwrite) VPLConstraintSet * attachedConstraintSet;
+@property (nonatomic, strong, readwrite) NSMutableDictionary * attachedLayersByVariableID;
 
 @property (nonatomic, assign, readwrite) CTFramesetterRef textFramesetterRef;
 @property (nonatomic, assign, readwrite) CFAttributedStringRef attributedTextRef;
@@ -30,6 +50,13 @@
 }
 
 - (instancetype)initWithIdentifier:(NSString *)identifier
+{
+  return [self initWithIdentifier:identifier
+                layoutConstraints:@[]];
+}
+
+- (instancetype)initWithIdentifier:(NSString *)identifier
+                 layoutConstraints:(NSArray *)layoutConstraints
 {
   self = [super init];
   if (self != nil)
@@ -37,7 +64,21 @@
     _sublayers = @[];
     _identifier = identifier;
     _frame = CGRectZero;
-    _layoutConstraints = @[];
+    _layoutConstraints = [layoutConstraints copy];
+    
+    _xVariableID = VPLVariableIDNone;
+    _yVariableID = VPLVariableIDNone;
+    _widthVariableID = VPLVariableIDNone;
+    _heightVariableID = VPLVariableIDNone;
+    
+    if (identifier != nil)
+    {
+      VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+      _xVariableID = [symbolTable variableIDForName:[self variableNameForAttribute:@"x"]];
+      _yVariableID = [symbolTable variableIDForName:[self variableNameForAttribute:@"y"]];
+      _widthVariableID = [symbolTable variableIDForName:[self variableNameForAttribute:@"width"]];
+      _heightVariableID = [symbolTable variableIDForName:[self variableNameForAttribute:@"height"]];
+    }
   }
   return self;
 }
@@ -94,7 +135,12 @@
   {
     for (NSDictionary * constraintData in constraintsDataArray)
     {
-      VPLLayoutConstraint * layoutConstraint = [[VPLLayoutConstraint alloc] initWithDictionary:constraintData];
+      VPLLayoutConstraint * layoutConstraint = [[VPLLayoutConstraint alloc] initWithDictionary:constraintData
+                                                                                          error:error];
+      if (layoutConstraint == nil)
+      {
+        return nil;
+      }
       [layoutConstraints addObject:layoutConstraint];
     }
   }
@@ -110,6 +156,8 @@
     CGColorRelease(_backgroundColorRef);
     _backgroundColorRef = NULL;
   }
+  
+  [self releaseText];
 
   for (VPLLayer * sublayer in [self.sublayers copy])
   {
@@ -134,15 +182,14 @@ CFStringFromNSString(NSString * string)
 
 - (CGSize)intrinsicContentSize
 {
-  CTFramesetterRef framesetterRef = self.textFramesetterRef;
-  if (framesetterRef != NULL)
+  if (self.text != nil)
   {
-    CGSize textSize = CTFramesetterSuggestFrameSizeWithConstraints(self.textFramesetterRef,
-                                                                   CFRangeMake(0, 0), // the whole string
-                                                                   NULL,
-                                                                   CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX), // unconstrained
-                                                                   NULL);
-    
+    // measured through the shared cache, so the same label in many layers is only measured once
+    VPLTextMeasurementCache * textMeasurementCache = [VPLTextMeasurementCache sharedTextMeasurementCache];
+    CGSize textSize = [textMeasurementCache sizeOfText:self.text
+                                              fontName:VPLLayerFontName
+                                              fontSize:VPLLayerFontSize
+                                           constraints:CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX)]; // unconstrained
     
     textSize.width = ceil(textSize.width);
     textSize.height = ceil(textSize.height);
@@ -158,55 +205,243 @@ CFStringFromNSString(NSString * string)
 // ===== CONSTRAINTS ===================================================================================================
 #pragma mark - Constraints
 
+- (NSString *)variableNameForAttribute:(NSString *)attribute
+{
+  return [NSString stringWithFormat:@"%@.%@", self.identifier, attribute];
+}
+
 - (void)updateConstraints
 {
-  NSMutableArray * updatedConstraints = [[NSMutableArray alloc] initWithArray:self.layoutConstraints];
+  VPLConstraintSet * constraintSet = self.constraintSet;
+  if (constraintSet == nil) return;
+  
+  // the root layer's size is the size its representation is drawn at, which edits the same variables
+  if (self.superlayer == nil) return;
+  
+  CGSize intrinsicContentSize = self.intrinsicContentSize;
+  self.editsIntrinsicWidth = [self suggestIntrinsicValue:intrinsicContentSize.width
+                                            forAttribute:@"width"
+                                          isEditVariable:self.editsIntrinsicWidth
+                                           constraintSet:constraintSet];
+  
+  self.editsIntrinsicHeight = [self suggestIntrinsicValue:intrinsicContentSize.height
+                                             forAttribute:@"height"
+                                           isEditVariable:self.editsIntrinsicHeight
+                                            constraintSet:constraintSet];
+}
+
+/**
+ * Suggests an intrinsic dimension, adding its edit variable first if needed. A negative value means the layer has no
+ * intrinsic size in that dimension, so the edit variable is removed instead. Returns whether the edit variable exists
+ * afterwards.
+ */
+- (BOOL)suggestIntrinsicValue:(CGFloat)value
+                 forAttribute:(NSString *)attribute
+               isEditVariable:(BOOL)isEditVariable
+                constraintSet:(VPLConstraintSet *)constraintSet
+{
+  NSString * variableName = [self variableNameForAttribute:attribute];
+  
+  if (value < 0)
+  {
+    if (isEditVariable)
+    {
+      [constraintSet removeEditVariable:variableName];
+    }
+    return NO;
+  }
   
-  if (self.intrinsicWidthConstraint != nil)
+  if (!isEditVariable)
   {
-    [updatedConstraints removeObject:self.intrinsicWidthConstraint];
-    self.intrinsicWidthConstraint = nil;
+    [constraintSet addEditVariable:variableName
+                            weight:VPLLayerIntrinsicContentSizeWeight];
   }
   
-  if (self.intrinsicHeightConstraint != nil)
+  [constraintSet suggestValue:value
+                  forVariable:variableName];
+  return YES;
+}
+
+- (void)removeIntrinsicContentSizeFromConstraintSet:(VPLConstraintSet *)constraintSet
+{
+  if (self.editsIntrinsicWidth)
   {
-    [updatedConstraints removeObject:self.intrinsicHeightConstraint];
-    self.intrinsicHeightConstraint = nil;
+    [constraintSet removeEditVariable:[self variableNameForAttribute:@"width"]];
+    self.editsIntrinsicWidth = NO;
   }
   
-  CGSize intrinsicContentSize = self.intrinsicContentSize;
-  NSLog(@"%@.intrinsicContentSize.width == %f", self.identifier, intrinsicContentSize.width);
-  if (intrinsicContentSize.width >= 0)
+  if (self.editsIntrinsicHeight)
   {
-    // setup a width constraint
-    self.intrinsicWidthConstraint = [[VPLLayoutConstraint alloc] initWithSubject:self.identifier
-                                                                      attribute:@"width"
-                                                                   relationship:@"=="
-                                                                  relatedObject:nil
-                                                               relatedAttribute:nil
-                                                                     multiplier:0
-                                                                       constant:intrinsicContentSize.width];
+    [constraintSet removeEditVariable:[self variableNameForAttribute:@"height"]];
+    self.editsIntrinsicHeight = NO;
+  }
+}
+
+// ===== CONSTRAINT SET ================================================================================================
+#pragma mark - Constraint Set
+
+- (VPLLayer *)attachedRootLayer
+{
+  return (self.attachedConstraintSet != nil ? self : self.superlayer.attachedRootLayer);
+}
+
+- (VPLConstraintSet *)constraintSet
+{
+  return self.attachedRootLayer.attachedConstraintSet;
+}
+
+- (NSArray *)attachToConstraintSet:(VPLConstraintSet *)constraintSet
+{
+  NSAssert(self.superlayer == nil,
+           @"-[%@ %@] Only the root layer can be attached to a constraint set",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+  
+  NSAssert(self.attachedConstraintSet == nil,
+           @"-[%@ %@] The layer is already attached to a constraint set",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+  
+  self.attachedConstraintSet = constraintSet;
+  self.attachedLayersByVariableID = [[NSMutableDictionary alloc] init];
+  
+  return [self addSubtreeToConstraintSet:constraintSet];
+}
+
+- (void)detachFromConstraintSet
+{
+  VPLConstraintSet * constraintSet = self.attachedConstraintSet;
+  if (constraintSet == nil) return;
+  
+  [self removeSubtreeFromConstraintSet:constraintSet];
+  
+  self.attachedConstraintSet = nil;
+  self.attachedLayersByVariableID = nil;
+}
+
+- (VPLLayer *)attachedLayerForVariableID:(VPLVariableID)variableID
+{
+  return [self.attachedRootLayer.attachedLayersByVariableID objectForKey:@(variableID)];
+}
+
+- (NSArray *)frameVariableIDs
+{
+  if (self.identifier == nil) return @[];
+  
+  return @[ @(self.xVariableID), @(self.yVariableID), @(self.widthVariableID), @(self.heightVariableID) ];
+}
+
+- (NSArray *)subtreeLayers
+{
+  NSMutableArray * layers = [[NSMutableArray alloc] init];
+  NSMutableArray * stack = [[NSMutableArray alloc] initWithObjects:self, nil];
+  while ([stack count] > 0)
+  {
+    VPLLayer * topLayer = [stack lastObject];
+    [stack removeLastObject];
     
-    [updatedConstraints addObject:self.intrinsicWidthConstraint];
+    [layers addObject:topLayer];
+    [stack addObjectsFromArray:topLayer.sublayers];
   }
+  return layers;
+}
+
+/**
+ * Adds the subtree's constraints to the constraint set as a single batch, followed by its intrinsic sizes. Returns the
+ * constraints that couldn't be satisfied.
+ */
+- (NSArray *)addSubtreeToConstraintSet:(VPLConstraintSet *)constraintSet
+{
+  NSArray * layers = [self subtreeLayers];
+  NSMutableDictionary * attachedLayersByVariableID = self.attachedRootLayer.attachedLayersByVariableID;
   
-  NSLog(@"%@.intrinsicContentSize.height == %f", self.identifier, intrinsicContentSize.height);
-  if (intrinsicContentSize.height >= 0)
+  NSMutableArray * constraints = [[NSMutableArray alloc] init];
+  for (VPLLayer * layer in layers)
   {
-    self.intrinsicHeightConstraint = [[VPLLayoutConstraint alloc] initWithSubject:self.identifier
-                                                                       attribute:@"height"
-                                                                    relationship:@"=="
-                                                                   relatedObject:nil
-                                                                relatedAttribute:nil
-                                                                      multiplier:0
-                                                                        constant:intrinsicContentSize.height];
+    // frames are only updated for variables whose values change, so start from the value of an unconstrained variable
+    layer.frame = CGRectZero;
     
+    for (NSNumber * variableID in [layer frameVariableIDs])
+    {
+      [attachedLayersByVariableID setObject:layer
+                                     forKey:variableID];
+    }
     
-    [updatedConstraints addObject:self.intrinsicHeightConstraint];
+    for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+    {
+      [constraints addObject:layoutConstraint.constraint];
+    }
+  }
+  
+  NSArray * unsatisfiableConstraints = [constraintSet addConstraints:constraints];
+  
+  // intrinsic sizes go last, so that their edit variables start out at the values the constraints give them
+  for (VPLLayer * layer in layers)
+  {
+    [layer updateConstraints];
   }
   
-  self.layoutConstraints = updatedConstraints;
+  return unsatisfiableConstraints;
+}
 
+- (void)addSubtreeToLayoutFingerprint:(VPLLayoutFingerprint *)fingerprint
+{
+  for (VPLLayer * layer in [self subtreeLayers])
+  {
+    for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+    {
+      [fingerprint addConstraint:layoutConstraint.constraint];
+    }
+    
+    // a negative intrinsic dimension has no edit variable, and nor does the root layer
+    if (layer.superlayer == nil) continue;
+    
+    CGSize intrinsicContentSize = layer.intrinsicContentSize;
+    if (intrinsicContentSize.width >= 0)
+    {
+      [fingerprint addEditVariable:[layer variableNameForAttribute:@"width"]
+                            weight:VPLLayerIntrinsicContentSizeWeight
+                             value:intrinsicContentSize.width];
+    }
+    
+    if (intrinsicContentSize.height >= 0)
+    {
+      [fingerprint addEditVariable:[layer variableNameForAttribute:@"height"]
+                            weight:VPLLayerIntrinsicContentSizeWeight
+                             value:intrinsicContentSize.height];
+    }
+  }
+}
+
+- (void)removeSubtreeFromConstraintSet:(VPLConstraintSet *)constraintSet
+{
+  NSArray * layers = [self subtreeLayers];
+  NSMutableDictionary * attachedLayersByVariableID = self.attachedRootLayer.attachedLayersByVariableID;
+  
+  NSMutableArray * constraints = [[NSMutableArray alloc] init];
+  for (VPLLayer * layer in layers)
+  {
+    [layer removeIntrinsicContentSizeFromConstraintSet:constraintSet];
+    
+    for (NSNumber * variableID in [layer frameVariableIDs])
+    {
+      if ([attachedLayersByVariableID objectForKey:variableID] == layer)
+      {
+        [attachedLayersByVariableID removeObjectForKey:variableID];
+      }
+    }
+    
+    // unsatisfiable constraints were never added
+    for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+    {
+      if ([constraintSet containsConstraint:layoutConstraint.constraint])
+      {
+        [constraints addObject:layoutConstraint.constraint];
+      }
+    }
+  }
+  
+  [constraintSet removeConstraints:constraints];
 }
 
 // ===== LAYER HIERARCHY ===============================================================================================
@@ -258,11 +493,19 @@ CFStringFromNSString(NSString * string)
            NSStringFromSelector(_cmd),
            sublayer);
   
+  NSAssert(sublayer.attachedConstraintSet == nil,
+           @"-[%@ %@] invoked with the root of an attached layer tree: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           sublayer);
+  
   [sublayer willMoveToSuperlayer:self];
   
   [sublayer.superlayer removeSublayer:sublayer];
-  NSArray * sublayers = [self.sublayers arrayByAddingObject:sublayer];
-  self.sublayers = sublayers;
+  NSMutableArray * sublayers = [[NSMutableArray alloc] initWithArray:self.sublayers];
+  [sublayers insertObject:sublayer
+                  atIndex:sublayerIndex];
+  self.sublayers = [NSArray arrayWithArray:sublayers];
   
   sublayer.superlayer = self;
   
@@ -295,8 +538,8 @@ CFStringFromNSString(NSString * string)
   [sublayer willMoveToSuperlayer:nil];
   [self willRemoveSublayer:sublayer];
   
-  NSMutableArray * sublayers = [[NSMutableArray alloc] initWithArray:self.superlayer.sublayers];
-  [sublayers removeObject:self];
+  NSMutableArray * sublayers = [[NSMutableArray alloc] initWithArray:self.sublayers];
+  [sublayers removeObject:sublayer];
   self.sublayers = [NSArray arrayWithArray:sublayers];
   
   [self didRemoveSublayer:sublayer];
@@ -310,12 +553,24 @@ CFStringFromNSString(NSString * string)
 
 - (void)didAddSublayer:(VPLLayer *)sublayer
 {
-  
+  VPLConstraintSet * constraintSet = self.constraintSet;
+  if (constraintSet != nil)
+  {
+    NSArray * unsatisfiableConstraints = [sublayer addSubtreeToConstraintSet:constraintSet];
+    if ([unsatisfiableConstraints count] > 0)
+    {
+      NSLog(@"%@: ignoring unsatisfiable constraints: %@", sublayer.identifier, unsatisfiableConstraints);
+    }
+  }
 }
 
 - (void)willRemoveSublayer:(VPLLayer *)sublayer
 {
-  
+  VPLConstraintSet * constraintSet = self.constraintSet;
+  if (constraintSet != nil)
+  {
+    [sublayer removeSubtreeFromConstraintSet:constraintSet];
+  }
 }
 
 - (void)didRemoveSublayer:(VPLLayer *)sublayer
@@ -361,34 +616,48 @@ CFStringFromNSString(NSString * string)
 // ===== TEXT ==========================================================================================================
 #pragma mark - Text
 
+- (void)setText:(NSString *)text
+{
+  if (text == _text || [text isEqualToString:_text]) return;
+  
+  _text = [text copy];
+  
+  // the attributed string and framesetter are created from the text, so they're created again on demand
+  [self releaseText];
+  
+  [self updateConstraints];
+}
+
+- (void)releaseText
+{
+  if (_textFramesetterRef != NULL)
+  {
+    CFRelease(_textFramesetterRef);
+    _textFramesetterRef = NULL;
+  }
+  
+  if (_attributedTextRef != NULL)
+  {
+    CFRelease(_attributedTextRef);
+    _attributedTextRef = NULL;
+  }
+}
+
 - (CFAttributedStringRef)attributedTextRef
 {
   if (_attributedTextRef == NULL
       && self.text != nil)
   {
-    // create default text attributes
-    CTFontRef font = CTFontCreateWithName(CFSTR("Helvetica Neue"),
-                                          17.0,
-                                          NULL);
-    
-    CFStringRef keys[] = { kCTFontAttributeName };
-    CFTypeRef values[] = { font };
-    
-    CFDictionaryRef attributes = CFDictionaryCreate(kCFAllocatorDefault,
-                                                    (const void**)&keys,
-                                                    (const void**)&values,
-                                                    1,
-                                                    &kCFTypeDictionaryKeyCallBacks,
-                                                    &kCFTypeDictionaryValueCallBacks);
+    // the font and its attributes are shared by every layer
+    VPLTextMeasurementCache * textMeasurementCache = [VPLTextMeasurementCache sharedTextMeasurementCache];
+    CFDictionaryRef attributes = [textMeasurementCache textAttributesWithFontName:VPLLayerFontName
+                                                                             size:VPLLayerFontSize];
     
     // create an attributed string
     CFStringRef stringRef = CFStringFromNSString(self.text);
     _attributedTextRef = CFAttributedStringCreate(NULL,
                                                   stringRef,
                                                   attributes);
-    
-    CFRelease(font);
-    CFRelease(attributes);
   }
   return _attributedTextRef;
 }
@@ -412,11 +681,6 @@ CFStringFromNSString(NSString * string)
   if (self.backgroundColorRef != NULL)
   {
     CGContextSetFillColorWithColor(ctx, self.backgroundColorRef);
-    
-    NSLog(@"[%@] drawing in %@",
-          self.identifier,
-          NSStringFromRect(self.frame));
-    
     CGContextFillRect(ctx, self.frame);
   }
   
@@ -0,0 +1,125 @@
+#import "VPLCassowaryTypes.h"
+#import "VPLConstraint.h"
+
+@class VPLLinearExpression;
+
+extern NSString * const VPLLayoutCacheErrorDomain;
+
+typedef enum _VPLLayoutCacheError {
+
+  VPLLayoutCacheErrorNone = 0,
+  VPLLayoutCacheErrorInvalidContents
+
+} VPLLayoutCacheError;
+
+// ===== FINGERPRINT ===================================================================================================
+#pragma mark - Fingerprint
+
+/**
+ * Builds a SHA-256 fingerprint of everything that determines a layout's solution: its constraints and their strengths,
+ * its edit variables with their weights and suggested values, and the variables whose values the layout reads back, in
+ * order.
+ *
+ * Constraints are fingerprinted in a canonical form, by their expressions, which have no marker variables, with their
+ * terms ordered by variable name, and the order they're added in doesn't matter. Two layouts built separately from the
+ * same layer tree, even in different processes, have the same fingerprint.
+ */
+@interface VPLLayoutFingerprint : NSObject
+
+- (void)addConstraint:(VPLConstraint *)constraint;
+
+/**
+ * Adds a constraint by its parts, as they'd be found in `VPLConstraint`, without having to build one.
+ */
+- (void)addConstraintWithExpression:(VPLLinearExpression *)expression
+                           relation:(VPLConstraintRelation)relation
+                           strength:(VPLConstraintStrength)strength;
+
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight
+                  value:(CGFloat)value;
+
+- (void)addResultVariable:(NSString *)variableName;
+
+/**
+ * The fingerprint as a hexadecimal string.
+ */
+- (NSString *)stringValue;
+
+@end
+
+// ===== LAYOUT CACHE ==================================================================================================
+#pragma mark - Layout Cache
+
+/**
+ * Remembers solved layouts by their fingerprint, so that laying out the same constraints at the same size again can
+ * skip building and solving the constraint set altogether.
+ *
+ * A cache holds the values of each layout's result variables, and is bounded by the memory they take up: once it's
+ * over its limit, the least recently used layouts are discarded. It can be written to a file and read back, so that
+ * repeated runs over a library that hasn't changed hardly need the solver.
+ *
+ * A cache is safe to use from several threads at once.
+ */
+@interface VPLLayoutCache : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithMemoryLimit:(NSUInteger)memoryLimit;
+
+/**
+ * The cache used by `VPLAssetRepresentation`. There's none unless one is set.
+ */
++ (VPLLayoutCache *)sharedLayoutCache;
+
++ (void)setSharedLayoutCache:(VPLLayoutCache *)layoutCache;
+
+// ===== LAYOUTS =======================================================================================================
+#pragma mark - Layouts
+
+/**
+ * The approximate number of bytes the cached layouts may take up. Defaults to 16MB.
+ */
+@property (nonatomic, assign, readonly) NSUInteger memoryLimit;
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ * Returns the cached values for a fingerprint, as an array of doubles, or nil if there are none.
+ */
+- (NSData *)valuesForFingerprint:(NSString *)fingerprint;
+
+- (void)setValues:(NSData *)values
+   forFingerprint:(NSString *)fingerprint;
+
+- (void)removeAllValues;
+
+// ----- STATISTICS ----------------------------------------------------------------------------------------------------
+#pragma mark Statistics
+
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+// ----- VERIFICATION --------------------------------------------------------------------------------------------------
+#pragma mark Verification
+
+/**
+ * When set, layouts found in the cache are solved again anyway, and an assertion fails if the solutions differ. It's
+ * set by default in debug builds.
+ */
+@property (nonatomic, assign, readwrite) BOOL verifiesCachedLayouts;
+
+// ===== PERSISTENCE ===================================================================================================
+#pragma mark - Persistence
+
+/**
+ * Adds the layouts in a file written by `-writeToFile:error:` to the cache.
+ */
+- (BOOL)readFromFile:(NSString *)path
+               error:(NSError * __autoreleasing *)error;
+
+- (BOOL)writeToFile:(NSString *)path
+              error:(NSError * __autoreleasing *)error;
+
+@end
@@ -0,0 +1,399 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLLayoutCache.h"
+#import "VPLConstraint.h"
+#import "VPLLinearExpression.h"
+#import "VPLSymbolTable.h"
+#import "VPLInstrumentation.h"
+#import <CommonCrypto/CommonDigest.h>
+
+NSString * const VPLLayoutCacheErrorDomain = @"com.vulpinelabs.VPLLayoutCache";
+
+static const NSUInteger VPLLayoutCacheDefaultMemoryLimit = 16 * 1024 * 1024;
+
+static const NSInteger VPLLayoutCacheFileVersion = 1;
+static NSString * const VPLLayoutCacheVersionKey = @"version";
+static NSString * const VPLLayoutCacheLayoutsKey = @"layouts";
+static NSString * const VPLLayoutCacheFingerprintKey = @"fingerprint";
+static NSString * const VPLLayoutCacheValuesKey = @"values";
+
+/**
+ * Numbers are written as hexadecimal floating point, so that the fingerprint only depends on their exact values.
+ */
+static NSString *
+VPLLayoutFingerprintNumber(CGFloat value)
+{
+  return [NSString stringWithFormat:@"%a", (double)value];
+}
+
+// ===== FINGERPRINT ===================================================================================================
+#pragma mark - Fingerprint
+
+@interface VPLLayoutFingerprint ()
+
+@property (nonatomic, strong, readonly) NSMutableArray * constraintDescriptions;
+@property (nonatomic, strong, readonly) NSMutableArray * editVariableDescriptions;
+@property (nonatomic, strong, readonly) NSMutableArray * resultVariableNames;
+
+@end
+
+@implementation VPLLayoutFingerprint
+
+- (instancetype)init
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _constraintDescriptions = [[NSMutableArray alloc] init];
+    _editVariableDescriptions = [[NSMutableArray alloc] init];
+    _resultVariableNames = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)addConstraint:(VPLConstraint *)constraint
+{
+  [self addConstraintWithExpression:constraint.expression
+                           relation:constraint.relation
+                           strength:constraint.strength];
+}
+
+- (void)addConstraintWithExpression:(VPLLinearExpression *)expression
+                           relation:(VPLConstraintRelation)relation
+                           strength:(VPLConstraintStrength)strength
+{
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  const VPLTerm * terms = expression.terms;
+  NSMutableArray * termDescriptions = [[NSMutableArray alloc] initWithCapacity:expression.termCount];
+  for (NSUInteger termIndex = 0; termIndex < expression.termCount; termIndex++)
+  {
+    [termDescriptions addObject:[NSString stringWithFormat:@"%@*%@",
+                                 [symbolTable nameForVariableID:terms[termIndex].variableID],
+                                 VPLLayoutFingerprintNumber(terms[termIndex].coefficient)]];
+  }
+
+  // ids depend on the order names were interned in, but names don't
+  [termDescriptions sortUsingSelector:@selector(compare:)];
+
+  [self.constraintDescriptions addObject:[NSString stringWithFormat:@"%d %d %@ %@",
+                                          (int)relation,
+                                          (int)strength,
+                                          VPLLayoutFingerprintNumber(expression.constantValue),
+                                          [termDescriptions componentsJoinedByString:@" "]]];
+}
+
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight
+                  value:(CGFloat)value
+{
+  [self.editVariableDescriptions addObject:[NSString stringWithFormat:@"%@ %@ %@",
+                                            variableName,
+                                            VPLLayoutFingerprintNumber(weight),
+                                            VPLLayoutFingerprintNumber(value)]];
+}
+
+- (void)addResultVariable:(NSString *)variableName
+{
+  [self.resultVariableNames addObject:variableName];
+}
+
+static void
+VPLLayoutFingerprintUpdate(CC_SHA256_CTX * context, NSString * section, NSArray * lines)
+{
+  const char * sectionString = [section UTF8String];
+  CC_SHA256_Update(context, sectionString, (CC_LONG)strlen(sectionString) + 1);
+
+  for (NSString * line in lines)
+  {
+    const char * lineString = [line UTF8String];
+    CC_SHA256_Update(context, lineString, (CC_LONG)strlen(lineString) + 1);
+  }
+}
+
+- (NSString *)stringValue
+{
+  CC_SHA256_CTX context;
+  CC_SHA256_Init(&context);
+
+  // constraints and edit variables are sets, but the result variables' order is the order of the cached values
+  VPLLayoutFingerprintUpdate(&context,
+                             @"constraints",
+                             [self.constraintDescriptions sortedArrayUsingSelector:@selector(compare:)]);
+  VPLLayoutFingerprintUpdate(&context,
+                             @"edits",
+                             [self.editVariableDescriptions sortedArrayUsingSelector:@selector(compare:)]);
+  VPLLayoutFingerprintUpdate(&context,
+                             @"results",
+                             self.resultVariableNames);
+
+  unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+  CC_SHA256_Final(digest, &context);
+
+  NSMutableString * digestString = [[NSMutableString alloc] initWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+  for (NSUInteger byteIndex = 0; byteIndex < CC_SHA256_DIGEST_LENGTH; byteIndex++)
+  {
+    [digestString appendFormat:@"%02x", digest[byteIndex]];
+  }
+  return digestString;
+}
+
+@end
+
+// ===== LAYOUT CACHE ==================================================================================================
+#pragma mark - Layout Cache
+
+static VPLLayoutCache * VPLLayoutCacheShared = nil;
+
+@interface VPLLayoutCache ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * valuesByFingerprint;
+
+// least recently used first
+@property (nonatomic, strong, readonly) NSMutableOrderedSet * recentFingerprints;
+
+@property (nonatomic, assign, readwrite) NSUInteger memoryUsage;
+@property (nonatomic, assign, readwrite) NSUInteger hitCount;
+@property (nonatomic, assign, readwrite) NSUInteger missCount;
+
+@end
+
+@implementation VPLLayoutCache
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+  return [self initWithMemoryLimit:VPLLayoutCacheDefaultMemoryLimit];
+}
+
+- (instancetype)initWithMemoryLimit:(NSUInteger)memoryLimit
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _memoryLimit = memoryLimit;
+    _valuesByFingerprint = [[NSMutableDictionary alloc] init];
+    _recentFingerprints = [[NSMutableOrderedSet alloc] init];
+
+#if DEBUG
+    _verifiesCachedLayouts = YES;
+#endif
+  }
+  return self;
+}
+
++ (VPLLayoutCache *)sharedLayoutCache
+{
+  @synchronized (self)
+  {
+    return VPLLayoutCacheShared;
+  }
+}
+
++ (void)setSharedLayoutCache:(VPLLayoutCache *)layoutCache
+{
+  @synchronized (self)
+  {
+    VPLLayoutCacheShared = layoutCache;
+  }
+}
+
+// ===== LAYOUTS =======================================================================================================
+#pragma mark - Layouts
+
+- (NSUInteger)count
+{
+  @synchronized (self)
+  {
+    return [self.valuesByFingerprint count];
+  }
+}
+
+static NSUInteger
+VPLLayoutCacheCost(NSString * fingerprint, NSData * values)
+{
+  return [fingerprint length] + [values length];
+}
+
+- (NSData *)valuesForFingerprint:(NSString *)fingerprint
+{
+  @synchronized (self)
+  {
+    NSData * values = [self.valuesByFingerprint objectForKey:fingerprint];
+    if (values != nil)
+    {
+      [self.recentFingerprints removeObject:fingerprint];
+      [self.recentFingerprints addObject:fingerprint];
+
+      self.hitCount++;
+      VPLInstrumentationCount(VPLInstrumentationCounterLayoutCacheHits, 1);
+    }
+    else
+    {
+      self.missCount++;
+      VPLInstrumentationCount(VPLInstrumentationCounterLayoutCacheMisses, 1);
+    }
+    return values;
+  }
+}
+
+- (void)setValues:(NSData *)values
+   forFingerprint:(NSString *)fingerprint
+{
+  values = [values copy];
+
+  @synchronized (self)
+  {
+    NSData * previousValues = [self.valuesByFingerprint objectForKey:fingerprint];
+    if (previousValues != nil)
+    {
+      self.memoryUsage -= VPLLayoutCacheCost(fingerprint, previousValues);
+      [self.recentFingerprints removeObject:fingerprint];
+    }
+
+    [self.valuesByFingerprint setObject:values
+                                 forKey:fingerprint];
+    [self.recentFingerprints addObject:fingerprint];
+    self.memoryUsage += VPLLayoutCacheCost(fingerprint, values);
+
+    while (self.memoryUsage > self.memoryLimit && [self.recentFingerprints count] > 0)
+    {
+      NSString * leastRecentFingerprint = [self.recentFingerprints firstObject];
+      NSData * leastRecentValues = [self.valuesByFingerprint objectForKey:leastRecentFingerprint];
+
+      self.memoryUsage -= VPLLayoutCacheCost(leastRecentFingerprint, leastRecentValues);
+      [self.valuesByFingerprint removeObjectForKey:leastRecentFingerprint];
+      [self.recentFingerprints removeObjectAtIndex:0];
+    }
+  }
+}
+
+- (void)removeAllValues
+{
+  @synchronized (self)
+  {
+    [self.valuesByFingerprint removeAllObjects];
+    [self.recentFingerprints removeAllObjects];
+    self.memoryUsage = 0;
+  }
+}
+
+// ===== PERSISTENCE ===================================================================================================
+#pragma mark - Persistence
+
+- (BOOL)readFromFile:(NSString *)path
+               error:(NSError * __autoreleasing *)error
+{
+  NSData * data = [NSData dataWithContentsOfFile:[path stringByExpandingTildeInPath]
+                                         options:0
+                                           error:error];
+  if (data == nil)
+  {
+    return NO;
+  }
+
+  NSDictionary * cacheDictionary = [NSPropertyListSerialization propertyListWithData:data
+                                                                             options:NSPropertyListImmutable
+                                                                              format:NULL
+                                                                               error:error];
+  if (cacheDictionary == nil)
+  {
+    return NO;
+  }
+
+  NSArray * layouts = nil;
+  if ([cacheDictionary isKindOfClass:[NSDictionary class]]
+      && [[cacheDictionary objectForKey:VPLLayoutCacheVersionKey] isEqual:@(VPLLayoutCacheFileVersion)])
+  {
+    layouts = [cacheDictionary objectForKey:VPLLayoutCacheLayoutsKey];
+  }
+
+  if (![layouts isKindOfClass:[NSArray class]])
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLLayoutCacheErrorDomain
+                                   code:VPLLayoutCacheErrorInvalidContents
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Invalid layout cache", nil)
+                
+                }];
+    }
+    return NO;
+  }
+
+  // layouts are written least recently used first, so adding them in order brings back their order too
+  for (NSDictionary * layout in layouts)
+  {
+    if (![layout isKindOfClass:[NSDictionary class]]) continue;
+
+    NSString * fingerprint = [layout objectForKey:VPLLayoutCacheFingerprintKey];
+    NSArray * valueNumbers = [layout objectForKey:VPLLayoutCacheValuesKey];
+    if (![fingerprint isKindOfClass:[NSString class]] || ![valueNumbers isKindOfClass:[NSArray class]]) continue;
+
+    NSMutableData * values = [[NSMutableData alloc] initWithLength:[valueNumbers count] * sizeof(double)];
+    double * valueDoubles = [values mutableBytes];
+    [valueNumbers enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+
+      valueDoubles[idx] = ([obj isKindOfClass:[NSNumber class]] ? [obj doubleValue] : 0.0);
+
+    }];
+
+    [self setValues:values
+     forFingerprint:fingerprint];
+  }
+
+  return YES;
+}
+
+- (BOOL)writeToFile:(NSString *)path
+              error:(NSError * __autoreleasing *)error
+{
+  // values are written as numbers rather than raw bytes, so the file doesn't depend on byte order
+  NSMutableArray * layouts = [[NSMutableArray alloc] init];
+  @synchronized (self)
+  {
+    for (NSString * fingerprint in self.recentFingerprints)
+    {
+      NSData * values = [self.valuesByFingerprint objectForKey:fingerprint];
+      const double * valueDoubles = [values bytes];
+      NSUInteger valueCount = [values length] / sizeof(double);
+
+      NSMutableArray * valueNumbers = [[NSMutableArray alloc] initWithCapacity:valueCount];
+      for (NSUInteger valueIndex = 0; valueIndex < valueCount; valueIndex++)
+      {
+        [valueNumbers addObject:@(valueDoubles[valueIndex])];
+      }
+
+      [layouts addObject:@{
+        VPLLayoutCacheFingerprintKey : fingerprint,
+        VPLLayoutCacheValuesKey : valueNumbers,
+      }];
+    }
+  }
+
+  NSDictionary * cacheDictionary = @{
+    VPLLayoutCacheVersionKey : @(VPLLayoutCacheFileVersion),
+    VPLLayoutCacheLayoutsKey : layouts,
+  };
+
+  NSData * data = [NSPropertyListSerialization dataWithPropertyList:cacheDictionary
+                                                             format:NSPropertyListBinaryFormat_v1_0
+                                                            options:0
+                                                              error:error];
+  if (data == nil)
+  {
+    return NO;
+  }
+
+  return [data writeToFile:[path stringByExpandingTildeInPath]
+                   options:NSDataWritingAtomic
+                     error:error];
+}
+
+@end
@@ -1,12 +1,24 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLConstraint.h"
 
-@class VPLConstraint;
+extern NSString * const VPLLayoutConstraintErrorDomain;
+
+typedef enum _VPLLayoutConstraintError {
+  
+  VPLLayoutConstraintErrorNone = 0,
+  VPLLayoutConstraintErrorInvalidStrength
+  
+} VPLLayoutConstraintError;
 
 @interface VPLLayoutConstraint : NSObject
 
 // ===== INITIALIZATION ================================================================================================
 
-- (id)initWithDictionary:(NSDictionary *)dictionary;
+/**
+ * Returns nil, and sets `error`, if the dictionary's `strength` isn't one of the strengths' names.
+ */
+- (id)initWithDictionary:(NSDictionary *)dictionary
+                   error:(NSError * __autoreleasing *)error;
 
 - (id)initWithSubject:(NSString *)subject
             attribute:(NSString *)attribute
@@ -16,6 +28,19 @@
            multiplier:(CGFloat)relatedAttributeMultiplier
              constant:(CGFloat)relatedAttributeConstant;
 
+/**
+ * Uses an already built `constraint`, instead of building one from the other arguments when it's first needed. The
+ * layout constraint takes its strength from `constraint`.
+ */
+- (id)initWithSubject:(NSString *)subject
+            attribute:(NSString *)attribute
+         relationship:(NSString *)relationship
+        relatedObject:(NSString *)relatedObject
+     relatedAttribute:(NSString *)relatedAttribute
+           multiplier:(CGFloat)relatedAttributeMultiplier
+             constant:(CGFloat)relatedAttributeConstant
+           constraint:(VPLConstraint *)constraint;
+
 // ===== SUBJECT =======================================================================================================
 
 @property (nonatomic, strong, readonly) NSString * subject;
@@ -33,6 +58,15 @@
 @property (nonatomic, assign, readonly) CGFloat relatedObjectAttributeMultiplier;
 @property (nonatomic, assign, readonly) CGFloat relatedObjectAttributeOffset;
 
+// ===== STRENGTH ======================================================================================================
+
+/**
+ * Read from a dictionary's `strength`, which is one of `required`, `strong`, `medium` or `weak`. Constraints without
+ * one are required. Any other value is an error rather than being taken as required, since a misspelled preference
+ * would otherwise become a required constraint, and could make the layout unsatisfiable.
+ */
+@property (nonatomic, assign, readonly) VPLConstraintStrength strength;
+
 // ===== CONSTRAINT ====================================================================================================
 
 @property (nonatomic, strong, readonly) VPLConstraint * constraint;
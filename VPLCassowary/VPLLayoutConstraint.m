@@ -3,7 +3,8 @@
 #endif
 
 #import "VPLLayoutConstraint.h"
-#import "VPLConstraint.h"
+
+NSString * const VPLLayoutConstraintErrorDomain = @"VPLLayoutConstraint";
 
 static NSString *
 VPLLayoutConstraintVariableNameWithIdentifierAndAttribute(NSString * identifier, NSString * attribute)
@@ -39,15 +40,64 @@ VPLLayoutConstraintVariableNameWithIdentifierAndAttribute(NSString * identifier,
   return self;
 }
 
+- (id)initWithSubject:(NSString *)subject
+            attribute:(NSString *)attribute
+         relationship:(NSString *)relationship
+        relatedObject:(NSString *)relatedObject
+     relatedAttribute:(NSString *)relatedAttribute
+           multiplier:(CGFloat)relatedAttributeMultiplier
+             constant:(CGFloat)relatedAttributeConstant
+           constraint:(VPLConstraint *)constraint
+{
+  self = [self initWithSubject:subject
+                     attribute:attribute
+                  relationship:relationship
+                 relatedObject:relatedObject
+              relatedAttribute:relatedAttribute
+                    multiplier:relatedAttributeMultiplier
+                      constant:relatedAttributeConstant];
+  if (self != nil)
+  {
+    _constraint = constraint;
+    _strength = constraint.strength;
+  }
+  return self;
+}
+
 - (id)initWithDictionary:(NSDictionary *)dictionary
+                   error:(NSError * __autoreleasing *)error
 {
-  return [self initWithSubject:dictionary[@"subject"]
+  id strengthName = dictionary[@"strength"];
+  VPLConstraintStrength strength = VPLConstraintStrengthRequired;
+  if (strengthName != nil
+      && (![strengthName isKindOfClass:[NSString class]] || !VPLConstraintStrengthFromName(strengthName, &strength)))
+  {
+    if (error != NULL)
+    {
+      NSString * localizedErrorFormat = NSLocalizedString(@"Unknown constraint strength (%@)", nil);
+      *error = [NSError errorWithDomain:VPLLayoutConstraintErrorDomain
+                                   code:VPLLayoutConstraintErrorInvalidStrength
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : [NSString stringWithFormat:localizedErrorFormat, strengthName]
+                
+                }];
+    }
+    return nil;
+  }
+  
+  self = [self initWithSubject:dictionary[@"subject"]
                      attribute:dictionary[@"attribute"]
                   relationship:dictionary[@"relationship"]
                  relatedObject:dictionary[@"relatedObject"]
               relatedAttribute:dictionary[@"relatedAttribute"]
                     multiplier:CGFloatFromObjectWithDefault(dictionary[@"relatedAttributeMultiplier"], 1.0f)
                       constant:CGFloatFromObjectWithDefault(dictionary[@"relatedAttributeConstant"], 0.0f)];
+  if (self != nil)
+  {
+    _strength = strength;
+  }
+  return self;
 }
 
 // ===== CONSTRAINT ====================================================================================================
@@ -84,6 +134,7 @@ VPLLayoutConstraintVariableNameWithIdentifierAndAttribute(NSString * identifier,
                                             toVariable:objectVariable
                                             multiplier:self.relatedObjectAttributeMultiplier
                                               constant:self.relatedObjectAttributeOffset];
+    _constraint.strength = self.strength;
   }
   
   return _constraint;
@@ -0,0 +1,81 @@
+#import "VPLCassowaryTypes.h"
+
+@class VPLAssetRepresentation;
+
+typedef enum _VPLLayoutFormat {
+
+  /** One JSON object per representation, each on a line of its own. */
+  VPLLayoutFormatJSON = 0,
+
+  /** A short header, followed by one length-prefixed binary record per representation. */
+  VPLLayoutFormatBinary = 1
+
+} VPLLayoutFormat;
+
+/**
+ * Writes the solved frames of representations, for consumers that only want their geometry. Laying a representation
+ * out for a writer solves its constraints but never draws it, so no bitmaps are allocated and nothing is encoded.
+ *
+ * In JSON, each representation is written on a line of its own, with each layer's frame as `[x, y, width, height]`:
+ *
+ *     {"filename":"button.png","width":120,"height":44,"layers":{"button":[0,0,120,44],"title":[10,12,100,20]}}
+ *
+ * In binary, the output starts with the magic `VPLF`, a 16 bit version and a 16 bit byte order mark, and each
+ * representation follows as a record of:
+ *
+ *     uint32_t length                 the number of bytes in the rest of the record
+ *     double width, height
+ *     uint32_t filenameLength         followed by the UTF-8 filename
+ *     uint32_t layerCount
+ *     for each layer:
+ *       uint32_t identifierLength     followed by the UTF-8 identifier
+ *       double x, y, width, height
+ *
+ * Like compiled libraries, binary output is in the byte order of the machine that wrote it, and isn't padded.
+ *
+ * Layers are written in the order of `-[VPLAssetRepresentation layersWithFrameVariables]`. Each record is built on the
+ * calling thread and then appended to a shared buffer, which is written out once it's large, so several threads can
+ * write layouts at once.
+ */
+@interface VPLLayoutWriter : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithFileHandle:(NSFileHandle *)fileHandle
+                            format:(VPLLayoutFormat)format;
+
+@property (nonatomic, strong, readonly) NSFileHandle * fileHandle;
+@property (nonatomic, assign, readonly) VPLLayoutFormat format;
+
+// ===== WRITING =======================================================================================================
+#pragma mark - Writing
+
+/**
+ * Lays the representation out at `size`, and writes the frames of its layers.
+ */
+- (void)writeLayoutOfRepresentation:(VPLAssetRepresentation *)representation
+                               size:(CGSize)size;
+
+/**
+ * Writes out whatever is buffered. This must be called after the last layout, and after each layout that whoever is
+ * reading the output is waiting for.
+ */
+- (void)flush;
+
+/**
+ * The number of layouts written so far.
+ */
+@property (nonatomic, assign, readonly) NSUInteger layoutCount;
+
+// ===== RECORDS =======================================================================================================
+#pragma mark - Records
+
+/**
+ * Returns the record for the frames of the representation's layers as they are, without laying it out first. Binary
+ * records don't include the header that starts the output.
+ */
++ (NSData *)dataWithLayoutOfRepresentation:(VPLAssetRepresentation *)representation
+                                    format:(VPLLayoutFormat)format;
+
+@end
@@ -0,0 +1,239 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLLayoutWriter.h"
+#import "VPLAssetRepresentation.h"
+#import "VPLLayer.h"
+#import "VPLInstrumentation.h"
+
+static const char VPLLayoutWriterMagic[4] = { 'V', 'P', 'L', 'F' };
+static const uint16_t VPLLayoutWriterVersion = 1;
+static const uint16_t VPLLayoutWriterByteOrderMark = 0xFEFF;
+
+// large enough that writing out the buffer costs little per layout
+static const NSUInteger VPLLayoutWriterBufferLimit = 64 * 1024;
+
+// ===== JSON ==========================================================================================================
+#pragma mark - JSON
+
+static void
+VPLLayoutWriterAppendJSONString(NSMutableData * data, NSString * string)
+{
+  const char * bytes = [string UTF8String];
+  size_t length = strlen(bytes);
+
+  [data appendBytes:"\"" length:1];
+
+  // copy runs of characters that don't need escaping in one go
+  size_t runStart = 0;
+  for (size_t byteIndex = 0; byteIndex < length; byteIndex++)
+  {
+    unsigned char byte = (unsigned char)bytes[byteIndex];
+    if (byte >= 0x20 && byte != '"' && byte != '\\') continue;
+
+    [data appendBytes:bytes + runStart length:byteIndex - runStart];
+    runStart = byteIndex + 1;
+
+    char escape[8];
+    int escapeLength = (byte < 0x20
+                        ? snprintf(escape, sizeof(escape), "\\u%04x", byte)
+                        : snprintf(escape, sizeof(escape), "\\%c", byte));
+    [data appendBytes:escape length:(NSUInteger)escapeLength];
+  }
+  [data appendBytes:bytes + runStart length:length - runStart];
+
+  [data appendBytes:"\"" length:1];
+}
+
+static void
+VPLLayoutWriterAppendJSONNumber(NSMutableData * data, double value)
+{
+  char number[32];
+  int numberLength = snprintf(number, sizeof(number), "%.15g", value);
+  [data appendBytes:number length:(NSUInteger)numberLength];
+}
+
+static void
+VPLLayoutWriterAppendJSONLayout(NSMutableData * data, VPLAssetRepresentation * representation)
+{
+  CGSize size = representation.rootLayer.frame.size;
+
+  [data appendBytes:"{\"filename\":" length:12];
+  VPLLayoutWriterAppendJSONString(data, representation.filename ?: @"");
+  [data appendBytes:",\"width\":" length:9];
+  VPLLayoutWriterAppendJSONNumber(data, size.width);
+  [data appendBytes:",\"height\":" length:10];
+  VPLLayoutWriterAppendJSONNumber(data, size.height);
+  [data appendBytes:",\"layers\":{" length:11];
+
+  BOOL isFirstLayer = YES;
+  for (VPLLayer * layer in [representation layersWithFrameVariables])
+  {
+    CGRect frame = layer.frame;
+
+    if (!isFirstLayer) [data appendBytes:"," length:1];
+    isFirstLayer = NO;
+
+    VPLLayoutWriterAppendJSONString(data, layer.identifier);
+    [data appendBytes:":[" length:2];
+    VPLLayoutWriterAppendJSONNumber(data, frame.origin.x);
+    [data appendBytes:"," length:1];
+    VPLLayoutWriterAppendJSONNumber(data, frame.origin.y);
+    [data appendBytes:"," length:1];
+    VPLLayoutWriterAppendJSONNumber(data, frame.size.width);
+    [data appendBytes:"," length:1];
+    VPLLayoutWriterAppendJSONNumber(data, frame.size.height);
+    [data appendBytes:"]" length:1];
+  }
+
+  [data appendBytes:"}}\n" length:3];
+}
+
+// ===== BINARY ========================================================================================================
+#pragma mark - Binary
+
+static void
+VPLLayoutWriterAppendUInt32(NSMutableData * data, uint32_t value)
+{
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void
+VPLLayoutWriterAppendDouble(NSMutableData * data, double value)
+{
+  [data appendBytes:&value length:sizeof(value)];
+}
+
+static void
+VPLLayoutWriterAppendBinaryString(NSMutableData * data, NSString * string)
+{
+  const char * bytes = [string UTF8String];
+  uint32_t length = (uint32_t)strlen(bytes);
+
+  VPLLayoutWriterAppendUInt32(data, length);
+  [data appendBytes:bytes length:length];
+}
+
+static void
+VPLLayoutWriterAppendBinaryLayout(NSMutableData * data, VPLAssetRepresentation * representation)
+{
+  CGSize size = representation.rootLayer.frame.size;
+  NSArray * layers = [representation layersWithFrameVariables];
+
+  // the length is filled in once the rest of the record is there
+  NSUInteger lengthOffset = [data length];
+  VPLLayoutWriterAppendUInt32(data, 0);
+
+  VPLLayoutWriterAppendDouble(data, size.width);
+  VPLLayoutWriterAppendDouble(data, size.height);
+  VPLLayoutWriterAppendBinaryString(data, representation.filename ?: @"");
+  VPLLayoutWriterAppendUInt32(data, (uint32_t)[layers count]);
+
+  for (VPLLayer * layer in layers)
+  {
+    CGRect frame = layer.frame;
+    VPLLayoutWriterAppendBinaryString(data, layer.identifier);
+    VPLLayoutWriterAppendDouble(data, frame.origin.x);
+    VPLLayoutWriterAppendDouble(data, frame.origin.y);
+    VPLLayoutWriterAppendDouble(data, frame.size.width);
+    VPLLayoutWriterAppendDouble(data, frame.size.height);
+  }
+
+  uint32_t length = (uint32_t)([data length] - lengthOffset - sizeof(uint32_t));
+  [data replaceBytesInRange:NSMakeRange(lengthOffset, sizeof(length))
+                  withBytes:&length];
+}
+
+// ===== LAYOUT WRITER =================================================================================================
+#pragma mark - Layout Writer
+
+@interface VPLLayoutWriter ()
+
+@property (nonatomic, strong, readonly) NSMutableData * buffer;
+@property (nonatomic, assign, readwrite) NSUInteger layoutCount;
+
+@end
+
+@implementation VPLLayoutWriter
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithFileHandle:(NSFileHandle *)fileHandle
+                            format:(VPLLayoutFormat)format
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _fileHandle = fileHandle;
+    _format = format;
+    _buffer = [[NSMutableData alloc] initWithCapacity:VPLLayoutWriterBufferLimit];
+
+    if (format == VPLLayoutFormatBinary)
+    {
+      [_buffer appendBytes:VPLLayoutWriterMagic length:sizeof(VPLLayoutWriterMagic)];
+      [_buffer appendBytes:&VPLLayoutWriterVersion length:sizeof(VPLLayoutWriterVersion)];
+      [_buffer appendBytes:&VPLLayoutWriterByteOrderMark length:sizeof(VPLLayoutWriterByteOrderMark)];
+    }
+  }
+  return self;
+}
+
+// ===== WRITING =======================================================================================================
+#pragma mark - Writing
+
+- (void)writeLayoutOfRepresentation:(VPLAssetRepresentation *)representation
+                               size:(CGSize)size
+{
+  [representation performLayoutWithSize:size];
+
+  uint64_t writeStartTime = VPLInstrumentationPhaseStart();
+  NSData * layoutData = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                                 format:self.format];
+
+  @synchronized (self)
+  {
+    [self.buffer appendData:layoutData];
+    self.layoutCount++;
+
+    if ([self.buffer length] >= VPLLayoutWriterBufferLimit)
+    {
+      [self flush];
+    }
+  }
+  VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseWriteLayout, writeStartTime);
+}
+
+- (void)flush
+{
+  @synchronized (self)
+  {
+    if ([self.buffer length] == 0) return;
+
+    [self.fileHandle writeData:self.buffer];
+    [self.buffer setLength:0];
+  }
+}
+
+// ===== RECORDS =======================================================================================================
+#pragma mark - Records
+
++ (NSData *)dataWithLayoutOfRepresentation:(VPLAssetRepresentation *)representation
+                                    format:(VPLLayoutFormat)format
+{
+  NSMutableData * data = [[NSMutableData alloc] init];
+  switch (format)
+  {
+    case VPLLayoutFormatJSON:
+      VPLLayoutWriterAppendJSONLayout(data, representation);
+      break;
+
+    case VPLLayoutFormatBinary:
+      VPLLayoutWriterAppendBinaryLayout(data, representation);
+      break;
+  }
+  return data;
+}
+
+@end
@@ -1,4 +1,5 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLSymbolTable.h"
 
 // ===== ERRORS ========================================================================================================
 
@@ -27,18 +28,46 @@ BOOL VPLLinearExpressionVariableIsSlack(NSString * variableName);
 
 CGFloat CGFloatFromObjectValue(id obj);
 
+// ===== TOLERANCE =====================================================================================================
+
+/**
+ * Arithmetic on expressions drops terms whose coefficients come out within the epsilon of zero, and rounds constants
+ * that do to zero, so that floating point residue doesn't stay in the tableau as live terms and spread through later
+ * substitutions. The solver uses the same epsilon wherever it tests a value against zero. Defaults to 1e-8; set it
+ * before solving anything.
+ */
+CGFloat VPLLinearExpressionEpsilon(void);
+void VPLLinearExpressionSetEpsilon(CGFloat epsilon);
+
+BOOL VPLLinearExpressionIsApproximatelyZero(CGFloat value);
+
 #define VPLSortVariables(array) [(array) sortedArrayUsingSelector:@selector(compare:)]
 #define VPLSortedVariables(...) VPLSortVariables(([NSArray arrayWithObjects:__VA_ARGS__, nil]))
 
+/**
+ * A single term of an expression's packed representation. Expressions store their terms in an array sorted by
+ * variable id, so merging two expressions is a linear walk over both arrays.
+ */
+typedef struct _VPLTerm {
+
+  VPLVariableID variableID;
+  CGFloat coefficient;
+
+} VPLTerm;
+
 /**!
  * Describes a linear expression in standard form:
  *
  *     constantValue + coeff0*variable0 + ... + coeffN*variableN = 0
  *
  * An expression will never have duplicate terms of the same variable, they are always combined. However, variables may
- * have a zero coefficient, which may be useful to mark an expression with a dummy variable.
+ * have a zero coefficient, which may be useful to mark an expression with a dummy variable. Such terms only survive
+ * until the expression takes part in arithmetic, which prunes terms within `VPLLinearExpressionEpsilon()` of zero.
  *
  * Expressions with no variables are _constant_; those with variables are considered _parametric_.
+ *
+ * Internally, variables are interned into the shared `VPLSymbolTable` and terms are kept as a packed array of
+ * `VPLTerm`s. The name-based methods are conveniences for the API boundary; the solver itself uses the id-based ones.
  */
 @interface VPLLinearExpression : NSObject <NSCopying> {}
 
@@ -54,6 +83,14 @@ CGFloat CGFloatFromObjectValue(id obj);
 + (instancetype)expressionFromString:(NSString *)expressionString
                                error:(NSError * __autoreleasing *)error;
 
+/**
+ * Creates an expression from packed terms, which must be sorted by variable id and contain no duplicates. The terms are
+ * copied.
+ */
++ (instancetype)expressionWithConstantValue:(CGFloat)constantValue
+                                      terms:(const VPLTerm *)terms
+                                      count:(NSUInteger)termCount;
+
 // ===== CONSTANT VALUE ================================================================================================
 #pragma mark - Constant Value
 
@@ -63,6 +100,10 @@ CGFloat CGFloatFromObjectValue(id obj);
 // ===== VARIABLES =====================================================================================================
 #pragma mark - Variables
 
+/**
+ * The expression's terms as a dictionary of variable names to coefficients. This is built on demand from the packed
+ * terms, so avoid it in loops.
+ */
 @property (nonatomic, strong, readonly) NSDictionary * variableTerms;
 - (BOOL)isParametric;
 
@@ -72,6 +113,15 @@ CGFloat CGFloatFromObjectValue(id obj);
 - (NSArray *)unrestrictedVariableNames;
 - (NSArray *)variableNamesPassingTest:(BOOL(^)(NSString * variableName, NSNumber * coefficient, BOOL * stop))block;
 
+// ----- PACKED TERMS --------------------------------------------------------------------------------------------------
+#pragma mark Packed Terms
+
+@property (nonatomic, assign, readonly) NSUInteger termCount;
+@property (nonatomic, assign, readonly) const VPLTerm * terms;
+
+- (CGFloat)coefficientForVariableID:(VPLVariableID)variableID;
+- (BOOL)containsVariableID:(VPLVariableID)variableID;
+
 // ===== OPERATIONS ====================================================================================================
 #pragma mark - Operations
 
@@ -79,6 +129,14 @@ CGFloat CGFloatFromObjectValue(id obj);
 
 - (VPLLinearExpression *)expressionByMultiplying:(CGFloat)multiplier;
 
+- (VPLLinearExpression *)expressionByAddingConstant:(CGFloat)constantValue;
+
+/**
+ * Returns `self + (multiplier * expression)`. Terms that cancel out are removed.
+ */
+- (VPLLinearExpression *)expressionByAddingExpression:(VPLLinearExpression *)expression
+                                          multiplier:(CGFloat)multiplier;
+
 - (VPLLinearExpression *)expressionBySubstitutingExpression:(VPLLinearExpression *)expression
                                                forVariable:(NSString *)variableName;
 
@@ -112,6 +170,19 @@ CGFloat CGFloatFromObjectValue(id obj);
 
 - (VPLLinearExpression *)expressionByRemovingVariableTerm:(NSString *)variableName;
 
+// ----- PACKED OPERATIONS ---------------------------------------------------------------------------------------------
+#pragma mark Packed Operations
+
+- (VPLLinearExpression *)expressionBySubstitutingExpression:(VPLLinearExpression *)expression
+                                             forVariableID:(VPLVariableID)variableID;
+
+- (VPLLinearExpression *)expressionBySolvingForVariableID:(VPLVariableID)variableID;
+
+- (VPLLinearExpression *)expressionByChangingSubjectFromVariableID:(VPLVariableID)currentSubject
+                                                     toVariableID:(VPLVariableID)updatedSubject;
+
+- (VPLLinearExpression *)expressionByRemovingVariableID:(VPLVariableID)variableID;
+
 // ===== EQUALITY ======================================================================================================
 #pragma mark - Equality
 
@@ -3,6 +3,8 @@
 #endif
 
 #import "VPLLinearExpression.h"
+#import "VPLInstrumentation.h"
+#import "VPLConstraintParser.h"
 
 // ===== ERRORS ========================================================================================================
 
@@ -65,6 +67,179 @@ CGFloatFromObjectValue(id obj)
   return (CGFLOAT_IS_DOUBLE ? [obj doubleValue] : [obj floatValue]);
 }
 
+// ===== TOLERANCE =====================================================================================================
+#pragma mark - Tolerance
+
+static CGFloat VPLLinearExpressionEpsilonValue = 1.0e-8;
+
+CGFloat
+VPLLinearExpressionEpsilon(void)
+{
+  return VPLLinearExpressionEpsilonValue;
+}
+
+void
+VPLLinearExpressionSetEpsilon(CGFloat epsilon)
+{
+  VPLLinearExpressionEpsilonValue = fabs(epsilon);
+}
+
+BOOL
+VPLLinearExpressionIsApproximatelyZero(CGFloat value)
+{
+  return (fabs(value) <= VPLLinearExpressionEpsilonValue);
+}
+
+/**
+ * Rounds a computed constant to zero if it's only floating point residue, so it doesn't flip the sign tests the solver
+ * makes on row constants.
+ */
+static inline CGFloat
+VPLLinearExpressionPrunedConstant(CGFloat constantValue)
+{
+  return (fabs(constantValue) <= VPLLinearExpressionEpsilonValue ? 0.0 : constantValue);
+}
+
+// ===== PACKED TERMS ==================================================================================================
+#pragma mark - Packed Terms
+
+static int
+VPLTermCompare(const void * term, const void * otherTerm)
+{
+  VPLVariableID variableID = ((const VPLTerm *)term)->variableID;
+  VPLVariableID otherVariableID = ((const VPLTerm *)otherTerm)->variableID;
+
+  return (variableID < otherVariableID ? -1 : (variableID > otherVariableID ? 1 : 0));
+}
+
+static VPLTerm *
+VPLTermsAllocate(NSUInteger termCount)
+{
+  return (termCount > 0 ? malloc(sizeof(VPLTerm) * termCount) : NULL);
+}
+
+static NSUInteger
+VPLTermsIndexOfVariableID(const VPLTerm * terms, NSUInteger termCount, VPLVariableID variableID)
+{
+  NSUInteger low = 0;
+  NSUInteger high = termCount;
+  while (low < high)
+  {
+    NSUInteger middle = low + (high - low) / 2;
+    VPLVariableID middleVariableID = terms[middle].variableID;
+    if (middleVariableID == variableID)
+    {
+      return middle;
+    }
+    else if (middleVariableID < variableID)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  return NSNotFound;
+}
+
+/**
+ * Removes the terms whose coefficients are within the epsilon of zero, in place, and returns the number left.
+ */
+static NSUInteger
+VPLTermsPrune(VPLTerm * terms, NSUInteger termCount)
+{
+  NSUInteger prunedTermCount = 0;
+  for (NSUInteger termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    if (fabs(terms[termIndex].coefficient) > VPLLinearExpressionEpsilonValue)
+    {
+      terms[prunedTermCount++] = terms[termIndex];
+    }
+  }
+
+  if (prunedTermCount < termCount)
+  {
+    VPLInstrumentationCount(VPLInstrumentationCounterTermsPruned, termCount - prunedTermCount);
+  }
+  return prunedTermCount;
+}
+
+/**
+ * Merges `terms + (multiplier * otherTerms)` into `mergedTerms`, which must have room for `termCount + otherTermCount`
+ * terms. Terms that cancel out to within the epsilon are dropped, as is any term for `excludedVariableID`. Returns the
+ * number of merged terms.
+ */
+static NSUInteger
+VPLTermsMerge(const VPLTerm * terms, NSUInteger termCount,
+              const VPLTerm * otherTerms, NSUInteger otherTermCount,
+              CGFloat multiplier,
+              VPLVariableID excludedVariableID,
+              VPLTerm * mergedTerms)
+{
+  NSUInteger termIndex = 0;
+  NSUInteger otherTermIndex = 0;
+  NSUInteger mergedTermCount = 0;
+  NSUInteger prunedTermCount = 0;
+
+  while (termIndex < termCount || otherTermIndex < otherTermCount)
+  {
+    VPLVariableID variableID;
+    CGFloat coefficient;
+    BOOL combined = NO;
+
+    if (otherTermIndex >= otherTermCount
+        || (termIndex < termCount && terms[termIndex].variableID < otherTerms[otherTermIndex].variableID))
+    {
+      variableID = terms[termIndex].variableID;
+      coefficient = terms[termIndex].coefficient;
+      termIndex++;
+    }
+    else if (termIndex >= termCount
+             || otherTerms[otherTermIndex].variableID < terms[termIndex].variableID)
+    {
+      variableID = otherTerms[otherTermIndex].variableID;
+      coefficient = multiplier * otherTerms[otherTermIndex].coefficient;
+      combined = YES;
+      otherTermIndex++;
+    }
+    else
+    {
+      variableID = terms[termIndex].variableID;
+      coefficient = terms[termIndex].coefficient + (multiplier * otherTerms[otherTermIndex].coefficient);
+      combined = YES;
+      termIndex++;
+      otherTermIndex++;
+    }
+
+    if (variableID == excludedVariableID) continue;
+    if (combined && fabs(coefficient) <= VPLLinearExpressionEpsilonValue)
+    {
+      prunedTermCount++;
+      continue;
+    }
+
+    mergedTerms[mergedTermCount].variableID = variableID;
+    mergedTerms[mergedTermCount].coefficient = coefficient;
+    mergedTermCount++;
+  }
+
+  if (prunedTermCount > 0)
+  {
+    VPLInstrumentationCount(VPLInstrumentationCounterTermsPruned, prunedTermCount);
+  }
+  return mergedTermCount;
+}
+
+@interface VPLLinearExpression ()
+{
+  VPLTerm * _terms;
+  NSUInteger _termCount;
+}
+
+@end
+
 @implementation VPLLinearExpression
 
 // ===== INITIALIZATION ================================================================================================
@@ -73,44 +248,77 @@ CGFloatFromObjectValue(id obj)
 - (id)initWithConstantValue:(CGFloat)constantValue
 {
   return [self initWithConstantValue:constantValue
-                       variableNames:@[]
-                variableCoefficients:@[]];
+                          ownedTerms:NULL
+                               count:0];
 }
 
 - (id)initWithConstantValue:(CGFloat)constantValue
               variableNames:(NSArray *)variableNames
        variableCoefficients:(NSArray *)variableCoefficients
 {
-  NSMutableDictionary * variableTerms = [[NSMutableDictionary alloc] initWithCapacity:[variableNames count]];
-  [variableNames enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-    
-    NSNumber * coefficient = [variableCoefficients objectAtIndex:idx];
-    NSNumber * existingCoefficient = [variableTerms objectForKey:obj];
-    if (existingCoefficient != nil)
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  NSUInteger termCount = [variableNames count];
+  VPLTerm * terms = VPLTermsAllocate(termCount);
+
+  NSUInteger termIndex = 0;
+  for (NSString * variableName in variableNames)
+  {
+    terms[termIndex].variableID = [symbolTable variableIDForName:variableName];
+    terms[termIndex].coefficient = CGFloatFromObjectValue([variableCoefficients objectAtIndex:termIndex]);
+    termIndex++;
+  }
+
+  qsort(terms, termCount, sizeof(VPLTerm), VPLTermCompare);
+
+  // combine duplicate terms of the same variable
+  NSUInteger uniqueTermCount = 0;
+  for (termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    if (uniqueTermCount > 0 && terms[uniqueTermCount-1].variableID == terms[termIndex].variableID)
     {
-      coefficient = @( [existingCoefficient doubleValue] + [coefficient doubleValue] );
+      terms[uniqueTermCount-1].coefficient += terms[termIndex].coefficient;
     }
-    
-    [variableTerms setObject:coefficient
-                      forKey:obj];
-  }];
-  
+    else
+    {
+      terms[uniqueTermCount] = terms[termIndex];
+      uniqueTermCount++;
+    }
+  }
+
   return [self initWithConstantValue:constantValue
-                       variableTerms:variableTerms];
+                          ownedTerms:terms
+                               count:uniqueTermCount];
 }
 
+/**
+ * Designated initializer. Takes ownership of `terms`, which must have been allocated with `malloc`, be sorted by variable
+ * id, and have no duplicates.
+ */
 - (id)initWithConstantValue:(CGFloat)constantValue
-              variableTerms:(NSDictionary *)variableTerms
+                 ownedTerms:(VPLTerm *)terms
+                      count:(NSUInteger)termCount
 {
   self = [super init];
   if (self != nil)
   {
     _constantValue = constantValue;
-    _variableTerms = variableTerms;
+    _terms = terms;
+    _termCount = termCount;
+  }
+  else
+  {
+    free(terms);
   }
   return self;
 }
 
+- (void)dealloc
+{
+  free(_terms);
+  _terms = NULL;
+}
+
 + (instancetype)expressionWithConstantValue:(CGFloat)constantValue
 {
   return [[self alloc] initWithConstantValue:constantValue];
@@ -125,119 +333,43 @@ CGFloatFromObjectValue(id obj)
                         variableCoefficients:variableCoefficients];
 }
 
-static NSString *
-NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInteger captureGroupIndex)
++ (instancetype)expressionWithConstantValue:(CGFloat)constantValue
+                                      terms:(const VPLTerm *)terms
+                                      count:(NSUInteger)termCount
 {
-  NSRange range = [result rangeAtIndex:captureGroupIndex];
-  if (range.location == NSNotFound) return nil;
-  
-  return [string substringWithRange:range];
+  VPLTerm * copiedTerms = VPLTermsAllocate(termCount);
+  if (termCount > 0)
+  {
+    memcpy(copiedTerms, terms, sizeof(VPLTerm) * termCount);
+  }
+
+  return [[self alloc] initWithConstantValue:constantValue
+                                  ownedTerms:copiedTerms
+                                       count:termCount];
 }
 
 + (instancetype)expressionFromString:(NSString *)expressionString
                                error:(NSError * __autoreleasing *)error
 {
-  static NSString * termPattern = @"\\s*"
-                                   "([+-])?"
-                                   "\\s*"
-                                   "("
-                                      "("
-                                        "(\\d+(?:\\.\\d+)?)"
-                                        "(?:\\s*\\*\\s*)?"
-                                        "([a-zA-Z]+)?"
-                                      ")"
-                                      "|"
-                                      "([a-zA-Z]+)"
-                                    ")"
-                                    "\\s*";
-  
-  static NSRegularExpression * termExpression = nil;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    NSError * error = nil;
-    termExpression = [NSRegularExpression regularExpressionWithPattern:termPattern
-                                                               options:0
-                                                                 error:&error];
-    NSAssert(termExpression != nil,
-             @"Failed to parse expression pattern: %@",
-             [error localizedDescription]);
-  });
-  
-  NSMutableArray * variableNames = [[NSMutableArray alloc] init];
-  NSMutableArray * variableCoefficients = [[NSMutableArray alloc] init];
-  CGFloat constantValue = 0.0f;
-  
-  NSUInteger currentOffset = 0;
-  while (currentOffset < [expressionString length])
+  VPLConstraintParser * parser = [[VPLConstraintParser alloc] initWithString:expressionString];
+  VPLLinearExpression * expression = [parser parseExpression];
+  if (expression == nil)
   {
-    // read the next term
-    NSTextCheckingResult * match = [termExpression firstMatchInString:expressionString
-                                                              options:0
-                                                                range:NSMakeRange(currentOffset, [expressionString length]-currentOffset)];
-    
-    if (match == nil || match.range.location != currentOffset)
-    {
-      if (error != NULL)
-      {
-        NSString * unexpectedString = [expressionString substringFromIndex:currentOffset];
-        NSString * localizedString = [NSString stringWithFormat:@"Encountered unexpected text in linear expression: %@", unexpectedString];
-        *error = [NSError errorWithDomain:VPLLinearExpressionErrorDomain
-                                     code:VPLLinearExpressionParseError
-                                 userInfo:@{ NSLocalizedDescriptionKey : localizedString }];
-      }
-      return nil;
-    }
-    
-    NSString * signString                   = NSStringForResultGroup(expressionString, match, 1);
-    NSString * constantOrCoefficientString  = NSStringForResultGroup(expressionString, match, 4);
-    NSString * coefficientVariableName      = NSStringForResultGroup(expressionString, match, 5);
-    NSString * nakedVariableName            = NSStringForResultGroup(expressionString, match, 6);
-    
-    // process any sign symbol
-    CGFloat constantOrCoefficientValue = 1.0;
-    if (signString != nil)
-    {
-      if ([signString isEqualToString:@"-"])
-      {
-        constantOrCoefficientValue = -1.0;
-      }
-    }
-    
-    // process the contant or coefficient
-    if (constantOrCoefficientString != nil)
-    {
-      constantOrCoefficientValue *= [constantOrCoefficientString doubleValue];
-    }
-    
-    // process the variable name
-    NSString * variableName = (coefficientVariableName != nil ? coefficientVariableName : nakedVariableName);
-    if (variableName != nil)
-    {
-      NSUInteger variableIndex = [variableNames indexOfObject:variableName];
-      if (variableIndex == NSNotFound)
-      {
-        [variableNames addObject:variableName];
-        [variableCoefficients addObject:@(constantOrCoefficientValue)];
-      }
-      else
-      {
-        // add the coefficients
-        NSNumber * variableCoefficient = variableCoefficients[variableIndex];
-        CGFloat combinedCoefficient = [variableCoefficient doubleValue] + constantOrCoefficientValue;
-        variableCoefficients[variableIndex] = @(combinedCoefficient);
-      }
-    }
-    else
+    if (error != NULL)
     {
-      constantValue += constantOrCoefficientValue;
+      *error = [NSError errorWithDomain:VPLLinearExpressionErrorDomain
+                                   code:VPLLinearExpressionParseError
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : [parser.error localizedDescription],
+             NSUnderlyingErrorKey : parser.error
+                
+                }];
     }
-    
-    currentOffset = match.range.location + match.range.length;
+    return nil;
   }
-
-  return [[VPLLinearExpression alloc] initWithConstantValue:constantValue
-                                             variableNames:variableNames
-                                      variableCoefficients:variableCoefficients];
+  
+  return expression;
 }
 
 // ===== EQUALITY ======================================================================================================
@@ -258,7 +390,16 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
   if (otherExpression == nil) return NO;
   
   if (self.constantValue != otherExpression.constantValue) return NO;
-  if (![self.variableTerms isEqualToDictionary:otherExpression.variableTerms]) return NO;
+  if (_termCount != otherExpression->_termCount) return NO;
+
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    const VPLTerm * term = &_terms[termIndex];
+    const VPLTerm * otherTerm = &otherExpression->_terms[termIndex];
+    
+    if (term->variableID != otherTerm->variableID) return NO;
+    if (term->coefficient != otherTerm->coefficient) return NO;
+  }
   
   return YES;
 }
@@ -268,7 +409,11 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
   NSUInteger result = 1;
   NSUInteger prime = 31;
   
-  result = prime * result + [self.variableTerms hash];
+  result = prime * result + _termCount;
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    result = prime * result + _terms[termIndex].variableID;
+  }
   
   return result;
 }
@@ -292,36 +437,33 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
     [description appendFormat:@"%f", self.constantValue];
   }
   
-  if ([self isParametric])
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
   {
-    [self.variableTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-      
-      NSString * variableName = key;
-      CGFloat variableCoefficient = (CGFLOAT_IS_DOUBLE ? [obj doubleValue] : [obj floatValue]);
-      
-      if ([description length] > 0)
-      {
-        if (variableCoefficient < 0)
-        {
-          [description appendString:@" - "];
-          variableCoefficient = -(variableCoefficient);
-        }
-        else
-        {
-          [description appendString:@" + "];
-        }
-      }
-      
-      if (variableCoefficient == 1.0)
+    NSString * variableName = [symbolTable nameForVariableID:_terms[termIndex].variableID];
+    CGFloat variableCoefficient = _terms[termIndex].coefficient;
+    
+    if ([description length] > 0)
+    {
+      if (variableCoefficient < 0)
       {
-        [description appendFormat:@"%@", variableName];
+        [description appendString:@" - "];
+        variableCoefficient = -(variableCoefficient);
       }
       else
       {
-        [description appendFormat:@"%f%@", variableCoefficient, variableName];
+        [description appendString:@" + "];
       }
-      
-    }];
+    }
+    
+    if (variableCoefficient == 1.0)
+    {
+      [description appendFormat:@"%@", variableName];
+    }
+    else
+    {
+      [description appendFormat:@"%f%@", variableCoefficient, variableName];
+    }
   }
 
   return description;
@@ -340,25 +482,33 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
 
 - (BOOL)isParametric
 {
-  return [self.variableTerms count] > 0;
+  return _termCount > 0;
+}
+
+- (NSDictionary *)variableTerms
+{
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  
+  NSMutableDictionary * variableTerms = [[NSMutableDictionary alloc] initWithCapacity:_termCount];
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    [variableTerms setObject:@(_terms[termIndex].coefficient)
+                      forKey:[symbolTable nameForVariableID:_terms[termIndex].variableID]];
+  }
+  
+  return variableTerms;
 }
 
 - (BOOL)containsVariable:(NSString *)variableName
 {
-  return [self.variableTerms objectForKey:variableName] != nil;
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  return variableID != VPLVariableIDNone && [self containsVariableID:variableID];
 }
 
 - (CGFloat)coefficientForVariable:(NSString *)variableName
 {
-  NSNumber * number = self.variableTerms[variableName];
-  if (CGFLOAT_IS_DOUBLE)
-  {
-    return [number doubleValue];
-  }
-  else
-  {
-    return [number floatValue];
-  }
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  return (variableID != VPLVariableIDNone ? [self coefficientForVariableID:variableID] : 0.0);
 }
 
 - (NSArray *)unrestrictedVariableNames
@@ -372,21 +522,49 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
 
 - (NSArray *)variableNamesPassingTest:(BOOL(^)(NSString *, NSNumber *, BOOL *))block
 {
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  
   NSMutableArray * variableNames = [[NSMutableArray alloc] init];
-  [self.variableTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+  BOOL stop = NO;
+  for (NSUInteger termIndex = 0; termIndex < _termCount && !stop; termIndex++)
+  {
+    NSString * variableName = [symbolTable nameForVariableID:_terms[termIndex].variableID];
     
-    BOOL matched = block(key, obj, stop);
+    BOOL matched = block(variableName, @(_terms[termIndex].coefficient), &stop);
     if (matched)
     {
-      [variableNames addObject:key];
+      [variableNames addObject:variableName];
     }
-    
-  }];
+  }
   
   [variableNames sortUsingSelector:@selector(compare:)];
   return variableNames;
 }
 
+// ----- PACKED TERMS --------------------------------------------------------------------------------------------------
+#pragma mark Packed Terms
+
+- (NSUInteger)termCount
+{
+  return _termCount;
+}
+
+- (const VPLTerm *)terms
+{
+  return _terms;
+}
+
+- (CGFloat)coefficientForVariableID:(VPLVariableID)variableID
+{
+  NSUInteger termIndex = VPLTermsIndexOfVariableID(_terms, _termCount, variableID);
+  return (termIndex != NSNotFound ? _terms[termIndex].coefficient : 0.0);
+}
+
+- (BOOL)containsVariableID:(VPLVariableID)variableID
+{
+  return VPLTermsIndexOfVariableID(_terms, _termCount, variableID) != NSNotFound;
+}
+
 // ===== OPERATIONS ====================================================================================================
 #pragma mark - Operations
 
@@ -401,67 +579,114 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
   if ([self isConstant] && self.constantValue == 0.0) return self;
   if (multiplier == 0.0) return [[[self class] alloc] initWithConstantValue:0];
   
-  CGFloat multipliedConstant = self.constantValue * multiplier;
+  CGFloat multipliedConstant = VPLLinearExpressionPrunedConstant(self.constantValue * multiplier);
 
-  NSMutableDictionary * multipliedTerms = [[NSMutableDictionary alloc] initWithCapacity:[self.variableTerms count]];
-  [self.variableTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    
-    CGFloat multipliedCoefficient = CGFloatFromObjectValue(obj) * multiplier;
-    if (multipliedCoefficient != 0.0)
-    {
-      [multipliedTerms setObject:@(multipliedCoefficient)
-                          forKey:key];
-    }
-    
-  }];
+  VPLTerm * multipliedTerms = VPLTermsAllocate(_termCount);
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    multipliedTerms[termIndex].variableID = _terms[termIndex].variableID;
+    multipliedTerms[termIndex].coefficient = _terms[termIndex].coefficient * multiplier;
+  }
+  NSUInteger multipliedTermCount = VPLTermsPrune(multipliedTerms, _termCount);
   
   return [[[self class] alloc] initWithConstantValue:multipliedConstant
-                                       variableTerms:multipliedTerms];
+                                          ownedTerms:multipliedTerms
+                                               count:multipliedTermCount];
+}
+
+- (VPLLinearExpression *)expressionByAddingConstant:(CGFloat)constantValue
+{
+  if (constantValue == 0.0) return self;
   
+  return [[self class] expressionWithConstantValue:VPLLinearExpressionPrunedConstant(self.constantValue + constantValue)
+                                             terms:_terms
+                                             count:_termCount];
 }
 
-+ (NSMutableDictionary *)combineTerms:(NSDictionary *)terms
-                            withTerms:(NSDictionary *)otherTerms
+- (VPLLinearExpression *)expressionByAddingExpression:(VPLLinearExpression *)expression
+                                          multiplier:(CGFloat)multiplier
 {
-  NSMutableDictionary * combinedTerms = [[NSMutableDictionary alloc] initWithDictionary:terms];
-  [otherTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    
-    NSNumber * coeffNumber = [terms objectForKey:key];
-    if (coeffNumber == nil)
-    {
-      combinedTerms[key] = obj;
-    }
-    else
-    {
-      CGFloat combinedCoeff = CGFloatFromObjectValue(coeffNumber) + CGFloatFromObjectValue(obj);
-      if (combinedCoeff == 0.0)
-      {
-        [combinedTerms removeObjectForKey:key];
-      }
-      else
-      {
-        combinedTerms[key] = @(combinedCoeff);
-      }
-    }
-  }];
+  if (multiplier == 0.0) return self;
+  
+  VPLTerm * combinedTerms = VPLTermsAllocate(_termCount + expression->_termCount);
+  NSUInteger combinedTermCount = VPLTermsMerge(_terms, _termCount,
+                                               expression->_terms, expression->_termCount,
+                                               multiplier,
+                                               VPLVariableIDNone,
+                                               combinedTerms);
   
-  return combinedTerms;
+  CGFloat combinedConstant = self.constantValue + (multiplier * expression.constantValue);
+  return [[[self class] alloc] initWithConstantValue:VPLLinearExpressionPrunedConstant(combinedConstant)
+                                          ownedTerms:combinedTerms
+                                               count:combinedTermCount];
 }
 
 - (VPLLinearExpression *)expressionBySubstitutingExpression:(VPLLinearExpression *)expression
                                                forVariable:(NSString *)variableName
 {
-  CGFloat coeff = [self coefficientForVariable:variableName];
-  if (coeff != 0.0)
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  if (variableID == VPLVariableIDNone) return self;
+  
+  return [self expressionBySubstitutingExpression:expression
+                                    forVariableID:variableID];
+}
+
+- (VPLLinearExpression *)expressionBySolvingForVariable:(NSString *)solvedVariableName
+{
+  NSAssert([self containsVariable:solvedVariableName],
+           @"[%@ %@] Cannot solve '%@' for unknown variable '%@'",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           self,
+           solvedVariableName);
+  
+  VPLVariableID solvedVariableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:solvedVariableName];
+  return [self expressionBySolvingForVariableID:solvedVariableID];
+}
+
+- (VPLLinearExpression *)expressionByChangingSubjectFromVariable:(NSString *)currentSubject
+                                                     toVariable:(NSString *)updatedSubject
+{
+  NSAssert([self containsVariable:updatedSubject],
+           @"[%@ %@] destination subject (%@) must be in expression: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           updatedSubject,
+           self);
+  
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+  return [self expressionByChangingSubjectFromVariableID:[symbolTable variableIDForName:currentSubject]
+                                            toVariableID:[symbolTable existingVariableIDForName:updatedSubject]];
+}
+
+- (VPLLinearExpression *)expressionByRemovingVariableTerm:(NSString *)variableName
+{
+  VPLVariableID variableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:variableName];
+  if (variableID == VPLVariableIDNone) return self;
+  
+  return [self expressionByRemovingVariableID:variableID];
+}
+
+// ----- PACKED OPERATIONS ---------------------------------------------------------------------------------------------
+#pragma mark Packed Operations
+
+- (VPLLinearExpression *)expressionBySubstitutingExpression:(VPLLinearExpression *)expression
+                                             forVariableID:(VPLVariableID)variableID
+{
+  CGFloat coeff = [self coefficientForVariableID:variableID];
+  if (!VPLLinearExpressionIsApproximatelyZero(coeff))
   {
-    VPLLinearExpression * multipliedExpression = [expression expressionByMultiplying:coeff];
-    NSMutableDictionary * combinedTerms = [[self class] combineTerms:self.variableTerms
-                                                           withTerms:multipliedExpression.variableTerms];
-    [combinedTerms removeObjectForKey:variableName];
-    
-    return [[[self class] alloc] initWithConstantValue:self.constantValue + multipliedExpression.constantValue
-                                         variableTerms:combinedTerms];
+    VPLTerm * combinedTerms = VPLTermsAllocate(_termCount + expression->_termCount);
+    NSUInteger combinedTermCount = VPLTermsMerge(_terms, _termCount,
+                                                 expression->_terms, expression->_termCount,
+                                                 coeff,
+                                                 variableID,
+                                                 combinedTerms);
     
+    CGFloat combinedConstant = self.constantValue + (coeff * expression.constantValue);
+    return [[[self class] alloc] initWithConstantValue:VPLLinearExpressionPrunedConstant(combinedConstant)
+                                            ownedTerms:combinedTerms
+                                                 count:combinedTermCount];
   }
   else
   {
@@ -469,79 +694,113 @@ NSStringForResultGroup(NSString * string, NSTextCheckingResult * result, NSUInte
   }
 }
 
-- (VPLLinearExpression *)expressionBySolvingForVariable:(NSString *)solvedVariableName
+- (VPLLinearExpression *)expressionBySolvingForVariableID:(VPLVariableID)solvedVariableID
 {
-  NSAssert([self containsVariable:solvedVariableName],
-           @"[%@ %@] Cannot solve '%@' for unknown variable '%@'",
+  NSUInteger solvedTermIndex = VPLTermsIndexOfVariableID(_terms, _termCount, solvedVariableID);
+  NSAssert(solvedTermIndex != NSNotFound,
+           @"[%@ %@] Cannot solve '%@' for unknown variable id %u",
            NSStringFromClass([self class]),
            NSStringFromSelector(_cmd),
            self,
-           solvedVariableName);
+           solvedVariableID);
   
-  CGFloat solvedVariableCoefficient = [self coefficientForVariable:solvedVariableName];
+  CGFloat solvedVariableCoefficient = _terms[solvedTermIndex].coefficient;
   
-  NSMutableDictionary * solvedTerms = [[NSMutableDictionary alloc] initWithCapacity:[self.variableTerms count]-1];
-  [self.variableTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    
-    NSString * variableName = key;
-    if ([variableName isEqualToString:solvedVariableName] == NO)
+  VPLTerm * solvedTerms = VPLTermsAllocate(_termCount - 1);
+  NSUInteger solvedTermCount = 0;
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    if (termIndex != solvedTermIndex)
     {
-      CGFloat variableCoefficient = CGFloatFromObjectValue(obj);
-      [solvedTerms setObject:@(-(variableCoefficient / solvedVariableCoefficient))
-                      forKey:variableName];
+      solvedTerms[solvedTermCount].variableID = _terms[termIndex].variableID;
+      solvedTerms[solvedTermCount].coefficient = -(_terms[termIndex].coefficient / solvedVariableCoefficient);
+      solvedTermCount++;
     }
-    
-  }];
+  }
   
-  CGFloat solvedConstantValue = -(self.constantValue / solvedVariableCoefficient);
+  CGFloat solvedConstantValue = VPLLinearExpressionPrunedConstant(-(self.constantValue / solvedVariableCoefficient));
   return [[[self class] alloc] initWithConstantValue:solvedConstantValue
-                                       variableTerms:solvedTerms];
+                                          ownedTerms:solvedTerms
+                                               count:VPLTermsPrune(solvedTerms, solvedTermCount)];
 }
 
-- (VPLLinearExpression *)expressionByChangingSubjectFromVariable:(NSString *)currentSubject
-                                                     toVariable:(NSString *)updatedSubject
+- (VPLLinearExpression *)expressionByChangingSubjectFromVariableID:(VPLVariableID)currentSubject
+                                                     toVariableID:(VPLVariableID)updatedSubject
 {
   // updatedSubject = (1/cI)*currentSubject - (constant/cI) - (c1/cI)v1 + ... + (cN / cI)vN
   
-  NSAssert([self containsVariable:updatedSubject],
-           @"[%@ %@] destination subject (%@) must be in expression: %@",
+  NSUInteger updatedSubjectIndex = VPLTermsIndexOfVariableID(_terms, _termCount, updatedSubject);
+  NSAssert(updatedSubjectIndex != NSNotFound,
+           @"[%@ %@] destination subject (%u) must be in expression: %@",
            NSStringFromClass([self class]),
            NSStringFromSelector(_cmd),
            updatedSubject,
            self);
   
-  CGFloat updatedSubjectCoeff = [self coefficientForVariable:updatedSubject];
+  CGFloat updatedSubjectCoeff = _terms[updatedSubjectIndex].coefficient;
   
-  NSMutableDictionary * exchangedTerms = [[NSMutableDictionary alloc] initWithCapacity:[self.variableTerms count]];
-  exchangedTerms[currentSubject] = @(1 / updatedSubjectCoeff);
+  // the current subject takes the updated subject's place, so there's never more terms than we started with
+  VPLTerm * exchangedTerms = VPLTermsAllocate(_termCount);
+  NSUInteger exchangedTermCount = 0;
+  BOOL insertedCurrentSubject = NO;
   
-  [self.variableTerms enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+  for (NSUInteger termIndex = 0; termIndex < _termCount; termIndex++)
+  {
+    VPLVariableID variableID = _terms[termIndex].variableID;
+    if (variableID == updatedSubject) continue;
     
-    NSString * variableName = key;
-    if (NO == [variableName isEqualToString:updatedSubject])
+    if (!insertedCurrentSubject && currentSubject < variableID)
     {
-      CGFloat variableCoeff = CGFloatFromObjectValue(obj);
-      exchangedTerms[variableName] = @(-(variableCoeff / updatedSubjectCoeff));
+      exchangedTerms[exchangedTermCount].variableID = currentSubject;
+      exchangedTerms[exchangedTermCount].coefficient = 1 / updatedSubjectCoeff;
+      exchangedTermCount++;
+      insertedCurrentSubject = YES;
     }
     
-  }];
+    if (variableID == currentSubject)
+    {
+      insertedCurrentSubject = YES;
+    }
+    
+    exchangedTerms[exchangedTermCount].variableID = variableID;
+    exchangedTerms[exchangedTermCount].coefficient = -(_terms[termIndex].coefficient / updatedSubjectCoeff);
+    exchangedTermCount++;
+  }
+  
+  if (!insertedCurrentSubject)
+  {
+    exchangedTerms[exchangedTermCount].variableID = currentSubject;
+    exchangedTerms[exchangedTermCount].coefficient = 1 / updatedSubjectCoeff;
+    exchangedTermCount++;
+  }
   
-  CGFloat updatedConstant = -(self.constantValue / updatedSubjectCoeff);
+  CGFloat updatedConstant = VPLLinearExpressionPrunedConstant(-(self.constantValue / updatedSubjectCoeff));
   
   return [[[self class] alloc] initWithConstantValue:updatedConstant
-                                       variableTerms:exchangedTerms];
+                                          ownedTerms:exchangedTerms
+                                               count:VPLTermsPrune(exchangedTerms, exchangedTermCount)];
 }
 
-
-- (VPLLinearExpression *)expressionByRemovingVariableTerm:(NSString *)variableName
+- (VPLLinearExpression *)expressionByRemovingVariableID:(VPLVariableID)variableID
 {
-  if (self.variableTerms[variableName] == nil) return self;
+  NSUInteger removedTermIndex = VPLTermsIndexOfVariableID(_terms, _termCount, variableID);
+  if (removedTermIndex == NSNotFound) return self;
   
-  NSMutableDictionary * variableTerms = [[NSMutableDictionary alloc] initWithDictionary:self.variableTerms];
-  [variableTerms removeObjectForKey:variableName];
+  VPLTerm * remainingTerms = VPLTermsAllocate(_termCount - 1);
+  if (removedTermIndex > 0)
+  {
+    memcpy(remainingTerms, _terms, sizeof(VPLTerm) * removedTermIndex);
+  }
+  if (removedTermIndex + 1 < _termCount)
+  {
+    memcpy(remainingTerms + removedTermIndex,
+           _terms + removedTermIndex + 1,
+           sizeof(VPLTerm) * (_termCount - removedTermIndex - 1));
+  }
   
   return [[[self class] alloc] initWithConstantValue:self.constantValue
-                                       variableTerms:variableTerms];
+                                          ownedTerms:remainingTerms
+                                               count:_termCount - 1];
 }
 
 @end
@@ -0,0 +1,93 @@
+#import "VPLCassowaryTypes.h"
+#import "VPLSymbolTable.h"
+#import "VPLTableau.h"
+
+/**
+ * Incrementally solves a single tableau: adding and removing constraints, edit variables and suggested values, and
+ * the dual simplex re-solve that follows suggestions.
+ *
+ * A solver doesn't keep track of which constraints it holds; `VPLConstraintSet` does that, and gives each independent
+ * group of constraints a solver of its own. Separate solvers never share constraints, and only touch the symbol table
+ * to look up the constraints' variables, so they may be used from different threads at the same time.
+ *
+ * Copying a solver forks it: the copy starts out with the same tableau, objective and edit variables, and shares the
+ * tableau's rows with the original until either of them changes, so it takes O(1) time however large the tableau is.
+ * The original and the copy can then be changed independently, on different threads if need be.
+ */
+@interface VPLSimplexSolver : NSObject <NSCopying>
+
+// ===== TABLEAU =======================================================================================================
+#pragma mark - Tableau
+
+@property (nonatomic, strong, readonly) VPLMutableTableau * tableau;
+
+/**
+ * The pivot rule used to optimize the solver's objectives. See `VPLPivotRule`.
+ */
+@property (nonatomic, assign) VPLPivotRule pivotRule;
+
+/**
+ * The number of pivots the solver has performed, including those of solvers merged into it.
+ */
+@property (nonatomic, assign, readonly) NSUInteger pivotCount;
+
+// ===== CONSTRAINTS ===================================================================================================
+#pragma mark - Constraints
+
+/**
+ * Adds a batch of constraints, sharing a single phase one optimization between them. `markerVariableIDs` holds each
+ * constraint's marker, as an `NSNumber`, in the same order. Returns the constraints that couldn't be satisfied, which
+ * are left out of the tableau.
+ *
+ * Constraints that aren't required get error variables, weighted in the objective by their strength, so they're always
+ * added, and any conflicts between them are settled by the optimization that follows. Only required constraints are
+ * ever returned.
+ */
+- (NSArray *)addConstraints:(NSArray *)constraints
+             markerVariableIDs:(NSArray *)markerVariableIDs;
+
+- (void)removeConstraints:(NSArray *)constraints
+        markerVariableIDs:(NSArray *)markerVariableIDs;
+
+// ===== EDIT VARIABLES ================================================================================================
+#pragma mark - Edit Variables
+
+- (BOOL)containsEditVariable:(NSString *)variableName;
+
+- (void)addEditVariable:(NSString *)variableName;
+
+/**
+ * Adds an edit variable whose error is multiplied by `weight` in the objective, so it's held in preference to edit
+ * variables with lower weights when they conflict.
+ */
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight;
+- (void)removeEditVariable:(NSString *)variableName;
+
+- (void)suggestValue:(CGFloat)value
+         forVariable:(NSString *)variableName;
+
+/**
+ * YES if suggestions have left restricted rows infeasible since the last `-resolve`. Adding or removing constraints or
+ * edit variables resolves first, since they need a feasible tableau.
+ */
+- (BOOL)needsResolve;
+
+- (void)resolve;
+
+// ===== VALUES ========================================================================================================
+#pragma mark - Values
+
+- (CGFloat)valueForVariableID:(VPLVariableID)variableID;
+
+// ===== MERGING =======================================================================================================
+#pragma mark - Merging
+
+/**
+ * Moves the rows, objective and edit variables of another solver into this one. The solvers must not share any
+ * constraints. The variables `solver` made for itself are given new ids, since both solvers hand them out from the
+ * same anonymous indexes. `solver` shouldn't be used afterwards.
+ */
+- (void)mergeSolver:(VPLSimplexSolver *)solver;
+
+@end
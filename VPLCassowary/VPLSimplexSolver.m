@@ -0,0 +1,1172 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSimplexSolver.h"
+#import "VPLConstraint.h"
+#import "VPLLinearExpression.h"
+#import "VPLTableau.h"
+#import "VPLInstrumentation.h"
+
+/**
+ * The error in an edit variable's value is minimized by the objective, multiplied by the edit variable's weight. This is
+ * the weight used by `-addEditVariable:`.
+ */
+static const CGFloat VPLSimplexSolverEditVariableWeight = 1.0;
+
+static int
+VPLSimplexSolverTermCompare(const void * term, const void * otherTerm)
+{
+  VPLVariableID variableID = ((const VPLTerm *)term)->variableID;
+  VPLVariableID otherVariableID = ((const VPLTerm *)otherTerm)->variableID;
+  
+  return (variableID < otherVariableID ? -1 : (variableID > otherVariableID ? 1 : 0));
+}
+
+/**
+ * Returns `expression` with the ids of solvers' own variables swapped by `mapVariableID`, for merging solvers.
+ * Expressions without any are returned as they are, so their rows stay shared.
+ */
+static VPLLinearExpression *
+VPLSimplexSolverExpressionByMappingVariableIDs(VPLLinearExpression * expression,
+                                               VPLVariableID (^mapVariableID)(VPLVariableID variableID))
+{
+  NSUInteger termCount = expression.termCount;
+  const VPLTerm * terms = expression.terms;
+  
+  BOOL needsMapping = NO;
+  for (NSUInteger termIndex = 0; termIndex < termCount && !needsMapping; termIndex++)
+  {
+    needsMapping = VPLVariableIDIsSolverVariable(terms[termIndex].variableID);
+  }
+  if (!needsMapping) return expression;
+  
+  VPLTerm * mappedTerms = malloc(sizeof(VPLTerm) * termCount);
+  for (NSUInteger termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    mappedTerms[termIndex].variableID = mapVariableID(terms[termIndex].variableID);
+    mappedTerms[termIndex].coefficient = terms[termIndex].coefficient;
+  }
+  qsort(mappedTerms, termCount, sizeof(VPLTerm), VPLSimplexSolverTermCompare);
+  
+  VPLLinearExpression * mappedExpression = [VPLLinearExpression expressionWithConstantValue:expression.constantValue
+                                                                                      terms:mappedTerms
+                                                                                      count:termCount];
+  free(mappedTerms);
+  return mappedExpression;
+}
+
+/**
+ * An edit variable is held at its suggested value by the equation:
+ *
+ *     variable = constant + plusError - minusError
+ *
+ * where both error variables are restricted, and their sum is minimized by the objective.
+ */
+@interface VPLEditVariable : NSObject <NSCopying>
+
+@property (nonatomic, assign) VPLVariableID variableID;
+@property (nonatomic, assign) VPLVariableID plusErrorVariableID;
+@property (nonatomic, assign) VPLVariableID minusErrorVariableID;
+@property (nonatomic, assign) CGFloat constant;
+@property (nonatomic, assign) CGFloat weight;
+
+@end
+
+@implementation VPLEditVariable
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  VPLEditVariable * editVariable = [[VPLEditVariable alloc] init];
+  editVariable.variableID = self.variableID;
+  editVariable.plusErrorVariableID = self.plusErrorVariableID;
+  editVariable.minusErrorVariableID = self.minusErrorVariableID;
+  editVariable.constant = self.constant;
+  editVariable.weight = self.weight;
+  
+  return editVariable;
+}
+
+@end
+
+/**
+ * A constraint that isn't required is held as a preference, by adding error variables to its expression:
+ *
+ *     0 = expression + plusError - minusError
+ *
+ * where both error variables are restricted, and their sum is minimized by the objective, multiplied by the weight of
+ * the constraint's strength. An inequality's slack already covers one direction, so it only gets the error variable
+ * for the other, and its `minusErrorVariableID` is `VPLVariableIDNone`.
+ *
+ * Preferences are never changed once they're added, so forks of a solver can share them.
+ */
+@interface VPLPreference : NSObject
+
+@property (nonatomic, assign) VPLVariableID plusErrorVariableID;
+@property (nonatomic, assign) VPLVariableID minusErrorVariableID;
+@property (nonatomic, assign) CGFloat weight;
+
+@end
+
+@implementation VPLPreference
+
+@end
+
+@interface VPLSimplexSolver ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * editVariables;
+@property (nonatomic, strong, readonly) NSMutableDictionary * preferencesByMarkerVariableID;
+@property (nonatomic, strong, readonly) NSMutableIndexSet * infeasibleRowVariableIDs;
+@property (nonatomic, assign, readonly) VPLVariableID objectiveVariableID;
+@property (nonatomic, assign) NSUInteger mergedPivotCount;
+@property (nonatomic, assign) NSUInteger variableIndexCount;
+@property (nonatomic, strong, readonly) NSMutableIndexSet * freeVariableIndexes;
+
+@end
+
+@implementation VPLSimplexSolver
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (id)init
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _tableau = [[VPLMutableTableau alloc] init];
+    _editVariables = [[NSMutableDictionary alloc] init];
+    _preferencesByMarkerVariableID = [[NSMutableDictionary alloc] init];
+    _infeasibleRowVariableIDs = [[NSMutableIndexSet alloc] init];
+    _objectiveVariableID = VPLVariableIDNone;
+    _freeVariableIndexes = [[NSMutableIndexSet alloc] init];
+  }
+  return self;
+}
+
+- (id)initWithSolver:(VPLSimplexSolver *)solver
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _tableau = [solver.tableau mutableCopy];
+    _objectiveVariableID = solver.objectiveVariableID;
+    _mergedPivotCount = solver.mergedPivotCount;
+    _variableIndexCount = solver.variableIndexCount;
+    _freeVariableIndexes = [solver.freeVariableIndexes mutableCopy];
+    
+    // edit variables are changed by suggestions, so each one is copied
+    _editVariables = [[NSMutableDictionary alloc] initWithCapacity:[solver.editVariables count]];
+    [solver.editVariables enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+      [_editVariables setObject:[obj copy]
+                         forKey:key];
+    }];
+    
+    _preferencesByMarkerVariableID = [solver.preferencesByMarkerVariableID mutableCopy];
+    _infeasibleRowVariableIDs = [solver.infeasibleRowVariableIDs mutableCopy];
+  }
+  return self;
+}
+
+// ===== NSCopying =====================================================================================================
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  return [[VPLSimplexSolver alloc] initWithSolver:self];
+}
+
+// ===== PIVOT RULE ====================================================================================================
+#pragma mark - Pivot Rule
+
+- (VPLPivotRule)pivotRule
+{
+  return self.tableau.pivotRule;
+}
+
+- (void)setPivotRule:(VPLPivotRule)pivotRule
+{
+  self.tableau.pivotRule = pivotRule;
+}
+
+- (NSUInteger)pivotCount
+{
+  return self.mergedPivotCount + self.tableau.pivotCount;
+}
+
+// ===== VARIABLES =====================================================================================================
+#pragma mark - Variables
+
+/**
+ * Hands out an anonymous id for a variable the solver makes for itself. The lowest index that's free is reused first,
+ * the same way constraint sets hand out markers, so however many error and artificial variables come and go, the
+ * solver only ever holds as many indexes as it has variables alive, and the symbol table never sees them. Indexes don't
+ * depend on what other solvers or threads are doing, so a solver fed the same constraints makes the same variables.
+ */
+- (VPLVariableID)createVariableIDOfKind:(VPLVariableKind)kind
+{
+  NSUInteger variableIndex = [self.freeVariableIndexes firstIndex];
+  if (variableIndex != NSNotFound)
+  {
+    [self.freeVariableIndexes removeIndex:variableIndex];
+  }
+  else
+  {
+    if (self.variableIndexCount > VPLVariableIndexMax - VPLVariableSolverIndexBase)
+    {
+      [NSException raise:NSInternalInconsistencyException
+                  format:@"Unable to create a variable, since the solver already holds %lu of its own",
+                         (unsigned long)self.variableIndexCount];
+    }
+    
+    variableIndex = VPLVariableSolverIndexBase + self.variableIndexCount++;
+  }
+  
+  return VPLVariableIDMakeAnonymous(variableIndex, kind);
+}
+
+/**
+ * Takes back a variable from `-createVariableIDOfKind:` once it has left the tableau.
+ */
+- (void)releaseVariableID:(VPLVariableID)variableID
+{
+  if (variableID == VPLVariableIDNone) return;
+  
+  NSAssert(VPLVariableIDIsSolverVariable(variableID),
+           @"[%@ %@] Attempt to release a variable the solver didn't create: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           [[VPLSymbolTable sharedSymbolTable] nameForVariableID:variableID]);
+  
+  [self.freeVariableIndexes addIndex:VPLVariableIDGetAnonymousIndex(variableID)];
+}
+
+// ===== OBJECTIVE =====================================================================================================
+#pragma mark - Objective
+
+/**
+ * The objective row is only needed once there's something to minimize, so it's created along with the first edit
+ * variable or preference.
+ */
+- (VPLVariableID)createObjectiveIfNeeded
+{
+  if (_objectiveVariableID == VPLVariableIDNone)
+  {
+    _objectiveVariableID = [self createVariableIDOfKind:VPLVariableKindObjective];
+    [self.tableau setExpression:[VPLLinearExpression expressionWithConstantValue:0.0]
+        forRowVariableID:_objectiveVariableID];
+  }
+  
+  return _objectiveVariableID;
+}
+
+/**
+ * Adds `multiplier * expression` to the objective, after replacing any basic variables in the expression so the
+ * objective row stays in terms of parametric variables only.
+ */
+- (void)addExpressionToObjective:(VPLLinearExpression *)expression
+                      multiplier:(CGFloat)multiplier
+{
+  VPLMutableTableau * tableau = self.tableau;
+  VPLVariableID objectiveVariableID = [self createObjectiveIfNeeded];
+  
+  VPLLinearExpression * parametricExpression = [tableau expressionByReplacingRowVariablesInExpression:expression];
+  VPLLinearExpression * objectiveExpression = [tableau expressionForRowVariableID:objectiveVariableID];
+  
+  [tableau setExpression:[objectiveExpression expressionByAddingExpression:parametricExpression
+                                                                multiplier:multiplier]
+        forRowVariableID:objectiveVariableID];
+}
+
+- (void)optimizeObjective
+{
+  if (self.objectiveVariableID != VPLVariableIDNone)
+  {
+    [self.tableau optimizeObjectiveVariableID:self.objectiveVariableID];
+  }
+}
+
+// ===== ADD CONSTRAINTS ===============================================================================================
+#pragma mark - Add Constraints
+
+/**
+ * When adding a constraint, we first search the expression for a basic variable that can be added to the tableau
+ * directly. This method returns the id of the variable that should be used to add the expression.
+ *
+ * If no variable can be found, then `VPLVariableIDNone` is returned, and the expression must be added using an
+ * artificial variable.
+ */
+- (VPLVariableID)selectBasicVariableFromBasicExpression:(VPLLinearExpression *)expression
+{
+  // If there is an unrestricted variable in the equation, make that the basic variable. However, a new unrestricted
+  // variable can be inserted into the tableau directly, so we prefer unknown variables first.
+  VPLMutableTableau * tableau = self.tableau;
+  
+  const VPLTerm * terms = expression.terms;
+  NSUInteger termCount = expression.termCount;
+  
+  VPLVariableID unrestrictedVariableID = VPLVariableIDNone;
+  for (NSUInteger termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    VPLVariableID variableID = terms[termIndex].variableID;
+    if (VPLVariableIDIsUnrestricted(variableID))
+    {
+      if (![tableau containsColumnVariableID:variableID])
+      {
+        // unrestricted, unknown variable
+        return variableID;
+      }
+      else if (unrestrictedVariableID == VPLVariableIDNone)
+      {
+        // unrestricted, but known. Keep searching for a better match.
+        unrestrictedVariableID = variableID;
+      }
+    }
+  }
+  
+  if (unrestrictedVariableID != VPLVariableIDNone)
+  {
+    // there was an unrestricted variable, but we'll have to perform a substitution
+    return unrestrictedVariableID;
+  }
+  
+  // No unrestricted variables, but if there is an unknown restricted variable with a negative coefficient we can use
+  // that.
+  for (NSUInteger termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    VPLVariableID variableID = terms[termIndex].variableID;
+    if (terms[termIndex].coefficient < -VPLLinearExpressionEpsilon()
+        && !VPLVariableIDIsDummy(variableID)
+        && ![tableau containsColumnVariableID:variableID])
+    {
+      return variableID;
+    }
+  }
+  
+  // all restricted variables have positive coefficients, or are dummy variables. In the special case where the
+  // expression contains only dummy variables, then pick the one that is not in the tableau to enter the basis.
+  VPLVariableID newDummyVariableID = VPLVariableIDNone;
+  for (NSUInteger termIndex = 0; termIndex < termCount; termIndex++)
+  {
+    VPLVariableID variableID = terms[termIndex].variableID;
+    if (VPLVariableIDIsDummy(variableID))
+    {
+      if (![tableau containsColumnVariableID:variableID])
+      {
+        newDummyVariableID = variableID;
+      }
+    }
+    else
+    {
+      // the expression contained non-dummy variables
+      return VPLVariableIDNone;
+    }
+  }
+  
+  return newDummyVariableID;
+}
+
+- (NSArray *)addConstraints:(NSArray *)constraints
+             markerVariableIDs:(NSArray *)markerVariableIDs
+{
+  // rows can only be added to a feasible tableau
+  [self resolveIfNeeded];
+  
+  NSMutableArray * artificialVariableIDs = [[NSMutableArray alloc] init];
+  NSMutableArray * artificialConstraints = [[NSMutableArray alloc] init];
+  NSMutableArray * preferences = [[NSMutableArray alloc] init];
+  
+  // add every row first...
+  for (NSUInteger constraintIndex = 0; constraintIndex < [constraints count]; constraintIndex++)
+  {
+    VPLConstraint * constraint = [constraints objectAtIndex:constraintIndex];
+    VPLVariableID markerVariableID = [[markerVariableIDs objectAtIndex:constraintIndex] unsignedIntValue];
+    
+    VPLLinearExpression * expression = [constraint expressionWithMarkerVariableID:markerVariableID];
+    if (![constraint isRequired])
+    {
+      VPLPreference * preference = [self preferenceForConstraint:constraint
+                                                markerVariableID:markerVariableID];
+      expression = [expression expressionByAddingExpression:[self errorExpressionForPreference:preference
+                                                                                    constraint:constraint]
+                                                 multiplier:1.0];
+      [preferences addObject:preference];
+    }
+    
+    // A preference's error variables are new and restricted, and one of them has a negative coefficient, so it never
+    // needs an artificial variable; only required constraints can turn out to be unsatisfiable.
+    VPLVariableID artificialVariableID = [self addRowsForExpression:expression];
+    if (artificialVariableID != VPLVariableIDNone)
+    {
+      [artificialVariableIDs addObject:@(artificialVariableID)];
+      [artificialConstraints addObject:constraint];
+    }
+  }
+  
+  // ...then drive all of the artificial variables out together
+  NSIndexSet * unsatisfiableIndexes = [self removeArtificialVariableIDs:artificialVariableIDs];
+  
+  // Conflicting preferences are traded off against each other by the objective, so a single optimization settles all
+  // of them at once.
+  for (VPLPreference * preference in preferences)
+  {
+    [self addExpressionToObjective:[self objectiveExpressionForPreference:preference]
+                        multiplier:preference.weight];
+  }
+  
+  [self optimizeObjective];
+  
+  VPLInstrumentationCount(VPLInstrumentationCounterConstraintsAdded, (int64_t)[constraints count]);
+  [self recordTableauStatistics];
+  
+  return [artificialConstraints objectsAtIndexes:unsatisfiableIndexes];
+}
+
+/**
+ * Creates the error variables for a constraint that isn't required, and records them under its marker.
+ */
+- (VPLPreference *)preferenceForConstraint:(VPLConstraint *)constraint
+                          markerVariableID:(VPLVariableID)markerVariableID
+{
+  VPLPreference * preference = [[VPLPreference alloc] init];
+  preference.plusErrorVariableID = [self createVariableIDOfKind:VPLVariableKindSlack];
+  preference.minusErrorVariableID = VPLVariableIDNone;
+  preference.weight = VPLConstraintStrengthWeight(constraint.strength);
+  
+  if (constraint.relation == VPLConstraintRelationEqual)
+  {
+    preference.minusErrorVariableID = [self createVariableIDOfKind:VPLVariableKindSlack];
+  }
+  
+  [self.preferencesByMarkerVariableID setObject:preference
+                                         forKey:@(markerVariableID)];
+  
+  return preference;
+}
+
+/**
+ * The terms a preference adds to its constraint's expression. An inequality's error variable has the opposite sign to
+ * its slack marker, so that it covers the direction the slack can't.
+ */
+- (VPLLinearExpression *)errorExpressionForPreference:(VPLPreference *)preference
+                                           constraint:(VPLConstraint *)constraint
+{
+  if (preference.minusErrorVariableID == VPLVariableIDNone)
+  {
+    VPLTerm errorTerm = { preference.plusErrorVariableID, (constraint.markerCoefficient > 0.0 ? -1.0 : 1.0) };
+    return [VPLLinearExpression expressionWithConstantValue:0.0
+                                                      terms:&errorTerm
+                                                      count:1];
+  }
+  
+  VPLTerm errorTerms[2] = {
+    { preference.plusErrorVariableID, 1.0 },
+    { preference.minusErrorVariableID, -1.0 },
+  };
+  
+  // terms are kept in id order
+  if (errorTerms[0].variableID > errorTerms[1].variableID)
+  {
+    VPLTerm swap = errorTerms[0];
+    errorTerms[0] = errorTerms[1];
+    errorTerms[1] = swap;
+  }
+  
+  return [VPLLinearExpression expressionWithConstantValue:0.0
+                                                    terms:errorTerms
+                                                    count:2];
+}
+
+/**
+ * The sum of a preference's error variables, which the objective minimizes.
+ */
+- (VPLLinearExpression *)objectiveExpressionForPreference:(VPLPreference *)preference
+{
+  VPLVariableID plusErrorVariableID = preference.plusErrorVariableID;
+  VPLVariableID minusErrorVariableID = preference.minusErrorVariableID;
+  if (minusErrorVariableID == VPLVariableIDNone)
+  {
+    VPLTerm errorTerm = { plusErrorVariableID, 1.0 };
+    return [VPLLinearExpression expressionWithConstantValue:0.0
+                                                      terms:&errorTerm
+                                                      count:1];
+  }
+  
+  VPLTerm errorTerms[2] = {
+    { MIN(plusErrorVariableID, minusErrorVariableID), 1.0 },
+    { MAX(plusErrorVariableID, minusErrorVariableID), 1.0 },
+  };
+  return [VPLLinearExpression expressionWithConstantValue:0.0
+                                                    terms:errorTerms
+                                                    count:2];
+}
+
+/**
+ * Adds a single expression, such as an edit variable's, outside of a batch. Returns NO if it can't be satisfied.
+ */
+- (BOOL)addExpression:(VPLLinearExpression *)expression
+{
+  VPLVariableID artificialVariableID = [self addRowsForExpression:expression];
+  if (artificialVariableID == VPLVariableIDNone) return YES;
+  
+  return [[self removeArtificialVariableIDs:@[ @(artificialVariableID) ]] count] == 0;
+}
+
+/**
+ * Adds the row for a constraint's expression to the tableau. If no variable in the expression can be made basic
+ * directly, an artificial variable is made basic instead, and its id is returned so that it can be driven to zero by
+ * `-removeArtificialVariableIDs:`. Otherwise returns `VPLVariableIDNone`.
+ */
+- (VPLVariableID)addRowsForExpression:(VPLLinearExpression *)constraintExpr
+{
+  // The constraint's expression is in the form 0 = c - e, with c gauranteed to be positive as required by the cassowary
+  // algorithm
+  NSAssert(constraintExpr.constantValue >= 0.0,
+           @"[%@ %@] constraint expressions are expected to have positive constants!",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+  
+  VPLMutableTableau * tableau = self.tableau;
+  
+  // replace all basic variables in the expression with their expressions in the tableau
+  VPLLinearExpression * basicExpression = [tableau expressionByReplacingRowVariablesInExpression:constraintExpr];
+  
+  // all basic variables have been removed from the expression, so the only variables left are parametric, or new
+  // variables. Substituting may have made the constant negative, so negate the expression to keep it positive.
+  if (basicExpression.constantValue < 0.0)
+  {
+    basicExpression = [basicExpression expressionByNegatingExpression];
+  }
+  
+  // If we find a basic variable in the expression, we can add it directly to the tableau
+  VPLVariableID basicVariableID = [self selectBasicVariableFromBasicExpression:basicExpression];
+  if (basicVariableID != VPLVariableIDNone)
+  {
+    VPLLinearExpression * rowExpression = [basicExpression expressionBySolvingForVariableID:basicVariableID];
+    
+    // substitute for the basic variable, if it's already a column. Only the rows that contain it are touched.
+    [tableau substituteExpression:rowExpression
+              forColumnVariableID:basicVariableID];
+    
+    [tableau setExpression:rowExpression
+          forRowVariableID:basicVariableID];
+    
+    return VPLVariableIDNone;
+  }
+  
+  // create an artifical variable $az, and add a row $az = expr
+  VPLVariableID artificialVariableID = [self createVariableIDOfKind:VPLVariableKindSlack];
+  [tableau setExpression:basicExpression
+        forRowVariableID:artificialVariableID];
+  
+  return artificialVariableID;
+}
+
+/**
+ * Phase one of the simplex method: minimizes the sum of the artificial variables, then removes each of them from the
+ * tableau. An artificial variable that can't be driven to zero means its constraint is unsatisfiable; its row is
+ * dropped, which drops the constraint. Returns the indexes of those artificial variables.
+ */
+- (NSIndexSet *)removeArtificialVariableIDs:(NSArray *)artificialVariableIDs
+{
+  NSMutableIndexSet * unsatisfiableIndexes = [[NSMutableIndexSet alloc] init];
+  if ([artificialVariableIDs count] == 0) return unsatisfiableIndexes;
+  
+  VPLInstrumentationCount(VPLInstrumentationCounterArtificialPhases, 1);
+  VPLMutableTableau * tableau = self.tableau;
+  
+  // Rows added later in a batch may have substituted into an earlier artificial row and left it with a negative
+  // constant. The artificial variable only measures how far its equation is from being satisfied, so negating the row
+  // is just as good, and keeps the tableau feasible for the minimization.
+  VPLLinearExpression * phaseOneExpr = [VPLLinearExpression expressionWithConstantValue:0.0];
+  for (NSNumber * artificialVariableIDNumber in artificialVariableIDs)
+  {
+    VPLVariableID artificialVariableID = [artificialVariableIDNumber unsignedIntValue];
+    VPLLinearExpression * artificialExpr = [tableau expressionForRowVariableID:artificialVariableID];
+    if (artificialExpr.constantValue < 0.0)
+    {
+      artificialExpr = [artificialExpr expressionByNegatingExpression];
+      [tableau setExpression:artificialExpr
+            forRowVariableID:artificialVariableID];
+    }
+    
+    phaseOneExpr = [phaseOneExpr expressionByAddingExpression:artificialExpr
+                                                   multiplier:1.0];
+  }
+  
+  VPLVariableID objectiveVariableID = [self createVariableIDOfKind:VPLVariableKindObjective];
+  
+  [tableau minimizeExpression:phaseOneExpr
+          objectiveVariableID:objectiveVariableID];
+  
+  [artificialVariableIDs enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+    
+    VPLVariableID artificialVariableID = [obj unsignedIntValue];
+    VPLLinearExpression * absRow = [tableau expressionForRowVariableID:artificialVariableID];
+    if (absRow != nil)
+    {
+      // anything within the epsilon is floating point noise rather than a constraint that can't be satisfied
+      if (absRow.constantValue > VPLLinearExpressionEpsilon())
+      {
+        // the artificial variable is basic and still positive, so this constraint can't be satisfied along with the
+        // others. No other row refers to a basic variable, so removing its row removes just this constraint.
+        [unsatisfiableIndexes addIndex:idx];
+        [tableau removeRowVariableID:artificialVariableID];
+      }
+      else if ([absRow isConstant])
+      {
+        // it's constant ($az = 0), so we can simply remove the row
+        [tableau removeRowVariableID:artificialVariableID];
+      }
+      else
+      {
+        // Artificial variable is non-constant ($az = 0 + bx + ...). We can pivot and turn $az into a column, which
+        // can then be removed. The row's constant is 0, so the pivot doesn't change any other row's value. Prefer a
+        // slack variable, but any variable will do.
+        VPLVariableID entryVariableID = absRow.terms[0].variableID;
+        for (NSUInteger termIndex = 0; termIndex < absRow.termCount; termIndex++)
+        {
+          VPLVariableID variableID = absRow.terms[termIndex].variableID;
+          if (VPLVariableIDIsSlack(variableID))
+          {
+            entryVariableID = variableID;
+            break;
+          }
+        }
+        
+        [tableau pivotRowVariableID:artificialVariableID
+                   columnVariableID:entryVariableID];
+      }
+    }
+    
+    // The artificial variable is parametric now (or gone), so simply remove its column
+    [tableau removeColumnVariableID:artificialVariableID];
+    [self releaseVariableID:artificialVariableID];
+    
+  }];
+  
+  [tableau removeRowVariableID:objectiveVariableID];
+  [self releaseVariableID:objectiveVariableID];
+  
+  return unsatisfiableIndexes;
+}
+
+// ===== REMOVE CONSTRAINT =============================================================================================
+#pragma mark - Remove Constraint
+
+- (void)removeConstraints:(NSArray *)constraints
+        markerVariableIDs:(NSArray *)markerVariableIDs
+{
+  [self resolveIfNeeded];
+  
+  for (NSUInteger constraintIndex = 0; constraintIndex < [constraints count]; constraintIndex++)
+  {
+    VPLConstraint * constraint = [constraints objectAtIndex:constraintIndex];
+    NSNumber * markerVariableID = [markerVariableIDs objectAtIndex:constraintIndex];
+    
+    VPLPreference * preference = [self.preferencesByMarkerVariableID objectForKey:markerVariableID];
+    if (preference != nil)
+    {
+      // take the error variables out of the objective first, while the rows they're defined by still exist
+      [self addExpressionToObjective:[self objectiveExpressionForPreference:preference]
+                          multiplier:-preference.weight];
+    }
+    
+    [self removeMarkerVariableID:[markerVariableID unsignedIntValue]
+         preferredExitVariableID:constraint.variableID];
+    
+    if (preference != nil)
+    {
+      [self removeErrorVariableID:preference.plusErrorVariableID];
+      [self removeErrorVariableID:preference.minusErrorVariableID];
+      [self.preferencesByMarkerVariableID removeObjectForKey:markerVariableID];
+    }
+  }
+  
+  // the objective only needs optimizing once the whole batch is gone
+  [self optimizeObjective];
+  
+  VPLInstrumentationCount(VPLInstrumentationCounterConstraintsRemoved, (int64_t)[constraints count]);
+  [self recordTableauStatistics];
+}
+
+/**
+ * Removes an error variable once its constraint or edit variable is gone. If it's still basic, nothing else refers to
+ * it, so its row can go; if it's parametric, it's 0, so its column can go without changing any row's value.
+ */
+- (void)removeErrorVariableID:(VPLVariableID)errorVariableID
+{
+  if (errorVariableID == VPLVariableIDNone) return;
+  
+  VPLMutableTableau * tableau = self.tableau;
+  if ([tableau containsRowVariableID:errorVariableID])
+  {
+    [tableau removeRowVariableID:errorVariableID];
+  }
+  else
+  {
+    [tableau removeColumnVariableID:errorVariableID];
+  }
+  
+  [self.infeasibleRowVariableIDs removeIndex:errorVariableID];
+  [self releaseVariableID:errorVariableID];
+}
+
+/**
+ * Removes the constraint identified by a marker variable. If the marker is parametric it's first pivoted into the
+ * basis, preferring the row of `preferredExitVariableID` when no restricted row qualifies.
+ */
+- (void)removeMarkerVariableID:(VPLVariableID)markerVariableID
+       preferredExitVariableID:(VPLVariableID)preferredExitVariableID
+{
+  VPLMutableTableau * tableau = self.tableau;
+  
+  if ([tableau containsRowVariableID:markerVariableID])
+  {
+    [tableau removeRowVariableID:markerVariableID];
+  }
+  else
+  {
+    // The marker variable is parametric, so we need to find a way to pivot it into the basis before we can remove it.
+    // Only the rows in the marker's column can be candidates.
+    NSIndexSet * markerRows = [tableau rowVariableIDsForColumnVariableID:markerVariableID];
+    
+    // First look for a restricted row that contains the marker variable with a negative coefficient. Then we can do a
+    // simple pivot.
+    __block VPLVariableID exitVariableID = VPLVariableIDNone;
+    __block CGFloat minRatio = CGFLOAT_MAX;
+    [markerRows enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      
+      VPLVariableID rowVariableID = (VPLVariableID)idx;
+      if (VPLVariableIDIsRestricted(rowVariableID))
+      {
+        VPLLinearExpression * rowExpr = [tableau expressionForRowVariableID:rowVariableID];
+        CGFloat coeff = [rowExpr coefficientForVariableID:markerVariableID];
+        if (coeff < -VPLLinearExpressionEpsilon())
+        {
+          CGFloat ratio = -rowExpr.constantValue / coeff;
+          if (exitVariableID == VPLVariableIDNone || ratio < minRatio)
+          {
+            minRatio = ratio;
+            exitVariableID = rowVariableID;
+          }
+        }
+      }
+      
+    }];
+    
+    if (exitVariableID == VPLVariableIDNone)
+    {
+      // the marker variable is either positive in all restricted row expressions, or only appears in unrestricted rows.
+      //
+      // Let's look again at restricted rows, and pick the one with the smallest ratio
+      [markerRows enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        
+        VPLVariableID rowVariableID = (VPLVariableID)idx;
+        if (VPLVariableIDIsRestricted(rowVariableID))
+        {
+          VPLLinearExpression * rowExpr = [tableau expressionForRowVariableID:rowVariableID];
+          CGFloat coeff = [rowExpr coefficientForVariableID:markerVariableID];
+          CGFloat ratio = rowExpr.constantValue / coeff;
+          if (exitVariableID == VPLVariableIDNone || ratio < minRatio)
+          {
+            minRatio = ratio;
+            exitVariableID = rowVariableID;
+          }
+        }
+        
+      }];
+    }
+    
+    if (exitVariableID == VPLVariableIDNone)
+    {
+      // the marker variable only appears in unrestricted row expressions. Pick any, but prefer the original equation
+      if ([markerRows containsIndex:preferredExitVariableID])
+      {
+        exitVariableID = preferredExitVariableID;
+      }
+      else
+      {
+        // never pivot out the objective row
+        NSUInteger exitIndex = [markerRows indexPassingTest:^BOOL(NSUInteger idx, BOOL *stop) {
+          return !VPLVariableIDIsObjective((VPLVariableID)idx);
+        }];
+        
+        if (exitIndex != NSNotFound)
+        {
+          exitVariableID = (VPLVariableID)exitIndex;
+        }
+      }
+    }
+    
+    if (exitVariableID != VPLVariableIDNone)
+    {
+      [tableau pivotRowVariableID:exitVariableID
+                 columnVariableID:markerVariableID];
+      [tableau removeRowVariableID:markerVariableID];
+    }
+    // else the marker variable doesn't appear in any equations
+  }
+}
+
+// ===== EDIT VARIABLES ================================================================================================
+#pragma mark - Edit Variables
+
+- (BOOL)containsEditVariable:(NSString *)variableName
+{
+  return [self.editVariables objectForKey:variableName] != nil;
+}
+
+- (void)addEditVariable:(NSString *)variableName
+{
+  [self addEditVariable:variableName
+                 weight:VPLSimplexSolverEditVariableWeight];
+}
+
+- (void)addEditVariable:(NSString *)variableName
+                 weight:(CGFloat)weight
+{
+  NSAssert(![self containsEditVariable:variableName],
+           @"[%@ %@] Attempt to add edit variable that already exists: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           variableName);
+  
+  VPLEditVariable * editVariable = [[VPLEditVariable alloc] init];
+  editVariable.variableID = [[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName];
+  editVariable.plusErrorVariableID = [self createVariableIDOfKind:VPLVariableKindSlack];
+  editVariable.minusErrorVariableID = [self createVariableIDOfKind:VPLVariableKindSlack];
+  editVariable.weight = weight;
+  
+  [self resolveIfNeeded];
+  editVariable.constant = [self valueForVariableID:editVariable.variableID];
+  
+  // variable = constant + plusError - minusError
+  // 0 = constant - variable + plusError - minusError
+  VPLTerm editTerms[3] = {
+    { editVariable.variableID, -1.0 },
+    { editVariable.plusErrorVariableID, 1.0 },
+    { editVariable.minusErrorVariableID, -1.0 },
+  };
+  qsort(editTerms, 3, sizeof(VPLTerm), VPLSimplexSolverTermCompare);
+  
+  VPLLinearExpression * editExpr = [VPLLinearExpression expressionWithConstantValue:editVariable.constant
+                                                                              terms:editTerms
+                                                                              count:3];
+  if (editExpr.constantValue < 0.0)
+  {
+    editExpr = [editExpr expressionByNegatingExpression];
+  }
+  
+  BOOL satisfiable = [self addExpression:editExpr];
+  NSAssert(satisfiable,
+           @"[%@ %@] Edit variable expressions are always satisfiable, since their error variables can absorb any value",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+  (void)satisfiable;
+  
+  // minimize the error on both sides
+  [self addExpressionToObjective:[self objectiveExpressionForEditVariable:editVariable]
+                      multiplier:weight];
+  
+  [self.editVariables setObject:editVariable
+                         forKey:variableName];
+  
+  [self optimizeObjective];
+}
+
+/**
+ * The sum of an edit variable's error variables, which the objective minimizes.
+ */
+- (VPLLinearExpression *)objectiveExpressionForEditVariable:(VPLEditVariable *)editVariable
+{
+  VPLVariableID plusErrorVariableID = editVariable.plusErrorVariableID;
+  VPLVariableID minusErrorVariableID = editVariable.minusErrorVariableID;
+  VPLTerm errorTerms[2] = {
+    { MIN(plusErrorVariableID, minusErrorVariableID), 1.0 },
+    { MAX(plusErrorVariableID, minusErrorVariableID), 1.0 },
+  };
+  return [VPLLinearExpression expressionWithConstantValue:0.0
+                                                    terms:errorTerms
+                                                    count:2];
+}
+
+- (void)removeEditVariable:(NSString *)variableName
+{
+  VPLEditVariable * editVariable = [self.editVariables objectForKey:variableName];
+  NSAssert(editVariable != nil,
+           @"[%@ %@] Attempt to remove edit variable that doesn't exist: %@",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           variableName);
+  
+  [self resolveIfNeeded];
+  
+  VPLVariableID plusErrorVariableID = editVariable.plusErrorVariableID;
+  VPLVariableID minusErrorVariableID = editVariable.minusErrorVariableID;
+  
+  // take the error variables out of the objective first, while the rows they're defined by still exist
+  [self addExpressionToObjective:[self objectiveExpressionForEditVariable:editVariable]
+                      multiplier:-editVariable.weight];
+  
+  // the plus error variable acts as the edit's marker
+  [self removeMarkerVariableID:plusErrorVariableID
+       preferredExitVariableID:editVariable.variableID];
+  
+  [self removeErrorVariableID:minusErrorVariableID];
+  
+  [self.infeasibleRowVariableIDs removeIndex:plusErrorVariableID];
+  [self releaseVariableID:plusErrorVariableID];
+  [self.editVariables removeObjectForKey:variableName];
+  
+  [self optimizeObjective];
+}
+
+- (void)suggestValue:(CGFloat)value
+         forVariable:(NSString *)variableName
+{
+  VPLEditVariable * editVariable = [self.editVariables objectForKey:variableName];
+  NSAssert(editVariable != nil,
+           @"[%@ %@] Attempt to suggest a value for %@, which is not an edit variable",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           variableName);
+  
+  CGFloat delta = value - editVariable.constant;
+  if (delta == 0.0) return;
+  
+  editVariable.constant = value;
+  
+  // Changing the edit's constant by delta is the same as substituting one of its error variables:
+  //
+  //     variable = (constant + delta) + plusError - minusError
+  //
+  // is the original equation with plusError = plusError' + delta, or with minusError = minusError' - delta. So we
+  // only have to adjust row constants, using whichever error variable is basic. If neither is, then we adjust the
+  // constant of every row in minusError's column.
+  VPLMutableTableau * tableau = self.tableau;
+  VPLVariableID plusErrorVariableID = editVariable.plusErrorVariableID;
+  VPLVariableID minusErrorVariableID = editVariable.minusErrorVariableID;
+  
+  if ([tableau containsRowVariableID:plusErrorVariableID])
+  {
+    [self addConstant:-delta
+      toRowVariableID:plusErrorVariableID];
+  }
+  else if ([tableau containsRowVariableID:minusErrorVariableID])
+  {
+    [self addConstant:delta
+      toRowVariableID:minusErrorVariableID];
+  }
+  else
+  {
+    NSIndexSet * columnRows = [tableau rowVariableIDsForColumnVariableID:minusErrorVariableID];
+    [columnRows enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      
+      VPLVariableID rowVariableID = (VPLVariableID)idx;
+      CGFloat coeff = [[tableau expressionForRowVariableID:rowVariableID] coefficientForVariableID:minusErrorVariableID];
+      [self addConstant:-(coeff * delta)
+        toRowVariableID:rowVariableID];
+      
+    }];
+  }
+}
+
+/**
+ * Adjusts a row's constant, noting the row if it's restricted and has become infeasible.
+ */
+- (void)addConstant:(CGFloat)constantValue
+    toRowVariableID:(VPLVariableID)rowVariableID
+{
+  VPLMutableTableau * tableau = self.tableau;
+  [tableau addConstant:constantValue
+       toRowVariableID:rowVariableID];
+  
+  if (VPLVariableIDIsRestricted(rowVariableID)
+      && [tableau expressionForRowVariableID:rowVariableID].constantValue < 0.0)
+  {
+    [self.infeasibleRowVariableIDs addIndex:rowVariableID];
+  }
+}
+
+- (BOOL)needsResolve
+{
+  return [self.infeasibleRowVariableIDs count] > 0;
+}
+
+- (void)resolveIfNeeded
+{
+  if ([self needsResolve])
+  {
+    [self resolve];
+  }
+}
+
+- (void)resolve
+{
+  VPLMutableTableau * tableau = self.tableau;
+  NSMutableIndexSet * infeasibleRowVariableIDs = self.infeasibleRowVariableIDs;
+  
+  // Dual simplex. The objective is still optimal after a suggestion, but some restricted rows may have negative
+  // constants. Pivot each of them out, choosing the entry variable that keeps the objective optimal.
+  while ([infeasibleRowVariableIDs count] > 0)
+  {
+    VPLVariableID exitVariableID = (VPLVariableID)[infeasibleRowVariableIDs firstIndex];
+    [infeasibleRowVariableIDs removeIndex:exitVariableID];
+    
+    VPLLinearExpression * exitExpr = [tableau expressionForRowVariableID:exitVariableID];
+    if (exitExpr == nil || exitExpr.constantValue >= 0.0) continue;
+    
+    VPLLinearExpression * objectiveExpr = [tableau expressionForRowVariableID:self.objectiveVariableID];
+    
+    VPLVariableID entryVariableID = VPLVariableIDNone;
+    CGFloat minRatio = CGFLOAT_MAX;
+    const VPLTerm * exitTerms = exitExpr.terms;
+    for (NSUInteger termIndex = 0; termIndex < exitExpr.termCount; termIndex++)
+    {
+      VPLVariableID variableID = exitTerms[termIndex].variableID;
+      CGFloat coeff = exitTerms[termIndex].coefficient;
+      if (coeff > VPLLinearExpressionEpsilon() && VPLVariableIDIsPivotable(variableID))
+      {
+        CGFloat ratio = [objectiveExpr coefficientForVariableID:variableID] / coeff;
+        if (ratio < minRatio)
+        {
+          minRatio = ratio;
+          entryVariableID = variableID;
+        }
+      }
+    }
+    
+    if (entryVariableID == VPLVariableIDNone)
+    {
+      [NSException raise:@"VPLSimplexSolverDualOptimizeFailed"
+                  format:@"Unable to restore feasibility of row %@ = %@",
+                         [[VPLSymbolTable sharedSymbolTable] nameForVariableID:exitVariableID],
+                         exitExpr];
+    }
+    
+    // the pivot changes the constants of every row that contains the entry variable, so check those afterwards
+    NSIndexSet * affectedRowVariableIDs = [tableau rowVariableIDsForColumnVariableID:entryVariableID];
+    
+    [tableau pivotRowVariableID:exitVariableID
+               columnVariableID:entryVariableID];
+    
+    [affectedRowVariableIDs enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      
+      VPLVariableID rowVariableID = (VPLVariableID)idx;
+      if (VPLVariableIDIsRestricted(rowVariableID)
+          && [tableau expressionForRowVariableID:rowVariableID].constantValue < 0.0)
+      {
+        [infeasibleRowVariableIDs addIndex:rowVariableID];
+      }
+      
+    }];
+  }
+  
+  [self recordTableauStatistics];
+}
+
+// ===== INSTRUMENTATION ===============================================================================================
+#pragma mark - Instrumentation
+
+- (void)recordTableauStatistics
+{
+  VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauRows, (int64_t)self.tableau.rowCount);
+  VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauTerms, (int64_t)self.tableau.termCount);
+  VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauMaximumRowLength,
+                                  (int64_t)self.tableau.maximumRowLength);
+}
+
+// ===== VALUES ========================================================================================================
+#pragma mark - Values
+
+- (CGFloat)valueForVariableID:(VPLVariableID)variableID
+{
+  return [self.tableau expressionForRowVariableID:variableID].constantValue;
+}
+
+// ===== MERGING =======================================================================================================
+#pragma mark - Merging
+
+- (void)mergeSolver:(VPLSimplexSolver *)solver
+{
+  VPLMutableTableau * tableau = self.tableau;
+  VPLMutableTableau * mergedTableau = solver.tableau;
+  VPLVariableID mergedObjectiveVariableID = solver.objectiveVariableID;
+  
+  // Both solvers hand out their own variables from the same indexes, so each of the merged solver's is given a new id
+  // from this one, the first time it's seen. Every other variable belongs to the constraints, which the solvers don't
+  // share, so those keep their ids.
+  NSUInteger mergedVariableIndexCount = solver.variableIndexCount;
+  VPLVariableID * mappedVariableIDs = calloc(MAX(mergedVariableIndexCount, 1), sizeof(VPLVariableID));
+  VPLVariableID (^mapVariableID)(VPLVariableID) = ^VPLVariableID(VPLVariableID variableID) {
+    
+    if (!VPLVariableIDIsSolverVariable(variableID)) return variableID;
+    
+    NSUInteger mappedIndex = VPLVariableIDGetAnonymousIndex(variableID) - VPLVariableSolverIndexBase;
+    if (mappedVariableIDs[mappedIndex] == VPLVariableIDNone)
+    {
+      mappedVariableIDs[mappedIndex] = [self createVariableIDOfKind:VPLVariableIDGetKind(variableID)];
+    }
+    return mappedVariableIDs[mappedIndex];
+    
+  };
+  
+  // Apart from their ids, the rows can be copied across as they are. Both objectives are sums over their own
+  // variables, so the merged objective is simply their sum.
+  [mergedTableau.rowVariableIDs enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    
+    VPLVariableID rowVariableID = (VPLVariableID)idx;
+    if (rowVariableID != mergedObjectiveVariableID)
+    {
+      VPLLinearExpression * rowExpr = [mergedTableau expressionForRowVariableID:rowVariableID];
+      [tableau setExpression:VPLSimplexSolverExpressionByMappingVariableIDs(rowExpr, mapVariableID)
+            forRowVariableID:mapVariableID(rowVariableID)];
+    }
+    
+  }];
+  
+  if (mergedObjectiveVariableID != VPLVariableIDNone)
+  {
+    VPLVariableID objectiveVariableID = [self createObjectiveIfNeeded];
+    VPLLinearExpression * objectiveExpr = [tableau expressionForRowVariableID:objectiveVariableID];
+    VPLLinearExpression * mergedObjectiveExpr = [mergedTableau expressionForRowVariableID:mergedObjectiveVariableID];
+    mergedObjectiveExpr = VPLSimplexSolverExpressionByMappingVariableIDs(mergedObjectiveExpr, mapVariableID);
+    
+    [tableau setExpression:[objectiveExpr expressionByAddingExpression:mergedObjectiveExpr
+                                                            multiplier:1.0]
+          forRowVariableID:objectiveVariableID];
+  }
+  
+  [solver.editVariables enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+    
+    VPLEditVariable * editVariable = [obj copy];
+    editVariable.plusErrorVariableID = mapVariableID(editVariable.plusErrorVariableID);
+    editVariable.minusErrorVariableID = mapVariableID(editVariable.minusErrorVariableID);
+    [self.editVariables setObject:editVariable
+                           forKey:key];
+    
+  }];
+  
+  // preferences may be shared with forks of the merged solver, so they're replaced rather than changed
+  [solver.preferencesByMarkerVariableID enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+    
+    VPLPreference * mergedPreference = obj;
+    VPLPreference * preference = [[VPLPreference alloc] init];
+    preference.plusErrorVariableID = mapVariableID(mergedPreference.plusErrorVariableID);
+    preference.minusErrorVariableID = mapVariableID(mergedPreference.minusErrorVariableID);
+    preference.weight = mergedPreference.weight;
+    [self.preferencesByMarkerVariableID setObject:preference
+                                           forKey:key];
+    
+  }];
+  
+  [solver.infeasibleRowVariableIDs enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    [self.infeasibleRowVariableIDs addIndex:mapVariableID((VPLVariableID)idx)];
+  }];
+  
+  free(mappedVariableIDs);
+  self.mergedPivotCount += solver.pivotCount;
+}
+
+@end
@@ -0,0 +1,163 @@
+#import "VPLCassowaryTypes.h"
+
+// ===== VARIABLE IDS ==================================================================================================
+
+/**
+ * Variables are interned into a symbol table once, and referred to by an integer id everywhere inside the solver. The
+ * low bits of every id hold the variable's kind, so checks like "is this a slack variable?" never have to look at the
+ * variable's name:
+ *
+ *     id = (index << VPLVariableKindBits) | kind
+ *
+ * Ids are never 0, so `VPLVariableIDNone` can be used to mean "no variable".
+ */
+typedef uint32_t VPLVariableID;
+
+#define VPLVariableIDNone ((VPLVariableID)0)
+
+typedef enum _VPLVariableKind {
+
+  VPLVariableKindExternal = 0,
+  VPLVariableKindSlack = 1,
+  VPLVariableKindDummy = 2,
+  VPLVariableKindObjective = 3
+
+} VPLVariableKind;
+
+#define VPLVariableKindBits 2
+#define VPLVariableKindMask ((VPLVariableID)((1 << VPLVariableKindBits) - 1))
+
+/**
+ * Ids with the top bit set are anonymous. They're never interned, so creating one costs nothing and leaves nothing
+ * behind in the symbol table; whoever hands them out decides when they can be handed out again. Constraint sets use
+ * them for their constraints' markers, and solvers for the error, artificial and objective variables they make for
+ * themselves. Below the top bit, they're laid out like any other id.
+ *
+ * An anonymous variable's name is its kind's prefix, followed by `#` and its index, and is made up whenever it's asked
+ * for. The symbol table turns such a name back into the same id, without interning it.
+ */
+#define VPLVariableIDAnonymousFlag ((VPLVariableID)1 << 31)
+
+/**
+ * The largest index that fits in an id alongside its kind, below the anonymous bit. A symbol table raises
+ * `VPLSymbolTableFullException` rather than intern a variable past it, since its id would wrap around and alias another
+ * variable's.
+ */
+#define VPLVariableIndexMax ((NSUInteger)((UINT32_MAX >> 1) >> VPLVariableKindBits))
+
+/**
+ * Anonymous indexes are split in half, so that markers and solvers' own variables can be handed out without either
+ * knowing about the other: markers are below this index, and solvers' variables are at or above it.
+ */
+#define VPLVariableSolverIndexBase ((VPLVariableIndexMax >> 1) + 1)
+
+static inline VPLVariableKind
+VPLVariableIDGetKind(VPLVariableID variableID)
+{
+  return (VPLVariableKind)(variableID & VPLVariableKindMask);
+}
+
+static inline BOOL
+VPLVariableIDIsAnonymous(VPLVariableID variableID)
+{
+  return (variableID & VPLVariableIDAnonymousFlag) != 0;
+}
+
+static inline VPLVariableID
+VPLVariableIDMakeAnonymous(NSUInteger anonymousIndex, VPLVariableKind kind)
+{
+  return VPLVariableIDAnonymousFlag | (VPLVariableID)(anonymousIndex << VPLVariableKindBits) | (VPLVariableID)kind;
+}
+
+static inline NSUInteger
+VPLVariableIDGetAnonymousIndex(VPLVariableID variableID)
+{
+  return (variableID & ~VPLVariableIDAnonymousFlag) >> VPLVariableKindBits;
+}
+
+static inline BOOL
+VPLVariableIDIsSolverVariable(VPLVariableID variableID)
+{
+  return (VPLVariableIDIsAnonymous(variableID) &&
+          VPLVariableIDGetAnonymousIndex(variableID) >= VPLVariableSolverIndexBase);
+}
+
+static inline BOOL
+VPLVariableIDIsExternal(VPLVariableID variableID)
+{
+  return VPLVariableIDGetKind(variableID) == VPLVariableKindExternal;
+}
+
+static inline BOOL
+VPLVariableIDIsSlack(VPLVariableID variableID)
+{
+  return VPLVariableIDGetKind(variableID) == VPLVariableKindSlack;
+}
+
+static inline BOOL
+VPLVariableIDIsDummy(VPLVariableID variableID)
+{
+  return VPLVariableIDGetKind(variableID) == VPLVariableKindDummy;
+}
+
+static inline BOOL
+VPLVariableIDIsObjective(VPLVariableID variableID)
+{
+  return VPLVariableIDGetKind(variableID) == VPLVariableKindObjective;
+}
+
+static inline BOOL
+VPLVariableIDIsRestricted(VPLVariableID variableID)
+{
+  VPLVariableKind kind = VPLVariableIDGetKind(variableID);
+  return kind == VPLVariableKindSlack || kind == VPLVariableKindDummy;
+}
+
+static inline BOOL
+VPLVariableIDIsUnrestricted(VPLVariableID variableID)
+{
+  return !VPLVariableIDIsRestricted(variableID);
+}
+
+static inline BOOL
+VPLVariableIDIsPivotable(VPLVariableID variableID)
+{
+  return VPLVariableIDIsSlack(variableID);
+}
+
+VPLVariableKind VPLVariableKindForName(NSString * variableName);
+
+extern NSString * const VPLSymbolTableFullException;
+
+/**
+ * Interns variable names into integer ids. Names are only needed at the API boundary: when expressions are created from
+ * names, and when they are described or converted back into dictionaries.
+ *
+ * A symbol table is safe to use from multiple threads.
+ */
+@interface VPLSymbolTable : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
++ (instancetype)sharedSymbolTable;
+
+// ===== VARIABLES =====================================================================================================
+#pragma mark - Variables
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ * Returns the id for the named variable, interning the name if it hasn't been seen before.
+ */
+- (VPLVariableID)variableIDForName:(NSString *)variableName;
+
+/**
+ * Returns the id for the named variable, or `VPLVariableIDNone` if the name has never been interned. Useful for
+ * lookups, which shouldn't grow the table.
+ */
+- (VPLVariableID)existingVariableIDForName:(NSString *)variableName;
+
+- (NSString *)nameForVariableID:(VPLVariableID)variableID;
+
+@end
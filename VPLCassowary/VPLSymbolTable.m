@@ -0,0 +1,218 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSymbolTable.h"
+#import "VPLLinearExpression.h"
+#import <pthread.h>
+
+VPLVariableKind
+VPLVariableKindForName(NSString * variableName)
+{
+  if ([variableName hasPrefix:VPLLinearExpressionSlackVariablePrefix])
+  {
+    return VPLVariableKindSlack;
+  }
+  else if ([variableName hasPrefix:VPLLinearExpressionDummyVariablePrefix])
+  {
+    return VPLVariableKindDummy;
+  }
+  else if ([variableName hasPrefix:VPLLinearExpressionObjectiveVariablePrefix])
+  {
+    return VPLVariableKindObjective;
+  }
+  else
+  {
+    return VPLVariableKindExternal;
+  }
+}
+
+NSString * const VPLSymbolTableFullException = @"VPLSymbolTableFullException";
+
+static NSString *
+VPLSymbolTablePrefixForKind(VPLVariableKind kind)
+{
+  switch (kind)
+  {
+    case VPLVariableKindSlack:
+      return VPLLinearExpressionSlackVariablePrefix;
+
+    case VPLVariableKindDummy:
+      return VPLLinearExpressionDummyVariablePrefix;
+
+    case VPLVariableKindObjective:
+      return VPLLinearExpressionObjectiveVariablePrefix;
+
+    case VPLVariableKindExternal:
+      break;
+  }
+  return @"";
+}
+
+/**
+ * Returns the id of an anonymous variable's name, or `VPLVariableIDNone` if it isn't one.
+ */
+static VPLVariableID
+VPLSymbolTableAnonymousVariableIDForName(NSString * variableName)
+{
+  VPLVariableKind kind = VPLVariableKindForName(variableName);
+  NSUInteger markIndex = [VPLSymbolTablePrefixForKind(kind) length];
+
+  // most names aren't anonymous, and this tells them apart without allocating anything
+  NSUInteger length = [variableName length];
+  if (length < markIndex + 2 || [variableName characterAtIndex:markIndex] != '#') return VPLVariableIDNone;
+
+  NSUInteger anonymousIndex = 0;
+  for (NSUInteger characterIndex = markIndex + 1; characterIndex < length; characterIndex++)
+  {
+    unichar character = [variableName characterAtIndex:characterIndex];
+    if (character < '0' || character > '9' || anonymousIndex > VPLVariableIndexMax / 10) return VPLVariableIDNone;
+
+    anonymousIndex = anonymousIndex * 10 + (NSUInteger)(character - '0');
+  }
+
+  if (anonymousIndex > VPLVariableIndexMax) return VPLVariableIDNone;
+
+  return VPLVariableIDMakeAnonymous(anonymousIndex, kind);
+}
+
+@interface VPLSymbolTable ()
+{
+  pthread_mutex_t _lock;
+}
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * variableIDsByName;
+@property (nonatomic, strong, readonly) NSMutableArray * variableNames;
+
+@end
+
+@implementation VPLSymbolTable
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (id)init
+{
+  self = [super init];
+  if (self != nil)
+  {
+    pthread_mutex_init(&_lock, NULL);
+    _variableIDsByName = [[NSMutableDictionary alloc] init];
+
+    // index 0 is reserved so that no variable is ever assigned VPLVariableIDNone
+    _variableNames = [[NSMutableArray alloc] initWithObjects:[NSNull null], nil];
+  }
+  return self;
+}
+
+- (void)dealloc
+{
+  pthread_mutex_destroy(&_lock);
+}
+
++ (instancetype)sharedSymbolTable
+{
+  static VPLSymbolTable * sharedSymbolTable = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedSymbolTable = [[self alloc] init];
+  });
+
+  return sharedSymbolTable;
+}
+
+// ===== VARIABLES =====================================================================================================
+#pragma mark - Variables
+
+- (NSUInteger)count
+{
+  pthread_mutex_lock(&_lock);
+  NSUInteger count = [self.variableNames count] - 1;
+  pthread_mutex_unlock(&_lock);
+
+  return count;
+}
+
+- (VPLVariableID)variableIDForName:(NSString *)variableName
+{
+  NSAssert(variableName != nil,
+           @"-[%@ %@] Attempt to intern a nil variable name",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+
+  VPLVariableID anonymousVariableID = VPLSymbolTableAnonymousVariableIDForName(variableName);
+  if (anonymousVariableID != VPLVariableIDNone) return anonymousVariableID;
+
+  pthread_mutex_lock(&_lock);
+
+  NSNumber * variableIDNumber = [self.variableIDsByName objectForKey:variableName];
+  VPLVariableID variableID;
+  if (variableIDNumber != nil)
+  {
+    variableID = [variableIDNumber unsignedIntValue];
+  }
+  else
+  {
+    NSString * internedName = [variableName copy];
+    NSUInteger variableIndex = [self.variableNames count];
+    if (variableIndex > VPLVariableIndexMax)
+    {
+      pthread_mutex_unlock(&_lock);
+      [self raiseFullExceptionForName:variableName];
+    }
+
+    variableID = (VPLVariableID)((variableIndex << VPLVariableKindBits) | VPLVariableKindForName(internedName));
+
+    [self.variableNames addObject:internedName];
+    [self.variableIDsByName setObject:@(variableID)
+                               forKey:internedName];
+  }
+
+  pthread_mutex_unlock(&_lock);
+
+  return variableID;
+}
+
+- (void)raiseFullExceptionForName:(NSString *)variableName
+{
+  [NSException raise:VPLSymbolTableFullException
+              format:@"Unable to intern %@, since the symbol table already holds %lu variables",
+                     variableName,
+                     (unsigned long)VPLVariableIndexMax];
+}
+
+- (VPLVariableID)existingVariableIDForName:(NSString *)variableName
+{
+  if (variableName == nil) return VPLVariableIDNone;
+
+  VPLVariableID anonymousVariableID = VPLSymbolTableAnonymousVariableIDForName(variableName);
+  if (anonymousVariableID != VPLVariableIDNone) return anonymousVariableID;
+
+  pthread_mutex_lock(&_lock);
+  NSNumber * variableIDNumber = [self.variableIDsByName objectForKey:variableName];
+  pthread_mutex_unlock(&_lock);
+
+  return (variableIDNumber != nil ? [variableIDNumber unsignedIntValue] : VPLVariableIDNone);
+}
+
+- (NSString *)nameForVariableID:(VPLVariableID)variableID
+{
+  if (VPLVariableIDIsAnonymous(variableID))
+  {
+    return [NSString stringWithFormat:@"%@#%lu",
+                                      VPLSymbolTablePrefixForKind(VPLVariableIDGetKind(variableID)),
+                                      (unsigned long)VPLVariableIDGetAnonymousIndex(variableID)];
+  }
+
+  NSUInteger variableIndex = variableID >> VPLVariableKindBits;
+
+  pthread_mutex_lock(&_lock);
+  NSString * variableName = (variableIndex > 0 && variableIndex < [self.variableNames count]
+                             ? [self.variableNames objectAtIndex:variableIndex]
+                             : nil);
+  pthread_mutex_unlock(&_lock);
+
+  return variableName;
+}
+
+@end
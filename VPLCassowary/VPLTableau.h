@@ -1,7 +1,25 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLSymbolTable.h"
 
 @class VPLLinearExpression;
 
+/**
+ * How optimization chooses the variable that enters the basis on each pivot. Whichever rule is chosen, a run of
+ * degenerate pivots switches to Bland's rule until the objective improves again, so optimization can't cycle.
+ */
+typedef enum _VPLPivotRule {
+
+  /** The first variable, by id, that would decrease the objective. Never cycles, but may need many more pivots. */
+  VPLPivotRuleBland = 0,
+
+  /** The variable with the most negative coefficient in the objective. */
+  VPLPivotRuleDantzig = 1,
+
+  /** The variable whose edge decreases the objective most steeply, with its coefficient scaled by its column's norm. */
+  VPLPivotRuleSteepestEdge = 2
+
+} VPLPivotRule;
+
 /**
  * A tableau is a collection of equations in "basic feasible solved form". This means that each equation looks like
  * this:
@@ -18,8 +36,20 @@
  * define the values of all the basic variables.
  *
  * We end up with a matrix of `M` rows representing basic variables, and `N` columns of parametric variables.
+ *
+ * Alongside its rows, a tableau keeps a reverse index from each column variable to the rows whose expressions contain
+ * it. This makes `containsColumnVariableID:` a single lookup, and lets substitution and pivoting visit only the rows
+ * that actually contain the column, rather than every row in the tableau.
+ *
+ * `VPLTableau` is immutable, and its `tableauBy...` methods each return a modified copy. The solver works on a
+ * `VPLMutableTableau` instead, which applies the same operations in place.
+ *
+ * Rows and the column index are kept in persistent maps (see `VPLVariableMap`), and row expressions are immutable, so
+ * tableaux share everything they haven't changed. Copying a tableau, mutably or not, takes O(1) time, and a change only
+ * copies the parts of the maps it touches. A solved tableau can be forked into any number of mutable copies, each of
+ * which may then be changed on a thread of its own.
  */
-@interface VPLTableau : NSObject
+@interface VPLTableau : NSObject <NSCopying, NSMutableCopying>
 
 // ===== INITIALIZATION ================================================================================================
 #pragma mark - Initialization
@@ -41,6 +71,58 @@
 
 - (VPLLinearExpression *)expressionByReplacingRowVariablesInExpression:(VPLLinearExpression *)expression;
 
+// ----- VARIABLE IDS --------------------------------------------------------------------------------------------------
+#pragma mark Variable IDs
+
+@property (nonatomic, assign, readonly) NSUInteger rowCount;
+@property (nonatomic, assign, readonly) NSUInteger columnCount;
+
+/**
+ * The ids of all row variables, in ascending order.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet * rowVariableIDs;
+
+- (VPLLinearExpression *)expressionForRowVariableID:(VPLVariableID)rowVariableID;
+
+- (BOOL)containsRowVariableID:(VPLVariableID)rowVariableID;
+- (BOOL)containsColumnVariableID:(VPLVariableID)columnVariableID;
+
+/**
+ * Returns the ids of the rows whose expressions contain the column variable, in ascending order, or nil if the
+ * variable isn't a column of this tableau.
+ */
+- (NSIndexSet *)rowVariableIDsForColumnVariableID:(VPLVariableID)columnVariableID;
+
+// ----- FILL-IN -------------------------------------------------------------------------------------------------------
+#pragma mark Fill-in
+
+/**
+ * The number of terms across all rows. Substitutions can add terms to rows that didn't have them, so this grows as the
+ * tableau fills in.
+ */
+@property (nonatomic, assign, readonly) NSUInteger termCount;
+
+/**
+ * The number of terms in the longest row. Like `termCount`, it's kept up to date as rows change, so reading it is cheap
+ * enough to do after every change.
+ */
+@property (nonatomic, assign, readonly) NSUInteger maximumRowLength;
+
+// ===== PIVOT RULE ====================================================================================================
+#pragma mark - Pivot Rule
+
+/**
+ * The pivot rule used by `tableauByMinimizingExpression:objectiveVariableName:`. Defaults to `VPLPivotRuleDantzig`, and
+ * is carried over to derived tableaux.
+ */
+@property (nonatomic, assign, readonly) VPLPivotRule pivotRule;
+
+/**
+ * The number of pivots performed to arrive at this tableau, including those performed on the tableaux it was derived
+ * from.
+ */
+@property (nonatomic, assign, readonly) NSUInteger pivotCount;
+
 // ===== ADDING ROWS ===================================================================================================
 #pragma mark - Adding Rows
 
@@ -73,3 +155,70 @@
                              columnVariable:(NSString *)columnVariable;
 
 @end
+
+/**
+ * A tableau that is modified in place. Each operation updates the column index incrementally, so its cost is
+ * proportional to the number of rows that contain the affected columns.
+ */
+@interface VPLMutableTableau : VPLTableau
+
+@property (nonatomic, assign) VPLPivotRule pivotRule;
+
+// ===== ROWS ==========================================================================================================
+#pragma mark - Rows
+
+- (void)setExpression:(VPLLinearExpression *)expression
+     forRowVariableID:(VPLVariableID)rowVariableID;
+
+- (void)removeRowVariableID:(VPLVariableID)rowVariableID;
+
+/**
+ * Adds `constantValue` to the row's constant. The row's terms are unchanged, so the column index isn't touched.
+ */
+- (void)addConstant:(CGFloat)constantValue
+    toRowVariableID:(VPLVariableID)rowVariableID;
+
+// ===== COLUMNS =======================================================================================================
+#pragma mark - Columns
+
+/**
+ * Replaces the column variable with `expression` in every row that contains it.
+ */
+- (void)substituteExpression:(VPLLinearExpression *)expression
+         forColumnVariableID:(VPLVariableID)columnVariableID;
+
+- (void)removeColumnVariableID:(VPLVariableID)columnVariableID;
+
+// ===== OPTIMIZATION ==================================================================================================
+#pragma mark - Optimization
+
+/**
+ * Adds the row `objectiveVariableID = expression` and optimizes it. See `-optimizeObjectiveVariableID:`.
+ */
+- (void)minimizeExpression:(VPLLinearExpression *)expression
+       objectiveVariableID:(VPLVariableID)objectiveVariableID;
+
+/**
+ * Pivots the tableau until the objective row can no longer be decreased. Raises `VPLTableauIsUnboundedException` if
+ * the objective is unbounded.
+ */
+- (void)optimizeObjectiveVariableID:(VPLVariableID)objectiveVariableID;
+
+// ===== PIVOTING ======================================================================================================
+#pragma mark - Pivoting
+
+- (void)pivotRowVariableID:(VPLVariableID)rowVariableID
+          columnVariableID:(VPLVariableID)columnVariableID;
+
+// ===== CHANGED ROWS ==================================================================================================
+#pragma mark - Changed Rows
+
+/**
+ * The ids of the rows that have been added, removed or modified since the last `-resetChangedRowVariableIDs`. A
+ * variable's value can only change if its row does, so this bounds the work needed to apply a new solution.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet * changedRowVariableIDs;
+
+- (void)resetChangedRowVariableIDs;
+
+@end
@@ -4,20 +4,63 @@
 
 #import "VPLTableau.h"
 #import "VPLLinearExpression.h"
+#import "VPLVariableMap.h"
+#import "VPLInstrumentation.h"
 
-static int64_t
-VPLTableauGenerateVariableNumber()
-{
-  static int64_t variableCount = 0;
-  return OSAtomicIncrement64Barrier(&variableCount);
-}
+/**
+ * The number of consecutive degenerate pivots (those that leave the objective unchanged) after which optimization falls
+ * back to Bland's rule, which can't cycle.
+ */
+static const NSUInteger VPLTableauDegeneratePivotLimit = 8;
 
-BOOL
-VPLTableauIsVariablePivotable(NSString * variableName)
+@interface VPLTableau ()
 {
-  return [variableName hasPrefix:VPLLinearExpressionSlackVariablePrefix];
+  @protected
+  VPLMutableVariableMap * _rows;          // row variable id => row expression
+  VPLMutableVariableMap * _columns;       // column variable id => map whose keys are the rows containing it
+  NSUInteger _termCount;
+  NSUInteger * _rowLengthCounts;          // row length => number of rows of that length
+  NSUInteger _rowLengthCapacity;
+  NSUInteger _maximumRowLength;
+
+  VPLPivotRule _pivotRule;
+  NSUInteger _pivotCount;
+
+  NSMutableIndexSet * _changedRowVariableIDs;  // only tracked by mutable tableaux
 }
 
+- (id)initWithTableau:(VPLTableau *)tableau;
+
+@end
+
+/**
+ * The in-place operations behind both `VPLMutableTableau` and the copying `tableauBy...` methods of `VPLTableau`.
+ */
+@interface VPLTableau (Mutation)
+
+- (void)setExpression:(VPLLinearExpression *)expression
+     forRowVariableID:(VPLVariableID)rowVariableID;
+
+- (void)removeRowVariableID:(VPLVariableID)rowVariableID;
+
+- (void)addConstant:(CGFloat)constantValue
+    toRowVariableID:(VPLVariableID)rowVariableID;
+
+- (void)substituteExpression:(VPLLinearExpression *)expression
+         forColumnVariableID:(VPLVariableID)columnVariableID;
+
+- (void)removeColumnVariableID:(VPLVariableID)columnVariableID;
+
+- (void)minimizeExpression:(VPLLinearExpression *)expression
+       objectiveVariableID:(VPLVariableID)objectiveVariableID;
+
+- (void)optimizeObjectiveVariableID:(VPLVariableID)objectiveVariableID;
+
+- (void)pivotRowVariableID:(VPLVariableID)rowVariableID
+          columnVariableID:(VPLVariableID)columnVariableID;
+
+@end
+
 @implementation VPLTableau
 
 // ===== INITIALIZATION ================================================================================================
@@ -25,19 +68,60 @@ VPLTableauIsVariablePivotable(NSString * variableName)
 
 - (id)init
 {
-  return [self initWithEquations:@{}];
+  self = [super init];
+  if (self != nil)
+  {
+    _rows = [[VPLMutableVariableMap alloc] init];
+    _columns = [[VPLMutableVariableMap alloc] init];
+    _pivotRule = VPLPivotRuleDantzig;
+  }
+  return self;
 }
 
 - (id)initWithEquations:(NSDictionary *)equations
+{
+  self = [self init];
+  if (self != nil)
+  {
+    VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+    [equations enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+
+      [self setExpression:obj
+         forRowVariableID:[symbolTable variableIDForName:key]];
+
+    }];
+  }
+  return self;
+}
+
+- (id)initWithTableau:(VPLTableau *)tableau
 {
   self = [super init];
   if (self != nil)
   {
-    _equations = equations;
+    // Both maps share all of their nodes with the tableau's until one side changes them, so this doesn't copy any
+    // rows. The column row sets are immutable maps, which are replaced rather than changed, so sharing them is safe.
+    _rows = [tableau->_rows mutableCopy];
+    _columns = [tableau->_columns mutableCopy];
+    _termCount = tableau->_termCount;
+    _maximumRowLength = tableau->_maximumRowLength;
+    if (tableau->_rowLengthCapacity > 0)
+    {
+      _rowLengthCapacity = tableau->_maximumRowLength + 1;
+      _rowLengthCounts = malloc(_rowLengthCapacity * sizeof(NSUInteger));
+      memcpy(_rowLengthCounts, tableau->_rowLengthCounts, _rowLengthCapacity * sizeof(NSUInteger));
+    }
+    _pivotRule = tableau->_pivotRule;
+    _pivotCount = tableau->_pivotCount;
   }
   return self;
 }
 
+- (void)dealloc
+{
+  free(_rowLengthCounts);
+}
+
 + (instancetype)tableau
 {
   return [[self alloc] init];
@@ -48,32 +132,78 @@ VPLTableauIsVariablePivotable(NSString * variableName)
   return [[self alloc] initWithEquations:equations];
 }
 
+// ===== NSCopying =====================================================================================================
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  return self;
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+  return [[VPLMutableTableau alloc] initWithTableau:self];
+}
+
+// ===== EQUATIONS =====================================================================================================
+#pragma mark - Equations
+
+- (NSDictionary *)equations
+{
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  NSMutableDictionary * equations = [[NSMutableDictionary alloc] initWithCapacity:[_rows count]];
+  [_rows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID variableID, id object, BOOL * stop) {
+    [equations setObject:object
+                  forKey:[symbolTable nameForVariableID:variableID]];
+  }];
+
+  return equations;
+}
+
 // ===== BASIC VARIABLES ===============================================================================================
 #pragma mark - Basic Variables
 
 - (NSArray *)rowVariableNames
 {
-  return [self.equations.allKeys sortedArrayUsingSelector:@selector(compare:)];
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  NSMutableArray * rowVariableNames = [[NSMutableArray alloc] initWithCapacity:[_rows count]];
+  [_rows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID variableID, id object, BOOL * stop) {
+    [rowVariableNames addObject:[symbolTable nameForVariableID:variableID]];
+  }];
+
+  [rowVariableNames sortUsingSelector:@selector(compare:)];
+  return rowVariableNames;
 }
 
 - (VPLLinearExpression *)expressionForRow:(NSString *)basicVariableName
 {
-  return [self.equations objectForKey:basicVariableName];
+  VPLVariableID rowVariableID = [[VPLSymbolTable sharedSymbolTable] existingVariableIDForName:basicVariableName];
+  if (rowVariableID == VPLVariableIDNone) return nil;
+
+  return [self expressionForRowVariableID:rowVariableID];
 }
 
 - (VPLLinearExpression *)expressionByReplacingRowVariablesInExpression:(VPLLinearExpression *)expression
 {
-  for (NSString * rowVariableName in self.rowVariableNames)
+  // Row expressions only ever contain column variables, so substituting one row can't introduce another row variable.
+  // That means a single pass over the original terms is enough.
+  VPLLinearExpression * replacedExpression = expression;
+
+  const VPLTerm * terms = expression.terms;
+  for (NSUInteger termIndex = 0; termIndex < expression.termCount; termIndex++)
   {
-    if ([expression containsVariable:rowVariableName])
+    VPLVariableID variableID = terms[termIndex].variableID;
+    VPLLinearExpression * rowExpression = [_rows objectForVariableID:variableID];
+    if (rowExpression != nil)
     {
-      VPLLinearExpression * rowExpression = [self expressionForRow:rowVariableName];
-      expression = [expression expressionBySubstitutingExpression:rowExpression
-                                                      forVariable:rowVariableName];
+      replacedExpression = [replacedExpression expressionBySubstitutingExpression:rowExpression
+                                                                    forVariableID:variableID];
     }
   }
-  
-  return expression;
+
+  return replacedExpression;
 }
 
 // ===== COLUMN VARIABLES ==============================================================================================
@@ -81,21 +211,100 @@ VPLTableauIsVariablePivotable(NSString * variableName)
 
 - (NSArray *)columnVariableNames
 {
-  NSMutableArray * columnVariables = [[NSMutableArray alloc] init];
-  [self.equations enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    VPLLinearExpression * expr = obj;
-    
-    for (NSString * variableName in expr.variableTerms.allKeys)
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  NSMutableArray * columnVariableNames = [[NSMutableArray alloc] initWithCapacity:[_columns count]];
+  [_columns enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID variableID, id object, BOOL * stop) {
+    [columnVariableNames addObject:[symbolTable nameForVariableID:variableID]];
+  }];
+
+  [columnVariableNames sortUsingSelector:@selector(compare:)];
+  return columnVariableNames;
+}
+
+// ----- VARIABLE IDS --------------------------------------------------------------------------------------------------
+#pragma mark Variable IDs
+
+- (NSUInteger)rowCount
+{
+  return [_rows count];
+}
+
+- (NSUInteger)columnCount
+{
+  return [_columns count];
+}
+
+- (NSIndexSet *)rowVariableIDs
+{
+  return [_rows variableIDs];
+}
+
+- (VPLLinearExpression *)expressionForRowVariableID:(VPLVariableID)rowVariableID
+{
+  return [_rows objectForVariableID:rowVariableID];
+}
+
+- (BOOL)containsRowVariableID:(VPLVariableID)rowVariableID
+{
+  return [_rows containsVariableID:rowVariableID];
+}
+
+- (BOOL)containsColumnVariableID:(VPLVariableID)columnVariableID
+{
+  return [_columns containsVariableID:columnVariableID];
+}
+
+- (NSIndexSet *)rowVariableIDsForColumnVariableID:(VPLVariableID)columnVariableID
+{
+  return [[_columns objectForVariableID:columnVariableID] variableIDs];
+}
+
+// ----- FILL-IN -------------------------------------------------------------------------------------------------------
+#pragma mark Fill-in
+
+- (NSUInteger)termCount
+{
+  return _termCount;
+}
+
+- (NSUInteger)maximumRowLength
+{
+  return _maximumRowLength;
+}
+
+/**
+ * Counts the rows of each length, so that the longest can be kept up to date as rows change, without walking them. When
+ * the last of the longest rows gets shorter, the next longest length is found by walking down the counts; every step
+ * down pays back a step the maximum took up earlier.
+ */
+- (void)updateRowLengthCountsByRemovingLength:(NSUInteger)currentLength
+                                 addingLength:(NSUInteger)updatedLength
+                                hasCurrentRow:(BOOL)hasCurrentRow
+                                hasUpdatedRow:(BOOL)hasUpdatedRow
+{
+  if (hasUpdatedRow)
+  {
+    if (updatedLength >= _rowLengthCapacity)
     {
-      if ([columnVariables containsObject:variableName] == NO)
-      {
-        [columnVariables addObject:variableName];
-      }
+      NSUInteger capacity = MAX(updatedLength + 1, _rowLengthCapacity * 2);
+      _rowLengthCounts = realloc(_rowLengthCounts, capacity * sizeof(NSUInteger));
+      memset(_rowLengthCounts + _rowLengthCapacity, 0, (capacity - _rowLengthCapacity) * sizeof(NSUInteger));
+      _rowLengthCapacity = capacity;
     }
-  }];
-  
-  [columnVariables sortUsingSelector:@selector(compare:)];
-  return columnVariables;
+
+    _rowLengthCounts[updatedLength]++;
+    _maximumRowLength = MAX(_maximumRowLength, updatedLength);
+  }
+
+  if (hasCurrentRow)
+  {
+    _rowLengthCounts[currentLength]--;
+    while (_maximumRowLength > 0 && _rowLengthCounts[_maximumRowLength] == 0)
+    {
+      _maximumRowLength--;
+    }
+  }
 }
 
 // ===== ADDING ROWS ===================================================================================================
@@ -104,30 +313,21 @@ VPLTableauIsVariablePivotable(NSString * variableName)
 - (VPLTableau *)tableauBySettingExpression:(VPLLinearExpression *)expression
                            forRowVariable:(NSString *)variableName
 {
-  NSMutableDictionary * equations = [[NSMutableDictionary alloc] initWithDictionary:self.equations];
-  [equations setObject:expression
-                forKey:variableName];
-  
-  return [[[self class] alloc] initWithEquations:equations];
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau setExpression:expression
+        forRowVariableID:[[VPLSymbolTable sharedSymbolTable] variableIDForName:variableName]];
+
+  return tableau;
 }
 
 - (VPLTableau *)tableauBySubstitutingExpression:(VPLLinearExpression *)expression
                              forColumnVariable:(NSString *)columnVariableName
 {
-  // iterate through each row, and substitute the expression
-  NSMutableDictionary * substitutedEquations = [[NSMutableDictionary alloc] initWithCapacity:[self.equations count]];
-  [self.equations enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    
-    VPLLinearExpression * variableExpression = obj;
-    VPLLinearExpression * substitutedExpression =
-      [variableExpression expressionBySubstitutingExpression:expression
-                                                 forVariable:columnVariableName];
-    
-    [substitutedEquations setObject:substitutedExpression
-                             forKey:key];
-  }];
-  
-  return [[[self class] alloc] initWithEquations:substitutedEquations];
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau substituteExpression:expression
+            forColumnVariableID:[[VPLSymbolTable sharedSymbolTable] variableIDForName:columnVariableName]];
+
+  return tableau;
 }
 
 // ===== REMOVING ROWS =================================================================================================
@@ -135,10 +335,10 @@ VPLTableauIsVariablePivotable(NSString * variableName)
 
 - (VPLTableau *)tableauByRemovingExpressionForRow:(NSString *)rowVariable
 {
-  NSMutableDictionary * updatedEquations = [[NSMutableDictionary alloc] initWithDictionary:self.equations];
-  [updatedEquations removeObjectForKey:rowVariable];
-  
-  return [[[self class] alloc] initWithEquations:updatedEquations];
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau removeRowVariableID:[[VPLSymbolTable sharedSymbolTable] variableIDForName:rowVariable]];
+
+  return tableau;
 }
 
 // ===== REMOVING COLUMNS ==============================================================================================
@@ -146,15 +346,10 @@ VPLTableauIsVariablePivotable(NSString * variableName)
 
 - (VPLTableau *)tableauByRemovingColumnVariable:(NSString *)columnVariable
 {
-  NSMutableDictionary * updatedEquations = [[NSMutableDictionary alloc] initWithCapacity:[self.equations count]];
-  [self.equations enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    
-    VPLLinearExpression * expr = obj;
-    updatedEquations[key] = [expr expressionByRemovingVariableTerm:columnVariable];
-    
-  }];
-  
-  return [[[self class] alloc] initWithEquations:updatedEquations];
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau removeColumnVariableID:[[VPLSymbolTable sharedSymbolTable] variableIDForName:columnVariable]];
+
+  return tableau;
 }
 
 // ===== OPTIMIZATION ==================================================================================================
@@ -168,68 +363,261 @@ VPLTableauIsVariablePivotable(NSString * variableName)
            NSStringFromClass([self class]),
            NSStringFromSelector(_cmd),
            objectiveVar);
-  
-  // look for a pivotable term whose coefficient is >= 0
-  VPLTableau * tableau = [self tableauBySettingExpression:linearExpression
-                                          forRowVariable:objectiveVar];
-  
-  while (YES)
+
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau minimizeExpression:linearExpression
+          objectiveVariableID:[[VPLSymbolTable sharedSymbolTable] variableIDForName:objectiveVar]];
+
+  return tableau;
+}
+
+// ===== PIVOTING ======================================================================================================
+#pragma mark - Pivoting
+
+- (VPLTableau *)tableauByPivotingRowVariable:(NSString *)rowVariable
+                             columnVariable:(NSString *)columnVariable
+{
+  VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+
+  VPLTableau * tableau = [[VPLTableau alloc] initWithTableau:self];
+  [tableau pivotRowVariableID:[symbolTable variableIDForName:rowVariable]
+             columnVariableID:[symbolTable variableIDForName:columnVariable]];
+
+  return tableau;
+}
+
+@end
+
+@implementation VPLTableau (Mutation)
+
+// ===== COLUMN INDEX ==================================================================================================
+#pragma mark - Column Index
+
+/**
+ * Replaces a row's expression, updating the column index for only those columns that appear in one expression but not
+ * the other. Either expression may be nil, to add or remove the row.
+ */
+- (void)replaceExpression:(VPLLinearExpression *)currentExpression
+           withExpression:(VPLLinearExpression *)updatedExpression
+         forRowVariableID:(VPLVariableID)rowVariableID
+{
+  const VPLTerm * currentTerms = currentExpression.terms;
+  NSUInteger currentTermCount = currentExpression.termCount;
+  const VPLTerm * updatedTerms = updatedExpression.terms;
+  NSUInteger updatedTermCount = updatedExpression.termCount;
+
+  NSUInteger currentTermIndex = 0;
+  NSUInteger updatedTermIndex = 0;
+  NSUInteger addedColumnCount = 0;
+  while (currentTermIndex < currentTermCount || updatedTermIndex < updatedTermCount)
   {
-    VPLLinearExpression * objectiveExpr = [tableau expressionForRow:objectiveVar];
-    
-    // Phase 1: Pick an entry variable with a negative coefficient. If none exist, then the solution is optimal. We
-    // sort the terms to ensure consistent ordering, and to avoid cycles (Bland’s anti-cycling rule).
-    CGFloat objectiveCoefficient = 0.0;
-    NSString * entryVariableName = nil;
-    for (NSString * parametricVar in [objectiveExpr.variableTerms.allKeys sortedArrayUsingSelector:@selector(compare:)])
+    if (updatedTermIndex >= updatedTermCount
+        || (currentTermIndex < currentTermCount
+            && currentTerms[currentTermIndex].variableID < updatedTerms[updatedTermIndex].variableID))
     {
-      if (VPLTableauIsVariablePivotable(parametricVar))
+      // the column was removed from this row
+      VPLVariableID columnVariableID = currentTerms[currentTermIndex].variableID;
+      VPLVariableMap * columnRows = [[_columns objectForVariableID:columnVariableID]
+                                     mapByRemovingObjectForVariableID:rowVariableID];
+      if ([columnRows count] == 0)
       {
-        CGFloat coeff = [objectiveExpr coefficientForVariable:parametricVar];
-        if (coeff < 0.0)
-        {
-          objectiveCoefficient = coeff;
-          entryVariableName = parametricVar;
-          break;
-        }
+        [_columns removeObjectForVariableID:columnVariableID];
+      }
+      else
+      {
+        [_columns setObject:columnRows
+              forVariableID:columnVariableID];
       }
+
+      currentTermIndex++;
     }
-    
+    else if (currentTermIndex >= currentTermCount
+             || updatedTerms[updatedTermIndex].variableID < currentTerms[currentTermIndex].variableID)
+    {
+      // the column was added to this row
+      VPLVariableID columnVariableID = updatedTerms[updatedTermIndex].variableID;
+      VPLVariableMap * columnRows = [_columns objectForVariableID:columnVariableID] ?: [VPLVariableMap map];
+      [_columns setObject:[columnRows mapBySettingObject:[NSNull null]
+                                           forVariableID:rowVariableID]
+            forVariableID:columnVariableID];
+
+      addedColumnCount++;
+      updatedTermIndex++;
+    }
+    else
+    {
+      // the column is in both, so the index doesn't change
+      currentTermIndex++;
+      updatedTermIndex++;
+    }
+  }
+
+  [_changedRowVariableIDs addIndex:rowVariableID];
+  _termCount = _termCount + updatedTermCount - currentTermCount;
+  [self updateRowLengthCountsByRemovingLength:currentTermCount
+                                 addingLength:updatedTermCount
+                                hasCurrentRow:(currentExpression != nil)
+                                hasUpdatedRow:(updatedExpression != nil)];
+  VPLInstrumentationCount(VPLInstrumentationCounterRowsTouched, 1);
+
+  // columns that appear in an existing row are fill-in, which pruning cancelled terms keeps down
+  if (currentExpression != nil && addedColumnCount > 0)
+  {
+    VPLInstrumentationCount(VPLInstrumentationCounterFillInTerms, addedColumnCount);
+  }
+
+  if (updatedExpression != nil)
+  {
+    [_rows setObject:updatedExpression
+       forVariableID:rowVariableID];
+  }
+  else
+  {
+    [_rows removeObjectForVariableID:rowVariableID];
+  }
+}
+
+// ===== ROWS ==========================================================================================================
+#pragma mark - Rows
+
+- (void)setExpression:(VPLLinearExpression *)expression
+     forRowVariableID:(VPLVariableID)rowVariableID
+{
+  NSAssert(expression != nil,
+           @"[%@ %@] Attempt to set a nil expression for a row",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+
+  [self replaceExpression:[_rows objectForVariableID:rowVariableID]
+           withExpression:expression
+         forRowVariableID:rowVariableID];
+}
+
+- (void)removeRowVariableID:(VPLVariableID)rowVariableID
+{
+  VPLLinearExpression * expression = [_rows objectForVariableID:rowVariableID];
+  if (expression == nil) return;
+
+  [self replaceExpression:expression
+           withExpression:nil
+         forRowVariableID:rowVariableID];
+}
+
+- (void)addConstant:(CGFloat)constantValue
+    toRowVariableID:(VPLVariableID)rowVariableID
+{
+  VPLLinearExpression * expression = [_rows objectForVariableID:rowVariableID];
+  if (expression == nil) return;
+
+  [_rows setObject:[expression expressionByAddingConstant:constantValue]
+     forVariableID:rowVariableID];
+  [_changedRowVariableIDs addIndex:rowVariableID];
+}
+
+// ===== COLUMNS =======================================================================================================
+#pragma mark - Columns
+
+- (void)substituteExpression:(VPLLinearExpression *)expression
+         forColumnVariableID:(VPLVariableID)columnVariableID
+{
+  // the column's row set is replaced rather than changed as we go, so the one we start with can be walked as it is
+  VPLVariableMap * columnRows = [_columns objectForVariableID:columnVariableID];
+  [columnRows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID rowVariableID, id object, BOOL * stop) {
+
+    VPLLinearExpression * rowExpression = [_rows objectForVariableID:rowVariableID];
+    VPLInstrumentationCount(VPLInstrumentationCounterSubstitutions, 1);
+
+    [self replaceExpression:rowExpression
+             withExpression:[rowExpression expressionBySubstitutingExpression:expression
+                                                               forVariableID:columnVariableID]
+           forRowVariableID:rowVariableID];
+
+  }];
+}
+
+- (void)removeColumnVariableID:(VPLVariableID)columnVariableID
+{
+  VPLVariableMap * columnRows = [_columns objectForVariableID:columnVariableID];
+  [columnRows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID rowVariableID, id object, BOOL * stop) {
+
+    VPLLinearExpression * rowExpression = [_rows objectForVariableID:rowVariableID];
+
+    [self replaceExpression:rowExpression
+             withExpression:[rowExpression expressionByRemovingVariableID:columnVariableID]
+           forRowVariableID:rowVariableID];
+
+  }];
+}
+
+// ===== OPTIMIZATION ==================================================================================================
+#pragma mark - Optimization
+
+- (void)minimizeExpression:(VPLLinearExpression *)expression
+       objectiveVariableID:(VPLVariableID)objectiveVariableID
+{
+  [self setExpression:expression
+     forRowVariableID:objectiveVariableID];
+
+  [self optimizeObjectiveVariableID:objectiveVariableID];
+}
+
+- (void)optimizeObjectiveVariableID:(VPLVariableID)objectiveVariableID
+{
+  NSAssert(VPLVariableIDIsObjective(objectiveVariableID),
+           @"[%@ %@] objective variable (%@) must be an objective variable",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd),
+           [[VPLSymbolTable sharedSymbolTable] nameForVariableID:objectiveVariableID]);
+
+  NSUInteger degeneratePivotCount = 0;
+  while (YES)
+  {
+    VPLLinearExpression * objectiveExpr = [_rows objectForVariableID:objectiveVariableID];
+
+    // Phase 1: Pick an entry variable with a negative coefficient. If none exist, then the solution is optimal. After a
+    // run of degenerate pivots we may be cycling, so fall back to Bland's rule until the objective improves again.
+    VPLPivotRule pivotRule = (degeneratePivotCount < VPLTableauDegeneratePivotLimit ? _pivotRule : VPLPivotRuleBland);
+    VPLVariableID entryVariableID = [self entryVariableIDForObjectiveExpression:objectiveExpr
+                                                                      pivotRule:pivotRule];
+
     // no entry variable, so we're optimal.
-    if (entryVariableName == nil) break;
-    
-    
+    if (entryVariableID == VPLVariableIDNone) break;
+
+
     // PHASE 2: Pick a pivot row (exit variable row), which will become parametric. We choose a row that contains the
     // entry variable, and has the minimum ratio of (-(rowConstant) / entryCoeff)), as the simplex algorithm describes.
-    // This ensures we maintain a feasible system.
-    NSString * exitVariableName = nil;
-    CGFloat minRatio = CGFLOAT_MAX;
-    for (NSString * rowVariable in tableau.rowVariableNames)
-    {
-      if (VPLTableauIsVariablePivotable(rowVariable))
+    // This ensures we maintain a feasible system. Only the rows in the entry variable's column can qualify. Rows
+    // aren't visited in id order, so ties are explicitly given to the lowest id, as Bland's rule requires.
+    __block VPLVariableID exitVariableID = VPLVariableIDNone;
+    __block CGFloat minRatio = CGFLOAT_MAX;
+    VPLVariableMap * columnRows = [_columns objectForVariableID:entryVariableID];
+    [columnRows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID rowVariableID, id object, BOOL * stop) {
+
+      if (VPLVariableIDIsPivotable(rowVariableID))
       {
-        VPLLinearExpression * expr = [tableau expressionForRow:rowVariable];
-        if ([expr containsVariable:entryVariableName])
+        VPLLinearExpression * expr = [_rows objectForVariableID:rowVariableID];
+        CGFloat entryCoeff = [expr coefficientForVariableID:entryVariableID];
+        if (entryCoeff < -VPLLinearExpressionEpsilon())
         {
-          CGFloat entryCoeff = [expr coefficientForVariable:entryVariableName];
-          if (entryCoeff < 0.0)
+          CGFloat ratio = - expr.constantValue / entryCoeff;
+          if (ratio < minRatio || (ratio == minRatio && rowVariableID < exitVariableID))
           {
-            CGFloat ratio = - expr.constantValue / entryCoeff;
-            if (ratio < minRatio)
-            {
-              minRatio = ratio;
-              exitVariableName = rowVariable;
-            }
+            minRatio = ratio;
+            exitVariableID = rowVariableID;
           }
         }
       }
-    }
-    
-    if (exitVariableName != nil)
+
+    }];
+
+    if (exitVariableID != VPLVariableIDNone)
     {
+      // a zero ratio leaves the objective where it is
+      degeneratePivotCount = (VPLLinearExpressionIsApproximatelyZero(minRatio) ? degeneratePivotCount + 1 : 0);
+
       // PIVOT
-      tableau = [tableau tableauByPivotingRowVariable:exitVariableName
-                                       columnVariable:entryVariableName];
+      [self pivotRowVariableID:exitVariableID
+              columnVariableID:entryVariableID];
     }
     else
     {
@@ -238,31 +626,157 @@ VPLTableauIsVariablePivotable(NSString * variableName)
                   format:@"Tableau is unbounded!"];
     }
   }
-  
-  return tableau;
 }
 
-- (VPLTableau *)tableauByPivotingRowVariable:(NSString *)rowVariable
-                             columnVariable:(NSString *)columnVariable
+/**
+ * Returns the pivotable variable with a negative coefficient in the objective that `pivotRule` prefers, or
+ * `VPLVariableIDNone` if the objective is optimal.
+ */
+- (VPLVariableID)entryVariableIDForObjectiveExpression:(VPLLinearExpression *)objectiveExpr
+                                             pivotRule:(VPLPivotRule)pivotRule
 {
-  VPLLinearExpression * rowExpression = [self expressionForRow:rowVariable];
-  NSAssert([rowExpression containsVariable:columnVariable],
+  VPLVariableID entryVariableID = VPLVariableIDNone;
+  CGFloat bestScore = 0.0;
+
+  const VPLTerm * objectiveTerms = objectiveExpr.terms;
+  for (NSUInteger termIndex = 0; termIndex < objectiveExpr.termCount; termIndex++)
+  {
+    VPLVariableID variableID = objectiveTerms[termIndex].variableID;
+    CGFloat coeff = objectiveTerms[termIndex].coefficient;
+    if (coeff >= -VPLLinearExpressionEpsilon() || !VPLVariableIDIsPivotable(variableID)) continue;
+
+    CGFloat score;
+    switch (pivotRule)
+    {
+      case VPLPivotRuleBland:
+        // Terms are kept sorted by variable id, so the first one gives a consistent ordering and avoids cycles.
+        return variableID;
+
+      case VPLPivotRuleDantzig:
+        score = coeff;
+        break;
+
+      case VPLPivotRuleSteepestEdge:
+        // the objective's rate of change per unit distance moved along the edge, rather than per unit of the variable
+        score = coeff / sqrt([self squaredNormOfColumnVariableID:variableID]);
+        break;
+    }
+
+    // strictly less, so ties go to the lowest id
+    if (score < bestScore)
+    {
+      bestScore = score;
+      entryVariableID = variableID;
+    }
+  }
+
+  return entryVariableID;
+}
+
+/**
+ * The squared length of the edge that increasing a column variable moves along: one for the variable itself, plus the
+ * squares of its coefficients in the constraint rows. Objective rows aren't part of the edge.
+ */
+- (CGFloat)squaredNormOfColumnVariableID:(VPLVariableID)columnVariableID
+{
+  __block CGFloat squaredNorm = 1.0;
+  VPLVariableMap * columnRows = [_columns objectForVariableID:columnVariableID];
+  [columnRows enumerateVariableIDsAndObjectsUsingBlock:^(VPLVariableID rowVariableID, id object, BOOL * stop) {
+
+    if (!VPLVariableIDIsObjective(rowVariableID))
+    {
+      CGFloat coeff = [[_rows objectForVariableID:rowVariableID] coefficientForVariableID:columnVariableID];
+      squaredNorm += coeff * coeff;
+    }
+
+  }];
+
+  return squaredNorm;
+}
+
+// ===== PIVOTING ======================================================================================================
+#pragma mark - Pivoting
+
+- (void)pivotRowVariableID:(VPLVariableID)rowVariableID
+          columnVariableID:(VPLVariableID)columnVariableID
+{
+  VPLLinearExpression * rowExpression = [_rows objectForVariableID:rowVariableID];
+  NSAssert([rowExpression containsVariableID:columnVariableID],
            @"Expected expression for row (%@ = %@) to contain %@",
-           rowVariable,
+           [[VPLSymbolTable sharedSymbolTable] nameForVariableID:rowVariableID],
            rowExpression,
-           columnVariable);
-  
+           [[VPLSymbolTable sharedSymbolTable] nameForVariableID:columnVariableID]);
+
   // change its subject (rowV = c + ... + colV) => colV = c1 + ... + rowV)
-  VPLLinearExpression * colExpr = [rowExpression expressionByChangingSubjectFromVariable:rowVariable
-                                                                             toVariable:columnVariable];
-  
-  // remove the row expression (row = expr)
-  VPLTableau * tableau = [self tableauByRemovingExpressionForRow:rowVariable];
-  tableau = [tableau tableauBySubstitutingExpression:colExpr
-                                   forColumnVariable:columnVariable];
-  
-  return [tableau tableauBySettingExpression:colExpr
-                              forRowVariable:columnVariable];
+  VPLLinearExpression * colExpr = [rowExpression expressionByChangingSubjectFromVariableID:rowVariableID
+                                                                              toVariableID:columnVariableID];
+
+  // remove the row expression (row = expr), substitute colExpr into only those rows that contain the column, and add
+  // the column's new row.
+  [self removeRowVariableID:rowVariableID];
+  [self substituteExpression:colExpr
+         forColumnVariableID:columnVariableID];
+  [self setExpression:colExpr
+     forRowVariableID:columnVariableID];
+
+  _pivotCount++;
+  VPLInstrumentationCount(VPLInstrumentationCounterPivots, 1);
+}
+
+@end
+
+@implementation VPLMutableTableau
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (id)init
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _changedRowVariableIDs = [[NSMutableIndexSet alloc] init];
+  }
+  return self;
+}
+
+- (id)initWithTableau:(VPLTableau *)tableau
+{
+  self = [super initWithTableau:tableau];
+  if (self != nil)
+  {
+    _changedRowVariableIDs = [[NSMutableIndexSet alloc] init];
+  }
+  return self;
+}
+
+// ===== PIVOT RULE ====================================================================================================
+#pragma mark - Pivot Rule
+
+- (void)setPivotRule:(VPLPivotRule)pivotRule
+{
+  _pivotRule = pivotRule;
+}
+
+// ===== CHANGED ROWS ==================================================================================================
+#pragma mark - Changed Rows
+
+- (NSIndexSet *)changedRowVariableIDs
+{
+  return [_changedRowVariableIDs copy];
+}
+
+- (void)resetChangedRowVariableIDs
+{
+  [_changedRowVariableIDs removeAllIndexes];
+}
+
+// ===== NSCopying =====================================================================================================
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  return [[VPLTableau alloc] initWithTableau:self];
 }
 
 @end
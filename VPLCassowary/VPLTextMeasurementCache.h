@@ -0,0 +1,68 @@
+#import "VPLCassowaryTypes.h"
+
+/**
+ * Measures text for layers' intrinsic sizes, and remembers the results. Labels repeat heavily across a library, often
+ * with the same text and font in many representations, so measurements are shared by every layer in the process
+ * rather than kept by each layer.
+ *
+ * Measurements are keyed by their text, font and size constraint, and the least recently used are discarded once the
+ * cache holds more than its limit. Fonts are cached too, since creating one is much slower than looking it up.
+ *
+ * A cache is safe to use from several threads at once.
+ */
+@interface VPLTextMeasurementCache : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit;
+
+/**
+ * The cache used by `VPLLayer`, which is created on first use.
+ */
++ (VPLTextMeasurementCache *)sharedTextMeasurementCache;
+
+// ===== FONTS =========================================================================================================
+#pragma mark - Fonts
+
+/**
+ * Returns the font with a name and size, creating it only the first time it's asked for. The font lives as long as the
+ * cache does.
+ */
+- (CTFontRef)fontWithName:(NSString *)fontName
+                     size:(CGFloat)fontSize;
+
+/**
+ * Returns attributes for an attributed string in the font, which live as long as the cache does.
+ */
+- (CFDictionaryRef)textAttributesWithFontName:(NSString *)fontName
+                                         size:(CGFloat)fontSize;
+
+// ===== MEASUREMENTS ==================================================================================================
+#pragma mark - Measurements
+
+/**
+ * The maximum number of measurements kept. Defaults to 10000.
+ */
+@property (nonatomic, assign, readonly) NSUInteger countLimit;
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/**
+ * Returns the size `CTFramesetterSuggestFrameSizeWithConstraints` suggests for the whole of `text` in the font, within
+ * `constraints`; pass `CGFLOAT_MAX` for an unconstrained dimension.
+ */
+- (CGSize)sizeOfText:(NSString *)text
+            fontName:(NSString *)fontName
+            fontSize:(CGFloat)fontSize
+         constraints:(CGSize)constraints;
+
+- (void)removeAllMeasurements;
+
+// ----- STATISTICS ----------------------------------------------------------------------------------------------------
+#pragma mark Statistics
+
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+@end
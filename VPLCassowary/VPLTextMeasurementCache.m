@@ -0,0 +1,252 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLTextMeasurementCache.h"
+#import "VPLInstrumentation.h"
+
+static const NSUInteger VPLTextMeasurementCacheDefaultCountLimit = 10000;
+
+// ===== MEASUREMENT KEY ===============================================================================================
+#pragma mark - Measurement Key
+
+@interface VPLTextMeasurementKey : NSObject <NSCopying>
+
+@property (nonatomic, copy,   readonly) NSString * text;
+@property (nonatomic, copy,   readonly) NSString * fontName;
+@property (nonatomic, assign, readonly) CGFloat fontSize;
+@property (nonatomic, assign, readonly) CGSize constraints;
+
+@end
+
+@implementation VPLTextMeasurementKey
+{
+  NSUInteger _hash;
+}
+
+- (instancetype)initWithText:(NSString *)text
+                    fontName:(NSString *)fontName
+                    fontSize:(CGFloat)fontSize
+                 constraints:(CGSize)constraints
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _text = [text copy];
+    _fontName = [fontName copy];
+    _fontSize = fontSize;
+    _constraints = constraints;
+
+    // the text is by far the most varied part of the key, so it does most of the hashing
+    _hash = [_text hash] ^ ([_fontName hash] * 31) ^ (NSUInteger)(_fontSize * 1000.0);
+  }
+  return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  return self;
+}
+
+- (NSUInteger)hash
+{
+  return _hash;
+}
+
+- (BOOL)isEqual:(id)object
+{
+  if (object == self) return YES;
+  if (![object isKindOfClass:[VPLTextMeasurementKey class]]) return NO;
+
+  VPLTextMeasurementKey * key = object;
+  return (_hash == key->_hash
+          && _fontSize == key.fontSize
+          && CGSizeEqualToSize(_constraints, key.constraints)
+          && [_fontName isEqualToString:key.fontName]
+          && [_text isEqualToString:key.text]);
+}
+
+@end
+
+// ===== TEXT MEASUREMENT CACHE ========================================================================================
+#pragma mark - Text Measurement Cache
+
+@interface VPLTextMeasurementCache ()
+
+// fonts and text attributes are keyed by their font name and size, and are never evicted
+@property (nonatomic, strong, readonly) NSMutableDictionary * fontsByKey;
+@property (nonatomic, strong, readonly) NSMutableDictionary * textAttributesByKey;
+
+@property (nonatomic, strong, readonly) NSMutableDictionary * sizesByKey;
+
+// least recently used first
+@property (nonatomic, strong, readonly) NSMutableOrderedSet * recentKeys;
+
+@property (nonatomic, assign, readwrite) NSUInteger hitCount;
+@property (nonatomic, assign, readwrite) NSUInteger missCount;
+
+@end
+
+@implementation VPLTextMeasurementCache
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+  return [self initWithCountLimit:VPLTextMeasurementCacheDefaultCountLimit];
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _countLimit = countLimit;
+    _fontsByKey = [[NSMutableDictionary alloc] init];
+    _textAttributesByKey = [[NSMutableDictionary alloc] init];
+    _sizesByKey = [[NSMutableDictionary alloc] init];
+    _recentKeys = [[NSMutableOrderedSet alloc] init];
+  }
+  return self;
+}
+
++ (VPLTextMeasurementCache *)sharedTextMeasurementCache
+{
+  static VPLTextMeasurementCache * sharedTextMeasurementCache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedTextMeasurementCache = [[VPLTextMeasurementCache alloc] init];
+  });
+  return sharedTextMeasurementCache;
+}
+
+// ===== FONTS =========================================================================================================
+#pragma mark - Fonts
+
+static NSString *
+VPLTextMeasurementFontKey(NSString * fontName, CGFloat fontSize)
+{
+  return [NSString stringWithFormat:@"%@ %a", fontName, (double)fontSize];
+}
+
+- (CTFontRef)fontWithName:(NSString *)fontName
+                     size:(CGFloat)fontSize
+{
+  NSString * fontKey = VPLTextMeasurementFontKey(fontName, fontSize);
+
+  @synchronized (self)
+  {
+    id font = [self.fontsByKey objectForKey:fontKey];
+    if (font == nil)
+    {
+      font = CFBridgingRelease(CTFontCreateWithName((__bridge CFStringRef)fontName, fontSize, NULL));
+      [self.fontsByKey setObject:font
+                          forKey:fontKey];
+    }
+    return (__bridge CTFontRef)font;
+  }
+}
+
+- (CFDictionaryRef)textAttributesWithFontName:(NSString *)fontName
+                                         size:(CGFloat)fontSize
+{
+  NSString * fontKey = VPLTextMeasurementFontKey(fontName, fontSize);
+
+  @synchronized (self)
+  {
+    NSDictionary * textAttributes = [self.textAttributesByKey objectForKey:fontKey];
+    if (textAttributes == nil)
+    {
+      id font = (__bridge id)[self fontWithName:fontName
+                                           size:fontSize];
+      textAttributes = @{ (__bridge NSString *)kCTFontAttributeName : font };
+      [self.textAttributesByKey setObject:textAttributes
+                                   forKey:fontKey];
+    }
+    return (__bridge CFDictionaryRef)textAttributes;
+  }
+}
+
+// ===== MEASUREMENTS ==================================================================================================
+#pragma mark - Measurements
+
+- (NSUInteger)count
+{
+  @synchronized (self)
+  {
+    return [self.sizesByKey count];
+  }
+}
+
+- (CGSize)sizeOfText:(NSString *)text
+            fontName:(NSString *)fontName
+            fontSize:(CGFloat)fontSize
+         constraints:(CGSize)constraints
+{
+  VPLTextMeasurementKey * key = [[VPLTextMeasurementKey alloc] initWithText:text
+                                                                   fontName:fontName
+                                                                   fontSize:fontSize
+                                                                constraints:constraints];
+
+  @synchronized (self)
+  {
+    NSValue * sizeValue = [self.sizesByKey objectForKey:key];
+    if (sizeValue != nil)
+    {
+      [self.recentKeys removeObject:key];
+      [self.recentKeys addObject:key];
+
+      self.hitCount++;
+      VPLInstrumentationCount(VPLInstrumentationCounterTextMeasurementHits, 1);
+      return [sizeValue sizeValue];
+    }
+
+    self.missCount++;
+    VPLInstrumentationCount(VPLInstrumentationCounterTextMeasurementMisses, 1);
+  }
+
+  // the text is measured outside the lock, so that other threads can keep measuring; if two threads measure the same
+  // text at once, they come up with the same size
+  CFAttributedStringRef attributedTextRef = CFAttributedStringCreate(NULL,
+                                                                     (__bridge CFStringRef)text,
+                                                                     [self textAttributesWithFontName:fontName
+                                                                                                 size:fontSize]);
+  CTFramesetterRef framesetterRef = CTFramesetterCreateWithAttributedString(attributedTextRef);
+  CGSize size = CTFramesetterSuggestFrameSizeWithConstraints(framesetterRef,
+                                                             CFRangeMake(0, 0), // the whole string
+                                                             NULL,
+                                                             constraints,
+                                                             NULL);
+  CFRelease(framesetterRef);
+  CFRelease(attributedTextRef);
+
+  @synchronized (self)
+  {
+    if ([self.sizesByKey objectForKey:key] == nil)
+    {
+      [self.sizesByKey setObject:[NSValue valueWithSize:size]
+                          forKey:key];
+      [self.recentKeys addObject:key];
+
+      while ([self.recentKeys count] > self.countLimit)
+      {
+        [self.sizesByKey removeObjectForKey:[self.recentKeys firstObject]];
+        [self.recentKeys removeObjectAtIndex:0];
+      }
+    }
+  }
+
+  return size;
+}
+
+- (void)removeAllMeasurements
+{
+  @synchronized (self)
+  {
+    [self.sizesByKey removeAllObjects];
+    [self.recentKeys removeAllObjects];
+  }
+}
+
+@end
@@ -0,0 +1,62 @@
+#import "VPLCassowaryTypes.h"
+#import "VPLSymbolTable.h"
+
+/**
+ * A persistent map from variable ids to objects, stored as a hash array mapped trie. Each level of the trie picks one
+ * of 32 slots by the next 5 bits of the variable id, and a slot holds either a single entry or a node for the ids that
+ * share those bits. Ids are unique, so no two of them ever share all their bits and the trie is at most 7 levels deep.
+ *
+ * Maps are never copied, only shared. A map derived from another one copies just the nodes along the path to the entry
+ * that changed, and shares every other node with the original, so copying a map costs O(1) and changing one entry costs
+ * O(log32 n).
+ *
+ * Maps enumerate their entries in trie order rather than id order. `variableIDs` gives the ids in ascending order.
+ */
+@interface VPLVariableMap : NSObject <NSCopying, NSMutableCopying>
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
++ (instancetype)map;
+
+// ===== ENTRIES =======================================================================================================
+#pragma mark - Entries
+
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+- (id)objectForVariableID:(VPLVariableID)variableID;
+
+- (BOOL)containsVariableID:(VPLVariableID)variableID;
+
+/**
+ * The ids of all entries, in ascending order. Unlike `count`, this walks the whole map.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet * variableIDs;
+
+- (void)enumerateVariableIDsAndObjectsUsingBlock:(void (^)(VPLVariableID variableID, id object, BOOL * stop))block;
+
+// ===== DERIVED MAPS ==================================================================================================
+#pragma mark - Derived Maps
+
+- (VPLVariableMap *)mapBySettingObject:(id)object
+                         forVariableID:(VPLVariableID)variableID;
+
+- (VPLVariableMap *)mapByRemovingObjectForVariableID:(VPLVariableID)variableID;
+
+@end
+
+/**
+ * A map that is changed in place. Nodes that only this map can see are updated where they are, rather than copied, so
+ * a run of changes only copies the nodes it shares with other maps, and each of those only once.
+ *
+ * Copying a mutable map, mutably or not, shares all of its nodes with the copy. Both maps then copy a shared node
+ * before their first change to it, so neither sees the other's changes.
+ */
+@interface VPLMutableVariableMap : VPLVariableMap
+
+- (void)setObject:(id)object
+    forVariableID:(VPLVariableID)variableID;
+
+- (void)removeObjectForVariableID:(VPLVariableID)variableID;
+
+@end
@@ -0,0 +1,561 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLVariableMap.h"
+
+static const NSUInteger VPLVariableMapBitsPerLevel = 5;
+
+static inline uint32_t
+VPLVariableMapSlotBit(VPLVariableID variableID, NSUInteger shift)
+{
+  return (uint32_t)1 << ((variableID >> shift) & 0x1f);
+}
+
+/**
+ * The index of a slot among the slots that are set in `bitmap`.
+ */
+static inline NSUInteger
+VPLVariableMapSlotIndex(uint32_t bitmap, uint32_t bit)
+{
+  return (NSUInteger)__builtin_popcount(bitmap & (bit - 1));
+}
+
+// ===== NODES =========================================================================================================
+#pragma mark - Nodes
+
+/**
+ * A node keeps the ids of its entries in slot order, and a single array of its entries' objects followed by its child
+ * nodes, each in slot order. Every node below the root holds at least two entries between it and its descendants.
+ *
+ * A node may only be changed in place by the mutable map that owns it. Nodes without an owner, and nodes whose owner
+ * has since been copied, are shared and never change.
+ */
+@interface VPLVariableMapNode : NSObject
+{
+  @public
+  id _owner;
+  uint32_t _entryMap;
+  uint32_t _nodeMap;
+  VPLVariableID * _variableIDs;
+  CFTypeRef * _slots;
+}
+
+@end
+
+@implementation VPLVariableMapNode
+
+- (void)dealloc
+{
+  NSUInteger slotCount = (NSUInteger)(__builtin_popcount(_entryMap) + __builtin_popcount(_nodeMap));
+  for (NSUInteger slotIndex = 0; slotIndex < slotCount; slotIndex++)
+  {
+    CFRelease(_slots[slotIndex]);
+  }
+
+  free(_variableIDs);
+  free(_slots);
+}
+
+@end
+
+/**
+ * Creates a node with room for the slots in both bitmaps. The caller must fill every slot.
+ */
+static VPLVariableMapNode *
+VPLVariableMapNodeCreate(id owner, uint32_t entryMap, uint32_t nodeMap)
+{
+  NSUInteger entryCount = (NSUInteger)__builtin_popcount(entryMap);
+  NSUInteger nodeCount = (NSUInteger)__builtin_popcount(nodeMap);
+
+  VPLVariableMapNode * node = [[VPLVariableMapNode alloc] init];
+  node->_owner = owner;
+  node->_entryMap = entryMap;
+  node->_nodeMap = nodeMap;
+  node->_variableIDs = malloc(entryCount * sizeof(VPLVariableID));
+  node->_slots = malloc((entryCount + nodeCount) * sizeof(CFTypeRef));
+
+  return node;
+}
+
+/**
+ * Returns a copy of the node with the slot for `bit` holding `object`, either as the entry for `variableID` or, if
+ * `isNode` is YES, as a child node. A nil object leaves the slot empty. Every other slot is shared with the node.
+ */
+static VPLVariableMapNode *
+VPLVariableMapNodeByReplacingSlot(VPLVariableMapNode * node,
+                                  uint32_t bit,
+                                  VPLVariableID variableID,
+                                  id object,
+                                  BOOL isNode,
+                                  id owner)
+{
+  uint32_t entryMap = node->_entryMap & ~bit;
+  uint32_t nodeMap = node->_nodeMap & ~bit;
+  if (object != nil)
+  {
+    if (isNode) nodeMap |= bit;
+    else entryMap |= bit;
+  }
+
+  VPLVariableMapNode * copiedNode = VPLVariableMapNodeCreate(owner, entryMap, nodeMap);
+  NSUInteger entryCount = (NSUInteger)__builtin_popcount(node->_entryMap);
+  NSUInteger slotIndex = 0;
+
+  for (uint32_t remainingMap = entryMap; remainingMap != 0; remainingMap &= remainingMap - 1)
+  {
+    uint32_t slotBit = remainingMap & (0u - remainingMap);
+    if (slotBit == bit)
+    {
+      copiedNode->_variableIDs[slotIndex] = variableID;
+      copiedNode->_slots[slotIndex] = CFBridgingRetain(object);
+    }
+    else
+    {
+      NSUInteger entryIndex = VPLVariableMapSlotIndex(node->_entryMap, slotBit);
+      copiedNode->_variableIDs[slotIndex] = node->_variableIDs[entryIndex];
+      copiedNode->_slots[slotIndex] = CFRetain(node->_slots[entryIndex]);
+    }
+    slotIndex++;
+  }
+
+  for (uint32_t remainingMap = nodeMap; remainingMap != 0; remainingMap &= remainingMap - 1)
+  {
+    uint32_t slotBit = remainingMap & (0u - remainingMap);
+    if (slotBit == bit)
+    {
+      copiedNode->_slots[slotIndex] = CFBridgingRetain(object);
+    }
+    else
+    {
+      NSUInteger childIndex = entryCount + VPLVariableMapSlotIndex(node->_nodeMap, slotBit);
+      copiedNode->_slots[slotIndex] = CFRetain(node->_slots[childIndex]);
+    }
+    slotIndex++;
+  }
+
+  return copiedNode;
+}
+
+/**
+ * Replaces the object in one of the node's slots in place.
+ */
+static void
+VPLVariableMapNodeSetSlot(VPLVariableMapNode * node, NSUInteger slotIndex, id object)
+{
+  CFTypeRef replacedObject = node->_slots[slotIndex];
+  node->_slots[slotIndex] = CFBridgingRetain(object);
+  CFRelease(replacedObject);
+}
+
+/**
+ * Returns a node for two entries whose ids share the slots of every level above `shift`.
+ */
+static VPLVariableMapNode *
+VPLVariableMapNodeWithEntries(VPLVariableID variableID,
+                              id object,
+                              VPLVariableID otherVariableID,
+                              id otherObject,
+                              NSUInteger shift,
+                              id owner)
+{
+  uint32_t bit = VPLVariableMapSlotBit(variableID, shift);
+  uint32_t otherBit = VPLVariableMapSlotBit(otherVariableID, shift);
+
+  if (bit == otherBit)
+  {
+    VPLVariableMapNode * childNode = VPLVariableMapNodeWithEntries(variableID,
+                                                                   object,
+                                                                   otherVariableID,
+                                                                   otherObject,
+                                                                   shift + VPLVariableMapBitsPerLevel,
+                                                                   owner);
+
+    VPLVariableMapNode * node = VPLVariableMapNodeCreate(owner, 0, bit);
+    node->_slots[0] = CFBridgingRetain(childNode);
+    return node;
+  }
+
+  VPLVariableMapNode * node = VPLVariableMapNodeCreate(owner, bit | otherBit, 0);
+  NSUInteger entryIndex = (bit < otherBit ? 0 : 1);
+  node->_variableIDs[entryIndex] = variableID;
+  node->_slots[entryIndex] = CFBridgingRetain(object);
+  node->_variableIDs[1 - entryIndex] = otherVariableID;
+  node->_slots[1 - entryIndex] = CFBridgingRetain(otherObject);
+
+  return node;
+}
+
+static id
+VPLVariableMapNodeObject(__unsafe_unretained VPLVariableMapNode * node, VPLVariableID variableID)
+{
+  for (NSUInteger shift = 0; node != nil; shift += VPLVariableMapBitsPerLevel)
+  {
+    uint32_t bit = VPLVariableMapSlotBit(variableID, shift);
+    if (node->_entryMap & bit)
+    {
+      NSUInteger entryIndex = VPLVariableMapSlotIndex(node->_entryMap, bit);
+      return (node->_variableIDs[entryIndex] == variableID ? (__bridge id)node->_slots[entryIndex] : nil);
+    }
+
+    if ((node->_nodeMap & bit) == 0) return nil;
+
+    NSUInteger slotIndex = __builtin_popcount(node->_entryMap) + VPLVariableMapSlotIndex(node->_nodeMap, bit);
+    node = (__bridge VPLVariableMapNode *)node->_slots[slotIndex];
+  }
+
+  return nil;
+}
+
+/**
+ * Returns the node with `object` set for `variableID`: the node itself if it's owned by `owner`, or if nothing changed,
+ * and otherwise a copy of it. `added` is set to YES if the map didn't already have an entry for `variableID`.
+ */
+static VPLVariableMapNode *
+VPLVariableMapNodeBySettingObject(VPLVariableMapNode * node,
+                                  VPLVariableID variableID,
+                                  id object,
+                                  NSUInteger shift,
+                                  id owner,
+                                  BOOL * added)
+{
+  uint32_t bit = VPLVariableMapSlotBit(variableID, shift);
+  BOOL isOwned = (owner != nil && node->_owner == owner);
+
+  if (node->_entryMap & bit)
+  {
+    NSUInteger entryIndex = VPLVariableMapSlotIndex(node->_entryMap, bit);
+    VPLVariableID entryVariableID = node->_variableIDs[entryIndex];
+    id entryObject = (__bridge id)node->_slots[entryIndex];
+
+    if (entryVariableID == variableID)
+    {
+      if (entryObject == object) return node;
+
+      if (isOwned)
+      {
+        VPLVariableMapNodeSetSlot(node, entryIndex, object);
+        return node;
+      }
+
+      return VPLVariableMapNodeByReplacingSlot(node, bit, variableID, object, NO, owner);
+    }
+
+    // another entry already has this slot, so both of them move down into a node of their own
+    *added = YES;
+    VPLVariableMapNode * childNode = VPLVariableMapNodeWithEntries(entryVariableID,
+                                                                   entryObject,
+                                                                   variableID,
+                                                                   object,
+                                                                   shift + VPLVariableMapBitsPerLevel,
+                                                                   owner);
+    return VPLVariableMapNodeByReplacingSlot(node, bit, VPLVariableIDNone, childNode, YES, owner);
+  }
+
+  if (node->_nodeMap & bit)
+  {
+    NSUInteger slotIndex = __builtin_popcount(node->_entryMap) + VPLVariableMapSlotIndex(node->_nodeMap, bit);
+    VPLVariableMapNode * childNode = (__bridge VPLVariableMapNode *)node->_slots[slotIndex];
+    VPLVariableMapNode * updatedChildNode = VPLVariableMapNodeBySettingObject(childNode,
+                                                                              variableID,
+                                                                              object,
+                                                                              shift + VPLVariableMapBitsPerLevel,
+                                                                              owner,
+                                                                              added);
+    if (updatedChildNode == childNode) return node;
+
+    if (isOwned)
+    {
+      VPLVariableMapNodeSetSlot(node, slotIndex, updatedChildNode);
+      return node;
+    }
+
+    return VPLVariableMapNodeByReplacingSlot(node, bit, VPLVariableIDNone, updatedChildNode, YES, owner);
+  }
+
+  *added = YES;
+  return VPLVariableMapNodeByReplacingSlot(node, bit, variableID, object, NO, owner);
+}
+
+/**
+ * Returns the node without an entry for `variableID`, in the same way as `VPLVariableMapNodeBySettingObject`.
+ * `removed` is set to YES if the map had an entry for `variableID`.
+ */
+static VPLVariableMapNode *
+VPLVariableMapNodeByRemovingObject(VPLVariableMapNode * node,
+                                   VPLVariableID variableID,
+                                   NSUInteger shift,
+                                   id owner,
+                                   BOOL * removed)
+{
+  uint32_t bit = VPLVariableMapSlotBit(variableID, shift);
+
+  if (node->_entryMap & bit)
+  {
+    NSUInteger entryIndex = VPLVariableMapSlotIndex(node->_entryMap, bit);
+    if (node->_variableIDs[entryIndex] != variableID) return node;
+
+    *removed = YES;
+    return VPLVariableMapNodeByReplacingSlot(node, bit, VPLVariableIDNone, nil, NO, owner);
+  }
+
+  if (node->_nodeMap & bit)
+  {
+    NSUInteger slotIndex = __builtin_popcount(node->_entryMap) + VPLVariableMapSlotIndex(node->_nodeMap, bit);
+    VPLVariableMapNode * childNode = (__bridge VPLVariableMapNode *)node->_slots[slotIndex];
+    VPLVariableMapNode * updatedChildNode = VPLVariableMapNodeByRemovingObject(childNode,
+                                                                               variableID,
+                                                                               shift + VPLVariableMapBitsPerLevel,
+                                                                               owner,
+                                                                               removed);
+    if (updatedChildNode == childNode) return node;
+
+    // a child left with a single entry is folded back into this node, which keeps the trie as shallow as it can be
+    if (updatedChildNode->_nodeMap == 0 && __builtin_popcount(updatedChildNode->_entryMap) == 1)
+    {
+      return VPLVariableMapNodeByReplacingSlot(node,
+                                               bit,
+                                               updatedChildNode->_variableIDs[0],
+                                               (__bridge id)updatedChildNode->_slots[0],
+                                               NO,
+                                               owner);
+    }
+
+    if (owner != nil && node->_owner == owner)
+    {
+      VPLVariableMapNodeSetSlot(node, slotIndex, updatedChildNode);
+      return node;
+    }
+
+    return VPLVariableMapNodeByReplacingSlot(node, bit, VPLVariableIDNone, updatedChildNode, YES, owner);
+  }
+
+  return node;
+}
+
+/**
+ * Calls the block for each entry below the node. Returns NO if the block stopped the enumeration.
+ */
+static BOOL
+VPLVariableMapNodeEnumerate(__unsafe_unretained VPLVariableMapNode * node,
+                            void (^block)(VPLVariableID variableID, id object, BOOL * stop))
+{
+  NSUInteger entryCount = (NSUInteger)__builtin_popcount(node->_entryMap);
+  NSUInteger slotCount = entryCount + (NSUInteger)__builtin_popcount(node->_nodeMap);
+
+  BOOL stop = NO;
+  for (NSUInteger entryIndex = 0; entryIndex < entryCount; entryIndex++)
+  {
+    block(node->_variableIDs[entryIndex], (__bridge id)node->_slots[entryIndex], &stop);
+    if (stop) return NO;
+  }
+
+  for (NSUInteger slotIndex = entryCount; slotIndex < slotCount; slotIndex++)
+  {
+    if (!VPLVariableMapNodeEnumerate((__bridge VPLVariableMapNode *)node->_slots[slotIndex], block)) return NO;
+  }
+
+  return YES;
+}
+
+// ===== MAPS ==========================================================================================================
+#pragma mark - Maps
+
+@interface VPLVariableMap ()
+{
+  @protected
+  VPLVariableMapNode * _root;
+  NSUInteger _count;
+}
+
+- (instancetype)initWithRoot:(VPLVariableMapNode *)root
+                       count:(NSUInteger)count;
+
+@end
+
+@implementation VPLVariableMap
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+  return [self initWithRoot:VPLVariableMapNodeCreate(nil, 0, 0)
+                      count:0];
+}
+
+- (instancetype)initWithRoot:(VPLVariableMapNode *)root
+                       count:(NSUInteger)count
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _root = root;
+    _count = count;
+  }
+  return self;
+}
+
++ (instancetype)map
+{
+  return [[self alloc] init];
+}
+
+// ===== NSCopying =====================================================================================================
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  return self;
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+  return [[VPLMutableVariableMap alloc] initWithRoot:_root
+                                               count:_count];
+}
+
+// ===== ENTRIES =======================================================================================================
+#pragma mark - Entries
+
+- (NSUInteger)count
+{
+  return _count;
+}
+
+- (id)objectForVariableID:(VPLVariableID)variableID
+{
+  return VPLVariableMapNodeObject(_root, variableID);
+}
+
+- (BOOL)containsVariableID:(VPLVariableID)variableID
+{
+  return VPLVariableMapNodeObject(_root, variableID) != nil;
+}
+
+- (NSIndexSet *)variableIDs
+{
+  NSMutableIndexSet * variableIDs = [[NSMutableIndexSet alloc] init];
+  VPLVariableMapNodeEnumerate(_root, ^(VPLVariableID variableID, id object, BOOL * stop) {
+    [variableIDs addIndex:variableID];
+  });
+
+  return variableIDs;
+}
+
+- (void)enumerateVariableIDsAndObjectsUsingBlock:(void (^)(VPLVariableID variableID, id object, BOOL * stop))block
+{
+  VPLVariableMapNodeEnumerate(_root, block);
+}
+
+// ===== DERIVED MAPS ==================================================================================================
+#pragma mark - Derived Maps
+
+- (VPLVariableMap *)mapBySettingObject:(id)object
+                         forVariableID:(VPLVariableID)variableID
+{
+  NSAssert(object != nil,
+           @"[%@ %@] Attempt to set a nil object for a variable",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+
+  // copying first stops a mutable map from changing the nodes the derived map shares with it
+  VPLVariableMap * map = [self copy];
+
+  BOOL added = NO;
+  VPLVariableMapNode * root = VPLVariableMapNodeBySettingObject(map->_root, variableID, object, 0, nil, &added);
+  if (root == map->_root) return map;
+
+  return [[VPLVariableMap alloc] initWithRoot:root
+                                        count:map->_count + (added ? 1 : 0)];
+}
+
+- (VPLVariableMap *)mapByRemovingObjectForVariableID:(VPLVariableID)variableID
+{
+  VPLVariableMap * map = [self copy];
+
+  BOOL removed = NO;
+  VPLVariableMapNode * root = VPLVariableMapNodeByRemovingObject(map->_root, variableID, 0, nil, &removed);
+  if (root == map->_root) return map;
+
+  return [[VPLVariableMap alloc] initWithRoot:root
+                                        count:map->_count - (removed ? 1 : 0)];
+}
+
+@end
+
+@interface VPLMutableVariableMap ()
+
+// Copying a map that is otherwise only read, such as one of an immutable tableau's maps, may happen on several threads
+// at once, so taking a new owner is atomic. Changes are never made concurrently, so they read the owner directly.
+@property (atomic, strong) id owner;
+
+@end
+
+@implementation VPLMutableVariableMap
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)initWithRoot:(VPLVariableMapNode *)root
+                       count:(NSUInteger)count
+{
+  self = [super initWithRoot:root
+                       count:count];
+  if (self != nil)
+  {
+    _owner = [[NSObject alloc] init];
+  }
+  return self;
+}
+
+// ===== NSCopying =====================================================================================================
+#pragma mark - NSCopying
+
+/**
+ * Once its nodes are shared, the map mustn't change them in place any more. Taking a new owner means it copies each
+ * one the first time it changes it, the same as the copy does.
+ */
+- (void)disownNodes
+{
+  self.owner = [[NSObject alloc] init];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+  [self disownNodes];
+  return [[VPLVariableMap alloc] initWithRoot:_root
+                                        count:_count];
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+  [self disownNodes];
+  return [[VPLMutableVariableMap alloc] initWithRoot:_root
+                                               count:_count];
+}
+
+// ===== ENTRIES =======================================================================================================
+#pragma mark - Entries
+
+- (void)setObject:(id)object
+    forVariableID:(VPLVariableID)variableID
+{
+  NSAssert(object != nil,
+           @"[%@ %@] Attempt to set a nil object for a variable",
+           NSStringFromClass([self class]),
+           NSStringFromSelector(_cmd));
+
+  BOOL added = NO;
+  _root = VPLVariableMapNodeBySettingObject(_root, variableID, object, 0, _owner, &added);
+  if (added) _count++;
+}
+
+- (void)removeObjectForVariableID:(VPLVariableID)variableID
+{
+  BOOL removed = NO;
+  _root = VPLVariableMapNodeByRemovingObject(_root, variableID, 0, _owner, &removed);
+  if (removed) _count--;
+}
+
+@end
@@ -0,0 +1,50 @@
+#import "VPLCassowaryTypes.h"
+
+/**
+ * Measures solver throughput on synthetic constraint systems:
+ *
+ * - `chain`:  a long chain of equalities, `x[i] = x[i-1] + 1`, added one constraint at a time.
+ * - `insets`: nested rectangles, each inset from its parent like the `InsetRectangles` sample, added a rectangle at a
+ *             time.
+ * - `grid`:   a grid of cells spaced by inequalities and aligned by equalities, added a row at a time.
+ * - `churn`:  a chain whose constraints are repeatedly removed and added again, in a fixed pseudo-random order.
+ * - `resize`: nested rectangles whose root size is an edit variable, re-solved at a sequence of sizes.
+ *
+ * Each workload reports its throughput, pivots, latency percentiles and how far its peak memory footprint rose above
+ * the footprint it started from, so earlier workloads don't inflate later ones' figures. Workloads that add constraints
+ * also report their constraint throughput and pivots per added constraint; `resize` adds none, so it leaves them out.
+ * The results are plain property lists, so they can be written as JSON and compared against the results of another
+ * commit.
+ */
+@interface VPLBenchmark : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+/**
+ * `scale` multiplies the size of every workload. A scale of 1 gives sizes comparable to a large production asset.
+ */
+- (instancetype)initWithScale:(CGFloat)scale;
+
+@property (nonatomic, assign, readonly) CGFloat scale;
+
+// ===== RUNNING =======================================================================================================
+#pragma mark - Running
+
+/**
+ * Runs every workload, and returns a dictionary with the scale and an array of per-workload results.
+ */
+- (NSDictionary *)run;
+
+// ===== COMPARING =====================================================================================================
+#pragma mark - Comparing
+
+/**
+ * Returns a description of each workload whose median latency or throughput is worse than the baseline's by more than
+ * `threshold` (0.1 for 10%). Workloads missing from either set of results are skipped.
+ */
++ (NSArray *)regressionsInResults:(NSDictionary *)results
+               comparedToBaseline:(NSDictionary *)baseline
+                        threshold:(CGFloat)threshold;
+
+@end
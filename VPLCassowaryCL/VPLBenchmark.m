@@ -0,0 +1,564 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLBenchmark.h"
+#import "VPLConstraint.h"
+#import "VPLConstraintSet.h"
+
+#import <mach/mach.h>
+#import <mach/mach_time.h>
+
+// ===== TIMING ========================================================================================================
+#pragma mark - Timing
+
+static double
+VPLBenchmarkCurrentTime()
+{
+  static mach_timebase_info_data_t timebase;
+  if (timebase.denom == 0)
+  {
+    mach_timebase_info(&timebase);
+  }
+
+  return (double)mach_absolute_time() * timebase.numer / timebase.denom / 1.0e9;
+}
+
+/**
+ * The memory the system charges the process for. Unlike `ru_maxrss`, which is the peak over the life of the process,
+ * it falls again as memory is freed, so each workload can be measured against the footprint it started from.
+ */
+static uint64_t
+VPLBenchmarkMemoryFootprint()
+{
+  task_vm_info_data_t vmInfo;
+  mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+  if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&vmInfo, &count) != KERN_SUCCESS)
+  {
+    return 0;
+  }
+  return vmInfo.phys_footprint;
+}
+
+/**
+ * A fixed-seed xorshift generator, so every run churns the same constraints in the same order.
+ */
+static uint32_t
+VPLBenchmarkNextRandom(uint32_t * state)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// ===== WORKLOAD ======================================================================================================
+#pragma mark - Workload
+
+/**
+ * Collects the measurements of a single workload.
+ */
+@interface VPLBenchmarkWorkload : NSObject
+
+- (instancetype)initWithName:(NSString *)name
+                  parameters:(NSDictionary *)parameters;
+
+@property (nonatomic, strong, readonly) NSString * name;
+@property (nonatomic, strong, readonly) NSDictionary * parameters;
+
+/**
+ * The number of constraints added by the measured operations. The results only include per-constraint figures if it's
+ * set.
+ */
+@property (nonatomic, assign) NSUInteger constraintCount;
+@property (nonatomic, assign) NSUInteger pivotCount;
+
+- (void)measure:(void(^)(void))operation;
+
+- (NSDictionary *)results;
+
+@end
+
+@implementation VPLBenchmarkWorkload
+{
+  NSMutableData * _latencies;   // double seconds, one per operation
+  uint64_t _baselineFootprint;  // before anything of the workload's was allocated
+  uint64_t _peakFootprint;      // after any operation
+}
+
+- (instancetype)initWithName:(NSString *)name
+                  parameters:(NSDictionary *)parameters
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _name = name;
+    _parameters = parameters;
+    _latencies = [[NSMutableData alloc] init];
+    _baselineFootprint = VPLBenchmarkMemoryFootprint();
+    _peakFootprint = _baselineFootprint;
+  }
+  return self;
+}
+
+- (void)measure:(void(^)(void))operation
+{
+  double startTime = VPLBenchmarkCurrentTime();
+  operation();
+  double latency = VPLBenchmarkCurrentTime() - startTime;
+
+  [_latencies appendBytes:&latency
+                   length:sizeof(latency)];
+
+  // sampled outside the timed operation, so the latencies don't include it
+  _peakFootprint = MAX(_peakFootprint, VPLBenchmarkMemoryFootprint());
+}
+
+static int
+VPLBenchmarkCompareLatencies(const void * a, const void * b)
+{
+  double latencyA = *(const double *)a;
+  double latencyB = *(const double *)b;
+  return (latencyA < latencyB ? -1 : (latencyA > latencyB ? 1 : 0));
+}
+
+- (NSDictionary *)results
+{
+  NSUInteger operationCount = [_latencies length] / sizeof(double);
+  NSMutableData * sortedLatencies = [_latencies mutableCopy];
+  double * latencies = [sortedLatencies mutableBytes];
+  qsort(latencies, operationCount, sizeof(double), VPLBenchmarkCompareLatencies);
+
+  double totalTime = 0.0;
+  for (NSUInteger operationIndex = 0; operationIndex < operationCount; operationIndex++)
+  {
+    totalTime += latencies[operationIndex];
+  }
+
+  // latencies are reported in microseconds
+  double (^percentile)(double) = ^double(double fraction) {
+    if (operationCount == 0) return 0.0;
+    NSUInteger index = MIN((NSUInteger)(fraction * operationCount), operationCount - 1);
+    return latencies[index] * 1.0e6;
+  };
+
+  NSMutableDictionary * results = [[NSMutableDictionary alloc] init];
+  results[@"name"] = self.name;
+  results[@"parameters"] = self.parameters;
+  results[@"operations"] = @(operationCount);
+  results[@"seconds"] = @(totalTime);
+  results[@"operationsPerSecond"] = @(totalTime > 0.0 ? operationCount / totalTime : 0.0);
+  results[@"pivots"] = @(self.pivotCount);
+
+  // a workload that only re-solves, like `resize`, adds no constraints, so it has no per-constraint figures to report
+  if (self.constraintCount > 0)
+  {
+    results[@"constraints"] = @(self.constraintCount);
+    results[@"constraintsPerSecond"] = @(totalTime > 0.0 ? self.constraintCount / totalTime : 0.0);
+    results[@"pivotsPerAdd"] = @((double)self.pivotCount / self.constraintCount);
+  }
+  results[@"peakMemoryGrowthBytes"] = @(_peakFootprint - _baselineFootprint);
+  results[@"latencyMicroseconds"] = @{
+    @"p50" : @(percentile(0.50)),
+    @"p90" : @(percentile(0.90)),
+    @"p99" : @(percentile(0.99)),
+    @"max" : @(percentile(1.00)),
+  };
+
+  return results;
+}
+
+@end
+
+@implementation VPLBenchmark
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+  return [self initWithScale:1.0];
+}
+
+- (instancetype)initWithScale:(CGFloat)scale
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _scale = scale;
+  }
+  return self;
+}
+
+- (NSUInteger)scaledSize:(NSUInteger)size
+{
+  return MAX((NSUInteger)1, (NSUInteger)round(size * self.scale));
+}
+
+// ===== RUNNING =======================================================================================================
+#pragma mark - Running
+
+- (NSDictionary *)run
+{
+  NSMutableArray * workloads = [[NSMutableArray alloc] init];
+
+  @autoreleasepool
+  {
+    [workloads addObject:[self runChainWithLength:[self scaledSize:2000]]];
+  }
+
+  @autoreleasepool
+  {
+    [workloads addObject:[self runInsetsWithDepth:[self scaledSize:250]]];
+  }
+
+  @autoreleasepool
+  {
+    NSUInteger gridSize = [self scaledSize:40];
+    [workloads addObject:[self runGridWithRows:gridSize
+                                       columns:gridSize]];
+  }
+
+  @autoreleasepool
+  {
+    [workloads addObject:[self runChurnWithLength:[self scaledSize:1000]
+                                       operations:[self scaledSize:2000]]];
+  }
+
+  @autoreleasepool
+  {
+    [workloads addObject:[self runResizeWithDepth:[self scaledSize:100]
+                                            steps:[self scaledSize:1000]]];
+  }
+
+  return @{
+    @"scale" : @(self.scale),
+    @"workloads" : workloads,
+  };
+}
+
+// ----- CHAIN ---------------------------------------------------------------------------------------------------------
+#pragma mark Chain
+
+- (VPLConstraint *)chainConstraintAtIndex:(NSUInteger)index
+{
+  NSString * variableName = [NSString stringWithFormat:@"chain.x%lu", (unsigned long)index];
+  NSString * previousVariableName = (index > 0
+                                     ? [NSString stringWithFormat:@"chain.x%lu", (unsigned long)(index - 1)]
+                                     : nil);
+
+  return [VPLConstraint constraintWithVariable:variableName
+                                     relatedBy:VPLConstraintRelationEqual
+                                    toVariable:previousVariableName
+                                    multiplier:(index > 0 ? 1 : 0)
+                                      constant:(index > 0 ? 1 : 0)];
+}
+
+- (NSDictionary *)runChainWithLength:(NSUInteger)length
+{
+  VPLBenchmarkWorkload * workload = [[VPLBenchmarkWorkload alloc] initWithName:@"chain"
+                                                                    parameters:@{ @"length" : @(length) }];
+
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  for (NSUInteger index = 0; index < length; index++)
+  {
+    VPLConstraint * constraint = [self chainConstraintAtIndex:index];
+    [workload measure:^{
+      [constraintSet addConstraint:constraint];
+    }];
+  }
+
+  workload.constraintCount = length;
+  workload.pivotCount = constraintSet.pivotCount;
+  return [workload results];
+}
+
+// ----- INSETS --------------------------------------------------------------------------------------------------------
+#pragma mark Insets
+
+/**
+ * The constraints placing rectangle `index` 10 points inside rectangle `index - 1`. The outermost rectangle is fixed at
+ * the origin, and its size is either fixed as well or left to edit variables.
+ */
+- (NSArray *)insetConstraintsForRectangleAtIndex:(NSUInteger)index
+                                           depth:(NSUInteger)depth
+                                       fixedSize:(BOOL)fixedSize
+{
+  NSString * (^variable)(NSUInteger, NSString *) = ^NSString *(NSUInteger rectangleIndex, NSString * attribute) {
+    return [NSString stringWithFormat:@"insets.r%lu.%@", (unsigned long)rectangleIndex, attribute];
+  };
+
+  NSMutableArray * constraints = [[NSMutableArray alloc] initWithCapacity:4];
+  if (index == 0)
+  {
+    CGFloat size = depth * 20.0 + 100.0;
+    NSArray * attributes = (fixedSize ? @[ @"x", @"y", @"width", @"height" ] : @[ @"x", @"y" ]);
+    for (NSString * attribute in attributes)
+    {
+      BOOL isOrigin = [attribute isEqualToString:@"x"] || [attribute isEqualToString:@"y"];
+      [constraints addObject:[VPLConstraint constraintWithVariable:variable(index, attribute)
+                                                         relatedBy:VPLConstraintRelationEqual
+                                                        toVariable:nil
+                                                        multiplier:0
+                                                          constant:(isOrigin ? 0.0 : size)]];
+    }
+    return constraints;
+  }
+
+  NSDictionary * insets = @{ @"x" : @(10), @"y" : @(10), @"width" : @(-20), @"height" : @(-20) };
+  [insets enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+
+    [constraints addObject:[VPLConstraint constraintWithVariable:variable(index, key)
+                                                       relatedBy:VPLConstraintRelationEqual
+                                                      toVariable:variable(index - 1, key)
+                                                      multiplier:1
+                                                        constant:[obj floatValue]]];
+
+  }];
+
+  // and keep it from collapsing
+  [constraints addObject:[VPLConstraint constraintWithVariable:variable(index, @"width")
+                                                     relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                    toVariable:nil
+                                                    multiplier:0
+                                                      constant:0]];
+  return constraints;
+}
+
+- (NSDictionary *)runInsetsWithDepth:(NSUInteger)depth
+{
+  VPLBenchmarkWorkload * workload = [[VPLBenchmarkWorkload alloc] initWithName:@"insets"
+                                                                    parameters:@{ @"depth" : @(depth) }];
+
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  NSUInteger constraintCount = 0;
+  for (NSUInteger index = 0; index < depth; index++)
+  {
+    NSArray * constraints = [self insetConstraintsForRectangleAtIndex:index
+                                                                depth:depth
+                                                            fixedSize:YES];
+    constraintCount += [constraints count];
+
+    [workload measure:^{
+      [constraintSet addConstraints:constraints];
+    }];
+  }
+
+  workload.constraintCount = constraintCount;
+  workload.pivotCount = constraintSet.pivotCount;
+  return [workload results];
+}
+
+// ----- GRID ----------------------------------------------------------------------------------------------------------
+#pragma mark Grid
+
+- (NSDictionary *)runGridWithRows:(NSUInteger)rowCount
+                          columns:(NSUInteger)columnCount
+{
+  VPLBenchmarkWorkload * workload = [[VPLBenchmarkWorkload alloc] initWithName:@"grid"
+                                                                    parameters:@{ @"rows" : @(rowCount),
+                                                                                  @"columns" : @(columnCount) }];
+
+  NSString * (^variable)(NSUInteger, NSUInteger, NSString *) = ^NSString *(NSUInteger row, NSUInteger column, NSString * attribute) {
+    return [NSString stringWithFormat:@"grid.r%luc%lu.%@", (unsigned long)row, (unsigned long)column, attribute];
+  };
+
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  NSUInteger constraintCount = 0;
+  for (NSUInteger row = 0; row < rowCount; row++)
+  {
+    NSMutableArray * constraints = [[NSMutableArray alloc] init];
+    for (NSUInteger column = 0; column < columnCount; column++)
+    {
+      if (column == 0)
+      {
+        // the first column is pinned to the left edge
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"x")
+                                                           relatedBy:VPLConstraintRelationEqual
+                                                          toVariable:nil
+                                                          multiplier:0
+                                                            constant:0]];
+      }
+      else
+      {
+        // cells are at least 20 and at most 40 points to the right of their neighbour
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"x")
+                                                           relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                          toVariable:variable(row, column - 1, @"x")
+                                                          multiplier:1
+                                                            constant:20]];
+
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"x")
+                                                           relatedBy:VPLConstraintRelationLessThanOrEqual
+                                                          toVariable:variable(row, column - 1, @"x")
+                                                          multiplier:1
+                                                            constant:40]];
+      }
+
+      if (row == 0)
+      {
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"y")
+                                                           relatedBy:VPLConstraintRelationEqual
+                                                          toVariable:nil
+                                                          multiplier:0
+                                                            constant:0]];
+      }
+      else
+      {
+        // rows are at least 20 points below the row above, and columns stay aligned
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"y")
+                                                           relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                          toVariable:variable(row - 1, column, @"y")
+                                                          multiplier:1
+                                                            constant:20]];
+
+        [constraints addObject:[VPLConstraint constraintWithVariable:variable(row, column, @"x")
+                                                           relatedBy:VPLConstraintRelationEqual
+                                                          toVariable:variable(row - 1, column, @"x")
+                                                          multiplier:1
+                                                            constant:0]];
+      }
+    }
+
+    constraintCount += [constraints count];
+    [workload measure:^{
+      [constraintSet addConstraints:constraints];
+    }];
+  }
+
+  workload.constraintCount = constraintCount;
+  workload.pivotCount = constraintSet.pivotCount;
+  return [workload results];
+}
+
+// ----- CHURN ---------------------------------------------------------------------------------------------------------
+#pragma mark Churn
+
+- (NSDictionary *)runChurnWithLength:(NSUInteger)length
+                          operations:(NSUInteger)operationCount
+{
+  VPLBenchmarkWorkload * workload = [[VPLBenchmarkWorkload alloc] initWithName:@"churn"
+                                                                    parameters:@{ @"length" : @(length),
+                                                                                  @"operations" : @(operationCount) }];
+
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  NSMutableArray * constraints = [[NSMutableArray alloc] initWithCapacity:length];
+  for (NSUInteger index = 0; index < length; index++)
+  {
+    [constraints addObject:[self chainConstraintAtIndex:index]];
+  }
+  [constraintSet addConstraints:constraints];
+
+  // only the churn itself is measured
+  NSUInteger initialPivotCount = constraintSet.pivotCount;
+
+  uint32_t randomState = 2463534242;
+  for (NSUInteger operationIndex = 0; operationIndex < operationCount; operationIndex++)
+  {
+    NSUInteger index = VPLBenchmarkNextRandom(&randomState) % length;
+    VPLConstraint * constraint = [constraints objectAtIndex:index];
+    VPLConstraint * replacement = [self chainConstraintAtIndex:index];
+
+    [workload measure:^{
+      [constraintSet removeConstraint:constraint];
+      [constraintSet addConstraint:replacement];
+    }];
+
+    [constraints replaceObjectAtIndex:index
+                           withObject:replacement];
+  }
+
+  workload.constraintCount = operationCount;
+  workload.pivotCount = constraintSet.pivotCount - initialPivotCount;
+  return [workload results];
+}
+
+// ----- RESIZE --------------------------------------------------------------------------------------------------------
+#pragma mark Resize
+
+- (NSDictionary *)runResizeWithDepth:(NSUInteger)depth
+                               steps:(NSUInteger)stepCount
+{
+  VPLBenchmarkWorkload * workload = [[VPLBenchmarkWorkload alloc] initWithName:@"resize"
+                                                                    parameters:@{ @"depth" : @(depth),
+                                                                                  @"steps" : @(stepCount) }];
+
+  VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+  for (NSUInteger index = 0; index < depth; index++)
+  {
+    [constraintSet addConstraints:[self insetConstraintsForRectangleAtIndex:index
+                                                                      depth:depth
+                                                                  fixedSize:NO]];
+  }
+
+  [constraintSet addEditVariable:@"insets.r0.width"];
+  [constraintSet addEditVariable:@"insets.r0.height"];
+
+  NSUInteger initialPivotCount = constraintSet.pivotCount;
+
+  // sweep the size back and forth, through sizes too small for the innermost rectangles
+  CGFloat largestSize = depth * 20.0 + 100.0;
+  for (NSUInteger step = 0; step < stepCount; step++)
+  {
+    CGFloat fraction = (CGFloat)(step % 100) / 100.0;
+    CGFloat size = largestSize * (step % 200 < 100 ? fraction : 1.0 - fraction);
+
+    [workload measure:^{
+      [constraintSet suggestValue:size
+                      forVariable:@"insets.r0.width"];
+      [constraintSet suggestValue:size * 0.5
+                      forVariable:@"insets.r0.height"];
+      [constraintSet resolve];
+    }];
+  }
+
+  workload.pivotCount = constraintSet.pivotCount - initialPivotCount;
+  return [workload results];
+}
+
+// ===== COMPARING =====================================================================================================
+#pragma mark - Comparing
+
++ (NSArray *)regressionsInResults:(NSDictionary *)results
+               comparedToBaseline:(NSDictionary *)baseline
+                        threshold:(CGFloat)threshold
+{
+  NSMutableDictionary * baselineWorkloads = [[NSMutableDictionary alloc] init];
+  for (NSDictionary * workload in baseline[@"workloads"])
+  {
+    baselineWorkloads[workload[@"name"]] = workload;
+  }
+
+  NSMutableArray * regressions = [[NSMutableArray alloc] init];
+  for (NSDictionary * workload in results[@"workloads"])
+  {
+    NSDictionary * baselineWorkload = baselineWorkloads[workload[@"name"]];
+    if (baselineWorkload == nil) continue;
+
+    double latency = [workload[@"latencyMicroseconds"][@"p50"] doubleValue];
+    double baselineLatency = [baselineWorkload[@"latencyMicroseconds"][@"p50"] doubleValue];
+    if (baselineLatency > 0.0 && latency > baselineLatency * (1.0 + threshold))
+    {
+      [regressions addObject:[NSString stringWithFormat:@"%@: median latency %.1fus, was %.1fus",
+                                                        workload[@"name"],
+                                                        latency,
+                                                        baselineLatency]];
+    }
+
+    double throughput = [workload[@"operationsPerSecond"] doubleValue];
+    double baselineThroughput = [baselineWorkload[@"operationsPerSecond"] doubleValue];
+    if (throughput < baselineThroughput * (1.0 - threshold))
+    {
+      [regressions addObject:[NSString stringWithFormat:@"%@: %.0f operations per second, was %.0f",
+                                                        workload[@"name"],
+                                                        throughput,
+                                                        baselineThroughput]];
+    }
+  }
+
+  return regressions;
+}
+
+@end
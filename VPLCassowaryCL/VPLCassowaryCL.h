@@ -1,4 +1,5 @@
 #import "VPLCassowaryTypes.h"
+#import "VPLLayoutWriter.h"
 
 extern NSString * const VPLCassowaryCLErrorDomain;
 
@@ -7,9 +8,54 @@ typedef enum _VPLCassowaryCLError
   VPLCassowaryCLErrorNone = 0,
   VPLCassowaryCLErrorUnableToLoadAssetsLibrary,
   VPLCassowaryCLErrorAssetNameNotFound,
+  VPLCassowaryCLErrorUnableToWriteBenchmarkResults,
+  VPLCassowaryCLErrorUnableToLoadBenchmarkBaseline,
+  VPLCassowaryCLErrorBenchmarkRegression,
+  VPLCassowaryCLErrorUnableToWriteInstrumentation,
+  VPLCassowaryCLErrorBatchRenderFailed,
+  VPLCassowaryCLErrorUnableToWriteCompiledLibrary,
+  VPLCassowaryCLErrorUnableToWriteLayoutCache,
+  VPLCassowaryCLErrorUnableToWriteLayout,
+  VPLCassowaryCLErrorUnableToReadLayoutQueries,
+  VPLCassowaryCLErrorLayoutFailed,
 }
 VPLCassowaryCLError;
 
+/**
+ * Draws an asset from an assets library:
+ *
+ *     VPLCassowaryCL <library path> <asset name>
+ *
+ * or draws every asset whose filename matches a shell-style pattern (every asset if there's no pattern), spreading the
+ * work across `jobs` threads (one per processor by default) and writing the images to the output directory:
+ *
+ *     VPLCassowaryCL batch <library path> [<pattern>] [--output-directory <path>] [--jobs <count>]
+ *
+ * or lays out the same assets at their own sizes without drawing them, and writes their solved frames as JSON or in
+ * binary (see `VPLLayoutWriter`) to a file or standard output:
+ *
+ *     VPLCassowaryCL layout <library path> [<pattern>] [--format json|binary] [--output <path>] [--jobs <count>]
+ *
+ * With `--queries <path>`, `layout` instead answers queries read from the path, or from standard input if it's `-`.
+ * Each query is a line holding an asset's filename, optionally followed by a width and height to lay it out at. An
+ * asset's constraints are kept once it's been laid out, so a query for it at another size only re-solves them. When
+ * the queries come from standard input, each answer is written out as soon as it's ready.
+ *
+ * or runs the solver benchmarks, writing their results as JSON to a file or standard output, and optionally failing if
+ * any workload regressed by more than 10% against the results of an earlier run:
+ *
+ *     VPLCassowaryCL benchmark [--scale <scale>] [--output <path>] [--compare <baseline path>]
+ *
+ * or compiles a library into the binary form that `VPLCompiledLibrary` reads, which any of the other commands can load
+ * in place of the JSON library:
+ *
+ *     VPLCassowaryCL compile <library path> <output path>
+ *
+ * Any command also takes `--instrumentation <path>`, which records solver counters and per-phase timings while it
+ * runs and writes them to the path as JSON, and `--layout-cache <path>`, which reads solved layouts from the path
+ * before it runs, and writes them back afterwards, so that layouts that haven't changed since an earlier run aren't
+ * solved again.
+ */
 @interface VPLCassowaryCL : NSObject
 
 // ===== INITIALIZATION ================================================================================================
@@ -27,6 +73,46 @@ VPLCassowaryCLError;
 
 @property (nonatomic, strong, readonly) NSString * assetName;
 
+// ===== BATCH =========================================================================================================
+#pragma mark - Batch
+
+@property (nonatomic, assign, readonly, getter = isBatch) BOOL batch;
+@property (nonatomic, strong, readonly) NSString * batchPattern;
+@property (nonatomic, strong, readonly) NSString * outputDirectory;
+@property (nonatomic, assign, readonly) NSUInteger jobCount;
+
+// ===== LAYOUT ========================================================================================================
+#pragma mark - Layout
+
+@property (nonatomic, assign, readonly, getter = isLayout) BOOL layout;
+@property (nonatomic, assign, readonly) VPLLayoutFormat layoutFormat;
+@property (nonatomic, strong, readonly) NSString * layoutOutputPath;
+@property (nonatomic, strong, readonly) NSString * layoutQueriesPath;
+
+// ===== COMPILE =======================================================================================================
+#pragma mark - Compile
+
+@property (nonatomic, assign, readonly, getter = isCompile) BOOL compile;
+@property (nonatomic, strong, readonly) NSString * compiledLibraryPath;
+
+// ===== BENCHMARK =====================================================================================================
+#pragma mark - Benchmark
+
+@property (nonatomic, assign, readonly, getter = isBenchmark) BOOL benchmark;
+@property (nonatomic, assign, readonly) CGFloat benchmarkScale;
+@property (nonatomic, strong, readonly) NSString * benchmarkOutputPath;
+@property (nonatomic, strong, readonly) NSString * benchmarkBaselinePath;
+
+// ===== INSTRUMENTATION ===============================================================================================
+#pragma mark - Instrumentation
+
+@property (nonatomic, strong, readonly) NSString * instrumentationPath;
+
+// ===== LAYOUT CACHE ==================================================================================================
+#pragma mark - Layout Cache
+
+@property (nonatomic, strong, readonly) NSString * layoutCachePath;
+
 // ===== PERFORM =======================================================================================================
 #pragma mark - Perform
 
@@ -4,11 +4,25 @@
 
 #import "VPLCassowaryCL.h"
 #import "VPLAssetsLibrary.h"
-#import "VPLAsset.h"
 #import "VPLAssetRepresentation.h"
+#import "VPLCompiledLibrary.h"
+#import "VPLBenchmark.h"
+#import "VPLInstrumentation.h"
+#import "VPLLayoutCache.h"
+#import "VPLLayoutWriter.h"
+#import "VPLWorkStealingQueue.h"
 
 NSString * const VPLCassowaryCLDomain = @"VPLCassowaryCL";
 
+static NSString * const VPLCassowaryCLBatchCommand = @"batch";
+static NSString * const VPLCassowaryCLBenchmarkCommand = @"benchmark";
+static NSString * const VPLCassowaryCLCompileCommand = @"compile";
+static NSString * const VPLCassowaryCLLayoutCommand = @"layout";
+
+static NSString * const VPLCassowaryCLStandardInputPath = @"-";
+
+static const CGFloat VPLCassowaryCLBenchmarkRegressionThreshold = 0.1;
+
 
 @implementation VPLCassowaryCL
 
@@ -28,8 +42,86 @@ NSString * const VPLCassowaryCLDomain = @"VPLCassowaryCL";
   self = [super init];
   if (self != nil)
   {
-    _libraryPath = [arguments objectAtIndex:0];
-    _assetName = [arguments objectAtIndex:1];
+    // positional arguments come first, and options follow them
+    NSUInteger optionIndex = 0;
+    NSString * command = [arguments firstObject];
+    if ([command isEqualToString:VPLCassowaryCLBenchmarkCommand])
+    {
+      _benchmark = YES;
+      _benchmarkScale = 1.0;
+      optionIndex = 1;
+    }
+    else if ([command isEqualToString:VPLCassowaryCLBatchCommand]
+             || [command isEqualToString:VPLCassowaryCLLayoutCommand])
+    {
+      _batch = [command isEqualToString:VPLCassowaryCLBatchCommand];
+      _layout = !_batch;
+      _libraryPath = [arguments objectAtIndex:1];
+      optionIndex = 2;
+      
+      if ([arguments count] > 2 && ![[arguments objectAtIndex:2] hasPrefix:@"--"])
+      {
+        _batchPattern = [arguments objectAtIndex:2];
+        optionIndex = 3;
+      }
+    }
+    else if ([command isEqualToString:VPLCassowaryCLCompileCommand])
+    {
+      _compile = YES;
+      _libraryPath = [arguments objectAtIndex:1];
+      _compiledLibraryPath = [arguments objectAtIndex:2];
+      optionIndex = 3;
+    }
+    else
+    {
+      _libraryPath = [arguments objectAtIndex:0];
+      _assetName = [arguments objectAtIndex:1];
+      optionIndex = 2;
+    }
+    
+    for (; optionIndex + 1 < [arguments count]; optionIndex += 2)
+    {
+      NSString * option = [arguments objectAtIndex:optionIndex];
+      NSString * value = [arguments objectAtIndex:optionIndex + 1];
+      
+      if ([option isEqualToString:@"--instrumentation"])
+      {
+        _instrumentationPath = value;
+      }
+      else if ([option isEqualToString:@"--layout-cache"])
+      {
+        _layoutCachePath = value;
+      }
+      else if ([option isEqualToString:@"--output-directory"])
+      {
+        _outputDirectory = value;
+      }
+      else if ([option isEqualToString:@"--jobs"])
+      {
+        _jobCount = (NSUInteger)MAX([value integerValue], 0);
+      }
+      else if ([option isEqualToString:@"--scale"])
+      {
+        _benchmarkScale = [value doubleValue];
+      }
+      else if ([option isEqualToString:@"--output"])
+      {
+        if (_layout) _layoutOutputPath = value;
+        else _benchmarkOutputPath = value;
+      }
+      else if ([option isEqualToString:@"--format"])
+      {
+        _layoutFormat = ([value isEqualToString:@"binary"] ? VPLLayoutFormatBinary : VPLLayoutFormatJSON);
+      }
+      else if ([option isEqualToString:@"--queries"])
+      {
+        _layoutQueriesPath = value;
+      }
+      else if ([option isEqualToString:@"--compare"])
+      {
+        _benchmarkBaselinePath = value;
+      }
+    }
   }
   return self;
 }
@@ -44,12 +136,11 @@ NSString * const VPLCassowaryCLDomain = @"VPLCassowaryCL";
 
 @synthesize assetName = _assetName;
 
-// ===== EXECUTE =======================================================================================================
-#pragma mark - Execute
+// ===== BATCH =========================================================================================================
+#pragma mark - Batch
 
-- (BOOL)perform:(NSError * __autoreleasing *)error
+- (BOOL)performBatch:(NSError * __autoreleasing *)error
 {
-  // create the asset library
   NSError * localError = nil;
   VPLAssetsLibrary * assetsLibrary = [VPLAssetsLibrary assetsLibraryWithPath:self.libraryPath
                                                                      error:&localError];
@@ -70,23 +161,638 @@ NSString * const VPLCassowaryCLDomain = @"VPLCassowaryCL";
     return NO;
   }
   
-  // find the asset
-  VPLAssetRepresentation * matchingAssetRepresentation = nil;
-  for (VPLAsset * asset in assetsLibrary.assets)
+  // The library's index is built here, on one thread, before the workers start. Each worker then creates the
+  // representations it draws, and they're freed as soon as they've been drawn, so only as many representations as
+  // there are workers are ever in memory. Layout and drawing only touch a representation's own layer tree and
+  // constraint set, so the workers don't share anything else.
+  NSArray * filenames = [assetsLibrary representationFilenamesMatchingPattern:self.batchPattern];
+  if ([filenames count] == 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to find assets matching %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString, self.batchPattern];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorAssetNameNotFound
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  NSString * outputDirectory = (self.outputDirectory != nil
+                                ? self.outputDirectory
+                                : [[NSFileManager defaultManager] currentDirectoryPath]);
+  
+  NSMutableArray * renderErrors = [[NSMutableArray alloc] init];
+  VPLWorkStealingQueue * workQueue = [[VPLWorkStealingQueue alloc] initWithWorkerCount:self.jobCount];
+  [workQueue performTasks:filenames
+               usingBlock:^(id task, NSUInteger workerIndex) {
+                 
+                 NSString * filename = task;
+                 NSString * path = [outputDirectory stringByAppendingPathComponent:filename];
+                 VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:filename];
+                 
+                 NSError * renderError = nil;
+                 if (representation == nil)
+                 {
+                   NSString * localizedFormatString = NSLocalizedString(@"Unable to load asset named %@", nil);
+                   NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString, filename];
+                   renderError = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                                     code:VPLCassowaryCLErrorUnableToLoadAssetsLibrary
+                                                 userInfo:@{ NSLocalizedDescriptionKey : localizedErrorMessage }];
+                 }
+                 else
+                 {
+                   [representation drawToFile:path
+                                        error:&renderError];
+                   
+                   // the image has been written, so the solver's memory can go even if something else keeps the asset
+                   [representation invalidateLayout];
+                 }
+                 
+                 if (renderError != nil)
+                 {
+                   @synchronized (renderErrors)
+                   {
+                     [renderErrors addObject:renderError];
+                   }
+                 }
+                 
+               }];
+  
+  if ([renderErrors count] > 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to render %lu of %lu assets", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString,
+                                                                    (unsigned long)[renderErrors count],
+                                                                    (unsigned long)[filenames count]];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorBatchRenderFailed
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage,
+                  NSUnderlyingErrorKey : [renderErrors firstObject]
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return YES;
+}
+
+// ===== LAYOUT ========================================================================================================
+#pragma mark - Layout
+
+- (BOOL)performLayout:(NSError * __autoreleasing *)error
+{
+  NSError * localError = nil;
+  VPLAssetsLibrary * assetsLibrary = [VPLAssetsLibrary assetsLibraryWithPath:self.libraryPath
+                                                                     error:&localError];
+  if (assetsLibrary == nil)
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToLoadAssetsLibrary
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to load assets library", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  NSFileHandle * outputFileHandle = [NSFileHandle fileHandleWithStandardOutput];
+  if (self.layoutOutputPath != nil)
+  {
+    [[NSFileManager defaultManager] createFileAtPath:self.layoutOutputPath
+                                            contents:nil
+                                          attributes:nil];
+    outputFileHandle = [NSFileHandle fileHandleForWritingAtPath:self.layoutOutputPath];
+  }
+  
+  if (outputFileHandle == nil)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to write layouts to %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString, self.layoutOutputPath];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToWriteLayout
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  VPLLayoutWriter * layoutWriter = [[VPLLayoutWriter alloc] initWithFileHandle:outputFileHandle
+                                                                        format:self.layoutFormat];
+  BOOL didPerform = (self.layoutQueriesPath != nil
+                     ? [self performLayoutQueriesWithAssetsLibrary:assetsLibrary
+                                                      layoutWriter:layoutWriter
+                                                             error:error]
+                     : [self performLayoutWithAssetsLibrary:assetsLibrary
+                                               layoutWriter:layoutWriter
+                                                      error:error]);
+  [layoutWriter flush];
+  
+  return didPerform;
+}
+
+/**
+ * Lays out every matching representation at its own size, in the same way that `batch` draws them.
+ */
+- (BOOL)performLayoutWithAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+                          layoutWriter:(VPLLayoutWriter *)layoutWriter
+                                 error:(NSError * __autoreleasing *)error
+{
+  NSArray * filenames = [assetsLibrary representationFilenamesMatchingPattern:self.batchPattern];
+  if ([filenames count] == 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to find assets matching %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString, self.batchPattern];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorAssetNameNotFound
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  NSMutableArray * missingFilenames = [[NSMutableArray alloc] init];
+  VPLWorkStealingQueue * workQueue = [[VPLWorkStealingQueue alloc] initWithWorkerCount:self.jobCount];
+  [workQueue performTasks:filenames
+               usingBlock:^(id task, NSUInteger workerIndex) {
+                 
+                 NSString * filename = task;
+                 VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:filename];
+                 if (representation == nil)
+                 {
+                   @synchronized (missingFilenames)
+                   {
+                     [missingFilenames addObject:filename];
+                   }
+                   return;
+                 }
+                 
+                 [layoutWriter writeLayoutOfRepresentation:representation
+                                                      size:representation.size];
+                 [representation invalidateLayout];
+                 
+               }];
+  
+  if ([missingFilenames count] > 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to lay out %lu of %lu assets, including %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString,
+                                                                    (unsigned long)[missingFilenames count],
+                                                                    (unsigned long)[filenames count],
+                                                                    [missingFilenames firstObject]];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorLayoutFailed
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return YES;
+}
+
+/**
+ * Answers layout queries in the order they're read. Queries for assets that can't be found are skipped, and reported
+ * once every query has been answered.
+ */
+- (BOOL)performLayoutQueriesWithAssetsLibrary:(VPLAssetsLibrary *)assetsLibrary
+                                 layoutWriter:(VPLLayoutWriter *)layoutWriter
+                                        error:(NSError * __autoreleasing *)error
+{
+  BOOL isStandardInput = [self.layoutQueriesPath isEqualToString:VPLCassowaryCLStandardInputPath];
+  FILE * queriesFile = (isStandardInput ? stdin : fopen([self.layoutQueriesPath fileSystemRepresentation], "r"));
+  if (queriesFile == NULL)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to read layout queries from %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString, self.layoutQueriesPath];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToReadLayoutQueries
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  // Representations are kept once they've been laid out, along with their constraint sets, so that a later query for
+  // the same representation at another size only has to suggest the new size and re-solve.
+  NSMutableDictionary * representationsByFilename = [[NSMutableDictionary alloc] init];
+  NSMutableArray * missingFilenames = [[NSMutableArray alloc] init];
+  NSUInteger queryCount = 0;
+  
+  char * line = NULL;
+  size_t lineCapacity = 0;
+  while (getline(&line, &lineCapacity, queriesFile) > 0)
+  {
+    @autoreleasepool
+    {
+      char filenameBytes[1024];
+      double width = 0;
+      double height = 0;
+      int fieldCount = sscanf(line, "%1023s %lf %lf", filenameBytes, &width, &height);
+      if (fieldCount < 1) continue;
+      
+      queryCount++;
+      NSString * filename = [NSString stringWithUTF8String:filenameBytes];
+      VPLAssetRepresentation * representation = [representationsByFilename objectForKey:filename];
+      if (representation == nil)
+      {
+        representation = [assetsLibrary representationWithFilename:filename];
+        if (representation == nil)
+        {
+          NSLog(@"Unable to find asset named %@", filename);
+          [missingFilenames addObject:filename];
+          continue;
+        }
+        
+        [representationsByFilename setObject:representation
+                                      forKey:filename];
+      }
+      
+      [layoutWriter writeLayoutOfRepresentation:representation
+                                           size:(fieldCount >= 3 ? CGSizeMake(width, height) : representation.size)];
+      if (isStandardInput)
+      {
+        [layoutWriter flush];
+      }
+    }
+  }
+  
+  free(line);
+  if (!isStandardInput)
+  {
+    fclose(queriesFile);
+  }
+  
+  if ([missingFilenames count] > 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Unable to answer %lu of %lu queries, including %@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString,
+                                                                    (unsigned long)[missingFilenames count],
+                                                                    (unsigned long)queryCount,
+                                                                    [missingFilenames firstObject]];
+      
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorLayoutFailed
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return YES;
+}
+
+// ===== COMPILE =======================================================================================================
+#pragma mark - Compile
+
+- (BOOL)performCompile:(NSError * __autoreleasing *)error
+{
+  NSError * localError = nil;
+  VPLAssetsLibrary * assetsLibrary = [VPLAssetsLibrary assetsLibraryWithPath:self.libraryPath
+                                                                     error:&localError];
+  if (assetsLibrary == nil)
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToLoadAssetsLibrary
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to load assets library", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  if (![VPLCompiledLibrary writeAssetsLibrary:assetsLibrary
+                                       toFile:self.compiledLibraryPath
+                                        error:&localError])
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToWriteCompiledLibrary
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to write compiled library", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return YES;
+}
+
+// ===== BENCHMARK =====================================================================================================
+#pragma mark - Benchmark
+
+- (BOOL)performBenchmark:(NSError * __autoreleasing *)error
+{
+  VPLBenchmark * benchmark = [[VPLBenchmark alloc] initWithScale:self.benchmarkScale];
+  NSDictionary * results = [benchmark run];
+  
+  // write the results
+  NSError * localError = nil;
+  NSData * resultsData = [NSJSONSerialization dataWithJSONObject:results
+                                                         options:NSJSONWritingPrettyPrinted
+                                                           error:&localError];
+  
+  BOOL didWrite = NO;
+  if (resultsData != nil)
+  {
+    if (self.benchmarkOutputPath != nil)
+    {
+      didWrite = [resultsData writeToFile:self.benchmarkOutputPath
+                                  options:NSDataWritingAtomic
+                                    error:&localError];
+    }
+    else
+    {
+      [[NSFileHandle fileHandleWithStandardOutput] writeData:resultsData];
+      didWrite = YES;
+    }
+  }
+  
+  if (!didWrite)
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToWriteBenchmarkResults
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to write benchmark results", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  if (self.benchmarkBaselinePath == nil)
+  {
+    return YES;
+  }
+  
+  // compare them against the baseline
+  NSDictionary * baseline = nil;
+  NSData * baselineData = [NSData dataWithContentsOfFile:self.benchmarkBaselinePath
+                                                 options:0
+                                                   error:&localError];
+  if (baselineData != nil)
+  {
+    baseline = [NSJSONSerialization JSONObjectWithData:baselineData
+                                               options:0
+                                                 error:&localError];
+  }
+  
+  if (![baseline isKindOfClass:[NSDictionary class]])
   {
-    NSUInteger matchingIndex = [asset.representations indexOfObjectPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+    if (error != NULL)
+    {
+      NSMutableDictionary * userInfo = [[NSMutableDictionary alloc] init];
+      userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Unable to load benchmark baseline", nil);
+      if (localError != nil)
+      {
+        userInfo[NSUnderlyingErrorKey] = localError;
+      }
       
-      return [((VPLAssetRepresentation *)obj).filename isEqualToString:self.assetName];
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToLoadBenchmarkBaseline
+                               userInfo:userInfo];
+    }
+    
+    return NO;
+  }
+  
+  NSArray * regressions = [VPLBenchmark regressionsInResults:results
+                                          comparedToBaseline:baseline
+                                                   threshold:VPLCassowaryCLBenchmarkRegressionThreshold];
+  if ([regressions count] > 0)
+  {
+    if (error != NULL)
+    {
+      NSString * localizedFormatString = NSLocalizedString(@"Benchmark regressed:\n%@", nil);
+      NSString * localizedErrorMessage = [NSString stringWithFormat:localizedFormatString,
+                                                                    [regressions componentsJoinedByString:@"\n"]];
       
-    }];
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorBenchmarkRegression
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : localizedErrorMessage
+                
+                }];
+    }
     
-    if (matchingIndex != NSNotFound)
+    return NO;
+  }
+  
+  return YES;
+}
+
+// ===== EXECUTE =======================================================================================================
+#pragma mark - Execute
+
+- (BOOL)perform:(NSError * __autoreleasing *)error
+{
+  if (self.layoutCachePath == nil)
+  {
+    return [self performInstrumentedCommand:error];
+  }
+  
+  // a missing or unreadable cache just means every layout is solved this time
+  VPLLayoutCache * layoutCache = [[VPLLayoutCache alloc] init];
+  if ([[NSFileManager defaultManager] fileExistsAtPath:self.layoutCachePath])
+  {
+    NSError * readError = nil;
+    if (![layoutCache readFromFile:self.layoutCachePath
+                             error:&readError])
     {
-      matchingAssetRepresentation = [asset.representations objectAtIndex:matchingIndex];
-      break;
+      NSLog(@"Ignoring layout cache: %@", [readError localizedDescription]);
     }
   }
   
+  [VPLLayoutCache setSharedLayoutCache:layoutCache];
+  BOOL didPerform = [self performInstrumentedCommand:error];
+  [VPLLayoutCache setSharedLayoutCache:nil];
+  
+  NSError * localError = nil;
+  if (![layoutCache writeToFile:self.layoutCachePath
+                          error:&localError])
+  {
+    if (didPerform && error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToWriteLayoutCache
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to write layout cache", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return didPerform;
+}
+
+- (BOOL)performInstrumentedCommand:(NSError * __autoreleasing *)error
+{
+  if (self.instrumentationPath == nil)
+  {
+    return [self performCommand:error];
+  }
+  
+  [VPLInstrumentation reset];
+  [VPLInstrumentation setEnabled:YES];
+  
+  BOOL didPerform = [self performCommand:error];
+  
+  [VPLInstrumentation setEnabled:NO];
+  
+  // the statistics are written even if the command failed, since they may show why
+  NSError * localError = nil;
+  NSData * statisticsData = [NSJSONSerialization dataWithJSONObject:[VPLInstrumentation statistics]
+                                                            options:NSJSONWritingPrettyPrinted
+                                                              error:&localError];
+  if (statisticsData == nil
+      || ![statisticsData writeToFile:self.instrumentationPath
+                              options:NSDataWritingAtomic
+                                error:&localError])
+  {
+    if (didPerform && error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToWriteInstrumentation
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to write instrumentation statistics", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  return didPerform;
+}
+
+- (BOOL)performCommand:(NSError * __autoreleasing *)error
+{
+  if (self.isBenchmark)
+  {
+    return [self performBenchmark:error];
+  }
+  
+  if (self.isBatch)
+  {
+    return [self performBatch:error];
+  }
+  
+  if (self.isLayout)
+  {
+    return [self performLayout:error];
+  }
+  
+  if (self.isCompile)
+  {
+    return [self performCompile:error];
+  }
+  
+  return [self performDraw:error];
+}
+
+- (BOOL)performDraw:(NSError * __autoreleasing *)error
+{
+  // create the asset library
+  NSError * localError = nil;
+  VPLAssetsLibrary * assetsLibrary = [VPLAssetsLibrary assetsLibraryWithPath:self.libraryPath
+                                                                     error:&localError];
+  if (assetsLibrary == nil)
+  {
+    if (error != NULL)
+    {
+      *error = [NSError errorWithDomain:VPLCassowaryCLDomain
+                                   code:VPLCassowaryCLErrorUnableToLoadAssetsLibrary
+                               userInfo:@{
+                
+             NSLocalizedDescriptionKey : NSLocalizedString(@"Unable to load assets library", nil),
+                  NSUnderlyingErrorKey : localError
+                
+                }];
+    }
+    
+    return NO;
+  }
+  
+  // find the asset
+  VPLAssetRepresentation * matchingAssetRepresentation = [assetsLibrary representationWithFilename:self.assetName];
+  
   if (matchingAssetRepresentation == nil)
   {
     if (error != NULL)
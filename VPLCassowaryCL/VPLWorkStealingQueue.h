@@ -0,0 +1,36 @@
+#import <Foundation/Foundation.h>
+
+/**
+ * Runs a fixed set of tasks on a pool of worker threads. Each worker starts with a contiguous share of the tasks in a
+ * deque of its own, and takes work from the back of it. A worker whose deque is empty steals from the front of another
+ * worker's, so a few expensive tasks don't leave the other workers idle, and workers rarely contend for the same end.
+ */
+@interface VPLWorkStealingQueue : NSObject
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+/**
+ * A `workerCount` of 0 uses one worker per active processor.
+ */
+- (instancetype)initWithWorkerCount:(NSUInteger)workerCount;
+
+@property (nonatomic, assign, readonly) NSUInteger workerCount;
+
+// ===== PERFORMING ====================================================================================================
+#pragma mark - Performing
+
+/**
+ * Calls `block` once for each task, and returns when every task has finished. `workerIndex` identifies the worker
+ * running the task, for per-worker state. The block must be safe to call from several threads at once.
+ */
+- (void)performTasks:(NSArray *)tasks
+          usingBlock:(void (^)(id task, NSUInteger workerIndex))block;
+
+/**
+ * The number of tasks that were run by a worker other than the one they were first given to, during the last
+ * `-performTasks:usingBlock:`.
+ */
+@property (nonatomic, assign, readonly) NSUInteger stolenTaskCount;
+
+@end
@@ -0,0 +1,139 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLWorkStealingQueue.h"
+#import <pthread.h>
+#import <stdatomic.h>
+
+/**
+ * Tasks are never added once started, so each worker's deque is just the range of task indexes `[front, back)` that it
+ * hasn't started yet.
+ */
+typedef struct _VPLWorkStealingDeque {
+
+  pthread_mutex_t lock;
+  NSUInteger front;
+  NSUInteger back;
+
+} VPLWorkStealingDeque;
+
+static BOOL
+VPLWorkStealingDequePopBack(VPLWorkStealingDeque * deque, NSUInteger * taskIndex)
+{
+  pthread_mutex_lock(&deque->lock);
+  BOOL didPop = deque->front < deque->back;
+  if (didPop)
+  {
+    deque->back--;
+    *taskIndex = deque->back;
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return didPop;
+}
+
+static BOOL
+VPLWorkStealingDequePopFront(VPLWorkStealingDeque * deque, NSUInteger * taskIndex)
+{
+  pthread_mutex_lock(&deque->lock);
+  BOOL didPop = deque->front < deque->back;
+  if (didPop)
+  {
+    *taskIndex = deque->front;
+    deque->front++;
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  return didPop;
+}
+
+@implementation VPLWorkStealingQueue
+
+// ===== INITIALIZATION ================================================================================================
+#pragma mark - Initialization
+
+- (instancetype)init
+{
+  return [self initWithWorkerCount:0];
+}
+
+- (instancetype)initWithWorkerCount:(NSUInteger)workerCount
+{
+  self = [super init];
+  if (self != nil)
+  {
+    _workerCount = (workerCount > 0 ? workerCount : [[NSProcessInfo processInfo] activeProcessorCount]);
+  }
+  return self;
+}
+
+// ===== PERFORMING ====================================================================================================
+#pragma mark - Performing
+
+- (void)performTasks:(NSArray *)tasks
+          usingBlock:(void (^)(id task, NSUInteger workerIndex))block
+{
+  NSUInteger taskCount = [tasks count];
+  NSUInteger workerCount = MAX((NSUInteger)1, MIN(self.workerCount, taskCount));
+  if (taskCount == 0)
+  {
+    _stolenTaskCount = 0;
+    return;
+  }
+
+  // give each worker a contiguous share of the tasks
+  VPLWorkStealingDeque * deques = calloc(workerCount, sizeof(VPLWorkStealingDeque));
+  for (NSUInteger workerIndex = 0; workerIndex < workerCount; workerIndex++)
+  {
+    pthread_mutex_init(&deques[workerIndex].lock, NULL);
+    deques[workerIndex].front = taskCount * workerIndex / workerCount;
+    deques[workerIndex].back = taskCount * (workerIndex + 1) / workerCount;
+  }
+
+  // dispatch_apply doesn't return until every worker has finished, so the workers can share the count on the stack
+  _Atomic NSUInteger stolenTaskCount = 0;
+  _Atomic NSUInteger * sharedStolenTaskCount = &stolenTaskCount;
+
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply(workerCount, queue, ^(size_t workerIndex) {
+
+    NSUInteger taskIndex = 0;
+    while (YES)
+    {
+      BOOL didStealTask = NO;
+      BOOL hasTask = VPLWorkStealingDequePopBack(&deques[workerIndex], &taskIndex);
+
+      // Out of work, so steal from the others, starting with the next worker along. Tasks are never added, so once
+      // every deque has been found empty there's nothing left to do.
+      for (NSUInteger offset = 1; !hasTask && offset < workerCount; offset++)
+      {
+        hasTask = VPLWorkStealingDequePopFront(&deques[(workerIndex + offset) % workerCount], &taskIndex);
+        didStealTask = hasTask;
+      }
+
+      if (!hasTask) break;
+
+      if (didStealTask)
+      {
+        atomic_fetch_add_explicit(sharedStolenTaskCount, 1, memory_order_relaxed);
+      }
+
+      @autoreleasepool
+      {
+        block([tasks objectAtIndex:taskIndex], workerIndex);
+      }
+    }
+
+  });
+
+  for (NSUInteger workerIndex = 0; workerIndex < workerCount; workerIndex++)
+  {
+    pthread_mutex_destroy(&deques[workerIndex].lock);
+  }
+  free(deques);
+
+  _stolenTaskCount = atomic_load(&stolenTaskCount);
+}
+
+@end
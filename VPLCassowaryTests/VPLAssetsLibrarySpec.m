@@ -0,0 +1,233 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLAssetsLibrary.h"
+#import "VPLAsset.h"
+#import "VPLAssetRepresentation.h"
+
+static NSDictionary *
+VPLAssetsLibrarySpecRepresentationDictionary(NSString * filename, CGFloat width, CGFloat height)
+{
+  return @{
+    @"filename" : filename,
+    @"size" : @[ @(width), @(height) ],
+    @"rootLayer" : @{ @"identifier" : @"root" },
+  };
+}
+
+/**
+ * A JSON library with two assets. Both have a representation named `shared.png`, of different sizes, and the second
+ * also has one whose constraint has a strength that doesn't exist, so that it's valid JSON but not a representation.
+ */
+static NSData *
+VPLAssetsLibrarySpecJSONData(void)
+{
+  NSDictionary * malformedRepresentation = @{
+    @"filename" : @"malformed.png",
+    @"size" : @[ @10, @10 ],
+    @"rootLayer" : @{
+      @"identifier" : @"root",
+      @"constraints" : @[ @{ @"subject" : @"root", @"attribute" : @"width", @"relationship" : @"==",
+                             @"strength" : @"bogus" } ],
+    },
+  };
+
+  NSDictionary * libraryDictionary = @{
+    @"assets" : @[
+      @{
+        @"title" : @"First",
+        @"representations" : @[ VPLAssetsLibrarySpecRepresentationDictionary(@"first.png", 100, 50),
+                                VPLAssetsLibrarySpecRepresentationDictionary(@"shared.png", 200, 100) ],
+      },
+      @{
+        @"title" : @"Second",
+        @"representations" : @[ VPLAssetsLibrarySpecRepresentationDictionary(@"shared.png", 300, 150),
+                                malformedRepresentation,
+                                VPLAssetsLibrarySpecRepresentationDictionary(@"second@2x.png", 400, 200) ],
+      },
+    ],
+  };
+
+  NSError * error = nil;
+  NSData * data = [NSJSONSerialization dataWithJSONObject:libraryDictionary
+                                                  options:0
+                                                    error:&error];
+  RAISE_SPEC_ERROR(error, @"Couldn't write JSON library");
+  return data;
+}
+
+SpecBegin(VPLAssetsLibrary)
+
+describe(@"VPLAssetsLibrary", ^{
+
+  describe(@"loaded from JSON", ^{
+
+    __block NSString * path = nil;
+    __block VPLAssetsLibrary * assetsLibrary = nil;
+
+    beforeEach(^{
+      path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+      [VPLAssetsLibrarySpecJSONData() writeToFile:path
+                                       atomically:YES];
+
+      NSError * error = nil;
+      assetsLibrary = [VPLAssetsLibrary assetsLibraryWithPath:path
+                                                        error:&error];
+      RAISE_SPEC_ERROR(error, @"Couldn't load JSON library");
+    });
+
+    afterEach(^{
+      assetsLibrary = nil;
+      [[NSFileManager defaultManager] removeItemAtPath:path
+                                                 error:NULL];
+      path = nil;
+    });
+
+    it(@"scans every asset", ^{
+      expect([assetsLibrary.assets valueForKey:@"title"]).to.equal((@[ @"First", @"Second" ]));
+    });
+
+    it(@"parses a representation again once it's been freed", ^{
+      __weak VPLAssetRepresentation * freedRepresentation = nil;
+      @autoreleasepool
+      {
+        VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:@"first.png"];
+        expect(representation.size.width).to.equal(100);
+        expect([assetsLibrary representationWithFilename:@"first.png"]).to.beIdenticalTo(representation);
+        freedRepresentation = representation;
+      }
+      expect(freedRepresentation).to.beNil();
+
+      VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:@"first.png"];
+      expect(representation.filename).to.equal(@"first.png");
+      expect(representation.size.width).to.equal(100);
+      expect(representation.size.height).to.equal(50);
+    });
+
+    it(@"returns the first representation with a filename", ^{
+      VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:@"shared.png"];
+      expect(representation.size.width).to.equal(200);
+      expect(representation.asset).to.beIdenticalTo([assetsLibrary.assets objectAtIndex:0]);
+    });
+
+    it(@"returns nil for a filename that isn't in the library", ^{
+      expect([assetsLibrary representationWithFilename:@"missing.png"]).to.beNil();
+    });
+
+    it(@"loads a malformed representation as nil, and the rest of the library as usual", ^{
+      expect([assetsLibrary representationWithFilename:@"malformed.png"]).to.beNil();
+      expect([assetsLibrary representationWithFilename:@"second@2x.png"].size.width).to.equal(400);
+
+      VPLAsset * secondAsset = [assetsLibrary.assets objectAtIndex:1];
+      expect([secondAsset.representations valueForKey:@"filename"]).to.equal((@[ @"shared.png", @"second@2x.png" ]));
+    });
+
+    it(@"matches filenames against a pattern, once each", ^{
+      expect([assetsLibrary representationFilenamesMatchingPattern:@"s*.png"]).to.equal((@[ @"shared.png",
+                                                                                            @"second@2x.png" ]));
+      expect([assetsLibrary representationFilenamesMatchingPattern:@"*@2x.png"]).to.equal(@[ @"second@2x.png" ]);
+      expect([assetsLibrary representationFilenamesMatchingPattern:nil]).to.haveCountOf(4);
+    });
+
+    it(@"matches every representation against a pattern, leaving out malformed ones", ^{
+      NSArray * representations = [assetsLibrary representationsMatchingPattern:@"s*.png"];
+      expect([representations valueForKey:@"filename"]).to.equal((@[ @"shared.png", @"shared.png", @"second@2x.png" ]));
+      expect([assetsLibrary representationsMatchingPattern:nil]).to.haveCountOf(4);
+    });
+
+  });
+
+  describe(@"loading on demand", ^{
+
+    __block NSMutableArray * loadedFilenames = nil;
+    __block VPLAssetsLibrary * assetsLibrary = nil;
+
+    beforeEach(^{
+      loadedFilenames = [[NSMutableArray alloc] init];
+      NSArray * representationFilenames = @[ @[ @"a.png", @"a@2x.png" ], @[ @"a.png", [NSNull null] ] ];
+      VPLAssetRepresentation * (^loader)(VPLAsset *, NSUInteger, NSUInteger) =
+        ^VPLAssetRepresentation *(VPLAsset * asset, NSUInteger assetIndex, NSUInteger representationIndex) {
+          id filename = representationFilenames[assetIndex][representationIndex];
+          [loadedFilenames addObject:filename];
+          return [[VPLAssetRepresentation alloc] initWithAsset:asset
+                                                      filename:(filename != [NSNull null] ? filename : nil)
+                                                          size:CGSizeMake(assetIndex + 1, representationIndex + 1)
+                                                     rootLayer:nil];
+        };
+
+      assetsLibrary = [VPLAssetsLibrary assetsLibraryWithAssetTitles:@[ @"A", [NSNull null] ]
+                                             representationFilenames:representationFilenames
+                                                              loader:loader];
+    });
+
+    afterEach(^{
+      assetsLibrary = nil;
+      loadedFilenames = nil;
+    });
+
+    it(@"creates nothing until a representation is looked up", ^{
+      expect(assetsLibrary.assets).to.haveCountOf(2);
+      expect([[assetsLibrary.assets objectAtIndex:1] title]).to.beNil();
+      expect(loadedFilenames).to.haveCountOf(0);
+    });
+
+    it(@"creates only the representation that's looked up, and again after it's freed", ^{
+      @autoreleasepool
+      {
+        VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:@"a@2x.png"];
+        expect([assetsLibrary representationWithFilename:@"a@2x.png"]).to.beIdenticalTo(representation);
+        expect(loadedFilenames).to.equal(@[ @"a@2x.png" ]);
+      }
+
+      expect([assetsLibrary representationWithFilename:@"a@2x.png"].size.height).to.equal(2);
+      expect(loadedFilenames).to.equal((@[ @"a@2x.png", @"a@2x.png" ]));
+    });
+
+    it(@"looks up the first representation with a filename, without creating the others", ^{
+      VPLAssetRepresentation * representation = [assetsLibrary representationWithFilename:@"a.png"];
+      expect(representation.size.width).to.equal(1);
+      expect(representation.asset).to.beIdenticalTo([assetsLibrary.assets objectAtIndex:0]);
+      expect(loadedFilenames).to.equal(@[ @"a.png" ]);
+    });
+
+    it(@"matches filenames without creating representations", ^{
+      expect([assetsLibrary representationFilenamesMatchingPattern:@"a*.png"]).to.equal((@[ @"a.png", @"a@2x.png" ]));
+      expect([assetsLibrary representationFilenamesMatchingPattern:nil]).to.equal((@[ @"a.png", @"a@2x.png" ]));
+      expect(loadedFilenames).to.haveCountOf(0);
+    });
+
+    it(@"creates every matching representation when they're asked for", ^{
+      NSArray * representations = [assetsLibrary representationsMatchingPattern:@"a.png"];
+      expect([representations valueForKey:@"asset"]).to.equal(assetsLibrary.assets);
+      expect(loadedFilenames).to.equal((@[ @"a.png", @"a.png" ]));
+    });
+
+  });
+
+  describe(@"made from assets", ^{
+
+    it(@"looks up the first representation with a filename", ^{
+      NSArray * (^representationFactory)(VPLAsset *) = ^NSArray *(VPLAsset * asset) {
+        return @[ [[VPLAssetRepresentation alloc] initWithAsset:asset
+                                                       filename:@"shared.png"
+                                                           size:CGSizeMake(10, 10)
+                                                      rootLayer:nil] ];
+      };
+      VPLAsset * firstAsset = [[VPLAsset alloc] initWithTitle:@"First"
+                                        representationFactory:representationFactory];
+      VPLAsset * secondAsset = [[VPLAsset alloc] initWithTitle:@"Second"
+                                         representationFactory:representationFactory];
+      VPLAssetsLibrary * assetsLibrary = [VPLAssetsLibrary assetsLibraryWithAssets:@[ firstAsset, secondAsset ]];
+
+      expect([assetsLibrary representationWithFilename:@"shared.png"].asset).to.beIdenticalTo(firstAsset);
+      expect([assetsLibrary representationFilenamesMatchingPattern:nil]).to.equal(@[ @"shared.png" ]);
+      expect([assetsLibrary representationsMatchingPattern:nil]).to.haveCountOf(2);
+    });
+
+  });
+
+});
+
+SpecEnd
@@ -0,0 +1,238 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLCompiledLibrary.h"
+#import "VPLAssetsLibrary.h"
+#import "VPLAsset.h"
+#import "VPLAssetRepresentation.h"
+#import "VPLLayer.h"
+#import "VPLLayoutConstraint.h"
+#import "VPLConstraint.h"
+
+static VPLLayoutConstraint *
+VPLCompiledLibrarySpecLayoutConstraint(NSString * subject,
+                                       NSString * attribute,
+                                       NSString * relationship,
+                                       NSString * relatedObject,
+                                       CGFloat constant,
+                                       NSString * strength)
+{
+  NSMutableDictionary * dictionary = [@{
+    @"subject" : subject,
+    @"attribute" : attribute,
+    @"relationship" : relationship,
+    @"relatedObject" : relatedObject,
+    @"relatedAttribute" : attribute,
+    @"relatedAttributeConstant" : @(constant),
+  } mutableCopy];
+  if (strength != nil)
+  {
+    dictionary[@"strength"] = strength;
+  }
+
+  NSError * error = nil;
+  VPLLayoutConstraint * layoutConstraint = [[VPLLayoutConstraint alloc] initWithDictionary:dictionary
+                                                                                     error:&error];
+  RAISE_SPEC_ERROR(error, @"Couldn't make layout constraint");
+  return layoutConstraint;
+}
+
+/**
+ * A library with one asset, whose representation's tree has sublayers two levels deep, so that the breadth first
+ * order of the layers differs from the depth first one.
+ */
+static NSData *
+VPLCompiledLibrarySpecData(void)
+{
+  VPLLayoutConstraint * requiredConstraint = VPLCompiledLibrarySpecLayoutConstraint(@"a", @"x", @"==", @"root", 10,
+                                                                                     nil);
+  VPLLayoutConstraint * strongConstraint = VPLCompiledLibrarySpecLayoutConstraint(@"c", @"width", @"<=", @"a", -20,
+                                                                                   @"strong");
+  VPLLayoutConstraint * weakConstraint = VPLCompiledLibrarySpecLayoutConstraint(@"b", @"height", @">=", @"a", 5,
+                                                                                 @"weak");
+
+  VPLLayer * rootLayer = [[VPLLayer alloc] initWithIdentifier:@"root"
+                                            layoutConstraints:@[ requiredConstraint ]];
+  VPLLayer * aLayer = [[VPLLayer alloc] initWithIdentifier:@"a"
+                                         layoutConstraints:@[ strongConstraint ]];
+  VPLLayer * bLayer = [[VPLLayer alloc] initWithIdentifier:@"b"
+                                         layoutConstraints:@[ weakConstraint ]];
+  VPLLayer * cLayer = [[VPLLayer alloc] initWithIdentifier:@"c"];
+  cLayer.text = @"Hello";
+
+  [rootLayer addSublayer:aLayer];
+  [rootLayer addSublayer:bLayer];
+  [aLayer addSublayer:cLayer];
+
+  VPLAsset * asset = [[VPLAsset alloc] initWithTitle:@"Title"
+                               representationFactory:^NSArray *(VPLAsset * asset) {
+                                 return @[ [[VPLAssetRepresentation alloc] initWithAsset:asset
+                                                                                filename:@"title.png"
+                                                                                    size:CGSizeMake(150, 100)
+                                                                               rootLayer:rootLayer] ];
+                               }];
+
+  return [VPLCompiledLibrary dataWithAssetsLibrary:[VPLAssetsLibrary assetsLibraryWithAssets:@[ asset ]]];
+}
+
+/**
+ * Returns `data` with `length` bytes at `offset` replaced by `bytes`.
+ */
+static NSData *
+VPLCompiledLibrarySpecDataReplacingBytes(NSData * data, NSUInteger offset, const void * bytes, NSUInteger length)
+{
+  NSMutableData * mutableData = [data mutableCopy];
+  [mutableData replaceBytesInRange:NSMakeRange(offset, length) withBytes:bytes];
+  return mutableData;
+}
+
+SpecBegin(VPLCompiledLibrary)
+
+describe(@"VPLCompiledLibrary", ^{
+
+  __block NSData * data = nil;
+
+  beforeEach(^{
+    data = VPLCompiledLibrarySpecData();
+  });
+
+  afterEach(^{
+    data = nil;
+  });
+
+  describe(@"reading what it wrote", ^{
+
+    __block VPLAssetsLibrary * assetsLibrary = nil;
+    __block VPLAssetRepresentation * representation = nil;
+
+    beforeEach(^{
+      NSError * error = nil;
+      assetsLibrary = [VPLCompiledLibrary assetsLibraryWithData:data
+                                                         error:&error];
+      RAISE_SPEC_ERROR(error, @"Couldn't read compiled library");
+
+      expect([assetsLibrary.assets count]).to.equal(1);
+      VPLAsset * asset = [assetsLibrary.assets objectAtIndex:0];
+      expect(asset.title).to.equal(@"Title");
+      expect([asset.representations count]).to.equal(1);
+      representation = [asset.representations objectAtIndex:0];
+    });
+
+    afterEach(^{
+      assetsLibrary = nil;
+      representation = nil;
+    });
+
+    it(@"is recognized as a compiled library", ^{
+      expect([VPLCompiledLibrary isCompiledLibraryData:data]).to.beTruthy();
+    });
+
+    it(@"keeps representations' filenames and sizes", ^{
+      expect(representation.filename).to.equal(@"title.png");
+      expect(representation.size.width).to.equal(150);
+      expect(representation.size.height).to.equal(100);
+    });
+
+    it(@"keeps the layer tree and its order", ^{
+      VPLLayer * rootLayer = representation.rootLayer;
+      expect(rootLayer.identifier).to.equal(@"root");
+      expect([rootLayer.sublayers valueForKey:@"identifier"]).to.equal((@[ @"a", @"b" ]));
+
+      VPLLayer * aLayer = [rootLayer.sublayers objectAtIndex:0];
+      VPLLayer * bLayer = [rootLayer.sublayers objectAtIndex:1];
+      expect([aLayer.sublayers valueForKey:@"identifier"]).to.equal(@[ @"c" ]);
+      expect(bLayer.sublayers).to.haveCountOf(0);
+
+      VPLLayer * cLayer = [aLayer.sublayers objectAtIndex:0];
+      expect(cLayer.text).to.equal(@"Hello");
+      expect(cLayer.superlayer).to.beIdenticalTo(aLayer);
+    });
+
+    it(@"keeps layout constraints and the constraints they build", ^{
+      VPLLayer * rootLayer = representation.rootLayer;
+      VPLLayer * aLayer = [rootLayer.sublayers objectAtIndex:0];
+
+      VPLLayoutConstraint * layoutConstraint = [aLayer.layoutConstraints objectAtIndex:0];
+      expect(layoutConstraint.subject).to.equal(@"c");
+      expect(layoutConstraint.attribute).to.equal(@"width");
+      expect(layoutConstraint.relationship).to.equal(@"<=");
+      expect(layoutConstraint.relatedObject).to.equal(@"a");
+      expect(layoutConstraint.relatedObjectAttributeOffset).to.equal(-20);
+
+      VPLConstraint * expectedConstraint = VPLCompiledLibrarySpecLayoutConstraint(@"c", @"width", @"<=", @"a", -20,
+                                                                                  @"strong").constraint;
+      expect(layoutConstraint.constraint.relation).to.equal(VPLConstraintRelationLessThanOrEqual);
+      expect(layoutConstraint.constraint.expression).to.equal(expectedConstraint.expression);
+      expect(layoutConstraint.constraint.markerCoefficient).to.equal(expectedConstraint.markerCoefficient);
+    });
+
+    it(@"keeps constraints' strengths", ^{
+      VPLLayer * rootLayer = representation.rootLayer;
+      VPLLayer * aLayer = [rootLayer.sublayers objectAtIndex:0];
+      VPLLayer * bLayer = [rootLayer.sublayers objectAtIndex:1];
+      VPLLayoutConstraint * requiredConstraint = [rootLayer.layoutConstraints objectAtIndex:0];
+      VPLLayoutConstraint * strongConstraint = [aLayer.layoutConstraints objectAtIndex:0];
+      VPLLayoutConstraint * weakConstraint = [bLayer.layoutConstraints objectAtIndex:0];
+
+      expect(requiredConstraint.strength).to.equal(VPLConstraintStrengthRequired);
+      expect(requiredConstraint.constraint.strength).to.equal(VPLConstraintStrengthRequired);
+      expect(strongConstraint.strength).to.equal(VPLConstraintStrengthStrong);
+      expect(strongConstraint.constraint.strength).to.equal(VPLConstraintStrengthStrong);
+      expect(weakConstraint.strength).to.equal(VPLConstraintStrengthWeak);
+      expect(weakConstraint.constraint.strength).to.equal(VPLConstraintStrengthWeak);
+    });
+
+  });
+
+  describe(@"rejecting invalid data", ^{
+
+    it(@"rejects data that's shorter than its header", ^{
+      NSError * error = nil;
+      NSData * truncatedData = [data subdataWithRange:NSMakeRange(0, 16)];
+      expect([VPLCompiledLibrary assetsLibraryWithData:truncatedData error:&error]).to.beNil();
+      expect(error.domain).to.equal(VPLCompiledLibraryErrorDomain);
+      expect(error.code).to.equal(VPLCompiledLibraryErrorInvalidContents);
+    });
+
+    it(@"rejects data whose tables are cut off", ^{
+      NSError * error = nil;
+      NSData * truncatedData = [data subdataWithRange:NSMakeRange(0, [data length] - 8)];
+      expect([VPLCompiledLibrary assetsLibraryWithData:truncatedData error:&error]).to.beNil();
+      expect(error.domain).to.equal(VPLCompiledLibraryErrorDomain);
+      expect(error.code).to.equal(VPLCompiledLibraryErrorInvalidContents);
+    });
+
+    it(@"rejects data that isn't a compiled library", ^{
+      NSError * error = nil;
+      NSData * otherData = VPLCompiledLibrarySpecDataReplacingBytes(data, 0, "JSON", 4);
+      expect([VPLCompiledLibrary isCompiledLibraryData:otherData]).to.beFalsy();
+      expect([VPLCompiledLibrary assetsLibraryWithData:otherData error:&error]).to.beNil();
+      expect(error.code).to.equal(VPLCompiledLibraryErrorInvalidContents);
+    });
+
+    it(@"rejects data written with the other byte order", ^{
+      // the byte order mark follows the magic number and the version
+      NSError * error = nil;
+      uint16_t swappedByteOrderMark = 0xFFFE;
+      NSData * swappedData = VPLCompiledLibrarySpecDataReplacingBytes(data, 6, &swappedByteOrderMark, 2);
+      expect([VPLCompiledLibrary assetsLibraryWithData:swappedData error:&error]).to.beNil();
+      expect(error.domain).to.equal(VPLCompiledLibraryErrorDomain);
+      expect(error.code).to.equal(VPLCompiledLibraryErrorUnsupportedVersion);
+    });
+
+    it(@"rejects other versions", ^{
+      NSError * error = nil;
+      uint16_t version = 1;
+      NSData * otherVersionData = VPLCompiledLibrarySpecDataReplacingBytes(data, 4, &version, 2);
+      expect([VPLCompiledLibrary assetsLibraryWithData:otherVersionData error:&error]).to.beNil();
+      expect(error.domain).to.equal(VPLCompiledLibraryErrorDomain);
+      expect(error.code).to.equal(VPLCompiledLibraryErrorUnsupportedVersion);
+    });
+
+  });
+
+});
+
+SpecEnd
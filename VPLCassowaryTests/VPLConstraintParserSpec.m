@@ -0,0 +1,81 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLConstraintParser.h"
+#import "VPLConstraint.h"
+#import "VPLLinearExpression.h"
+
+SpecBegin(VPLConstraintParser)
+
+describe(@"VPLConstraintParser", ^{
+
+  describe(@"+ constraintFromString:error:", ^{
+
+    it(@"parses a constraint between two variables", ^{
+      VPLConstraint * constraint = [VPLConstraintParser constraintFromString:@"second.x >= first.x + 10"
+                                                                       error:NULL];
+
+      expect(constraint.variableName).to.equal(@"second.x");
+      expect(constraint.relation).to.equal(VPLConstraintRelationGreaterThanOrEqual);
+      expect(constraint.relatedVariableName).to.equal(@"first.x");
+      expect(constraint.multiplier).to.equal(1);
+      expect(constraint.constant).to.equal(10);
+    });
+
+    it(@"builds the same expression as the equivalent constraint", ^{
+      VPLConstraint * constraint = [VPLConstraintParser constraintFromString:@"x <= y * 2 + 5"
+                                                                       error:NULL];
+      VPLConstraint * otherConstraint = [VPLConstraint constraintWithVariable:@"x"
+                                                                    relatedBy:VPLConstraintRelationLessThanOrEqual
+                                                                   toVariable:@"y"
+                                                                   multiplier:2
+                                                                     constant:5];
+
+      expect(constraint.expression).to.equal(otherConstraint.expression);
+      expect(constraint.markerCoefficient).to.equal(otherConstraint.markerCoefficient);
+    });
+
+    it(@"parses a constraint between arbitrary expressions", ^{
+      VPLConstraint * constraint = [VPLConstraintParser constraintFromString:@"a + b == 2 * c - 4"
+                                                                       error:NULL];
+
+      //   0 = 2c - 4 - a - b
+      // = 4 + a + b - 2c
+      expect(constraint.variableName).to.equal(@"a");
+      expect(constraint.relatedVariableName).to.beNil();
+      expect(constraint.expression).to.equal([VPLLinearExpression expressionFromString:@"4 + a + b - 2c"]);
+    });
+
+  });
+
+  describe(@"- parseConstraints", ^{
+
+    it(@"parses statements separated by newlines and semicolons, skipping comments", ^{
+      NSString * text = @"# header\n"
+                         "a.x == 0; a.width == 100\n"
+                         "\n"
+                         "b.x >= a.x + a.width   # to the right of a\n";
+      VPLConstraintParser * parser = [[VPLConstraintParser alloc] initWithString:text];
+      NSArray * constraints = [parser parseConstraints];
+
+      expect(parser.error).to.beNil();
+      expect([constraints count]).to.equal(3);
+      expect([constraints[2] variableName]).to.equal(@"b.x");
+    });
+
+    it(@"reports the line and column of a syntax error", ^{
+      VPLConstraintParser * parser = [[VPLConstraintParser alloc] initWithString:@"a >= b\nc >> d\n"];
+
+      expect([parser parseConstraints]).to.beNil();
+      expect(parser.error.code).to.equal(VPLConstraintParserErrorInvalidSyntax);
+      NSString * description = [parser.error localizedDescription];
+      expect([description rangeOfString:@"line 2, column 3"].location).notTo.equal(NSNotFound);
+    });
+
+  });
+
+});
+
+SpecEnd
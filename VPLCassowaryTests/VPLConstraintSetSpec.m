@@ -17,6 +17,31 @@ describe(@"VPLConstraintSet", ^{
     constraintSet = nil;
   });
   
+  // markers are handed out by the constraint set, so they're looked up there to find them in the tableau
+  NSString * (^markerVariableName)(VPLConstraint *) = ^NSString * (VPLConstraint * constraint) {
+    VPLVariableID markerVariableID = [constraintSet markerVariableIDForConstraint:constraint];
+    return [[VPLSymbolTable sharedSymbolTable] nameForVariableID:markerVariableID];
+  };
+  
+  // 10 <= x <= 100, y = x + 5
+  NSArray * (^boundedXConstraints)(void) = ^NSArray * (void) {
+    return @[ [VPLConstraint constraintWithVariable:@"x"
+                                          relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                         toVariable:nil
+                                         multiplier:0
+                                           constant:10],
+              [VPLConstraint constraintWithVariable:@"x"
+                                          relatedBy:VPLConstraintRelationLessThanOrEqual
+                                         toVariable:nil
+                                         multiplier:0
+                                           constant:100],
+              [VPLConstraint constraintWithVariable:@"y"
+                                          relatedBy:VPLConstraintRelationEqual
+                                         toVariable:@"x"
+                                         multiplier:1
+                                           constant:5] ];
+  };
+  
   describe(@"- addConstraint:", ^{
     
     describe(@"when there are no constraints", ^{
@@ -50,7 +75,7 @@ describe(@"VPLConstraintSet", ^{
         //   x = 10 + sX
         
         VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                              variableNames:@[ xGTE10.markerVariableName ]
+                                                                              variableNames:@[ markerVariableName(xGTE10) ]
                                                                        variableCoefficients:@[ @(1.0f) ]];
         
         expect([constraintSet.tableau equations]).to.equal(@{ @"x" : expectedExpr });
@@ -113,7 +138,7 @@ describe(@"VPLConstraintSet", ^{
         //
         
         VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                              variableNames:@[ xGTE10.markerVariableName, yEQx.markerVariableName ]
+                                                                              variableNames:@[ markerVariableName(xGTE10), markerVariableName(yEQx) ]
                                                                        variableCoefficients:@[ @(1.0f), @(1.0f) ]];
         
         expect([constraintSet.tableau expressionForRow:@"y"]).to.equal(expectedExpr);
@@ -183,19 +208,19 @@ describe(@"VPLConstraintSet", ^{
         //
         
         VPLLinearExpression * expectedXExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                               variableNames:@[ xGTE10.markerVariableName ]
+                                                                               variableNames:@[ markerVariableName(xGTE10) ]
                                                                        variableCoefficients:@[ @(1.0f) ]];
 
         expect([constraintSet.tableau expressionForRow:@"x"]).to.equal(expectedXExpr);
         
         VPLLinearExpression * expectedSlackXExpr = [VPLLinearExpression expressionWithConstantValue:90
-                                                                                    variableNames:@[ xGTE10.markerVariableName ]
+                                                                                    variableNames:@[ markerVariableName(xGTE10) ]
                                                                              variableCoefficients:@[ @(-1.0f) ]];
-        expect([constraintSet.tableau expressionForRow:xLTE100.markerVariableName]).to.equal(expectedSlackXExpr);
+        expect([constraintSet.tableau expressionForRow:markerVariableName(xLTE100)]).to.equal(expectedSlackXExpr);
         
         expect(constraintSet.tableau.equations).to.equal((@{
                                                          @"x" : expectedXExpr,
-                                                         xLTE100.markerVariableName : expectedSlackXExpr
+                                                         markerVariableName(xLTE100) : expectedSlackXExpr
                                                           }));
       });
       
@@ -229,7 +254,7 @@ describe(@"VPLConstraintSet", ^{
         [constraintSet addConstraint:xEQ50];
         
         expect([constraintSet.tableau expressionForRow:@"x"]).to.equal([VPLLinearExpression expressionWithConstantValue:50
-                                                                                                         variableNames:@[ xEQ50.markerVariableName ]
+                                                                                                         variableNames:@[ markerVariableName(xEQ50) ]
                                                                                                   variableCoefficients:@[ @(-1.0) ]]);
         
         // We add z = 50 the same way
@@ -251,7 +276,7 @@ describe(@"VPLConstraintSet", ^{
         [constraintSet addConstraint:zEQ50];
         
         expect([constraintSet.tableau expressionForRow:@"z"]).to.equal([VPLLinearExpression expressionWithConstantValue:50
-                                                                                                         variableNames:@[ zEQ50.markerVariableName ]
+                                                                                                         variableNames:@[ markerVariableName(zEQ50) ]
                                                                                                   variableCoefficients:@[ @(-1.0) ]]);
         
         // Now we add an equality between z and x
@@ -287,11 +312,11 @@ describe(@"VPLConstraintSet", ^{
       
       it(@"adds the constraint directly after solving for the new dummy variable", ^{
         VPLLinearExpression * expectedD3Expr = [VPLLinearExpression expressionWithConstantValue:0
-                                                                                variableNames:@[ xEQ50.markerVariableName, zEQ50.markerVariableName ]
+                                                                                variableNames:@[ markerVariableName(xEQ50), markerVariableName(zEQ50) ]
                                                                          variableCoefficients:@[ @(-1.0f), @(1.0f) ]];
         
-        expect([constraintSet.tableau expressionForRow:zEQx.markerVariableName]).to.equal(expectedD3Expr);
-        expect([constraintSet.tableau rowVariableNames]).to.equal((VPLSortedVariables(@"x", @"z", zEQx.markerVariableName)));
+        expect([constraintSet.tableau expressionForRow:markerVariableName(zEQx)]).to.equal(expectedD3Expr);
+        expect([constraintSet.tableau rowVariableNames]).to.equal((VPLSortedVariables(@"x", @"z", markerVariableName(zEQx))));
       });
       
     });
@@ -366,20 +391,20 @@ describe(@"VPLConstraintSet", ^{
         });
         
         it(@"removes the artificial variable column", ^{
-          expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", xGTE10.markerVariableName));
-          expect(constraintSet.tableau.columnVariableNames).to.equal(VPLSortedVariables(xGTE20.markerVariableName));
+          expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", markerVariableName(xGTE10)));
+          expect(constraintSet.tableau.columnVariableNames).to.equal(VPLSortedVariables(markerVariableName(xGTE20)));
           
           VPLLinearExpression * expectedXExpr = [VPLLinearExpression expressionWithConstantValue:20
-                                                                                 variableNames:@[ xGTE20.markerVariableName ]
+                                                                                 variableNames:@[ markerVariableName(xGTE20) ]
                                                                           variableCoefficients:@[ @(1) ]];
           
           expect([constraintSet.tableau expressionForRow:@"x"]).to.equal(expectedXExpr);
 
           VPLLinearExpression * expectedXMarkerExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                                 variableNames:@[ xGTE20.markerVariableName ]
+                                                                                 variableNames:@[ markerVariableName(xGTE20) ]
                                                                           variableCoefficients:@[ @(1) ]];
           
-          expect([constraintSet.tableau expressionForRow:xGTE10.markerVariableName]).to.equal(expectedXMarkerExpr);        
+          expect([constraintSet.tableau expressionForRow:markerVariableName(xGTE10)]).to.equal(expectedXMarkerExpr);        
         });
         
       });
@@ -438,7 +463,7 @@ describe(@"VPLConstraintSet", ^{
                                               constant:100];
         [constraintSet addConstraint:xLTE100];
         
-        expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", xLTE100.markerVariableName));
+        expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", markerVariableName(xLTE100)));
         
         [constraintSet removeConstraint:xLTE100];
       });
@@ -448,11 +473,16 @@ describe(@"VPLConstraintSet", ^{
         xLTE100 = nil;
       });
       
+      it(@"no longer contains the constraint", ^{
+        expect([constraintSet containsConstraint:xLTE100]).to.beFalsy();
+        expect([constraintSet containsConstraint:xGTE10]).to.beTruthy();
+      });
+      
       it(@"simply drops the marker variable's row", ^{
         expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x"));
         expect([constraintSet.tableau expressionForRow:@"x"]).to.equal((
           [VPLLinearExpression expressionWithConstantValue:10
-                                            variableNames:@[ xGTE10.markerVariableName ]
+                                            variableNames:@[ markerVariableName(xGTE10) ]
                                      variableCoefficients:@[ @(1.0f) ]]
         ));
       });
@@ -505,7 +535,7 @@ describe(@"VPLConstraintSet", ^{
                                                 constant:100];
           [constraintSet addConstraint:xLTE100];
           
-          expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", xLTE100.markerVariableName));
+          expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", markerVariableName(xLTE100)));
           
           [constraintSet removeConstraint:xGTE10];
         });
@@ -518,7 +548,7 @@ describe(@"VPLConstraintSet", ^{
         it(@"pivot the marker variable into the basis and remove it", ^{
           expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x"));
           expect([constraintSet.tableau expressionForRow:@"x"]).to.equal([VPLLinearExpression expressionWithConstantValue:100
-                                                                                                           variableNames:@[ xLTE100.markerVariableName ]
+                                                                                                           variableNames:@[ markerVariableName(xLTE100) ]
                                                                                                     variableCoefficients:@[ @(-1.0) ]]);
         });
         
@@ -646,20 +676,20 @@ describe(@"VPLConstraintSet", ^{
           });
           
           it(@"pivot the marker variable into the basis using the smallest ratio", ^{
-            expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", xGTE10.markerVariableName));
-            expect(constraintSet.tableau.columnVariableNames).to.equal(VPLSortedVariables(xGTE20.markerVariableName));
+            expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", markerVariableName(xGTE10)));
+            expect(constraintSet.tableau.columnVariableNames).to.equal(VPLSortedVariables(markerVariableName(xGTE20)));
             
             VPLLinearExpression * expectedXExpr = [VPLLinearExpression expressionWithConstantValue:20
-                                                                                   variableNames:@[ xGTE20.markerVariableName ]
+                                                                                   variableNames:@[ markerVariableName(xGTE20) ]
                                                                             variableCoefficients:@[ @(1) ]];
             
             expect([constraintSet.tableau expressionForRow:@"x"]).to.equal(expectedXExpr);
             
             VPLLinearExpression * expectedXMarkerExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                                         variableNames:@[ xGTE20.markerVariableName ]
+                                                                                         variableNames:@[ markerVariableName(xGTE20) ]
                                                                                   variableCoefficients:@[ @(1) ]];
             
-            expect([constraintSet.tableau expressionForRow:xGTE10.markerVariableName]).to.equal(expectedXMarkerExpr);
+            expect([constraintSet.tableau expressionForRow:markerVariableName(xGTE10)]).to.equal(expectedXMarkerExpr);
           });
           
           
@@ -734,7 +764,7 @@ describe(@"VPLConstraintSet", ^{
             expect(constraintSet.tableau.rowVariableNames).to.equal(VPLSortedVariables(@"z"));
             
             VPLLinearExpression * expectedZExpr = [VPLLinearExpression expressionWithConstantValue:0
-                                                                                   variableNames:@[ @"x", zEQx.markerVariableName ]
+                                                                                   variableNames:@[ @"x", markerVariableName(zEQx) ]
                                                                             variableCoefficients:@[ @(1.0f), @(-1.0f) ]];
             expect([constraintSet.tableau expressionForRow:@"z"]).to.equal(expectedZExpr);
           });
@@ -747,6 +777,364 @@ describe(@"VPLConstraintSet", ^{
     
   });
   
+  // ===== BATCHES =====================================================================================================
+#pragma mark - Batches
+  
+  describe(@"- addConstraints:", ^{
+    
+    __block VPLConstraint * xGTE10;
+    __block VPLConstraint * xLTE5;
+    __block VPLConstraint * yEQ2x;
+    __block NSArray * unsatisfiableConstraints;
+    
+    beforeEach(^{
+      constraintSet = [[VPLConstraintSet alloc] init];
+      
+      xGTE10 = [VPLConstraint constraintWithVariable:@"x"
+                                           relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                          toVariable:nil
+                                          multiplier:0
+                                            constant:10];
+      
+      xLTE5 = [VPLConstraint constraintWithVariable:@"x"
+                                          relatedBy:VPLConstraintRelationLessThanOrEqual
+                                         toVariable:nil
+                                         multiplier:0
+                                           constant:5];
+      
+      yEQ2x = [VPLConstraint constraintWithVariable:@"y"
+                                          relatedBy:VPLConstraintRelationEqual
+                                         toVariable:@"x"
+                                         multiplier:2
+                                           constant:0];
+      
+      unsatisfiableConstraints = [constraintSet addConstraints:@[ xGTE10, xLTE5, yEQ2x ]];
+    });
+    
+    afterEach(^{
+      xGTE10 = nil;
+      xLTE5 = nil;
+      yEQ2x = nil;
+      unsatisfiableConstraints = nil;
+    });
+    
+    it(@"returns the constraints that couldn't be satisfied, instead of raising", ^{
+      expect(unsatisfiableConstraints).to.equal(@[ xLTE5 ]);
+    });
+    
+    it(@"adds the rest of the constraints", ^{
+      expect([constraintSet containsConstraint:xGTE10]).to.beTruthy();
+      expect([constraintSet containsConstraint:yEQ2x]).to.beTruthy();
+      expect([constraintSet containsConstraint:xLTE5]).to.beFalsy();
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(10);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(20);
+    });
+    
+  });
+  
+  // ===== EDIT VARIABLES ==============================================================================================
+#pragma mark - Edit Variables
+  
+  describe(@"edit variables", ^{
+    
+    beforeEach(^{
+      constraintSet = [[VPLConstraintSet alloc] init];
+      for (VPLConstraint * constraint in boundedXConstraints())
+      {
+        [constraintSet addConstraint:constraint];
+      }
+      [constraintSet addEditVariable:@"x"];
+    });
+    
+    it(@"holds the edit variable at its current value", ^{
+      expect([constraintSet containsEditVariable:@"x"]).to.beTruthy();
+      expect([constraintSet valueForVariable:@"x"]).to.equal(10);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(15);
+    });
+    
+    it(@"moves the edit variable to a suggested value", ^{
+      [constraintSet suggestValue:50
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(50);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(55);
+    });
+    
+    it(@"keeps required constraints satisfied when a suggestion can't be met", ^{
+      [constraintSet suggestValue:150
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(100);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(105);
+      
+      [constraintSet suggestValue:0
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(10);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(15);
+    });
+    
+    it(@"reads the values of a batch of variables", ^{
+      VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+      VPLVariableID variableIDs[3] = {
+        [symbolTable variableIDForName:@"x"],
+        [symbolTable variableIDForName:@"y"],
+        VPLVariableIDNone,
+      };
+      CGFloat values[3] = { -1, -1, -1 };
+      
+      [constraintSet getValues:values
+                forVariableIDs:variableIDs
+                         count:3];
+      
+      expect(values[0]).to.equal(10);
+      expect(values[1]).to.equal(15);
+      expect(values[2]).to.equal(0);
+    });
+    
+    it(@"reports the variables whose values changed", ^{
+      [constraintSet resetChangedVariableIDs];
+      [constraintSet suggestValue:50
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      
+      VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+      NSIndexSet * changedVariableIDs = [constraintSet changedVariableIDs];
+      expect([changedVariableIDs containsIndex:[symbolTable variableIDForName:@"x"]]).to.beTruthy();
+      expect([changedVariableIDs containsIndex:[symbolTable variableIDForName:@"y"]]).to.beTruthy();
+      
+      [constraintSet resetChangedVariableIDs];
+      expect([[constraintSet changedVariableIDs] count]).to.equal(0);
+    });
+    
+    it(@"stops holding the variable once the edit variable is removed", ^{
+      [constraintSet suggestValue:50
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      [constraintSet removeEditVariable:@"x"];
+      
+      expect([constraintSet containsEditVariable:@"x"]).to.beFalsy();
+      expect([constraintSet valueForVariable:@"y"]).to.equal([constraintSet valueForVariable:@"x"] + 5);
+    });
+    
+  });
+  
+  describe(@"independent components", ^{
+    
+    beforeEach(^{
+      constraintSet = [[VPLConstraintSet alloc] init];
+      
+      [constraintSet addConstraints:@[ [VPLConstraint constraintWithVariable:@"a"
+                                                                   relatedBy:VPLConstraintRelationEqual
+                                                                  toVariable:nil
+                                                                  multiplier:0
+                                                                    constant:10],
+                                       [VPLConstraint constraintWithVariable:@"b"
+                                                                   relatedBy:VPLConstraintRelationEqual
+                                                                  toVariable:@"a"
+                                                                  multiplier:2
+                                                                    constant:0],
+                                       [VPLConstraint constraintWithVariable:@"c"
+                                                                   relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                                  toVariable:nil
+                                                                  multiplier:0
+                                                                    constant:3],
+                                       [VPLConstraint constraintWithVariable:@"d"
+                                                                   relatedBy:VPLConstraintRelationEqual
+                                                                  toVariable:@"c"
+                                                                  multiplier:1
+                                                                    constant:1] ]];
+    });
+    
+    it(@"solves each component", ^{
+      expect([constraintSet valueForVariable:@"a"]).to.equal(10);
+      expect([constraintSet valueForVariable:@"b"]).to.equal(20);
+      expect([constraintSet valueForVariable:@"c"]).to.equal(3);
+      expect([constraintSet valueForVariable:@"d"]).to.equal(4);
+    });
+    
+    it(@"merges components joined by a constraint", ^{
+      [constraintSet addConstraint:[VPLConstraint constraintWithVariable:@"c"
+                                                              relatedBy:VPLConstraintRelationEqual
+                                                             toVariable:@"b"
+                                                             multiplier:1
+                                                               constant:0]];
+      
+      expect([constraintSet valueForVariable:@"b"]).to.equal(20);
+      expect([constraintSet valueForVariable:@"c"]).to.equal(20);
+      expect([constraintSet valueForVariable:@"d"]).to.equal(21);
+    });
+    
+    it(@"keeps each component's preferences and edit variables when they're merged", ^{
+      // both solvers make error variables of their own before they're merged
+      VPLConstraint * cEQ6 = [VPLConstraint constraintWithVariable:@"c"
+                                                        relatedBy:VPLConstraintRelationEqual
+                                                       toVariable:nil
+                                                       multiplier:0
+                                                         constant:6];
+      cEQ6.strength = VPLConstraintStrengthWeak;
+      [constraintSet addConstraint:cEQ6];
+      [constraintSet addEditVariable:@"e"];
+      [constraintSet suggestValue:12
+                      forVariable:@"e"];
+      [constraintSet resolve];
+      
+      [constraintSet addConstraint:[VPLConstraint constraintWithVariable:@"e"
+                                                              relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                             toVariable:@"c"
+                                                             multiplier:1
+                                                               constant:0]];
+      
+      expect([constraintSet valueForVariable:@"c"]).to.equal(6);
+      expect([constraintSet valueForVariable:@"d"]).to.equal(7);
+      expect([constraintSet valueForVariable:@"e"]).to.equal(12);
+      
+      // the edit variable outweighs the weak preference
+      [constraintSet suggestValue:3
+                      forVariable:@"e"];
+      [constraintSet resolve];
+      
+      expect([constraintSet valueForVariable:@"c"]).to.equal(3);
+      expect([constraintSet valueForVariable:@"d"]).to.equal(4);
+      expect([constraintSet valueForVariable:@"e"]).to.equal(3);
+      
+      [constraintSet removeEditVariable:@"e"];
+      [constraintSet removeConstraint:cEQ6];
+      
+      expect([constraintSet containsEditVariable:@"e"]).to.beFalsy();
+      expect([constraintSet valueForVariable:@"c"]).to.beGreaterThanOrEqualTo(3);
+      expect([constraintSet valueForVariable:@"d"]).to.equal([constraintSet valueForVariable:@"c"] + 1);
+      expect([constraintSet valueForVariable:@"e"]).to.beGreaterThanOrEqualTo([constraintSet valueForVariable:@"c"]);
+    });
+    
+  });
+  
+  describe(@"forking", ^{
+    
+    beforeEach(^{
+      constraintSet = [[VPLConstraintSet alloc] init];
+      [constraintSet addConstraints:boundedXConstraints()];
+      [constraintSet addEditVariable:@"x"];
+    });
+    
+    it(@"changes the fork without changing the original", ^{
+      VPLConstraintSet * forkedConstraintSet = [constraintSet constraintSetByForking];
+      [forkedConstraintSet suggestValue:50
+                            forVariable:@"x"];
+      [forkedConstraintSet resolve];
+      
+      expect([forkedConstraintSet valueForVariable:@"y"]).to.equal(55);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(15);
+      expect(constraintSet.tableau.equations).notTo.equal(forkedConstraintSet.tableau.equations);
+    });
+    
+    it(@"applies each variant to a fork of its own", ^{
+      NSArray * variants = @[
+        ^(VPLConstraintSet * forkedConstraintSet) {
+          [forkedConstraintSet suggestValue:40
+                                forVariable:@"x"];
+        },
+        ^(VPLConstraintSet * forkedConstraintSet) {
+          VPLConstraint * yGTE70 = [VPLConstraint constraintWithVariable:@"y"
+                                                               relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                              toVariable:nil
+                                                              multiplier:0
+                                                                constant:70];
+          [forkedConstraintSet addConstraint:yGTE70];
+        },
+      ];
+      NSArray * forkedConstraintSets = [constraintSet constraintSetsByApplyingVariants:variants];
+      
+      expect([forkedConstraintSets[0] valueForVariable:@"y"]).to.equal(45);
+      expect([forkedConstraintSets[1] valueForVariable:@"y"]).to.equal(70);
+      expect([constraintSet valueForVariable:@"y"]).to.equal(15);
+    });
+    
+  });
+  
+  describe(@"strengths", ^{
+    
+    VPLConstraint * (^xConstraint)(VPLConstraintRelation, CGFloat, VPLConstraintStrength) =
+      ^VPLConstraint *(VPLConstraintRelation relation, CGFloat constant, VPLConstraintStrength strength) {
+        VPLConstraint * constraint = [VPLConstraint constraintWithVariable:@"x"
+                                                                 relatedBy:relation
+                                                                toVariable:nil
+                                                                multiplier:0
+                                                                  constant:constant];
+        constraint.strength = strength;
+        return constraint;
+      };
+    
+    beforeEach(^{
+      constraintSet = [[VPLConstraintSet alloc] init];
+    });
+    
+    it(@"satisfies the stronger of two conflicting preferences", ^{
+      VPLConstraint * xEQ10 = xConstraint(VPLConstraintRelationEqual, 10, VPLConstraintStrengthWeak);
+      VPLConstraint * xEQ20 = xConstraint(VPLConstraintRelationEqual, 20, VPLConstraintStrengthStrong);
+      NSArray * unsatisfiableConstraints = [constraintSet addConstraints:@[ xEQ10, xEQ20 ]];
+      
+      expect(unsatisfiableConstraints).to.equal(@[]);
+      expect([constraintSet valueForVariable:@"x"]).to.equal(20);
+      
+      [constraintSet removeConstraint:xEQ20];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(10);
+    });
+    
+    it(@"satisfies preferences as nearly as the required constraints allow", ^{
+      [constraintSet addConstraint:xConstraint(VPLConstraintRelationLessThanOrEqual, 5, VPLConstraintStrengthRequired)];
+      [constraintSet addConstraint:xConstraint(VPLConstraintRelationEqual, 10, VPLConstraintStrengthMedium)];
+      [constraintSet addConstraint:xConstraint(VPLConstraintRelationGreaterThanOrEqual, 8, VPLConstraintStrengthWeak)];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(5);
+    });
+    
+    it(@"gives way to edit variables unless it's strong", ^{
+      [constraintSet addConstraint:xConstraint(VPLConstraintRelationEqual, 10, VPLConstraintStrengthMedium)];
+      [constraintSet addEditVariable:@"x"];
+      [constraintSet suggestValue:30
+                      forVariable:@"x"];
+      [constraintSet resolve];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(30);
+      
+      [constraintSet addConstraint:xConstraint(VPLConstraintRelationLessThanOrEqual, 20, VPLConstraintStrengthStrong)];
+      
+      expect([constraintSet valueForVariable:@"x"]).to.equal(20);
+    });
+    
+    it(@"leaves the symbol table alone as preferences and edit variables come and go", ^{
+      VPLSymbolTable * symbolTable = [VPLSymbolTable sharedSymbolTable];
+      VPLConstraint * xGTE0 = xConstraint(VPLConstraintRelationGreaterThanOrEqual, 0, VPLConstraintStrengthRequired);
+      [constraintSet addConstraint:xGTE0];
+      NSUInteger symbolCount = symbolTable.count;
+      
+      for (NSUInteger round = 0; round < 100; round++)
+      {
+        VPLConstraint * xEQ10 = xConstraint(VPLConstraintRelationEqual, 10, VPLConstraintStrengthWeak);
+        VPLConstraint * xLTE200 = xConstraint(VPLConstraintRelationLessThanOrEqual, 200, VPLConstraintStrengthStrong);
+        [constraintSet addConstraints:@[ xEQ10, xLTE200 ]];
+        [constraintSet addEditVariable:@"x"];
+        [constraintSet suggestValue:round
+                        forVariable:@"x"];
+        [constraintSet resolve];
+        
+        expect([constraintSet valueForVariable:@"x"]).to.equal(round);
+        
+        [constraintSet removeEditVariable:@"x"];
+        [constraintSet removeConstraints:@[ xEQ10, xLTE200 ]];
+      }
+      
+      expect(symbolTable.count).to.equal(symbolCount);
+    });
+    
+  });
+  
 });
 
-SpecEnd
\ No newline at end of file
+SpecEnd
@@ -11,10 +11,19 @@ describe(@"VPLConstraint", ^{
     constraint = nil;
   });
   
+  // constraints are given their markers by the constraint set they're added to, so these give them one of their own
+  VPLVariableID (^markerVariableID)(void) = ^VPLVariableID {
+    return VPLVariableIDMakeAnonymous(0, constraint.markerVariableKind);
+  };
+  
+  NSString * (^markerVariableName)(void) = ^NSString * {
+    return [[VPLSymbolTable sharedSymbolTable] nameForVariableID:markerVariableID()];
+  };
+  
   // ===== EXPRESSION ==================================================================================================
 #pragma mark - Expression
   
-  describe(@"- expression", ^{
+  describe(@"- expressionWithMarkerVariableID:", ^{
     
     describe(@"when the constraint is an equality", ^{
       
@@ -33,13 +42,21 @@ describe(@"VPLConstraint", ^{
           // 0 = 10 + y - x - dX
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                                variableNames:@[ @"y", @"x", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"y", @"x", markerVariableName() ]
                                                                          variableCoefficients:@[ @(1), @(-1), @(-1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a dummy marker variable", ^{
-          expect(VPLLinearExpressionVariableIsDummy(constraint.markerVariableName)).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindDummy);
+        });
+        
+        it(@"leaves the marker out of its expression", ^{
+          VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
+                                                                                variableNames:@[ @"y", @"x" ]
+                                                                         variableCoefficients:@[ @(1), @(-1) ]];
+          expect(constraint.expression).to.equal(expectedExpr);
+          expect(constraint.markerCoefficient).to.equal(-1);
         });
 
       });
@@ -59,13 +76,13 @@ describe(@"VPLConstraint", ^{
           // 0 = 10 - x - dX
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                                variableNames:@[ @"x", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"x", markerVariableName() ]
                                                                          variableCoefficients:@[ @(-1), @(-1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a dummy marker variable", ^{
-          expect(VPLLinearExpressionVariableIsDummy(constraint.markerVariableName)).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindDummy);
         });
         
       });
@@ -91,14 +108,13 @@ describe(@"VPLConstraint", ^{
           // 0 = 2y + 10 - x + sX
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:10
-                                                                                variableNames:@[ @"x", @"y", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"x", @"y", markerVariableName() ]
                                                                          variableCoefficients:@[ @(-1), @(2), @(1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a slack marker variable", ^{
-          expect(constraint.markerVariableName).notTo.beNil();
-          expect([constraint.markerVariableName hasPrefix:VPLLinearExpressionSlackVariablePrefix]).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindSlack);
         });
         
       });
@@ -119,14 +135,13 @@ describe(@"VPLConstraint", ^{
           // x - sX + 3 = 0
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:3
-                                                                                variableNames:@[ @"x", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"x", markerVariableName() ]
                                                                          variableCoefficients:@[ @(1), @(-1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a slack marker variable", ^{
-          expect(constraint.markerVariableName).notTo.beNil();
-          expect([constraint.markerVariableName hasPrefix:VPLLinearExpressionSlackVariablePrefix]).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindSlack);
         });
         
       });
@@ -151,14 +166,13 @@ describe(@"VPLConstraint", ^{
           // x + sX + y + 2 = 0
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:2
-                                                                                variableNames:@[ @"x", @"y", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"x", @"y", markerVariableName() ]
                                                                          variableCoefficients:@[ @(1), @(1), @(1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a slack marker variable", ^{
-          expect(constraint.markerVariableName).notTo.beNil();
-          expect([constraint.markerVariableName hasPrefix:VPLLinearExpressionSlackVariablePrefix]).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindSlack);
         });
         
       });
@@ -179,14 +193,13 @@ describe(@"VPLConstraint", ^{
           // 0 = 32 - x - sX
           
           VPLLinearExpression * expectedExpr = [VPLLinearExpression expressionWithConstantValue:32
-                                                                                variableNames:@[ @"x", constraint.markerVariableName ]
+                                                                                variableNames:@[ @"x", markerVariableName() ]
                                                                          variableCoefficients:@[ @(-1), @(-1) ]];
-          expect(constraint.expression).to.equal(expectedExpr);
+          expect([constraint expressionWithMarkerVariableID:markerVariableID()]).to.equal(expectedExpr);
         });
         
         it(@"has a slack marker variable", ^{
-          expect(constraint.markerVariableName).notTo.beNil();
-          expect([constraint.markerVariableName hasPrefix:VPLLinearExpressionSlackVariablePrefix]).to.beTruthy();
+          expect(constraint.markerVariableKind).to.equal(VPLVariableKindSlack);
         });
         
       });
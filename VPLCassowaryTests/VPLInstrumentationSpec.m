@@ -0,0 +1,139 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLInstrumentation.h"
+#import "VPLConstraintSet.h"
+#import "VPLConstraint.h"
+
+SpecBegin(VPLInstrumentation)
+
+describe(@"VPLInstrumentation", ^{
+
+  beforeEach(^{
+    [VPLInstrumentation reset];
+    [VPLInstrumentation setEnabled:YES];
+  });
+
+  afterEach(^{
+    [VPLInstrumentation setEnabled:NO];
+    [VPLInstrumentation reset];
+  });
+
+  describe(@"counters", ^{
+
+    it(@"adds up amounts", ^{
+      VPLInstrumentationCount(VPLInstrumentationCounterPivots, 3);
+      VPLInstrumentationCount(VPLInstrumentationCounterPivots, 4);
+
+      expect([VPLInstrumentation statistics][@"counters"][@"pivots"]).to.equal(7);
+      expect([VPLInstrumentation statistics][@"counters"][@"substitutions"]).to.equal(0);
+    });
+
+    it(@"records nothing while disabled", ^{
+      [VPLInstrumentation setEnabled:NO];
+      VPLInstrumentationCount(VPLInstrumentationCounterPivots, 3);
+
+      expect([VPLInstrumentation isEnabled]).to.beFalsy();
+      expect([VPLInstrumentation statistics][@"counters"][@"pivots"]).to.equal(0);
+    });
+
+  });
+
+  describe(@"gauges", ^{
+
+    it(@"keeps the largest value recorded", ^{
+      VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauRows, 5);
+      VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauRows, 9);
+      VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauRows, 4);
+
+      expect([VPLInstrumentation statistics][@"gauges"][@"tableauRows"]).to.equal(9);
+    });
+
+    it(@"records the size of the tableau as constraints are added", ^{
+      VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+      [constraintSet addConstraints:@[ [VPLConstraint constraintWithVariable:@"x"
+                                                                   relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                                                  toVariable:nil
+                                                                  multiplier:0
+                                                                    constant:10],
+                                       [VPLConstraint constraintWithVariable:@"y"
+                                                                   relatedBy:VPLConstraintRelationEqual
+                                                                  toVariable:@"x"
+                                                                  multiplier:2
+                                                                    constant:0] ]];
+
+      NSDictionary * statistics = [VPLInstrumentation statistics];
+      expect(statistics[@"counters"][@"constraintsAdded"]).to.equal(2);
+      expect([statistics[@"gauges"][@"tableauRows"] integerValue]).to.beGreaterThanOrEqualTo(2);
+      expect([statistics[@"gauges"][@"tableauTerms"] integerValue]).to.beGreaterThan(0);
+      expect([statistics[@"gauges"][@"tableauMaximumRowLength"] integerValue]).to.beGreaterThan(0);
+    });
+
+  });
+
+  describe(@"phases", ^{
+
+    it(@"counts and times each phase", ^{
+      for (NSUInteger phaseIndex = 0; phaseIndex < 2; phaseIndex++)
+      {
+        uint64_t startTime = VPLInstrumentationPhaseStart();
+        expect(startTime).notTo.equal(0);
+        VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseSolve, startTime);
+      }
+
+      NSDictionary * solvePhase = [VPLInstrumentation statistics][@"phases"][@"solve"];
+      expect(solvePhase[@"count"]).to.equal(2);
+      expect([solvePhase[@"seconds"] doubleValue]).to.beGreaterThanOrEqualTo(0);
+      expect([VPLInstrumentation statistics][@"phases"][@"draw"][@"count"]).to.equal(0);
+    });
+
+    it(@"doesn't time a phase that started while disabled", ^{
+      [VPLInstrumentation setEnabled:NO];
+      uint64_t startTime = VPLInstrumentationPhaseStart();
+      [VPLInstrumentation setEnabled:YES];
+      VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseSolve, startTime);
+
+      expect(startTime).to.equal(0);
+      expect([VPLInstrumentation statistics][@"phases"][@"solve"][@"count"]).to.equal(0);
+    });
+
+  });
+
+  describe(@"+ reset", ^{
+
+    it(@"clears counters, gauges and phases", ^{
+      VPLInstrumentationCount(VPLInstrumentationCounterLayoutCacheHits, 1);
+      VPLInstrumentationRecordMaximum(VPLInstrumentationGaugeTableauTerms, 12);
+      VPLInstrumentationPhaseEnd(VPLInstrumentationPhaseDraw, VPLInstrumentationPhaseStart());
+
+      [VPLInstrumentation reset];
+
+      NSDictionary * statistics = [VPLInstrumentation statistics];
+      expect(statistics[@"counters"][@"layoutCacheHits"]).to.equal(0);
+      expect(statistics[@"gauges"][@"tableauTerms"]).to.equal(0);
+      expect(statistics[@"phases"][@"draw"][@"count"]).to.equal(0);
+      expect(statistics[@"phases"][@"draw"][@"seconds"]).to.equal(0);
+    });
+
+  });
+
+  describe(@"+ statistics", ^{
+
+    it(@"names every measurement, and can be written as JSON", ^{
+      NSDictionary * statistics = [VPLInstrumentation statistics];
+
+      expect([statistics allKeys]).to.haveCountOf(3);
+      expect(statistics[@"counters"]).to.haveCountOf(VPLInstrumentationCounterCount);
+      expect(statistics[@"gauges"]).to.haveCountOf(VPLInstrumentationGaugeCount);
+      expect(statistics[@"phases"]).to.haveCountOf(VPLInstrumentationPhaseCount);
+      expect([statistics[@"phases"] allKeys]).to.contain(@"encodePNG");
+      expect([NSJSONSerialization isValidJSONObject:statistics]).to.beTruthy();
+    });
+
+  });
+
+});
+
+SpecEnd
@@ -0,0 +1,178 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLJSONScanner.h"
+
+static VPLJSONScanner *
+VPLJSONScannerSpecScanner(NSString * string)
+{
+  return [[VPLJSONScanner alloc] initWithData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+SpecBegin(VPLJSONScanner)
+
+describe(@"VPLJSONScanner", ^{
+
+  describe(@"- skipValue", ^{
+
+    it(@"skips nested containers, including brackets inside strings", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"{ \"skipped\": { \"a\": [1, { \"b\": \"]}\\\"\" }], "
+                                                           @"\"c\": null }, \"kept\": \"value\" }");
+
+      __block NSString * keptValue = nil;
+      BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+        if ([key isEqualToString:@"kept"])
+        {
+          return [scanner scanString:&keptValue];
+        }
+        return [scanner skipValue];
+      }];
+
+      expect(didScan).to.beTruthy();
+      expect(scanner.error).to.beNil();
+      expect(keptValue).to.equal(@"value");
+      expect([scanner scanEnd]).to.beTruthy();
+    });
+
+    it(@"leaves a skipped value's bytes for NSJSONSerialization", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"[ { \"a\": [1, 2.5e3, true, false, null] }, \"next\" ]");
+
+      __block NSRange skippedRange = NSMakeRange(NSNotFound, 0);
+      BOOL didScan = [scanner scanArrayUsingBlock:^BOOL(NSUInteger index) {
+        NSUInteger start = [scanner locationOfNextValue];
+        if (![scanner skipValue])
+        {
+          return NO;
+        }
+        if (index == 0)
+        {
+          skippedRange = NSMakeRange(start, scanner.location - start);
+        }
+        return YES;
+      }];
+      expect(didScan).to.beTruthy();
+
+      NSData * skippedData = [scanner.data subdataWithRange:skippedRange];
+      id skippedValue = [NSJSONSerialization JSONObjectWithData:skippedData
+                                                        options:0
+                                                          error:NULL];
+      expect(skippedValue).to.equal((@{ @"a" : @[ @1, @2500, @YES, @NO, [NSNull null] ] }));
+    });
+
+    it(@"fails on mismatched brackets", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"[1, { \"a\": 2 ]]");
+      expect([scanner skipValue]).to.beFalsy();
+      expect(scanner.error.code).to.equal(VPLJSONScannerErrorInvalidSyntax);
+      expect([scanner.error localizedDescription]).to.contain(@"unexpected ']'");
+    });
+
+    it(@"fails on an unterminated string", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"[\"a\\\"]");
+      expect([scanner skipValue]).to.beFalsy();
+      expect([scanner.error localizedDescription]).to.contain(@"unterminated string");
+    });
+
+  });
+
+  describe(@"- scanString:", ^{
+
+    it(@"scans a string without escapes", ^{
+      NSString * string = nil;
+      expect([VPLJSONScannerSpecScanner(@"  \"café.png\"") scanString:&string]).to.beTruthy();
+      expect(string).to.equal(@"café.png");
+    });
+
+    it(@"unescapes a string with escapes", ^{
+      NSString * string = nil;
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"\"a \\\"quoted\\\" \\\\ path\\/\\u00e9\\n\"");
+      expect([scanner scanString:&string]).to.beTruthy();
+      expect(string).to.equal(@"a \"quoted\" \\ path/é\n");
+      expect([scanner scanEnd]).to.beTruthy();
+    });
+
+    it(@"fails on something other than a string", ^{
+      NSString * string = nil;
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"12");
+      expect([scanner scanString:&string]).to.beFalsy();
+      expect([scanner.error localizedDescription]).to.contain(@"expected a string");
+    });
+
+  });
+
+  describe(@"trailing commas", ^{
+
+    it(@"scans empty containers", ^{
+      expect([VPLJSONScannerSpecScanner(@"{ }") scanObjectUsingBlock:^BOOL(NSString * key) {
+        return NO;
+      }]).to.beTruthy();
+      expect([VPLJSONScannerSpecScanner(@"[ ]") scanArrayUsingBlock:^BOOL(NSUInteger index) {
+        return NO;
+      }]).to.beTruthy();
+    });
+
+    it(@"rejects a trailing comma in an object, as NSJSONSerialization does", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"{ \"a\": 1, }");
+      BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+        return [scanner skipValue];
+      }];
+
+      expect(didScan).to.beFalsy();
+      expect([scanner.error localizedDescription]).to.contain(@"expected a string");
+      expect([NSJSONSerialization JSONObjectWithData:scanner.data options:0 error:NULL]).to.beNil();
+    });
+
+    it(@"rejects a trailing comma in an array, as NSJSONSerialization does", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"[1, 2, ]");
+      __block NSUInteger elementCount = 0;
+      BOOL didScan = [scanner scanArrayUsingBlock:^BOOL(NSUInteger index) {
+        elementCount++;
+        return [scanner skipValue];
+      }];
+
+      expect(didScan).to.beFalsy();
+      expect(elementCount).to.equal(3);
+      expect([scanner.error localizedDescription]).to.contain(@"expected a value");
+      expect([NSJSONSerialization JSONObjectWithData:scanner.data options:0 error:NULL]).to.beNil();
+    });
+
+  });
+
+  describe(@"errors", ^{
+
+    it(@"reports the line and column of the error", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"{\n  \"a\": 1,\n  \"b\" 2\n}");
+      BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+        return [scanner skipValue];
+      }];
+
+      expect(didScan).to.beFalsy();
+      expect(scanner.error.domain).to.equal(VPLJSONScannerErrorDomain);
+      expect(scanner.error.code).to.equal(VPLJSONScannerErrorInvalidSyntax);
+      expect([scanner.error localizedDescription]).to.equal(@"Invalid JSON at line 3, column 7: expected ':'");
+    });
+
+    it(@"counts columns from the start of the first line", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"  [1] x");
+      expect([scanner skipValue]).to.beTruthy();
+      expect([scanner scanEnd]).to.beFalsy();
+      expect([scanner.error localizedDescription]).to.contain(@"line 1, column 7");
+    });
+
+    it(@"keeps the first error", ^{
+      VPLJSONScanner * scanner = VPLJSONScannerSpecScanner(@"{\n\"a\" 1 }");
+      BOOL didScan = [scanner scanObjectUsingBlock:^BOOL(NSString * key) {
+        return [scanner skipValue];
+      }];
+
+      expect(didScan).to.beFalsy();
+      expect([scanner scanEnd]).to.beFalsy();
+      expect([scanner.error localizedDescription]).to.equal(@"Invalid JSON at line 2, column 5: expected ':'");
+    });
+
+  });
+
+});
+
+SpecEnd
@@ -0,0 +1,402 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLLayer.h"
+#import "VPLLayoutConstraint.h"
+#import "VPLConstraintSet.h"
+#import "VPLAssetRepresentation.h"
+
+static VPLLayoutConstraint *
+VPLLayerSpecLayoutConstraint(NSString * subject,
+                             NSString * attribute,
+                             NSString * relatedObject,
+                             CGFloat multiplier,
+                             CGFloat constant)
+{
+  return [[VPLLayoutConstraint alloc] initWithSubject:subject
+                                            attribute:attribute
+                                         relationship:@"=="
+                                        relatedObject:relatedObject
+                                     relatedAttribute:attribute
+                                           multiplier:multiplier
+                                             constant:constant];
+}
+
+/**
+ * A layer inset from its superlayer's origin by `offset`, and half its superlayer's size.
+ */
+static VPLLayer *
+VPLLayerSpecBoxLayer(NSString * identifier, NSString * superlayerIdentifier, CGFloat offset)
+{
+  NSArray * layoutConstraints = @[
+    VPLLayerSpecLayoutConstraint(identifier, @"x", superlayerIdentifier, 1, offset),
+    VPLLayerSpecLayoutConstraint(identifier, @"y", superlayerIdentifier, 1, offset),
+    VPLLayerSpecLayoutConstraint(identifier, @"width", superlayerIdentifier, 0.5, 0),
+    VPLLayerSpecLayoutConstraint(identifier, @"height", superlayerIdentifier, 0.5, 0),
+  ];
+  return [[VPLLayer alloc] initWithIdentifier:identifier
+                            layoutConstraints:layoutConstraints];
+}
+
+/**
+ * A layer inset from its superlayer's origin by `offset`, whose size is left to its text.
+ */
+static VPLLayer *
+VPLLayerSpecLabelLayer(NSString * identifier, NSString * superlayerIdentifier, CGFloat offset)
+{
+  NSArray * layoutConstraints = @[
+    VPLLayerSpecLayoutConstraint(identifier, @"x", superlayerIdentifier, 1, offset),
+    VPLLayerSpecLayoutConstraint(identifier, @"y", superlayerIdentifier, 1, offset),
+  ];
+  return [[VPLLayer alloc] initWithIdentifier:identifier
+                            layoutConstraints:layoutConstraints];
+}
+
+static VPLAssetRepresentation *
+VPLLayerSpecRepresentation(VPLLayer * rootLayer, CGSize size)
+{
+  return [[VPLAssetRepresentation alloc] initWithAsset:nil
+                                              filename:@"layer.png"
+                                                  size:size
+                                             rootLayer:rootLayer];
+}
+
+static BOOL
+VPLLayerSpecFrameIsEqualToRect(CGRect frame, CGRect rect)
+{
+  return (fabs(frame.origin.x - rect.origin.x) < 1.0e-6 &&
+          fabs(frame.origin.y - rect.origin.y) < 1.0e-6 &&
+          fabs(frame.size.width - rect.size.width) < 1.0e-6 &&
+          fabs(frame.size.height - rect.size.height) < 1.0e-6);
+}
+
+static BOOL
+VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(VPLConstraintSet * constraintSet, VPLLayer * layer)
+{
+  for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+  {
+    if (![constraintSet containsConstraint:layoutConstraint.constraint]) return NO;
+  }
+  return YES;
+}
+
+static BOOL
+VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(VPLConstraintSet * constraintSet, VPLLayer * layer)
+{
+  for (VPLLayoutConstraint * layoutConstraint in layer.layoutConstraints)
+  {
+    if ([constraintSet containsConstraint:layoutConstraint.constraint]) return YES;
+  }
+  return NO;
+}
+
+SpecBegin(VPLLayer)
+
+describe(@"VPLLayer", ^{
+
+  __block VPLLayer * rootLayer = nil;
+  __block VPLLayer * aLayer = nil;
+  __block VPLLayer * a1Layer = nil;
+  __block VPLAssetRepresentation * representation = nil;
+
+  // root (200 x 100) > a > a1
+  beforeEach(^{
+    rootLayer = [[VPLLayer alloc] initWithIdentifier:@"root"];
+    aLayer = VPLLayerSpecBoxLayer(@"a", @"root", 10);
+    a1Layer = VPLLayerSpecBoxLayer(@"a1", @"a", 5);
+    [rootLayer addSublayer:aLayer];
+    [aLayer addSublayer:a1Layer];
+
+    representation = VPLLayerSpecRepresentation(rootLayer, CGSizeMake(200, 100));
+    [representation performLayout];
+  });
+
+  afterEach(^{
+    representation = nil;
+    rootLayer = nil;
+    aLayer = nil;
+    a1Layer = nil;
+  });
+
+  describe(@"- attachToConstraintSet:", ^{
+
+    it(@"adds the whole tree's constraints, and solves every layer's frame", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      expect(constraintSet).notTo.beNil();
+      expect(aLayer.constraintSet).to.beIdenticalTo(constraintSet);
+      expect(a1Layer.constraintSet).to.beIdenticalTo(constraintSet);
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(constraintSet, aLayer)).to.beTruthy();
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(constraintSet, a1Layer)).to.beTruthy();
+
+      expect(VPLLayerSpecFrameIsEqualToRect(rootLayer.frame, CGRectMake(0, 0, 200, 100))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(aLayer.frame, CGRectMake(10, 10, 100, 50))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(a1Layer.frame, CGRectMake(15, 15, 50, 25))).to.beTruthy();
+    });
+
+    it(@"indexes each layer by its frame variables", ^{
+      expect([rootLayer attachedLayerForVariableID:aLayer.widthVariableID]).to.beIdenticalTo(aLayer);
+      expect([aLayer attachedLayerForVariableID:a1Layer.xVariableID]).to.beIdenticalTo(a1Layer);
+    });
+
+    it(@"returns the constraints that couldn't be satisfied, and leaves them out", ^{
+      VPLLayoutConstraint * xEQ10 = VPLLayerSpecLayoutConstraint(@"c", @"x", @"other", 1, 10);
+      VPLLayoutConstraint * xEQ20 = VPLLayerSpecLayoutConstraint(@"c", @"x", @"other", 1, 20);
+      VPLLayer * otherLayer = [[VPLLayer alloc] initWithIdentifier:@"other"];
+      VPLLayer * cLayer = [[VPLLayer alloc] initWithIdentifier:@"c"
+                                             layoutConstraints:@[ xEQ10, xEQ20 ]];
+      [otherLayer addSublayer:cLayer];
+
+      VPLConstraintSet * constraintSet = [[VPLConstraintSet alloc] init];
+      NSArray * unsatisfiableConstraints = [otherLayer attachToConstraintSet:constraintSet];
+
+      expect(unsatisfiableConstraints).to.haveCountOf(1);
+      VPLConstraint * unsatisfiableConstraint = [unsatisfiableConstraints firstObject];
+      VPLConstraint * satisfiedConstraint = (unsatisfiableConstraint == xEQ10.constraint ?
+                                             xEQ20.constraint :
+                                             xEQ10.constraint);
+      expect([constraintSet containsConstraint:unsatisfiableConstraint]).to.beFalsy();
+      expect([constraintSet containsConstraint:satisfiedConstraint]).to.beTruthy();
+
+      // only the constraint that was added is removed again
+      [otherLayer detachFromConstraintSet];
+      expect([constraintSet containsConstraint:satisfiedConstraint]).to.beFalsy();
+    });
+
+  });
+
+  describe(@"- detachFromConstraintSet", ^{
+
+    it(@"removes the tree's constraints, and stops indexing its layers", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      [rootLayer detachFromConstraintSet];
+
+      expect(rootLayer.constraintSet).to.beNil();
+      expect(a1Layer.constraintSet).to.beNil();
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, aLayer)).to.beFalsy();
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, a1Layer)).to.beFalsy();
+      expect([rootLayer attachedLayerForVariableID:aLayer.xVariableID]).to.beNil();
+    });
+
+  });
+
+  describe(@"inserting a subtree into an attached tree", ^{
+
+    __block VPLLayer * bLayer = nil;
+    __block VPLLayer * b1Layer = nil;
+
+    beforeEach(^{
+      bLayer = VPLLayerSpecBoxLayer(@"b", @"root", 20);
+      b1Layer = VPLLayerSpecBoxLayer(@"b1", @"b", 5);
+      [bLayer addSublayer:b1Layer];
+    });
+
+    afterEach(^{
+      bLayer = nil;
+      b1Layer = nil;
+    });
+
+    it(@"adds just the subtree's constraints, and lays it out with the rest of the tree", ^{
+      [rootLayer addSublayer:bLayer];
+
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      expect(bLayer.constraintSet).to.beIdenticalTo(constraintSet);
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(constraintSet, bLayer)).to.beTruthy();
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(constraintSet, b1Layer)).to.beTruthy();
+      expect([rootLayer attachedLayerForVariableID:b1Layer.heightVariableID]).to.beIdenticalTo(b1Layer);
+
+      [representation performLayout];
+
+      expect(VPLLayerSpecFrameIsEqualToRect(bLayer.frame, CGRectMake(20, 20, 100, 50))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(b1Layer.frame, CGRectMake(25, 25, 50, 25))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(aLayer.frame, CGRectMake(10, 10, 100, 50))).to.beTruthy();
+    });
+
+    it(@"inserts the subtree at the index it's given", ^{
+      [rootLayer insertSublayer:bLayer
+                        atIndex:0];
+
+      expect(rootLayer.sublayers).to.equal((@[ bLayer, aLayer ]));
+      expect(bLayer.superlayer).to.beIdenticalTo(rootLayer);
+    });
+
+    it(@"lays the subtree out again at a new size", ^{
+      [rootLayer addSublayer:bLayer];
+      [representation performLayoutWithSize:CGSizeMake(400, 200)];
+
+      expect(VPLLayerSpecFrameIsEqualToRect(bLayer.frame, CGRectMake(20, 20, 200, 100))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(b1Layer.frame, CGRectMake(25, 25, 100, 50))).to.beTruthy();
+    });
+
+  });
+
+  describe(@"removing a subtree from an attached tree", ^{
+
+    it(@"removes just the subtree's constraints, and stops indexing its layers", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      [aLayer removeFromSuperlayer];
+
+      expect(aLayer.constraintSet).to.beNil();
+      expect(a1Layer.constraintSet).to.beNil();
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, aLayer)).to.beFalsy();
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, a1Layer)).to.beFalsy();
+      expect([rootLayer attachedLayerForVariableID:aLayer.xVariableID]).to.beNil();
+      expect([rootLayer attachedLayerForVariableID:a1Layer.xVariableID]).to.beNil();
+
+      [representation performLayoutWithSize:CGSizeMake(300, 150)];
+      expect(VPLLayerSpecFrameIsEqualToRect(rootLayer.frame, CGRectMake(0, 0, 300, 150))).to.beTruthy();
+    });
+
+    it(@"removes the layer from its own superlayer's sublayers", ^{
+      [a1Layer removeFromSuperlayer];
+
+      expect(aLayer.sublayers).to.haveCountOf(0);
+      expect(rootLayer.sublayers).to.equal(@[ aLayer ]);
+      expect(a1Layer.superlayer).to.beNil();
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(rootLayer.constraintSet, aLayer)).to.beTruthy();
+    });
+
+    it(@"keeps the order of the remaining sublayers", ^{
+      VPLLayer * bLayer = VPLLayerSpecBoxLayer(@"b", @"root", 20);
+      VPLLayer * cLayer = VPLLayerSpecBoxLayer(@"c", @"root", 30);
+      [rootLayer addSublayer:bLayer];
+      [rootLayer addSublayer:cLayer];
+
+      [bLayer removeFromSuperlayer];
+
+      expect(rootLayer.sublayers).to.equal((@[ aLayer, cLayer ]));
+    });
+
+    it(@"can be added back", ^{
+      [aLayer removeFromSuperlayer];
+      [rootLayer addSublayer:aLayer];
+      [representation performLayoutWithSize:CGSizeMake(400, 200)];
+
+      expect([rootLayer attachedLayerForVariableID:a1Layer.xVariableID]).to.beIdenticalTo(a1Layer);
+      expect(VPLLayerSpecFrameIsEqualToRect(aLayer.frame, CGRectMake(10, 10, 200, 100))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(a1Layer.frame, CGRectMake(15, 15, 100, 50))).to.beTruthy();
+    });
+
+  });
+
+  describe(@"moving a layer between attached trees", ^{
+
+    __block VPLLayer * otherRootLayer = nil;
+    __block VPLAssetRepresentation * otherRepresentation = nil;
+
+    beforeEach(^{
+      // the other tree's root has the same identifier, so the moved layer's constraints still refer to its superlayer
+      otherRootLayer = [[VPLLayer alloc] initWithIdentifier:@"root"];
+      otherRepresentation = VPLLayerSpecRepresentation(otherRootLayer, CGSizeMake(400, 200));
+      [otherRepresentation performLayout];
+    });
+
+    afterEach(^{
+      otherRootLayer = nil;
+      otherRepresentation = nil;
+    });
+
+    it(@"moves the subtree's constraints from one constraint set to the other", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      VPLConstraintSet * otherConstraintSet = otherRootLayer.constraintSet;
+
+      [otherRootLayer addSublayer:aLayer];
+
+      expect(rootLayer.sublayers).to.haveCountOf(0);
+      expect(aLayer.constraintSet).to.beIdenticalTo(otherConstraintSet);
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, aLayer)).to.beFalsy();
+      expect(VPLLayerSpecConstraintSetContainsAnyLayoutConstraintOfLayer(constraintSet, a1Layer)).to.beFalsy();
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(otherConstraintSet, aLayer)).to.beTruthy();
+      expect(VPLLayerSpecConstraintSetContainsLayoutConstraintsOfLayer(otherConstraintSet, a1Layer)).to.beTruthy();
+
+      expect([rootLayer attachedLayerForVariableID:aLayer.xVariableID]).to.beNil();
+      expect([otherRootLayer attachedLayerForVariableID:aLayer.xVariableID]).to.beIdenticalTo(aLayer);
+    });
+
+    it(@"lays the subtree out in its new tree", ^{
+      [otherRootLayer addSublayer:aLayer];
+      [otherRepresentation performLayout];
+
+      expect(VPLLayerSpecFrameIsEqualToRect(aLayer.frame, CGRectMake(10, 10, 200, 100))).to.beTruthy();
+      expect(VPLLayerSpecFrameIsEqualToRect(a1Layer.frame, CGRectMake(15, 15, 100, 50))).to.beTruthy();
+    });
+
+  });
+
+  describe(@"intrinsic sizes", ^{
+
+    __block VPLLayer * labelLayer = nil;
+
+    beforeEach(^{
+      labelLayer = VPLLayerSpecLabelLayer(@"label", @"root", 10);
+      [rootLayer addSublayer:labelLayer];
+      [representation performLayout];
+    });
+
+    afterEach(^{
+      labelLayer = nil;
+    });
+
+    it(@"has no edit variables without text", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      expect([constraintSet containsEditVariable:@"label.width"]).to.beFalsy();
+      expect([constraintSet containsEditVariable:@"label.height"]).to.beFalsy();
+    });
+
+    it(@"adds edit variables when text is set, and sizes the layer to fit it", ^{
+      labelLayer.text = @"Hello";
+      [representation performLayout];
+
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+      expect([constraintSet containsEditVariable:@"label.width"]).to.beTruthy();
+      expect([constraintSet containsEditVariable:@"label.height"]).to.beTruthy();
+
+      CGSize intrinsicContentSize = labelLayer.intrinsicContentSize;
+      expect(intrinsicContentSize.width).to.beGreaterThan(0);
+      expect(VPLLayerSpecFrameIsEqualToRect(labelLayer.frame, CGRectMake(10, 10,
+                                                                        intrinsicContentSize.width,
+                                                                        intrinsicContentSize.height))).to.beTruthy();
+    });
+
+    it(@"suggests the new size when the text changes", ^{
+      labelLayer.text = @"Hello";
+      [representation performLayout];
+      CGFloat shortWidth = labelLayer.frame.size.width;
+
+      labelLayer.text = @"Hello, world";
+      [representation performLayout];
+
+      expect(labelLayer.frame.size.width).to.beGreaterThan(shortWidth);
+      expect(labelLayer.frame.size.width).to.beCloseToWithin(labelLayer.intrinsicContentSize.width, 1.0e-6);
+    });
+
+    it(@"removes the edit variables when the text is cleared, and adds them again when it's set", ^{
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+
+      labelLayer.text = @"Hello";
+      labelLayer.text = nil;
+      expect([constraintSet containsEditVariable:@"label.width"]).to.beFalsy();
+      expect([constraintSet containsEditVariable:@"label.height"]).to.beFalsy();
+
+      labelLayer.text = @"Hello";
+      [representation performLayout];
+      expect([constraintSet containsEditVariable:@"label.width"]).to.beTruthy();
+      expect(labelLayer.frame.size.height).to.beCloseToWithin(labelLayer.intrinsicContentSize.height, 1.0e-6);
+    });
+
+    it(@"removes the edit variables along with the layer", ^{
+      labelLayer.text = @"Hello";
+      VPLConstraintSet * constraintSet = rootLayer.constraintSet;
+
+      [labelLayer removeFromSuperlayer];
+
+      expect([constraintSet containsEditVariable:@"label.width"]).to.beFalsy();
+      expect([constraintSet containsEditVariable:@"label.height"]).to.beFalsy();
+    });
+
+  });
+
+});
+
+SpecEnd
@@ -0,0 +1,116 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLLayoutCache.h"
+#import "VPLConstraint.h"
+
+static NSData *
+VPLLayoutCacheSpecValues(double value, NSUInteger count)
+{
+  NSMutableData * values = [[NSMutableData alloc] initWithLength:count * sizeof(double)];
+  double * doubles = [values mutableBytes];
+  for (NSUInteger valueIndex = 0; valueIndex < count; valueIndex++)
+  {
+    doubles[valueIndex] = value;
+  }
+  return values;
+}
+
+SpecBegin(VPLLayoutCache)
+
+describe(@"VPLLayoutFingerprint", ^{
+
+  VPLConstraint * (^widthConstraint)(CGFloat) = ^VPLConstraint *(CGFloat constant) {
+    return [VPLConstraint constraintWithVariable:@"a.width"
+                                       relatedBy:VPLConstraintRelationEqual
+                                      toVariable:@"b.width"
+                                      multiplier:1
+                                        constant:constant];
+  };
+
+  VPLConstraint * (^heightConstraint)(void) = ^VPLConstraint *(void) {
+    return [VPLConstraint constraintWithVariable:@"a.height"
+                                       relatedBy:VPLConstraintRelationGreaterThanOrEqual
+                                      toVariable:nil
+                                      multiplier:0
+                                        constant:10];
+  };
+
+  it(@"doesn't depend on marker variables or the order constraints are added in", ^{
+    VPLLayoutFingerprint * fingerprint = [[VPLLayoutFingerprint alloc] init];
+    [fingerprint addConstraint:widthConstraint(20)];
+    [fingerprint addConstraint:heightConstraint()];
+
+    VPLLayoutFingerprint * otherFingerprint = [[VPLLayoutFingerprint alloc] init];
+    [otherFingerprint addConstraint:heightConstraint()];
+    [otherFingerprint addConstraint:widthConstraint(20)];
+
+    expect([fingerprint stringValue]).to.equal([otherFingerprint stringValue]);
+  });
+
+  it(@"depends on constants and edit variables", ^{
+    VPLLayoutFingerprint * fingerprint = [[VPLLayoutFingerprint alloc] init];
+    [fingerprint addConstraint:widthConstraint(20)];
+    [fingerprint addEditVariable:@"a.width" weight:1 value:100];
+
+    VPLLayoutFingerprint * otherConstantFingerprint = [[VPLLayoutFingerprint alloc] init];
+    [otherConstantFingerprint addConstraint:widthConstraint(21)];
+    [otherConstantFingerprint addEditVariable:@"a.width" weight:1 value:100];
+
+    VPLLayoutFingerprint * otherValueFingerprint = [[VPLLayoutFingerprint alloc] init];
+    [otherValueFingerprint addConstraint:widthConstraint(20)];
+    [otherValueFingerprint addEditVariable:@"a.width" weight:1 value:200];
+
+    expect([fingerprint stringValue]).notTo.equal([otherConstantFingerprint stringValue]);
+    expect([fingerprint stringValue]).notTo.equal([otherValueFingerprint stringValue]);
+  });
+
+});
+
+describe(@"VPLLayoutCache", ^{
+
+  it(@"returns the values stored for a fingerprint", ^{
+    VPLLayoutCache * layoutCache = [[VPLLayoutCache alloc] init];
+    [layoutCache setValues:VPLLayoutCacheSpecValues(1, 4) forFingerprint:@"a"];
+
+    expect([layoutCache valuesForFingerprint:@"a"]).to.equal(VPLLayoutCacheSpecValues(1, 4));
+    expect([layoutCache valuesForFingerprint:@"b"]).to.beNil();
+    expect(layoutCache.hitCount).to.equal(1);
+    expect(layoutCache.missCount).to.equal(1);
+  });
+
+  it(@"discards the least recently used layouts once it's over its memory limit", ^{
+    // each layout takes 1 byte of fingerprint and 32 bytes of values
+    VPLLayoutCache * layoutCache = [[VPLLayoutCache alloc] initWithMemoryLimit:70];
+    [layoutCache setValues:VPLLayoutCacheSpecValues(1, 4) forFingerprint:@"a"];
+    [layoutCache setValues:VPLLayoutCacheSpecValues(2, 4) forFingerprint:@"b"];
+    [layoutCache valuesForFingerprint:@"a"];
+    [layoutCache setValues:VPLLayoutCacheSpecValues(3, 4) forFingerprint:@"c"];
+
+    expect(layoutCache.count).to.equal(2);
+    expect([layoutCache valuesForFingerprint:@"a"]).notTo.beNil();
+    expect([layoutCache valuesForFingerprint:@"b"]).to.beNil();
+    expect([layoutCache valuesForFingerprint:@"c"]).notTo.beNil();
+  });
+
+  it(@"reads back the layouts it writes", ^{
+    NSString * path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+
+    VPLLayoutCache * layoutCache = [[VPLLayoutCache alloc] init];
+    [layoutCache setValues:VPLLayoutCacheSpecValues(1.5, 8) forFingerprint:@"a"];
+
+    NSError * error = nil;
+    expect([layoutCache writeToFile:path error:&error]).to.beTruthy();
+
+    VPLLayoutCache * readLayoutCache = [[VPLLayoutCache alloc] init];
+    expect([readLayoutCache readFromFile:path error:&error]).to.beTruthy();
+    expect([readLayoutCache valuesForFingerprint:@"a"]).to.equal(VPLLayoutCacheSpecValues(1.5, 8));
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+  });
+
+});
+
+SpecEnd
@@ -0,0 +1,236 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLLayoutWriter.h"
+#import "VPLAssetRepresentation.h"
+#import "VPLLayer.h"
+
+// an identifier with a quote, a backslash, a control character and a character outside ASCII
+static NSString * const VPLLayoutWriterSpecTitleIdentifier = @"ti\"t\\le\té";
+
+/**
+ * A representation whose layers already have frames, so records can be made without laying it out.
+ */
+static VPLAssetRepresentation *
+VPLLayoutWriterSpecRepresentation(void)
+{
+  VPLLayer * rootLayer = [[VPLLayer alloc] initWithIdentifier:@"button"];
+  rootLayer.frame = CGRectMake(0, 0, 120, 44);
+
+  VPLLayer * titleLayer = [[VPLLayer alloc] initWithIdentifier:VPLLayoutWriterSpecTitleIdentifier];
+  titleLayer.frame = CGRectMake(10, 12, 100, 20.5);
+  [rootLayer addSublayer:titleLayer];
+
+  return [[VPLAssetRepresentation alloc] initWithAsset:nil
+                                              filename:@"button \"1\".png"
+                                                  size:CGSizeMake(120, 44)
+                                             rootLayer:rootLayer];
+}
+
+/**
+ * Reads binary values in order from a record, the way a consumer would.
+ */
+@interface VPLLayoutWriterSpecReader : NSObject
+
+@property (nonatomic, strong) NSData * data;
+@property (nonatomic, assign) NSUInteger location;
+
+- (void)readBytes:(void *)bytes
+           length:(NSUInteger)length;
+- (uint32_t)readUInt32;
+- (double)readDouble;
+- (NSString *)readString;
+
+@end
+
+@implementation VPLLayoutWriterSpecReader
+
+- (void)readBytes:(void *)bytes
+           length:(NSUInteger)length
+{
+  NSAssert(self.location + length <= [self.data length], @"[%@ %@] read past the end of the record",
+           NSStringFromClass([self class]), NSStringFromSelector(_cmd));
+  [self.data getBytes:bytes range:NSMakeRange(self.location, length)];
+  self.location += length;
+}
+
+- (uint32_t)readUInt32
+{
+  uint32_t value = 0;
+  [self readBytes:&value length:sizeof(value)];
+  return value;
+}
+
+- (double)readDouble
+{
+  double value = 0;
+  [self readBytes:&value length:sizeof(value)];
+  return value;
+}
+
+- (NSString *)readString
+{
+  uint32_t length = [self readUInt32];
+  NSString * string = [[NSString alloc] initWithData:[self.data subdataWithRange:NSMakeRange(self.location, length)]
+                                            encoding:NSUTF8StringEncoding];
+  self.location += length;
+  return string;
+}
+
+@end
+
+SpecBegin(VPLLayoutWriter)
+
+describe(@"VPLLayoutWriter", ^{
+
+  __block VPLAssetRepresentation * representation = nil;
+
+  beforeEach(^{
+    representation = VPLLayoutWriterSpecRepresentation();
+  });
+
+  afterEach(^{
+    representation = nil;
+  });
+
+  describe(@"JSON records", ^{
+
+    it(@"writes a line with each layer's frame", ^{
+      NSData * data = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                               format:VPLLayoutFormatJSON];
+      NSString * line = [[NSString alloc] initWithData:data
+                                              encoding:NSUTF8StringEncoding];
+
+      NSString * expectedLine = (@"{\"filename\":\"button \\\"1\\\".png\",\"width\":120,\"height\":44,"
+                                 @"\"layers\":{\"button\":[0,0,120,44],"
+                                 @"\"ti\\\"t\\\\le\\u0009é\":[10,12,100,20.5]}}\n");
+      expect(line).to.equal(expectedLine);
+    });
+
+    it(@"escapes strings so that they read back as they were", ^{
+      NSData * data = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                               format:VPLLayoutFormatJSON];
+      NSError * error = nil;
+      NSDictionary * layout = [NSJSONSerialization JSONObjectWithData:data
+                                                              options:0
+                                                                error:&error];
+      RAISE_SPEC_ERROR(error, @"Couldn't read JSON layout");
+
+      expect(layout[@"filename"]).to.equal(@"button \"1\".png");
+      expect([layout[@"layers"] allKeys]).to.contain(VPLLayoutWriterSpecTitleIdentifier);
+      expect(layout[@"layers"][VPLLayoutWriterSpecTitleIdentifier]).to.equal((@[ @10, @12, @100, @20.5 ]));
+    });
+
+  });
+
+  describe(@"binary records", ^{
+
+    it(@"starts each record with the length of the rest of it", ^{
+      NSData * data = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                               format:VPLLayoutFormatBinary];
+      VPLLayoutWriterSpecReader * reader = [[VPLLayoutWriterSpecReader alloc] init];
+      reader.data = data;
+
+      expect([reader readUInt32]).to.equal([data length] - sizeof(uint32_t));
+    });
+
+    it(@"writes the size, the filename and each layer's frame", ^{
+      VPLLayoutWriterSpecReader * reader = [[VPLLayoutWriterSpecReader alloc] init];
+      reader.data = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                             format:VPLLayoutFormatBinary];
+      [reader readUInt32];
+
+      expect([reader readDouble]).to.equal(120);
+      expect([reader readDouble]).to.equal(44);
+      expect([reader readString]).to.equal(@"button \"1\".png");
+      expect([reader readUInt32]).to.equal(2);
+
+      expect([reader readString]).to.equal(@"button");
+      expect([reader readDouble]).to.equal(0);
+      expect([reader readDouble]).to.equal(0);
+      expect([reader readDouble]).to.equal(120);
+      expect([reader readDouble]).to.equal(44);
+
+      // strings are written as they are, without escaping
+      expect([reader readString]).to.equal(VPLLayoutWriterSpecTitleIdentifier);
+      expect([reader readDouble]).to.equal(10);
+      expect([reader readDouble]).to.equal(12);
+      expect([reader readDouble]).to.equal(100);
+      expect([reader readDouble]).to.equal(20.5);
+
+      expect(reader.location).to.equal([reader.data length]);
+    });
+
+  });
+
+  describe(@"writing to a file", ^{
+
+    __block NSString * path = nil;
+
+    beforeEach(^{
+      path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+      [[NSFileManager defaultManager] createFileAtPath:path
+                                              contents:nil
+                                            attributes:nil];
+    });
+
+    afterEach(^{
+      [[NSFileManager defaultManager] removeItemAtPath:path
+                                                 error:NULL];
+      path = nil;
+    });
+
+    it(@"writes a header, followed by a record for each layout", ^{
+      NSFileHandle * fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+      VPLLayoutWriter * writer = [[VPLLayoutWriter alloc] initWithFileHandle:fileHandle
+                                                                      format:VPLLayoutFormatBinary];
+      [writer writeLayoutOfRepresentation:representation
+                                     size:CGSizeMake(120, 44)];
+      [writer flush];
+      [fileHandle closeFile];
+
+      expect(writer.layoutCount).to.equal(1);
+
+      NSData * data = [NSData dataWithContentsOfFile:path];
+      VPLLayoutWriterSpecReader * reader = [[VPLLayoutWriterSpecReader alloc] init];
+      reader.data = data;
+
+      char magic[4];
+      [reader readBytes:magic length:sizeof(magic)];
+      expect(memcmp(magic, "VPLF", sizeof(magic))).to.equal(0);
+
+      uint16_t version = 0;
+      uint16_t byteOrderMark = 0;
+      [reader readBytes:&version length:sizeof(version)];
+      [reader readBytes:&byteOrderMark length:sizeof(byteOrderMark)];
+      expect(version).to.equal(1);
+      expect(byteOrderMark).to.equal(0xFEFF);
+
+      // the record is of the frames the layout left the layers with
+      NSData * record = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                                 format:VPLLayoutFormatBinary];
+      expect([data subdataWithRange:NSMakeRange(reader.location, [data length] - reader.location)]).to.equal(record);
+    });
+
+    it(@"writes nothing but records in JSON", ^{
+      NSFileHandle * fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+      VPLLayoutWriter * writer = [[VPLLayoutWriter alloc] initWithFileHandle:fileHandle
+                                                                      format:VPLLayoutFormatJSON];
+      [writer writeLayoutOfRepresentation:representation
+                                     size:CGSizeMake(120, 44)];
+      [writer flush];
+      [fileHandle closeFile];
+
+      NSData * record = [VPLLayoutWriter dataWithLayoutOfRepresentation:representation
+                                                                 format:VPLLayoutFormatJSON];
+      expect(writer.layoutCount).to.equal(1);
+      expect([NSData dataWithContentsOfFile:path]).to.equal(record);
+    });
+
+  });
+
+});
+
+SpecEnd
@@ -522,6 +522,28 @@ describe(@"VPLLinearExpression", ^{
       
     });
     
+    describe(@"when substituting leaves floating point residue", ^{
+      
+      beforeEach(^{
+        //   2((-1.5 + 5e-13)y + z + 2.5 + 5e-13) + 3y - 5
+        // = 1e-12y + 2z + 1e-12
+        // = 2z
+        
+        VPLLinearExpression * substituteExpression =
+          [VPLLinearExpression expressionWithConstantValue:2.5 + 5e-13
+                                             variableNames:@[ @"y", @"z" ]
+                                      variableCoefficients:@[ @(-1.5 + 5e-13), @1 ]];
+        result = [expression expressionBySubstitutingExpression:substituteExpression
+                                                    forVariable:@"x"];
+      });
+      
+      it(@"should prune the near-zero term and constant", ^{
+        expect(result.termCount).to.equal(1);
+        expect(result).to.equal([VPLLinearExpression expressionFromString:@"2z"]);
+      });
+      
+    });
+    
     describe(@"when the variable doesn't exist", ^{
       
       beforeEach(^{
@@ -0,0 +1,107 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLSymbolTable.h"
+#import "VPLLinearExpression.h"
+
+SpecBegin(VPLSymbolTable)
+
+describe(@"VPLSymbolTable", ^{
+
+  __block VPLSymbolTable * symbolTable;
+
+  beforeEach(^{
+    symbolTable = [[VPLSymbolTable alloc] init];
+  });
+
+  afterEach(^{
+    symbolTable = nil;
+  });
+
+  // ===== VARIABLES ===================================================================================================
+#pragma mark - Variables
+
+  describe(@"- variableIDForName:", ^{
+
+    it(@"returns the same id each time a name is interned", ^{
+      VPLVariableID variableID = [symbolTable variableIDForName:@"x"];
+
+      expect(variableID).notTo.equal(VPLVariableIDNone);
+      expect([symbolTable variableIDForName:@"x"]).to.equal(variableID);
+      expect(symbolTable.count).to.equal(1);
+    });
+
+    it(@"returns different ids for different names", ^{
+      expect([symbolTable variableIDForName:@"x"]).notTo.equal([symbolTable variableIDForName:@"y"]);
+    });
+
+    it(@"tags each id with the variable's kind", ^{
+      NSString * slackName = [VPLLinearExpressionSlackVariablePrefix stringByAppendingString:@"x"];
+      NSString * dummyName = [VPLLinearExpressionDummyVariablePrefix stringByAppendingString:@"x"];
+      NSString * objectiveName = [VPLLinearExpressionObjectiveVariablePrefix stringByAppendingString:@"x"];
+
+      expect(VPLVariableIDIsExternal([symbolTable variableIDForName:@"x"])).to.beTruthy();
+      expect(VPLVariableIDIsSlack([symbolTable variableIDForName:slackName])).to.beTruthy();
+      expect(VPLVariableIDIsDummy([symbolTable variableIDForName:dummyName])).to.beTruthy();
+      expect(VPLVariableIDIsObjective([symbolTable variableIDForName:objectiveName])).to.beTruthy();
+
+      expect(VPLVariableIDIsRestricted([symbolTable variableIDForName:slackName])).to.beTruthy();
+      expect(VPLVariableIDIsRestricted([symbolTable variableIDForName:dummyName])).to.beTruthy();
+      expect(VPLVariableIDIsRestricted([symbolTable variableIDForName:@"x"])).to.beFalsy();
+    });
+
+  });
+
+  describe(@"anonymous variables", ^{
+
+    it(@"names them without interning them", ^{
+      VPLVariableID variableID = VPLVariableIDMakeAnonymous(7, VPLVariableKindSlack);
+      NSString * variableName = [symbolTable nameForVariableID:variableID];
+
+      expect(variableName).to.equal([VPLLinearExpressionSlackVariablePrefix stringByAppendingString:@"#7"]);
+      expect(VPLVariableIDIsAnonymous(variableID)).to.beTruthy();
+      expect(VPLVariableIDIsSlack(variableID)).to.beTruthy();
+      expect(symbolTable.count).to.equal(0);
+    });
+
+    it(@"turns their names back into the same ids", ^{
+      VPLVariableID variableID = VPLVariableIDMakeAnonymous(3, VPLVariableKindDummy);
+      NSString * variableName = [symbolTable nameForVariableID:variableID];
+
+      expect([symbolTable variableIDForName:variableName]).to.equal(variableID);
+      expect([symbolTable existingVariableIDForName:variableName]).to.equal(variableID);
+      expect(symbolTable.count).to.equal(0);
+    });
+
+    it(@"interns names that only look like them", ^{
+      VPLVariableID variableID = [symbolTable variableIDForName:@"x#2"];
+
+      expect(VPLVariableIDIsAnonymous(variableID)).to.beFalsy();
+      expect(symbolTable.count).to.equal(1);
+    });
+
+  });
+
+  describe(@"- existingVariableIDForName:", ^{
+
+    it(@"returns VPLVariableIDNone for names that haven't been interned", ^{
+      expect([symbolTable existingVariableIDForName:@"x"]).to.equal(VPLVariableIDNone);
+      expect(symbolTable.count).to.equal(0);
+    });
+
+  });
+
+  describe(@"- nameForVariableID:", ^{
+
+    it(@"returns the interned name", ^{
+      VPLVariableID variableID = [symbolTable variableIDForName:@"layer.width"];
+      expect([symbolTable nameForVariableID:variableID]).to.equal(@"layer.width");
+    });
+
+  });
+
+});
+
+SpecEnd
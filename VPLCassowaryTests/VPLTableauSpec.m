@@ -388,6 +388,132 @@ describe(@"VPLTableau", ^{
     
   });
   
+  // ===== MUTABLE TABLEAU =============================================================================================
+#pragma mark - Mutable Tableau
+  
+  describe(@"VPLMutableTableau", ^{
+    
+    __block VPLMutableTableau * mutableTableau;
+    __block VPLSymbolTable * symbolTable;
+    
+    beforeEach(^{
+      NSDictionary * equations = @{
+        @"x" : [VPLLinearExpression expressionFromString:@"95 - 0.5a - b"],
+        @"y" : [VPLLinearExpression expressionFromString:@"100       - b"],
+        @"z" : [VPLLinearExpression expressionFromString:@"90 -    a - b"],
+      };
+      
+      mutableTableau = [[VPLTableau tableauWithEquations:equations] mutableCopy];
+      symbolTable = [VPLSymbolTable sharedSymbolTable];
+    });
+    
+    afterEach(^{
+      mutableTableau = nil;
+      symbolTable = nil;
+    });
+    
+    it(@"indexes the rows that contain each column", ^{
+      NSMutableIndexSet * expectedRows = [[NSMutableIndexSet alloc] init];
+      [expectedRows addIndex:[symbolTable variableIDForName:@"x"]];
+      [expectedRows addIndex:[symbolTable variableIDForName:@"z"]];
+      
+      expect([mutableTableau rowVariableIDsForColumnVariableID:[symbolTable variableIDForName:@"a"]]).to.equal(expectedRows);
+      expect([mutableTableau containsColumnVariableID:[symbolTable variableIDForName:@"b"]]).to.beTruthy();
+      expect([mutableTableau containsColumnVariableID:[symbolTable variableIDForName:@"x"]]).to.beFalsy();
+    });
+    
+    it(@"pivots in place, updating the column index", ^{
+      [mutableTableau pivotRowVariableID:[symbolTable variableIDForName:@"x"]
+                        columnVariableID:[symbolTable variableIDForName:@"a"]];
+      
+      expect(mutableTableau.rowVariableNames).to.equal(VPLSortedVariables(@"a", @"y", @"z"));
+      expect(mutableTableau.columnVariableNames).to.equal(VPLSortedVariables(@"x", @"b"));
+      expect([mutableTableau containsColumnVariableID:[symbolTable variableIDForName:@"a"]]).to.beFalsy();
+      expect([mutableTableau expressionForRow:@"z"]).to.equal([VPLLinearExpression expressionFromString:@"-100 + 2x + b"]);
+    });
+    
+    it(@"drops a column from the index once no rows contain it", ^{
+      [mutableTableau removeColumnVariableID:[symbolTable variableIDForName:@"a"]];
+      
+      expect(mutableTableau.columnVariableNames).to.equal(VPLSortedVariables(@"b"));
+      expect([mutableTableau expressionForRow:@"x"]).to.equal([VPLLinearExpression expressionFromString:@"95 - b"]);
+    });
+    
+    it(@"returns an immutable copy that isn't affected by later changes", ^{
+      VPLTableau * copiedTableau = [mutableTableau copy];
+      [mutableTableau removeRowVariableID:[symbolTable variableIDForName:@"x"]];
+      
+      expect(copiedTableau.rowVariableNames).to.equal(VPLSortedVariables(@"x", @"y", @"z"));
+      expect(mutableTableau.rowVariableNames).to.equal(VPLSortedVariables(@"y", @"z"));
+    });
+    
+  });
+  
+  describe(@"pivot rules", ^{
+    
+    __block NSString * slackA = nil;
+    __block NSString * slackB = nil;
+    __block NSString * slackC = nil;
+    __block NSString * slackD = nil;
+    __block VPLTableau * originalTableau = nil;
+    __block VPLLinearExpression * objectiveExpr = nil;
+    __block VPLVariableID objectiveVariableID = VPLVariableIDNone;
+    
+    beforeEach(^{
+      slackA = [NSString stringWithFormat:@"%@PivotA", VPLLinearExpressionSlackVariablePrefix];
+      slackB = [NSString stringWithFormat:@"%@PivotB", VPLLinearExpressionSlackVariablePrefix];
+      slackC = [NSString stringWithFormat:@"%@PivotC", VPLLinearExpressionSlackVariablePrefix];
+      slackD = [NSString stringWithFormat:@"%@PivotD", VPLLinearExpressionSlackVariablePrefix];
+      
+      // maximize a + 3b, with a <= 4 and b <= 6, by minimizing -a - 3b:
+      //
+      //   C = 4 - A
+      //   D = 6 - B
+      originalTableau = [VPLTableau tableauWithEquations:@{
+                                                          slackC : [VPLLinearExpression expressionWithConstantValue:4
+                                                                                                      variableNames:@[ slackA ]
+                                                                                               variableCoefficients:@[ @(-1) ]],
+                                                          slackD : [VPLLinearExpression expressionWithConstantValue:6
+                                                                                                      variableNames:@[ slackB ]
+                                                                                               variableCoefficients:@[ @(-1) ]],
+                                                         }];
+      
+      objectiveExpr = [VPLLinearExpression expressionWithConstantValue:0
+                                                         variableNames:@[ slackA, slackB ]
+                                                  variableCoefficients:@[ @(-1), @(-3) ]];
+      
+      NSString * objectiveVariableName = [NSString stringWithFormat:@"%@PivotZ", VPLLinearExpressionObjectiveVariablePrefix];
+      objectiveVariableID = [[VPLSymbolTable sharedSymbolTable] variableIDForName:objectiveVariableName];
+    });
+    
+    afterEach(^{
+      slackA = nil;
+      slackB = nil;
+      slackC = nil;
+      slackD = nil;
+      originalTableau = nil;
+      objectiveExpr = nil;
+    });
+    
+    it(@"defaults to the Dantzig rule", ^{
+      expect(originalTableau.pivotRule).to.equal(VPLPivotRuleDantzig);
+    });
+    
+    it(@"reaches the same optimum with every rule, and counts the pivots", ^{
+      for (NSNumber * pivotRule in @[ @(VPLPivotRuleBland), @(VPLPivotRuleDantzig), @(VPLPivotRuleSteepestEdge) ])
+      {
+        VPLMutableTableau * mutableTableau = [originalTableau mutableCopy];
+        mutableTableau.pivotRule = [pivotRule intValue];
+        [mutableTableau minimizeExpression:objectiveExpr
+                       objectiveVariableID:objectiveVariableID];
+        
+        expect([mutableTableau expressionForRowVariableID:objectiveVariableID].constantValue).to.equal(-22);
+        expect(mutableTableau.pivotCount).to.equal(2);
+      }
+    });
+    
+  });
+  
 });
 
-SpecEnd
\ No newline at end of file
+SpecEnd
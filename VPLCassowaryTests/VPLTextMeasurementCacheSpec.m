@@ -0,0 +1,65 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLTextMeasurementCache.h"
+
+SpecBegin(VPLTextMeasurementCache)
+
+describe(@"VPLTextMeasurementCache", ^{
+
+  CGSize unconstrained = CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX);
+
+  it(@"creates each font once", ^{
+    VPLTextMeasurementCache * textMeasurementCache = [[VPLTextMeasurementCache alloc] init];
+    CTFontRef font = [textMeasurementCache fontWithName:@"Helvetica Neue" size:17];
+
+    expect(font != NULL).to.beTruthy();
+    expect([textMeasurementCache fontWithName:@"Helvetica Neue" size:17] == font).to.beTruthy();
+    expect([textMeasurementCache fontWithName:@"Helvetica Neue" size:12] == font).to.beFalsy();
+  });
+
+  it(@"measures the same text in the same font once", ^{
+    VPLTextMeasurementCache * textMeasurementCache = [[VPLTextMeasurementCache alloc] init];
+    CGSize size = [textMeasurementCache sizeOfText:@"Hello"
+                                          fontName:@"Helvetica Neue"
+                                          fontSize:17
+                                       constraints:unconstrained];
+    CGSize cachedSize = [textMeasurementCache sizeOfText:@"Hello"
+                                                fontName:@"Helvetica Neue"
+                                                fontSize:17
+                                             constraints:unconstrained];
+    [textMeasurementCache sizeOfText:@"Hello"
+                            fontName:@"Helvetica Neue"
+                            fontSize:12
+                         constraints:unconstrained];
+
+    expect(size.width).to.beGreaterThan(0);
+    expect(CGSizeEqualToSize(size, cachedSize)).to.beTruthy();
+    expect(textMeasurementCache.hitCount).to.equal(1);
+    expect(textMeasurementCache.missCount).to.equal(2);
+  });
+
+  it(@"discards the least recently used measurements once it's over its limit", ^{
+    VPLTextMeasurementCache * textMeasurementCache = [[VPLTextMeasurementCache alloc] initWithCountLimit:2];
+    for (NSString * text in @[ @"a", @"b", @"a", @"c" ])
+    {
+      [textMeasurementCache sizeOfText:text
+                              fontName:@"Helvetica Neue"
+                              fontSize:17
+                           constraints:unconstrained];
+    }
+    expect(textMeasurementCache.count).to.equal(2);
+    expect(textMeasurementCache.missCount).to.equal(3);
+
+    [textMeasurementCache sizeOfText:@"b"
+                            fontName:@"Helvetica Neue"
+                            fontSize:17
+                         constraints:unconstrained];
+    expect(textMeasurementCache.missCount).to.equal(4);
+  });
+
+});
+
+SpecEnd
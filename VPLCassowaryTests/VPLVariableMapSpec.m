@@ -0,0 +1,77 @@
+#if ! __has_feature(objc_arc)
+#error This file must be compiled with ARC
+#endif
+
+#import "VPLSpecHelper.h"
+#import "VPLVariableMap.h"
+
+// enough ids that many of them share slots, several levels down
+static const VPLVariableID VPLVariableMapSpecCount = 2000;
+
+SpecBegin(VPLVariableMap)
+
+describe(@"VPLVariableMap", ^{
+
+  it(@"sets, replaces and removes entries", ^{
+    VPLMutableVariableMap * map = [[VPLMutableVariableMap alloc] init];
+    for (VPLVariableID variableID = 0; variableID < VPLVariableMapSpecCount; variableID++)
+    {
+      [map setObject:@(variableID)
+       forVariableID:variableID * 37];
+    }
+    [map setObject:@"replaced"
+     forVariableID:37];
+    for (VPLVariableID variableID = 0; variableID < VPLVariableMapSpecCount; variableID += 2)
+    {
+      [map removeObjectForVariableID:variableID * 37];
+    }
+
+    expect(map.count).to.equal(VPLVariableMapSpecCount / 2);
+    expect([map objectForVariableID:37]).to.equal(@"replaced");
+    expect([map objectForVariableID:3 * 37]).to.equal(@3);
+    expect([map containsVariableID:2 * 37]).to.beFalsy();
+    expect([map containsVariableID:38]).to.beFalsy();
+    expect([map.variableIDs firstIndex]).to.equal(37);
+    expect([map.variableIDs count]).to.equal(VPLVariableMapSpecCount / 2);
+  });
+
+  it(@"isn't affected by changes to the map it was copied from", ^{
+    VPLMutableVariableMap * map = [[VPLMutableVariableMap alloc] init];
+    for (VPLVariableID variableID = 0; variableID < VPLVariableMapSpecCount; variableID++)
+    {
+      [map setObject:@(variableID)
+       forVariableID:variableID];
+    }
+
+    VPLVariableMap * copiedMap = [map copy];
+    VPLMutableVariableMap * forkedMap = [map mutableCopy];
+    for (VPLVariableID variableID = 0; variableID < VPLVariableMapSpecCount; variableID++)
+    {
+      [map setObject:@"changed"
+       forVariableID:variableID];
+    }
+    [forkedMap removeObjectForVariableID:10];
+
+    expect(copiedMap.count).to.equal(VPLVariableMapSpecCount);
+    expect([copiedMap objectForVariableID:10]).to.equal(@10);
+    expect([forkedMap containsVariableID:10]).to.beFalsy();
+    expect([forkedMap objectForVariableID:11]).to.equal(@11);
+    expect([map objectForVariableID:10]).to.equal(@"changed");
+  });
+
+  it(@"derives maps without changing the original", ^{
+    VPLVariableMap * map = [[VPLVariableMap map] mapBySettingObject:@1
+                                                      forVariableID:1];
+    VPLVariableMap * derivedMap = [[map mapBySettingObject:@33
+                                             forVariableID:33]
+                                   mapByRemovingObjectForVariableID:1];
+
+    expect(map.count).to.equal(1);
+    expect([map objectForVariableID:1]).to.equal(@1);
+    expect(derivedMap.count).to.equal(1);
+    expect([derivedMap objectForVariableID:33]).to.equal(@33);
+  });
+
+});
+
+SpecEnd